@@ -63,6 +63,13 @@
 /* Blueooth stack (like Bluez). OBEX */
 #cmakedefine GSM_ENABLE_BLUEOBEX
 
+/* TCP or Unix socket. AT commands */
+#cmakedefine GSM_ENABLE_SOCKETAT
+/* TCP or Unix socket. FBUS2 */
+#cmakedefine GSM_ENABLE_SOCKETFBUS2
+/* TCP or Unix socket. OBEX */
+#cmakedefine GSM_ENABLE_SOCKETOBEX
+
 /* --------------------------- Phone modules (specific) ----------------- */
 
 /* n0650.c models */
@@ -182,6 +189,12 @@
 #ifndef HAVE_ALARM
 #cmakedefine HAVE_ALARM
 #endif
+#ifndef HAVE_CLOCK_GETTIME
+#cmakedefine HAVE_CLOCK_GETTIME
+#endif
+#ifndef HAVE_MKFIFO
+#cmakedefine HAVE_MKFIFO
+#endif
 #ifndef HAVE_GETPASS
 #cmakedefine HAVE_GETPASS
 #endif
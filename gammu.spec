@@ -259,11 +259,11 @@ Currently supported phones include:
 This package contains Gammu SMS Daemon and tool to inject messages 
 into the queue.
 
-%package -n libGammu7
+%package -n libGammu8
 Summary:    Mobile phone management library
 Group:      System/Libraries
 
-%description -n libGammu7
+%description -n libGammu8
 Gammu is command line utility and library to work with mobile phones
 from many vendors. Support for different models differs, but basic
 functions should work with majority of them. Program can work with
@@ -281,11 +281,11 @@ Currently supported phones include:
 
 This package contains Gammu shared library.
 
-%package -n libgsmsd7
+%package -n libgsmsd8
 Summary:    SMS daemon helper library
 Group:      System/Libraries
 
-%description -n libgsmsd7
+%description -n libgsmsd8
 Gammu is command line utility and library to work with mobile phones
 from many vendors. Support for different models differs, but basic
 functions should work with majority of them. Program can work with
@@ -334,13 +334,13 @@ make -C build-dir install DESTDIR=%buildroot
 cat libgammu.lang >> %{name}.lang
 install -m644 docs/config/smsdrc %buildroot/etc/gammu-smsdrc
 
-%post -n libGammu7 -p /sbin/ldconfig
+%post -n libGammu8 -p /sbin/ldconfig
 
-%post -n libgsmsd7 -p /sbin/ldconfig
+%post -n libgsmsd8 -p /sbin/ldconfig
 
-%postun -n libGammu7 -p /sbin/ldconfig
+%postun -n libGammu8 -p /sbin/ldconfig
 
-%postun -n libgsmsd7 -p /sbin/ldconfig
+%postun -n libgsmsd8 -p /sbin/ldconfig
 
 %post smsd
 %if 0%{?mandriva_version}
@@ -405,12 +405,12 @@ fi
 %attr(755,root,root) %config /etc/init.d/gammu-smsd
 %config /etc/gammu-smsdrc
 
-%files -n libGammu7
+%files -n libGammu8
 %defattr(-,root,root)
 %_libdir/libGammu*.so.*
 %_datadir/gammu/
 
-%files -n libgsmsd7
+%files -n libgsmsd8
 %defattr(-,root,root)
 %_libdir/libgsmsd*.so.*
 
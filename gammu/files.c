@@ -341,130 +341,233 @@ void GetFolderListing(int argc UNUSED, char *argv[])
 	GSM_Terminate();
 }
 
-static void GetOneFile(GSM_File * File, gboolean newtime, int i)
+/**
+ * Number of seconds over which current transfer speed is computed.
+ */
+#define TRANSFER_SPEED_WINDOW 5
+
+/**
+ * State for computing current transfer speed.
+ */
+typedef struct {
+	time_t window_start;
+	size_t window_done;
+	long unsigned int speed;
+} TransferSpeed;
+
+/**
+ * Starts measuring transfer speed.
+ */
+static void InitTransferSpeed(TransferSpeed * speed)
 {
-	GSM_Error error;
+	speed->window_start = time(NULL);
+	speed->window_done = 0;
+	speed->speed = 0;
+}
+
+/**
+ * Prints current speed of transfer, it is computed over last few
+ * seconds so that slowdowns are visible.
+ */
+static void PrintTransferSpeed(size_t done, TransferSpeed * speed)
+{
+	time_t now;
+	long diff;
+
+	now = time(NULL);
+	diff = now - speed->window_start;
+	/* First estimate is shown after one second */
+	if (diff >= TRANSFER_SPEED_WINDOW || (speed->speed == 0 && diff > 0)) {
+		speed->speed = (done - speed->window_done) / diff;
+		speed->window_start = now;
+		speed->window_done = done;
+	}
+	if (speed->speed > 0) {
+		fprintf(stderr, _(", %lu Bytes/sec"), speed->speed);
+	}
+}
+
+/**
+ * Prints summary of finished transfer.
+ */
+static void PrintTransferSummary(size_t done, time_t start)
+{
+	long diff;
+
+	diff = time(NULL) - start;
+	if ((diff > 0) && (done > 0)) {
+		fprintf(stderr, "\r");
+		fprintf(stderr, _("%lu Bytes in %li seconds, %lu Bytes/sec"),
+			(long unsigned int) done, (long unsigned int) diff, (long unsigned int) done / diff);
+	}
+	fprintf(stderr, "\n");
+	fflush(stderr);
+}
+
+/**
+ * State of file being saved by GetOneFile.
+ */
+typedef struct {
 	FILE *file;
+	char name[5000];
+	int index;
 	gboolean start;
-	unsigned char buffer[5000];
-	struct utimbuf filedate;
-	int Handle, Size, p, q, j, old1;
-	time_t t_time1, t_time2;
+	time_t t_time1;
+	int old1;
+	TransferSpeed speed;
+} GetOneFileState;
+
+/**
+ * Prints name of file being read.
+ */
+static void PrintGettingFile(GSM_File * File, GetOneFileState * state)
+{
+	if (state->start) {
+		printf(_("Getting \"%s\"\n"), DecodeUnicodeConsole(File->Name));
+		state->start = FALSE;
+	}
+}
+
+/**
+ * Opens local file where data read from phone will be saved.
+ */
+static GSM_Error OpenSavedFile(GSM_File * File, GetOneFileState * state)
+{
+	int j;
+
+	sprintf(state->name, "%s", DecodeUnicodeConsole(File->Name));
+	for (j = strlen(state->name) - 1; j > 0; j--) {
+		if (state->name[j] == '\\' || state->name[j] == '/')
+			break;
+	}
+	if (state->name[j] == '\\' || state->name[j] == '/') {
+		sprintf(state->name, "%s",
+			DecodeUnicodeConsole(File->Name + j * 2 + 2));
+	}
+	state->file = fopen(state->name, "wb");
+	if (state->file == NULL) {
+		sprintf(state->name, "file%s",
+			DecodeUnicodeString(File->ID_FullName));
+		state->file = fopen(state->name, "wb");
+	}
+	if (state->file == NULL) {
+		sprintf(state->name, "file%i", state->index);
+		state->file = fopen(state->name, "wb");
+	}
+	if (state->file == NULL)
+		return ERR_CANTOPENFILE;
+	printf(_("  Saving to %s\n"), state->name);
+	return ERR_NONE;
+}
+
+/**
+ * Writes file data as they are received from phone.
+ */
+static GSM_Error SaveFilePart(GSM_StateMachine * s UNUSED, GSM_File * File,
+			      const unsigned char *data, size_t length,
+			      size_t total, void *user_data)
+{
+	GetOneFileState *state = (GetOneFileState *) user_data;
+	GSM_Error error;
+	time_t t_time2;
 	long diff;
+	int p, q;
+
+	PrintGettingFile(File, state);
+	if (File->Folder) {
+		return ERR_FILENOTSUPPORTED;
+	}
+	if (state->file == NULL) {
+		error = OpenSavedFile(File, state);
+		if (error != ERR_NONE)
+			return error;
+	}
+	if (fwrite(data, 1, length, state->file) != length) {
+		printf_err("%s", _("Error while writing file!\n"));
+		return ERR_WRITING_FILE;
+	}
+
+	if (total == 0) {
+		fprintf(stderr, "*");
+	} else {
+		fprintf(stderr, "\r");
+		fprintf(stderr, _("%i percent"),
+			(int)(File->Used * 100 / total));
+		PrintTransferSpeed(File->Used, &state->speed);
+		if (File->Used * 100 / total >= 2) {
+			t_time2 = time(NULL);
+			diff = t_time2 - state->t_time1;
+			p = diff * (total - File->Used) / File->Used;
+			if (p != 0) {
+				if (p < state->old1)
+					state->old1 = p;
+				q = state->old1 / 60;
+				fprintf(stderr,
+					_(" (%02i:%02i minutes left)"),
+					q, state->old1 - q * 60);
+			} else {
+				fprintf(stderr, "%30c", 0x20);
+			}
+		}
+	}
+	return ERR_NONE;
+}
+
+static void GetOneFile(GSM_File * File, gboolean newtime, int i)
+{
+	GSM_Error error;
+	GetOneFileState state;
+	struct utimbuf filedate;
 
 	if (File->Buffer != NULL) {
 		free(File->Buffer);
 		File->Buffer = NULL;
 	}
 	File->Used = 0;
-	start = TRUE;
-
-	t_time1 = time(NULL);
-	old1 = 65536;
 
-	error = ERR_NONE;
-	while (error == ERR_NONE) {
-		error = GSM_GetFilePart(gsm, File, &Handle, &Size);
-		if (error == ERR_NONE || error == ERR_EMPTY
-		    || error == ERR_WRONGCRC) {
-			if (start) {
-				printf(_("Getting \"%s\"\n"),
-				       DecodeUnicodeConsole(File->Name));
-				start = FALSE;
-			}
-			if (File->Folder) {
-				free(File->Buffer);
-				GSM_Terminate();
-				printf("%s\n",
-				       _ ("Is a folder. Please give only file names."));
-				Terminate(2);
-			}
-			if (Size == 0) {
-				fprintf(stderr, "*");
-			} else {
-				fprintf(stderr, "\r");
-				fprintf(stderr, _("%i percent"),
-					(int)(File->Used * 100 / Size));
-				if (File->Used * 100 / Size >= 2) {
-					t_time2 = time(NULL);
-					diff = t_time2 - t_time1;
-					p = diff * (Size -
-						    File->Used) / File->Used;
-					if (p != 0) {
-						if (p < old1)
-							old1 = p;
-						q = old1 / 60;
-						fprintf(stderr,
-							_
-							(" (%02i:%02i minutes left)"),
-							q, old1 - q * 60);
-					} else {
-						fprintf(stderr, "%30c", 0x20);
-					}
-				}
-			}
-			if (error == ERR_EMPTY)
-				break;
-			if (error == ERR_WRONGCRC) {
-				printf_warn("%s\n",
-				    _("File checksum calculated by phone doesn't match with value calculated by Gammu. File is damaged or there is a error in Gammu."));
-				break;
-			}
+	state.file = NULL;
+	state.index = i;
+	state.start = TRUE;
+	state.t_time1 = time(NULL);
+	state.old1 = 65536;
+	InitTransferSpeed(&state.speed);
+
+	/* Data are written as they come, file is not kept in memory */
+	error = GSM_GetFileStream(gsm, File, SaveFilePart, &state);
+	if (state.file != NULL) {
+		if (fclose(state.file) != 0 && error == ERR_NONE) {
+			printf_err("%s", _("Error while writing file!\n"));
+			error = ERR_WRITING_FILE;
 		}
-		Print_Error(error);
-	}
-	t_time2 = time(NULL);
-	diff = t_time2 - t_time1;
-	if ((diff > 0) && (File->Used > 0)) {
-		fprintf(stderr, "\r");
-		if (Size != 0) {
-			fprintf(stderr, _("%i percent done."), (int)(File->Used * 100 / Size));
+		/* Do not leave partially received file behind */
+		if (error != ERR_NONE && error != ERR_WRONGCRC) {
+			remove(state.name);
+			state.file = NULL;
 		}
-		fprintf(stderr, _("%lu Bytes in %li seconds, %lu Bytes/sec"),
-			(long unsigned int) File->Used, (long unsigned int) diff, (long unsigned int) File->Used / diff);
 	}
-	fprintf(stderr, "\n");
-	fflush(stderr);
-	if (error == ERR_NONE || error == ERR_EMPTY || error == ERR_WRONGCRC) {
-		if (File->Used != 0) {
-			sprintf(buffer, "%s", DecodeUnicodeConsole(File->Name));
-			for (j = strlen(buffer) - 1; j > 0; j--) {
-				if (buffer[j] == '\\' || buffer[j] == '/')
-					break;
-			}
-			if (buffer[j] == '\\' || buffer[j] == '/') {
-				sprintf(buffer, "%s",
-					DecodeUnicodeConsole(File->Name +
-							     j * 2 + 2));
-			}
-			file = fopen(buffer, "wb");
-			if (file == NULL) {
-				sprintf(buffer, "file%s",
-					DecodeUnicodeString(File->ID_FullName));
-				file = fopen(buffer, "wb");
-			}
-			if (file == NULL) {
-				sprintf(buffer, "file%i", i);
-				file = fopen(buffer, "wb");
-			}
-			if (file == NULL)
-				Print_Error(ERR_CANTOPENFILE);
-			printf(_("  Saving to %s\n"), buffer);
-			if (fwrite(File->Buffer, 1, File->Used, file) != File->Used) {
-				printf_err("%s", _("Error while writing file!\n"));
-			}
-			free(File->Buffer);
-			File->Buffer = NULL;
-			fclose(file);
-			if (!newtime && !File->ModifiedEmpty) {
-				/* access time */
-				filedate.actime = Fill_Time_T(File->Modified);
-				/* modification time */
-				filedate.modtime = Fill_Time_T(File->Modified);
-				smprintf(gsm, "Setting date of %s\n", buffer);
-				utime(buffer, &filedate);
-			}
-		}
+	if (File->Folder) {
+		PrintGettingFile(File, &state);
+		GSM_Terminate();
+		printf("%s\n",
+		       _ ("Is a folder. Please give only file names."));
+		Terminate(2);
+	}
+	if (error == ERR_WRONGCRC) {
+		printf_warn("%s\n",
+		    _("File checksum calculated by phone doesn't match with value calculated by Gammu. File is damaged or there is a error in Gammu."));
+	} else {
+		Print_Error(error);
+	}
+	PrintGettingFile(File, &state);
+
+	PrintTransferSummary(File->Used, state.t_time1);
+	if (state.file != NULL && !newtime && !File->ModifiedEmpty) {
+		/* access time */
+		filedate.actime = Fill_Time_T(File->Modified);
+		/* modification time */
+		filedate.modtime = Fill_Time_T(File->Modified);
+		smprintf(gsm, "Setting date of %s\n", state.name);
+		utime(state.name, &filedate);
 	}
 }
 
@@ -580,12 +683,12 @@ void AddOneFile(GSM_File * File, const char *text, const gboolean send)
 	GSM_Error error;
 	int Pos, Handle, i, j, old1;
 	time_t t_time1, t_time2;
-	GSM_DateTime dt;
 	long diff;
+	TransferSpeed speed;
 
-	GSM_GetCurrentDateTime(&dt);
-	t_time1 = Fill_Time_T(dt);
+	t_time1 = time(NULL);
 	old1 = 65536;
+	InitTransferSpeed(&speed);
 
 	smprintf(gsm, "Adding file to filesystem now\n");
 	error = ERR_NONE;
@@ -603,9 +706,9 @@ void AddOneFile(GSM_File * File, const char *text, const gboolean send)
 			fprintf(stderr, "%s ", text);
 			fprintf(stderr, _("%i percent"),
 				(int)(Pos * 100 / File->Used));
+			PrintTransferSpeed(Pos, &speed);
 			if (Pos * 100 / File->Used >= 2) {
-				GSM_GetCurrentDateTime(&dt);
-				t_time2 = Fill_Time_T(dt);
+				t_time2 = time(NULL);
 				diff = t_time2 - t_time1;
 				i = diff * (File->Used - Pos) / Pos;
 				if (i != 0) {
@@ -621,7 +724,7 @@ void AddOneFile(GSM_File * File, const char *text, const gboolean send)
 			}
 		}
 	}
-	fprintf(stderr, "\n");
+	PrintTransferSummary(Pos, t_time1);
 	if (error == ERR_WRONGCRC) {
 		printf_warn("%s\n",
 		    _("File checksum calculated by phone doesn't match with value calculated by Gammu. File is damaged or there is a error in Gammu."));
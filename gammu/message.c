@@ -325,13 +325,35 @@ void DeleteSMS(int argc, char *argv[])
 	GSM_Terminate();
 }
 
+/**
+ * State of listing messages in GetAllSMS.
+ */
+typedef struct {
+	GSM_SMSFolders	*folders;
+	void		*BackupPtr;
+	int		smsnum;
+	int		smspos;
+} GetAllSMSState;
+
+/**
+ * Prints message read by GSM_GetAllSMS.
+ */
+static GSM_Error PrintAllSMS(GSM_StateMachine *s, GSM_MultiSMSMessage *sms, void *user_data)
+{
+	GetAllSMSState *state = (GetAllSMSState *)user_data;
+
+	PrintSMSLocation(&sms->SMS[0], state->folders);
+	state->smspos++;
+	state->smsnum += sms->Number;
+	DisplayMultiSMSInfo(sms, FALSE, FALSE, state->BackupPtr, s);
+	return ERR_NONE;
+}
+
 void GetAllSMS(int argc, char *argv[])
 {
 	GSM_Error error;
-	GSM_MultiSMSMessage 	sms;
 	GSM_SMSFolders		folders;
-	gboolean		start = TRUE;
-	int			smsnum=0,smspos=0;
+	GetAllSMSState		state;
 #ifndef GSM_ENABLE_BACKUP
 	void			*BackupPtr = NULL;
 #else
@@ -342,9 +364,6 @@ void GetAllSMS(int argc, char *argv[])
 	BackupPtr = &Backup;
 #endif
 
-	sms.Number = 0;
-	sms.SMS[0].Location = 0;
-
 	GSM_Init(TRUE);
 
 #ifdef GSM_ENABLE_BACKUP
@@ -357,29 +376,18 @@ void GetAllSMS(int argc, char *argv[])
 	error=GSM_GetSMSFolders(gsm, &folders);
 	Print_Error(error);
 
-	while (error == ERR_NONE) {
-		sms.SMS[0].Folder=0x00;
-		error=GSM_GetNextSMS(gsm, &sms, start);
+	state.folders = &folders;
+	state.BackupPtr = BackupPtr;
+	state.smsnum = 0;
+	state.smspos = 0;
 
-		switch (error) {
-		case ERR_EMPTY:
-			break;
-		case ERR_CORRUPTED:
-			fprintf(stderr, "\n%s\n", _("Corrupted message, skipping"));
-			fflush(stderr);
-			error = ERR_NONE;
-			continue;
-		default:
-			Print_Error(error);
-			PrintSMSLocation(&sms.SMS[0], &folders);
-			smspos++;
-			smsnum+=sms.Number;
-			DisplayMultiSMSInfo(&sms, FALSE, FALSE, BackupPtr, gsm);
-		}
-		start=FALSE;
+	error = GSM_GetAllSMS(gsm, PrintAllSMS, &state);
+	if (error != ERR_EMPTY) {
+		Print_Error(error);
 	}
+
 	printf("\n\n");
-	printf(_("%i SMS parts in %i SMS sequences"),smsnum,smspos);
+	printf(_("%i SMS parts in %i SMS sequences"), state.smsnum, state.smspos);
 	printf("\n");
 	fflush(stdout);
 
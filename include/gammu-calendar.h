@@ -15,6 +15,7 @@
 #include <gammu-datetime.h>
 #include <gammu-limits.h>
 #include <gammu-debug.h>
+#include <gammu-memory.h>
 
 /**
  * \defgroup Note Note
@@ -815,6 +816,43 @@ GSM_Error GSM_GetCalendar(GSM_StateMachine * s, GSM_CalendarEntry * Note);
  */
 GSM_Error GSM_GetNextCalendar(GSM_StateMachine * s, GSM_CalendarEntry * Note,
 			      gboolean start);
+
+/**
+ * Callback for \ref GSM_GetCalendarChanges.
+ *
+ * \param s State machine pointer.
+ * \param change Type of change.
+ * \param Note Changed entry, NULL for \ref GSM_Change_Reset, only
+ * Location is set for \ref GSM_Change_Deleted.
+ * \param user_data Pointer passed to \ref GSM_GetCalendarChanges.
+ *
+ * \return Error code, any error stops synchronisation.
+ *
+ * \ingroup Calendar
+ */
+typedef GSM_Error (*GSM_CalendarChangeCallback) (GSM_StateMachine *s,
+						 GSM_ChangeType change,
+						 GSM_CalendarEntry *Note,
+						 void *user_data);
+
+/**
+ * Reports calendar entries changed since last synchronisation, works
+ * same way as \ref GSM_GetMemoryChanges.
+ *
+ * \param s State machine pointer.
+ * \param state_file Path to file with synchronisation state, it is
+ * created if it does not exist. NULL reports all entries.
+ * \param callback Function called for each change.
+ * \param user_data Pointer passed to callback.
+ *
+ * \return Error code.
+ *
+ * \ingroup Calendar
+ */
+GSM_Error GSM_GetCalendarChanges(GSM_StateMachine * s,
+				 const char *state_file,
+				 GSM_CalendarChangeCallback callback,
+				 void *user_data);
 /**
  * Sets calendar entry
  *
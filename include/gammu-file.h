@@ -255,6 +255,78 @@ GSM_Error GSM_AddFilePart(GSM_StateMachine * s, GSM_File * File, int *Pos,
  */
 GSM_Error GSM_SendFilePart(GSM_StateMachine * s, GSM_File * File, int *Pos,
 			   int *Handle);
+/**
+ * Callback receiving data of file read by \ref GSM_GetFileStream.
+ *
+ * \param s State machine pointer.
+ * \param File File structure, Used contains number of bytes received
+ * so far including this part.
+ * \param data Received data.
+ * \param length Length of received data.
+ * \param total Total size of file or 0 if phone did not tell it.
+ * \param user_data Pointer passed to \ref GSM_GetFileStream.
+ *
+ * \return Error code, any error aborts the transfer.
+ *
+ * \ingroup File
+ */
+typedef GSM_Error (*GSM_FileSink) (GSM_StateMachine *s, GSM_File *File,
+				   const unsigned char *data, size_t length,
+				   size_t total, void *user_data);
+
+/**
+ * Callback providing data of file written by \ref GSM_AddFileStream.
+ *
+ * \param s State machine pointer.
+ * \param File File structure.
+ * \param data Buffer where data should be stored.
+ * \param length Number of bytes to store, callback has to fill
+ * whole buffer.
+ * \param user_data Pointer passed to \ref GSM_AddFileStream.
+ *
+ * \return Error code, any error aborts the transfer.
+ *
+ * \ingroup File
+ */
+typedef GSM_Error (*GSM_FileSource) (GSM_StateMachine *s, GSM_File *File,
+				     unsigned char *data, size_t length,
+				     void *user_data);
+
+/**
+ * Reads whole file and passes its data to sink as they are received
+ * instead of storing them in File->Buffer, so that big files do not
+ * have to be kept in memory.
+ *
+ * \param s State machine pointer.
+ * \param File File structure with path, File->Buffer is not used.
+ * \param sink Callback receiving file data.
+ * \param user_data Pointer passed to callback.
+ *
+ * \return Error code, \ref ERR_WRONGCRC if phone reported wrong
+ * checksum after complete transfer.
+ *
+ * \ingroup File
+ */
+GSM_Error GSM_GetFileStream(GSM_StateMachine * s, GSM_File * File,
+			    GSM_FileSink sink, void *user_data);
+
+/**
+ * Adds file to filesystem reading its data from source as they are
+ * sent instead of from File->Buffer.
+ *
+ * \param s State machine pointer.
+ * \param File File structure, File->Used has to contain size of file.
+ * \param source Callback providing file data.
+ * \param user_data Pointer passed to callback.
+ *
+ * \return Error code, \ref ERR_WRONGCRC if phone reported wrong
+ * checksum after complete transfer.
+ *
+ * \ingroup File
+ */
+GSM_Error GSM_AddFileStream(GSM_StateMachine * s, GSM_File * File,
+			    GSM_FileSource source, void *user_data);
+
 /**
  * Acquires filesystem status.
  *
@@ -492,6 +492,70 @@ GSM_Error GSM_GetMemory(GSM_StateMachine * s, GSM_MemoryEntry * entry);
 GSM_Error GSM_GetNextMemory(GSM_StateMachine * s, GSM_MemoryEntry * entry,
 			    gboolean start);
 
+/**
+ * Type of change reported by incremental synchronisation.
+ *
+ * \ingroup Memory
+ */
+typedef enum {
+	/**
+	 * All previously synchronised entries are no longer valid, all
+	 * current entries are reported as modified after this.
+	 */
+	GSM_Change_Reset = 1,
+	/**
+	 * Entry was added or modified.
+	 */
+	GSM_Change_Modified,
+	/**
+	 * Entry was deleted.
+	 */
+	GSM_Change_Deleted,
+} GSM_ChangeType;
+
+/**
+ * Callback for \ref GSM_GetMemoryChanges.
+ *
+ * \param s State machine pointer.
+ * \param change Type of change.
+ * \param entry Changed entry, NULL for \ref GSM_Change_Reset, only
+ * MemoryType and Location are set for \ref GSM_Change_Deleted.
+ * \param user_data Pointer passed to \ref GSM_GetMemoryChanges.
+ *
+ * \return Error code, any error stops synchronisation.
+ *
+ * \ingroup Memory
+ */
+typedef GSM_Error (*GSM_MemoryChangeCallback) (GSM_StateMachine *s,
+					       GSM_ChangeType change,
+					       GSM_MemoryEntry *entry,
+					       void *user_data);
+
+/**
+ * Reports phonebook entries changed since last synchronisation. State
+ * of synchronisation (change counter and locations of entries) is kept
+ * in state file, so that only changes have to be read from phones
+ * supporting change logs, other phones report all entries each time.
+ *
+ * State file is updated only if all changes were successfully passed
+ * to callback.
+ *
+ * \param s State machine pointer.
+ * \param type Memory type.
+ * \param state_file Path to file with synchronisation state, it is
+ * created if it does not exist. NULL reports all entries.
+ * \param callback Function called for each change.
+ * \param user_data Pointer passed to callback.
+ *
+ * \return Error code.
+ *
+ * \ingroup Memory
+ */
+GSM_Error GSM_GetMemoryChanges(GSM_StateMachine * s, GSM_MemoryType type,
+			       const char *state_file,
+			       GSM_MemoryChangeCallback callback,
+			       void *user_data);
+
 /**
  * Sets memory (phonebooks or calls) entry.
  *
@@ -410,6 +410,22 @@ typedef struct {
 	int AllParts;
 } GSM_UDHHeader;
 
+/**
+ * National language for shift tables, identifiers are same as used in
+ * UDH (3GPP TS 23.038, section 6.2.1.2.4).
+ *
+ * \ingroup SMS
+ */
+typedef enum {
+	/**
+	 * Default alphabet and its extension table.
+	 */
+	SMS_Language_Default = 0,
+	SMS_Language_Turkish,
+	SMS_Language_Spanish,
+	SMS_Language_Portuguese,
+} GSM_NationalLanguage;
+
 /**
  * TP-Message-Type-Indicator. See GSM 03.40 section 9.2.3.1.
  *
@@ -617,6 +633,161 @@ GSM_Error GSM_DecodePDUFrame(GSM_Debug_Info *di, GSM_SMSMessage *SMS,
 			const unsigned char *buffer, size_t length,
 			size_t *final_pos, gboolean SMSC);
 
+/**
+ * Compact information about message decoded by \ref GSM_DecodePDUBatch.
+ * All strings point to data owned by the batch.
+ *
+ * \ingroup SMS
+ */
+typedef struct {
+	/**
+	 * Result of decoding, other fields are valid only for ERR_NONE.
+	 */
+	GSM_Error Error;
+	/**
+	 * Type of message.
+	 */
+	GSM_SMSMessageType PDU;
+	/**
+	 * Type of coding.
+	 */
+	GSM_Coding_Type Coding;
+	/**
+	 * SMS class (0 is flash SMS, 1 is normal one, -1 if not set).
+	 */
+	signed char Class;
+	/**
+	 * Message reference.
+	 */
+	unsigned char MessageReference;
+	/**
+	 * In delivery reports: status.
+	 */
+	unsigned char DeliveryStatus;
+	/**
+	 * Indicates whether "Reply via same center" is set.
+	 */
+	gboolean ReplyViaSameSMSC;
+	/**
+	 * Date and time, when SMS was saved or sent
+	 */
+	GSM_DateTime DateTime;
+	/**
+	 * Date of SMSC response in DeliveryReport messages.
+	 */
+	GSM_DateTime SMSCTime;
+	/**
+	 * Type of UDH.
+	 */
+	GSM_UDH UDHType;
+	/**
+	 * 8-bit ID of multipart message, see \ref GSM_UDHHeader.
+	 */
+	int ID8bit;
+	/**
+	 * 16-bit ID of multipart message, see \ref GSM_UDHHeader.
+	 */
+	int ID16bit;
+	/**
+	 * Number of current part of multipart message, see \ref GSM_UDHHeader.
+	 */
+	int PartNumber;
+	/**
+	 * Total number of parts of multipart message, see \ref GSM_UDHHeader.
+	 */
+	int AllParts;
+	/**
+	 * Sender or recipient number in UTF-8.
+	 */
+	const char *Number;
+	/**
+	 * SMSC number in UTF-8, empty if PDU did not include it.
+	 */
+	const char *SMSC;
+	/**
+	 * Message text in UTF-8, raw data for 8-bit messages. It is always
+	 * terminated by zero.
+	 */
+	const char *Text;
+	/**
+	 * Length of Text in bytes.
+	 */
+	size_t TextLength;
+	/**
+	 * Raw UDH data.
+	 */
+	const unsigned char *UDH;
+	/**
+	 * Length of UDH data.
+	 */
+	size_t UDHLength;
+} GSM_SMSPDUInfo;
+
+/**
+ * Result of \ref GSM_DecodePDUBatch. All strings of all messages are
+ * stored in single allocated block.
+ *
+ * \ingroup SMS
+ */
+typedef struct {
+	/**
+	 * Decoded messages, same order as input.
+	 */
+	GSM_SMSPDUInfo *Messages;
+	/**
+	 * Number of messages.
+	 */
+	size_t Count;
+	/**
+	 * Storage for strings.
+	 */
+	char *Data;
+	/**
+	 * Used size of storage.
+	 */
+	size_t DataUsed;
+	/**
+	 * Allocated size of storage.
+	 */
+	size_t DataSize;
+} GSM_SMSPDUBatch;
+
+/**
+ * Decodes many PDUs at once. Unlike \ref GSM_DecodePDUFrame this does
+ * not need GSM_SMSMessage for each message, the results are stored in
+ * compact form in the batch.
+ *
+ * Raw PDUs are parsed in place, hex encoded ones are decoded to single
+ * reused buffer.
+ *
+ * Failure to decode single message is stored in its Error field and
+ * does not stop decoding of others.
+ *
+ * \param di Debug information structure.
+ * \param Batch Where to store results, needs to be freed using
+ * \ref GSM_FreePDUBatch.
+ * \param PDUs Array of PDU data.
+ * \param Lengths Lengths of PDU data (number of hex chars for hex data).
+ * \param Count Number of PDUs.
+ * \param Hex Whether PDUs are hex encoded.
+ * \param SMSC Whether PDUs include SMSC data.
+ *
+ * \return Error code, ERR_NONE even if some of messages failed to
+ * decode.
+ *
+ * \ingroup SMS
+ */
+GSM_Error GSM_DecodePDUBatch(GSM_Debug_Info *di, GSM_SMSPDUBatch *Batch,
+			const unsigned char * const *PDUs, const size_t *Lengths,
+			size_t Count, gboolean Hex, gboolean SMSC);
+
+/**
+ * Frees data allocated by \ref GSM_DecodePDUBatch.
+ *
+ * \ingroup SMS
+ */
+void GSM_FreePDUBatch(GSM_SMSPDUBatch *Batch);
+
 /**
  * Decodes SMS frame.
  *
@@ -674,6 +845,35 @@ void GSM_DecodeUDHHeader(GSM_Debug_Info * di, GSM_UDHHeader * UDH);
  */
 void GSM_EncodeUDHHeader(GSM_Debug_Info * di, GSM_UDHHeader * UDH);
 
+/**
+ * Appends national language shift information elements to encoded UDH.
+ * Call it after \ref GSM_EncodeUDHHeader, which rewrites the UDH. UDH
+ * of type UDH_NoUDH is changed to UDH_UserUDH.
+ *
+ * \param UDH Header to update.
+ * \param LockingShift Language of locking shift table.
+ * \param SingleShift Language of single shift table.
+ *
+ * \return ERR_MOREMEMORY if there is no room in the UDH, it is left
+ * untouched then and text must not be encoded using national tables.
+ *
+ * \ingroup SMS
+ */
+GSM_Error GSM_EncodeUDHNationalLanguage(GSM_UDHHeader * UDH,
+	GSM_NationalLanguage LockingShift, GSM_NationalLanguage SingleShift);
+
+/**
+ * Reads national language shift information elements from UDH.
+ *
+ * \param UDH Header to read.
+ * \param[out] LockingShift Language of locking shift table.
+ * \param[out] SingleShift Language of single shift table.
+ *
+ * \ingroup SMS
+ */
+void GSM_DecodeUDHNationalLanguage(const GSM_UDHHeader * UDH,
+	GSM_NationalLanguage * LockingShift, GSM_NationalLanguage * SingleShift);
+
 /**
  * Sets default content for SMS except for changing locations.
  * Use this for clearing structure while keeping location of message.
@@ -1014,6 +1214,16 @@ typedef struct {
 	unsigned char ReplaceMessage;
 	gboolean Unknown;
 	GSM_MultiPartSMSEntry Entries[GSM_MAX_MULTI_SMS];
+	/**
+	 * National language locking shift table for text in default
+	 * alphabet. Decoding sets it from the UDH, encoding of text which is
+	 * not automatically coded uses it.
+	 */
+	GSM_NationalLanguage LockingShift;
+	/**
+	 * National language single shift table, see LockingShift.
+	 */
+	GSM_NationalLanguage SingleShift;
 } GSM_MultiPartSMSInfo;
 
 /**
@@ -1065,6 +1275,8 @@ void GSM_FreeMultiPartSMSInfo(GSM_MultiPartSMSInfo * Info);
 /**
  * Links SMS messages according to IDs.
  *
+ * Only used parts (up to Number) of input messages are accessed.
+ *
  * \return Error code.
  *
  * \ingroup SMS
@@ -1232,6 +1444,40 @@ GSM_Error GSM_GetSMS(GSM_StateMachine * s, GSM_MultiSMSMessage * sms);
  */
 GSM_Error GSM_GetNextSMS(GSM_StateMachine * s, GSM_MultiSMSMessage * sms,
 			 gboolean start);
+
+/**
+ * Callback receiving messages from \ref GSM_GetAllSMS. The message is
+ * valid only during the callback and the callback must not communicate
+ * with the phone.
+ *
+ * \param s State machine pointer.
+ * \param sms Message read from phone.
+ * \param user_data Pointer passed to \ref GSM_GetAllSMS.
+ *
+ * \return Error code, anything else than ERR_NONE stops reading.
+ *
+ * \ingroup SMS
+ */
+typedef GSM_Error (*GSM_GetAllSMSCallback) (GSM_StateMachine *s, GSM_MultiSMSMessage *sms, void *user_data);
+
+/**
+ * Reads all SMS messages from phone and passes them to callback. AT
+ * phones list all messages from each memory at once, for other
+ * phones this falls back to \ref GSM_GetNextSMS. Corrupted messages
+ * are skipped.
+ *
+ * Please note that this commend does not have to mark message as read
+ * in phone. To do so, you have to call \ref GSM_GetSMS.
+ *
+ * \param s State machine pointer.
+ * \param callback Function called for each message.
+ * \param user_data Pointer passed to callback.
+ *
+ * \return Error code, error returned by callback is passed back.
+ *
+ * \ingroup SMS
+ */
+GSM_Error GSM_GetAllSMS(GSM_StateMachine *s, GSM_GetAllSMSCallback callback, void *user_data);
 /**
  * Sets SMS.
  *
@@ -1422,6 +1668,110 @@ GSM_Error GSM_SetIncomingUSSD(GSM_StateMachine * s, gboolean enable);
 void GSM_SMSCounter(GSM_Debug_Info *di, unsigned char *MessageBuffer,
 	GSM_UDH UDHType, GSM_Coding_Type Coding, int *SMSNum, size_t *CharsLeft);
 
+/**
+ * Information how text is split into messages, see
+ * \ref GSM_SplitSMSText.
+ *
+ * \ingroup SMS
+ */
+typedef struct {
+	/**
+	 * Coding used for the text.
+	 */
+	GSM_Coding_Type Coding;
+	/**
+	 * Language of national locking shift table for default alphabet.
+	 */
+	GSM_NationalLanguage LockingShift;
+	/**
+	 * Language of national single shift table for default alphabet.
+	 */
+	GSM_NationalLanguage SingleShift;
+	/**
+	 * Length of UDH in each message, including national language
+	 * information elements.
+	 */
+	int UDHLength;
+	/**
+	 * Space for text in each message, in septets for default alphabet,
+	 * chars for Unicode and bytes for 8-bit coding.
+	 */
+	size_t Capacity;
+	/**
+	 * Number of messages needed, can be more than GSM_MAX_MULTI_SMS.
+	 */
+	int Parts;
+	/**
+	 * Free space in the last message, in same units as Capacity.
+	 */
+	size_t CharsLeft;
+	/**
+	 * Position in text where each message starts, message i ends at
+	 * Start[i + 1]. Filled for first GSM_MAX_MULTI_SMS messages.
+	 */
+	size_t Start[GSM_MAX_MULTI_SMS + 1];
+	/**
+	 * Space used in each message, in same units as Capacity.
+	 */
+	size_t Used[GSM_MAX_MULTI_SMS];
+} GSM_SMSSplitInfo;
+
+/**
+ * Calculates how text will be split into messages without encoding
+ * them. Text is processed in single pass, the split is same as the
+ * one done by \ref GSM_EncodeMultiPartSMS for given coding.
+ *
+ * \param di Debug settings.
+ * \param[in] Text Message text in Unicode, raw data for 8-bit coding.
+ * \param[in] Length Length of text in chars (bytes for 8-bit coding).
+ * \param[in] UDHType UDH type used in each message.
+ * \param[in] Coding GSM Encoding type, 0 to choose default alphabet
+ * if text can be stored in it, otherwise national language tables or
+ * Unicode, whichever needs less messages.
+ * \param[out] Info Information about split messages.
+ *
+ * \return Error code, ERR_NOTSUPPORTED for compressed codings.
+ *
+ * \ingroup SMS
+ */
+GSM_Error GSM_SplitSMSText(GSM_Debug_Info *di, const unsigned char *Text,
+	size_t Length, GSM_UDH UDHType, GSM_Coding_Type Coding,
+	GSM_SMSSplitInfo *Info);
+
+/**
+ * Callback receiving messages from \ref GSM_EncodeSplitSMS. The
+ * message is valid only during the callback.
+ *
+ * \param SMS Encoded message.
+ * \param user_data Pointer passed to \ref GSM_EncodeSplitSMS.
+ *
+ * \return Error code, anything else than ERR_NONE stops encoding.
+ *
+ * \ingroup SMS
+ */
+typedef GSM_Error (*GSM_SMSPartCallback) (GSM_SMSMessage *SMS, void *user_data);
+
+/**
+ * Encodes text split by \ref GSM_SplitSMSText and passes messages one
+ * by one to the callback, so that no GSM_MultiSMSMessage is needed.
+ *
+ * \param di Debug settings.
+ * \param[in] Text Same text as passed to \ref GSM_SplitSMSText.
+ * \param[in] Info Result of \ref GSM_SplitSMSText.
+ * \param[in] UDHType Same UDH type as passed to \ref GSM_SplitSMSText.
+ * \param[in] Class Message class, -1 for none.
+ * \param[in] Callback Function receiving encoded messages.
+ * \param[in] user_data Pointer passed to the callback.
+ *
+ * \return Error code, ERR_MOREMEMORY if text needs more than
+ * GSM_MAX_MULTI_SMS messages, or error returned by the callback.
+ *
+ * \ingroup SMS
+ */
+GSM_Error GSM_EncodeSplitSMS(GSM_Debug_Info *di, const unsigned char *Text,
+	const GSM_SMSSplitInfo *Info, GSM_UDH UDHType, int Class,
+	GSM_SMSPartCallback Callback, void *user_data);
+
 #endif
 
 /* Editor configuration
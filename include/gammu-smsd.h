@@ -88,6 +88,22 @@ typedef struct {
  */
 GSM_Error SMSD_InjectSMS(GSM_SMSDConfig * Config, GSM_MultiSMSMessage * sms, char *NewID);
 
+/**
+ * Enqueues several SMS messages in SMS daemon queue at once. Backends
+ * supporting transactions store either all messages or none of them.
+ *
+ * \param Config SMSD configuration pointer.
+ * \param sms Array of messages to send.
+ * \param count Number of messages in the array.
+ * \param injected Pointer where number of stored messages will be
+ * written. Can be NULL and then it is ignored.
+ *
+ * \return Error code
+ *
+ * \ingroup SMSD
+ */
+GSM_Error SMSD_InjectSMSBatch(GSM_SMSDConfig * Config, GSM_MultiSMSMessage * sms, size_t count, size_t *injected);
+
 /**
  * Gets SMSD status via shared memory.
  *
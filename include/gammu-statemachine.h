@@ -101,6 +101,25 @@ typedef struct {
 	 * Phone features override.
 	 */
 	GSM_Feature PhoneFeatures[GSM_MAX_PHONE_FEATURES + 1];
+	/**
+	 * Path to file where detected phone capabilities are cached, NULL
+	 * or empty string disables the cache. It has to be allocated by
+	 * malloc, it is freed by \ref GSM_FreeStateMachine and
+	 * \ref GSM_ReadConfig.
+	 */
+	char *CapabilityCache;
+	/**
+	 * Path to file where raw device traffic is recorded, NULL or empty
+	 * string disables recording. Sessions are appended to existing
+	 * file. It has to be allocated by malloc, it is freed by
+	 * \ref GSM_FreeStateMachine and \ref GSM_ReadConfig.
+	 */
+	char *DeviceTrace;
+	/**
+	 * Percentage of recorded delays used when replaying device trace,
+	 * 0 replays without any delays.
+	 */
+	int ReplayTiming;
 } GSM_Config;
 
 /**
@@ -130,7 +149,13 @@ typedef enum {
 	GCT_BLUEOBEX,
 	GCT_FBUS2USB,
 	GCT_BLUES60,
-	GCT_NONE
+	GCT_NONE,
+	GCT_TCPAT,
+	GCT_UNIXAT,
+	GCT_TCPFBUS2,
+	GCT_UNIXFBUS2,
+	GCT_TCPOBEX,
+	GCT_UNIXOBEX
 } GSM_ConnectionType;
 
 /**
@@ -206,6 +231,19 @@ int GSM_ReadDevice(GSM_StateMachine * s, gboolean waitforreply);
  */
 gboolean GSM_IsConnected(GSM_StateMachine * s);
 
+/**
+ * Returns file descriptor of opened device, which can be used for
+ * waiting for incoming data using select() or poll(). Once the
+ * descriptor is readable, call \ref GSM_ReadDevice to process the data.
+ *
+ * \ingroup StateMachine
+ *
+ * \param s State machine data
+ * \return File descriptor or -1 if not connected or the connection
+ * does not use a descriptor (eg. USB or any connection on Windows).
+ */
+int GSM_GetDeviceDescriptor(GSM_StateMachine * s);
+
 /**
  * Finds and reads gammu configuration file. The search order depends on
  * platform. On POSIX systems it looks for ~/.gammurc and then for
@@ -150,6 +150,32 @@ gboolean EncodeUTF8(char *dest, const unsigned char *src);
  */
 void DecodeUTF8(unsigned char *dest, const char *src, int len);
 
+/**
+ * Encodes text of given length to UTF-8, characters outside BMP are
+ * expected as UTF-16 surrogate pairs.
+ *
+ * \param dest Output buffer, needs space for len * 3 + 1 bytes.
+ * \param src Unicode text, does not have to be terminated.
+ * \param len Number of chars in src.
+ * \return Number of bytes written, not counting terminating zero.
+ *
+ * \ingroup Unicode
+ */
+size_t EncodeUTF8Len(char *dest, const unsigned char *src, size_t len);
+
+/**
+ * Decodes UTF-8 text of given length, characters outside BMP are
+ * stored as UTF-16 surrogate pairs.
+ *
+ * \param dest Output buffer, needs space for (len + 1) * 2 bytes.
+ * \param src UTF-8 text, does not have to be terminated.
+ * \param len Number of bytes in src.
+ * \return Number of chars written, not counting terminating zero.
+ *
+ * \ingroup Unicode
+ */
+size_t DecodeUTF8Len(unsigned char *dest, const char *src, size_t len);
+
 /**
  * Decode hex encoded binary text.
  *
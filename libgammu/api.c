@@ -1,4 +1,5 @@
 #include <string.h>
+#include <stdlib.h>
 
 #include <gammu.h>
 #include "gsmstate.h"
@@ -534,6 +535,56 @@ GSM_Error GSM_GetNextMemory(GSM_StateMachine *s, GSM_MemoryEntry *entry, gboolea
 	PRINT_LOG_ERROR(err);
 	return err;
 }
+/**
+ * Reports all memory entries as changed, used when phone does not
+ * provide change log.
+ */
+static GSM_Error GSM_GetAllMemoryChanges(GSM_StateMachine *s, GSM_MemoryType type, GSM_MemoryChangeCallback callback, void *user_data)
+{
+	GSM_Error err;
+	GSM_MemoryEntry *entry;
+	gboolean start = TRUE;
+
+	entry = (GSM_MemoryEntry *)malloc(sizeof(GSM_MemoryEntry));
+	if (entry == NULL) {
+		return ERR_MOREMEMORY;
+	}
+
+	err = callback(s, GSM_Change_Reset, NULL, user_data);
+	while (err == ERR_NONE) {
+		entry->MemoryType = type;
+		err = s->Phone.Functions->GetNextMemory(s, entry, start);
+		if (err == ERR_EMPTY) {
+			err = ERR_NONE;
+			break;
+		}
+		if (err != ERR_NONE) {
+			break;
+		}
+		start = FALSE;
+		err = callback(s, GSM_Change_Modified, entry, user_data);
+		GSM_FreeMemoryEntry(entry);
+	}
+
+	free(entry);
+	return err;
+}
+/**
+ * Reports memory entries changed since state stored in state file.
+ */
+GSM_Error GSM_GetMemoryChanges(GSM_StateMachine *s, GSM_MemoryType type, const char *state_file, GSM_MemoryChangeCallback callback, void *user_data)
+{
+	GSM_Error err;
+
+	CHECK_PHONE_CONNECTION();
+
+	err = s->Phone.Functions->GetMemoryChanges(s, type, state_file, callback, user_data);
+	if (err == ERR_NOTIMPLEMENTED) {
+		err = GSM_GetAllMemoryChanges(s, type, callback, user_data);
+	}
+	PRINT_LOG_ERROR(err);
+	return err;
+}
 /**
  * Sets memory (phonebooks or calls) entry.
  */
@@ -685,6 +736,63 @@ GSM_Error GSM_GetNextSMS(GSM_StateMachine *s, GSM_MultiSMSMessage *sms, gboolean
 	PRINT_LOG_ERROR(err);
 	return err;
 }
+/**
+ * Reads all SMS messages using GetNextSMS, used for phones which can
+ * not do better.
+ */
+static GSM_Error GSM_GetAllSMSIterate(GSM_StateMachine *s, GSM_GetAllSMSCallback callback, void *user_data)
+{
+	GSM_MultiSMSMessage *sms;
+	GSM_Error err;
+	gboolean start = TRUE;
+
+	sms = (GSM_MultiSMSMessage *)malloc(sizeof(GSM_MultiSMSMessage));
+	if (sms == NULL) {
+		return ERR_MOREMEMORY;
+	}
+	sms->Number = 0;
+	sms->SMS[0].Location = 0;
+
+	while (TRUE) {
+		sms->SMS[0].Folder = 0;
+		err = s->Phone.Functions->GetNextSMS(s, sms, start);
+		start = FALSE;
+		if (err == ERR_EMPTY) {
+			err = ERR_NONE;
+			break;
+		}
+		if (err == ERR_CORRUPTED) {
+			smprintf(s, "Corrupted message, skipping\n");
+			continue;
+		}
+		if (err != ERR_NONE) {
+			break;
+		}
+		err = callback(s, sms, user_data);
+		if (err != ERR_NONE) {
+			break;
+		}
+	}
+
+	free(sms);
+	return err;
+}
+/**
+ * Reads all SMS messages.
+ */
+GSM_Error GSM_GetAllSMS(GSM_StateMachine *s, GSM_GetAllSMSCallback callback, void *user_data)
+{
+	GSM_Error err;
+
+	CHECK_PHONE_CONNECTION();
+
+	err = s->Phone.Functions->GetAllSMS(s, callback, user_data);
+	if (err == ERR_NOTIMPLEMENTED) {
+		err = GSM_GetAllSMSIterate(s, callback, user_data);
+	}
+	PRINT_LOG_ERROR(err);
+	return err;
+}
 /**
  * Sets SMS.
  */
@@ -1441,6 +1549,54 @@ GSM_Error GSM_GetNextCalendar(GSM_StateMachine *s, GSM_CalendarEntry *Note, gboo
 	PRINT_LOG_ERROR(err);
 	return err;
 }
+/**
+ * Reports all calendar entries as changed, used when phone does not
+ * provide change log.
+ */
+static GSM_Error GSM_GetAllCalendarChanges(GSM_StateMachine *s, GSM_CalendarChangeCallback callback, void *user_data)
+{
+	GSM_Error err;
+	GSM_CalendarEntry *note;
+	gboolean start = TRUE;
+
+	note = (GSM_CalendarEntry *)malloc(sizeof(GSM_CalendarEntry));
+	if (note == NULL) {
+		return ERR_MOREMEMORY;
+	}
+
+	err = callback(s, GSM_Change_Reset, NULL, user_data);
+	while (err == ERR_NONE) {
+		err = s->Phone.Functions->GetNextCalendar(s, note, start);
+		if (err == ERR_EMPTY) {
+			err = ERR_NONE;
+			break;
+		}
+		if (err != ERR_NONE) {
+			break;
+		}
+		start = FALSE;
+		err = callback(s, GSM_Change_Modified, note, user_data);
+	}
+
+	free(note);
+	return err;
+}
+/**
+ * Reports calendar entries changed since state stored in state file.
+ */
+GSM_Error GSM_GetCalendarChanges(GSM_StateMachine *s, const char *state_file, GSM_CalendarChangeCallback callback, void *user_data)
+{
+	GSM_Error err;
+
+	CHECK_PHONE_CONNECTION();
+
+	err = s->Phone.Functions->GetCalendarChanges(s, state_file, callback, user_data);
+	if (err == ERR_NOTIMPLEMENTED) {
+		err = GSM_GetAllCalendarChanges(s, callback, user_data);
+	}
+	PRINT_LOG_ERROR(err);
+	return err;
+}
 /**
  * Sets calendar entry
  */
@@ -1778,6 +1934,112 @@ GSM_Error GSM_SendFilePart(GSM_StateMachine *s, GSM_File *File, int *Pos, int *H
 	PRINT_LOG_ERROR(err);
 	return err;
 }
+/**
+ * Reads file by parts for drivers not supporting streaming.
+ *
+ * Data are released as soon as they are passed to sink, so received
+ * parts are not kept for whole transfer. Drivers which need whole file
+ * in buffer (for example to verify checksum) have to implement
+ * GetFileStream.
+ */
+static GSM_Error GSM_GetFileStreamParts(GSM_StateMachine *s, GSM_File *File, GSM_FileSink sink, void *user_data)
+{
+	GSM_Error err, sinkerr;
+	int Handle = 0, Size = 0;
+	size_t old;
+
+	File->Used = 0;
+	File->Buffer = NULL;
+
+	do {
+		old = File->Used;
+		err = s->Phone.Functions->GetFilePart(s, File, &Handle, &Size);
+		if (err != ERR_NONE && err != ERR_EMPTY && err != ERR_WRONGCRC) {
+			break;
+		}
+		if (File->Used > old) {
+			sinkerr = sink(s, File, File->Buffer + old, File->Used - old, Size > 0 ? Size : 0, user_data);
+			if (sinkerr != ERR_NONE) {
+				err = sinkerr;
+			}
+		}
+		free(File->Buffer);
+		File->Buffer = NULL;
+	} while (err == ERR_NONE);
+
+	free(File->Buffer);
+	File->Buffer = NULL;
+
+	if (err == ERR_EMPTY) {
+		return ERR_NONE;
+	}
+	return err;
+}
+/**
+ * Reads file passing its data to sink.
+ */
+GSM_Error GSM_GetFileStream(GSM_StateMachine *s, GSM_File *File, GSM_FileSink sink, void *user_data)
+{
+	GSM_Error err;
+
+	CHECK_PHONE_CONNECTION();
+
+	err = s->Phone.Functions->GetFileStream(s, File, sink, user_data);
+	if (err == ERR_NOTIMPLEMENTED) {
+		err = GSM_GetFileStreamParts(s, File, sink, user_data);
+	}
+	PRINT_LOG_ERROR(err);
+	return err;
+}
+/**
+ * Adds file by parts for drivers not supporting streaming, these
+ * need whole file in memory.
+ */
+static GSM_Error GSM_AddFileStreamParts(GSM_StateMachine *s, GSM_File *File, GSM_FileSource source, void *user_data)
+{
+	GSM_Error err;
+	int Pos = 0, Handle = 0;
+
+	File->Buffer = NULL;
+	if (File->Used > 0) {
+		File->Buffer = (unsigned char *)malloc(File->Used);
+		if (File->Buffer == NULL) {
+			return ERR_MOREMEMORY;
+		}
+		err = source(s, File, File->Buffer, File->Used, user_data);
+		if (err != ERR_NONE) {
+			goto done;
+		}
+	}
+
+	do {
+		err = s->Phone.Functions->AddFilePart(s, File, &Pos, &Handle);
+	} while (err == ERR_NONE);
+
+	if (err == ERR_EMPTY) {
+		err = ERR_NONE;
+	}
+done:
+	free(File->Buffer);
+	File->Buffer = NULL;
+	return err;
+}
+/**
+ * Adds file reading its data from source.
+ */
+GSM_Error GSM_AddFileStream(GSM_StateMachine *s, GSM_File *File, GSM_FileSource source, void *user_data)
+{
+	GSM_Error err;
+
+	CHECK_PHONE_CONNECTION();
+
+	err = s->Phone.Functions->AddFileStream(s, File, source, user_data);
+	if (err == ERR_NOTIMPLEMENTED) {
+		err = GSM_AddFileStreamParts(s, File, source, user_data);
+	}
+	PRINT_LOG_ERROR(err);
+	return err;
+}
 /**
  * Acquires filesystem status.
  */
@@ -27,7 +27,9 @@ GSM_Debug_Info GSM_none_debug = {
 	FALSE,
 	FALSE,
 	NULL,
-	NULL
+	NULL,
+	0,
+	""
 	};
 
 GSM_Debug_Info GSM_global_debug = {
@@ -38,7 +40,9 @@ GSM_Debug_Info GSM_global_debug = {
 	FALSE,
 	FALSE,
 	NULL,
-	NULL
+	NULL,
+	0,
+	""
 	};
 
 /**
@@ -49,18 +53,74 @@ void dbg_write(GSM_Debug_Info *d, const char *text)
 	if (d->log_function != NULL) {
 		d->log_function(text, d->user_data);
 	} else if (d->df != NULL) {
-		fprintf(d->df, "%s", text);
+		fputs(text, d->df);
+	}
+}
+
+/**
+ * Returns debug structure which should be really used for output.
+ */
+static GSM_Debug_Info *dbg_resolve(GSM_Debug_Info *d)
+{
+	if (d == NULL || d->use_global) {
+		return &GSM_global_debug;
 	}
+	return d;
+}
+
+gboolean dbg_text_enabled(GSM_Debug_Info *d)
+{
+	d = dbg_resolve(d);
+	return d->dl != DL_NONE && d->dl != DL_BINARY;
+}
+
+void dbg_flush(GSM_Debug_Info *d)
+{
+	if (d->df == NULL) {
+		return;
+	}
+
+	/*
+	 * Flush whenever message is complete, so that the log tail is not
+	 * lost on crash or while program is idle. Only partial lines stay
+	 * buffered, binary dumps have no lines at all.
+	 */
+	if (d->was_lf || d->dl == DL_BINARY) {
+		fflush(d->df);
+	}
+}
+
+/**
+ * Writes timestamp prefix for dated debug levels.
+ *
+ * The timestamp has second resolution, so it is formatted only once
+ * per second.
+ */
+static void dbg_write_timestamp(GSM_Debug_Info *d)
+{
+	GSM_DateTime 		date_time;
+	time_t			now;
+
+	now = time(NULL);
+	if (now != d->stamp_time || d->stamp[0] == 0) {
+		GSM_GetCurrentDateTime(&date_time);
+		snprintf(d->stamp, sizeof(d->stamp), "%s %4d/%02d/%02d %02d:%02d:%02d: ",
+			DayOfWeek(date_time.Year, date_time.Month, date_time.Day),
+			date_time.Year, date_time.Month, date_time.Day,
+			date_time.Hour, date_time.Minute, date_time.Second);
+		d->stamp_time = now;
+	}
+	dbg_write(d, d->stamp);
 }
 
 PRINTF_STYLE(2, 0)
 int dbg_vprintf(GSM_Debug_Info *d, const char *format, va_list argp)
 {
 	int 			result=0;
-	char			buffer[3000], timestamp[60];
+	char			buffer[3000];
 	char			*pos, *end;
 	char			save = 0;
-	GSM_DateTime 		date_time;
+	size_t			length;
 	Debug_Level		l;
 
 	l = d->dl;
@@ -70,21 +130,31 @@ int dbg_vprintf(GSM_Debug_Info *d, const char *format, va_list argp)
 	result = vsnprintf(buffer, sizeof(buffer) - 1, format, argp);
 	pos = buffer;
 
+	/*
+	 * Without timestamps and callback we can write the whole message
+	 * at once, there is no need to handle separate lines.
+	 */
+	if (d->log_function == NULL &&
+			l != DL_TEXTALLDATE && l != DL_TEXTERRORDATE && l != DL_TEXTDATE) {
+		length = strlen(buffer);
+		if (length > 0 && d->df != NULL) {
+			fwrite(buffer, 1, length, d->df);
+			d->was_lf = (buffer[length - 1] == '\n');
+			dbg_flush(d);
+		}
+		return result;
+	}
+
 	while (*pos != 0) {
 
 		/* Find new line in string */
-		end = strstr(pos, "\n");
+		end = strchr(pos, '\n');
 
 		/* Are we at start of line? */
 		if (d->was_lf) {
 			/* Show date? */
 			if (l == DL_TEXTALLDATE || l == DL_TEXTERRORDATE || l == DL_TEXTDATE) {
-				GSM_GetCurrentDateTime(&date_time);
-				sprintf(timestamp, "%s %4d/%02d/%02d %02d:%02d:%02d: ",
-					DayOfWeek(date_time.Year, date_time.Month, date_time.Day),
-					date_time.Year, date_time.Month, date_time.Day,
-					date_time.Hour, date_time.Minute, date_time.Second);
-				dbg_write(d, timestamp);
+				dbg_write_timestamp(d);
 			}
 			d->was_lf = FALSE;
 		}
@@ -114,18 +184,31 @@ int dbg_vprintf(GSM_Debug_Info *d, const char *format, va_list argp)
 		}
 	}
 
-	/* Flush buffers, this might be configurable, but it could cause drop of last log messages */
-	if (d->df != NULL) {
-		fflush(d->df);
-	}
+	dbg_flush(d);
 
 	return result;
 }
 
+void dbg_write_binary(GSM_Debug_Info *d, const unsigned char *data, const size_t length)
+{
+	d = dbg_resolve(d);
+
+	if (d->dl != DL_BINARY || d->df == NULL || length == 0) {
+		return;
+	}
+	fwrite(data, 1, length, d->df);
+	dbg_flush(d);
+}
+
 GSM_Error GSM_SetDebugFileDescriptor(FILE *fd, gboolean closable, GSM_Debug_Info *privdi)
 {
 	privdi->was_lf = TRUE;
 
+	/* Write out anything what might be still buffered */
+	if (privdi->df != NULL) {
+		fflush(privdi->df);
+	}
+
 	if (privdi->df != NULL
 			&& fileno(privdi->df) != fileno(stderr)
 			&& fileno(privdi->df) != fileno(stdout)
@@ -243,11 +326,7 @@ int smfprintf(GSM_Debug_Info *d, const char *format, ...)
 	int 			result;
 	GSM_Debug_Info		*tmpdi;
 
-	if (d == NULL || d->use_global) {
-		tmpdi = &GSM_global_debug;
-	} else {
-		tmpdi = d;
-	}
+	tmpdi = dbg_resolve(d);
 
 	va_start(argp, format);
 	result = dbg_vprintf(tmpdi, format, argp);
@@ -313,9 +392,13 @@ int smprintf_level(GSM_StateMachine * s, GSM_DebugSeverity severity, const char
 /* Dumps a message */
 void DumpMessage(GSM_Debug_Info *d, const unsigned char *message, const int messagesize)
 {
+	static const char hex[] = "0123456789ABCDEF";
 	int i, j = 0;
 	char buffer[(CHARS_PER_LINE * 5) + 1];
 
+	/* Formatting the dump is expensive, skip it if nobody will see it */
+	if (!dbg_text_enabled(d)) return;
+
 	smfprintf(d, "\n");
 
 	if (messagesize == 0) return;
@@ -325,8 +408,9 @@ void DumpMessage(GSM_Debug_Info *d, const unsigned char *message, const int mess
 
 	for (i = 0; i < messagesize; i++) {
 		/* Write hex number */
-		snprintf(buffer + (j * 4), 3, "%02X", message[i]);
-		buffer[(j * 4) + 2] = ' '; /* wipe snprintf's \0 */
+		buffer[(j * 4)] = hex[message[i] >> 4];
+		buffer[(j * 4) + 1] = hex[message[i] & 0x0f];
+		buffer[(j * 4) + 2] = ' ';
 
 		/* Write char if possible */
 		if (isprint(message[i])
@@ -3,6 +3,7 @@
 
 #include <gammu-debug.h>
 #include <stdarg.h>
+#include <time.h>
 
 /* ------------------------------------------------------------------------- */
 
@@ -13,6 +14,27 @@ extern GSM_Debug_Info	GSM_none_debug;
 void DumpMessage(GSM_Debug_Info *d, const unsigned char *message, const int messagesize);
 void DumpMessageText(GSM_Debug_Info *d, const unsigned char *message, const int messagesize);
 
+/**
+ * Returns whether text messages would end up in debug log.
+ *
+ * Use this to avoid expensive preparation of debug output which would
+ * be thrown away anyway.
+ */
+gboolean dbg_text_enabled(GSM_Debug_Info *d);
+
+/**
+ * Writes raw data to binary debug log.
+ *
+ * Unlike smprintf with %c, this also handles zero bytes and does not
+ * go through formatting.
+ */
+void dbg_write_binary(GSM_Debug_Info *d, const unsigned char *data, const size_t length);
+
+/**
+ * Flushes pending debug output.
+ */
+void dbg_flush(GSM_Debug_Info *d);
+
 
 /* ------------------------------------------------------------------------- */
 
@@ -46,6 +68,14 @@ struct _GSM_Debug_Info {
      * User data to be passed to callback.
      */
     void * user_data;
+	/**
+	 * Time for which timestamp was last generated.
+	 */
+	time_t		stamp_time;
+	/**
+	 * Cached timestamp prefix for dated log levels.
+	 */
+	char		stamp[60];
 };
 
 
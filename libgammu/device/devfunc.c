@@ -130,18 +130,25 @@ int bluetooth_checkservicename(GSM_StateMachine *s, const char *name)
 #endif
 #endif
 
-#if defined (GSM_ENABLE_BLUETOOTHDEVICE) || defined (GSM_ENABLE_IRDADEVICE)
+#if defined (GSM_ENABLE_BLUETOOTHDEVICE) || defined (GSM_ENABLE_IRDADEVICE) || defined (GSM_ENABLE_SOCKETDEVICE)
 
 /* Windows do not have this, but we don't seem to need it there */
 #ifndef MSG_DONTWAIT
 #define MSG_DONTWAIT 0
 #endif
 
-int socket_read(GSM_StateMachine *s UNUSED, void *buf, size_t nbytes, socket_type hPhone)
+/* Do not get killed by SIGPIPE when peer closes connection, platforms
+ * without MSG_NOSIGNAL set SO_NOSIGPIPE on the socket instead */
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+int socket_read(GSM_StateMachine *s, void *buf, size_t nbytes, socket_type hPhone)
 {
 	fd_set 		readfds;
 	int result = 0;
 	struct timeval 	timer;
+	gboolean	closed;
 
 	FD_ZERO(&readfds);
 	FD_SET(hPhone, &readfds);
@@ -151,11 +158,26 @@ int socket_read(GSM_StateMachine *s UNUSED, void *buf, size_t nbytes, socket_typ
 
 	if (select(hPhone + 1, &readfds, NULL, NULL, &timer) > 0) {
 		result = recv(hPhone, buf, nbytes, MSG_DONTWAIT);
-#ifndef WIN32
-		if (result < 0 && errno != EINTR) {
- 			return 0;
- 		}
+		/* Socket is readable, but there is nothing to read */
+		if (result == 0 && nbytes > 0) {
+			smprintf(s, "Connection closed by peer\n");
+			return -1;
+		}
+		if (result < 0) {
+#ifdef WIN32
+			result = WSAGetLastError();
+			closed = (result == WSAECONNRESET || result == WSAECONNABORTED ||
+				result == WSAENETRESET || result == WSAENOTCONN);
+#else
+			closed = (errno == ECONNRESET || errno == ENOTCONN);
 #endif
+			/* Interrupted or not yet ready read, just no data */
+			if (!closed) {
+				return 0;
+			}
+			smprintf(s, "Connection reset by peer\n");
+			return -1;
+		}
 	}
 
 	return result;
@@ -167,7 +189,7 @@ int socket_write(GSM_StateMachine *s, unsigned const char *buf, size_t nbytes, s
 	size_t		actual = 0;
 
 	do {
-		ret = send(hPhone, buf, nbytes - actual, 0);
+		ret = send(hPhone, buf, nbytes - actual, MSG_NOSIGNAL);
         	if (ret < 0) {
             		if (actual != nbytes) {
 				GSM_OSErrorInfo(s,"socket_write");
@@ -12,7 +12,7 @@ int bluetooth_checkservicename(GSM_StateMachine *s, const char *name);
 #endif
 #endif
 
-#if defined (GSM_ENABLE_BLUETOOTHDEVICE) || defined (GSM_ENABLE_IRDADEVICE)
+#if defined (GSM_ENABLE_BLUETOOTHDEVICE) || defined (GSM_ENABLE_IRDADEVICE) || defined (GSM_ENABLE_SOCKETDEVICE)
 
 int socket_read(GSM_StateMachine *s, void *buf, size_t nbytes, socket_type hPhone);
 
@@ -0,0 +1,448 @@
+/* (c) 2015 Gammu contributors */
+
+/**
+ * \file replay.c
+ *
+ * Recording and replaying of raw device traffic.
+ *
+ * When DeviceTrace is configured, everything read from and written to
+ * the device is stored in text trace, one record per line:
+ *
+ * \verbatim
+ * # Gammu 1.35.90 device trace
+ * connection at
+ * # Session started Sun Oct 18 16:14:26 2015
+ * O 0.000000
+ * W 0.000120 41540D
+ * R 0.003560 0D0A4F4B0D0A
+ * \endverbatim
+ *
+ * Records are opening of the device (O), data read (R) and written (W)
+ * with hex encoded data, each with time in seconds since start of the
+ * recording. Replay connection serves the reads back with recorded delays
+ * scaled by ReplayTiming and checks that writes match the trace.
+ *
+ * Recording appends to existing trace, so that reconnecting does not
+ * overwrite previous sessions, each session starts with a comment and
+ * its times are counted from its start. Replay continues where the
+ * previous connection of the same state machine stopped.
+ */
+
+#include <gammu-config.h>
+
+#include "../../gsmstate.h"
+#include "../../gsmcomon.h"
+#include "../../debug.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#ifdef WIN32
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#else
+#  include <sys/time.h>
+#endif
+
+#ifdef HAVE_UNISTD_H
+#  include <unistd.h>
+#endif
+
+/**
+ * Returns current time in seconds.
+ */
+static double replay_now(void)
+{
+#ifdef WIN32
+	return GetTickCount() / 1000.0;
+#else
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+#endif
+}
+
+/**
+ * Writes trace record, data are split to more records if needed.
+ */
+static void record_write_record(GSM_StateMachine *s, char direction, const unsigned char *data, size_t length)
+{
+	GSM_Device_ReplayData *d = &s->Device.Replay;
+	char hex[REPLAY_MAX_RECORD * 2 + 1];
+	double now;
+	long sec, usec;
+	size_t chunk;
+
+	now = replay_now() - d->Start;
+	sec = (long)now;
+	usec = (long)((now - sec) * 1000000);
+
+	do {
+		chunk = length > REPLAY_MAX_RECORD ? REPLAY_MAX_RECORD : length;
+		EncodeHexBin(hex, data, chunk);
+		fprintf(d->File, "%c %ld.%06ld%s%s\n", direction, sec, usec, chunk > 0 ? " " : "", hex);
+		data += chunk;
+		length -= chunk;
+	} while (length > 0);
+
+	/* Keep the trace usable even if we crash */
+	fflush(d->File);
+}
+
+static GSM_Error record_open(GSM_StateMachine *s)
+{
+	GSM_Device_ReplayData *d = &s->Device.Replay;
+	GSM_Error error;
+	time_t now;
+
+	error = s->Device.RecordedFunctions->OpenDevice(s);
+	if (error != ERR_NONE) {
+		return error;
+	}
+
+	if (d->File == NULL) {
+		d->File = fopen(s->CurrentConfig->DeviceTrace, "a");
+		if (d->File == NULL) {
+			smprintf(s, "Failed to create device trace %s\n", s->CurrentConfig->DeviceTrace);
+			s->Device.RecordedFunctions->CloseDevice(s);
+			return ERR_CANTOPENFILE;
+		}
+		d->Start = replay_now();
+
+		/* Header is written only to new trace */
+		fseek(d->File, 0, SEEK_END);
+		if (ftell(d->File) == 0) {
+			fprintf(d->File, "# Gammu %s device trace\n", GAMMU_VERSION);
+			fprintf(d->File, "connection %s\n", s->CurrentConfig->Connection);
+		}
+		now = time(NULL);
+		fprintf(d->File, "# Session started %s", ctime(&now));
+	}
+
+	record_write_record(s, 'O', NULL, 0);
+
+	return ERR_NONE;
+}
+
+static GSM_Error record_close(GSM_StateMachine *s)
+{
+	return s->Device.RecordedFunctions->CloseDevice(s);
+}
+
+static GSM_Error record_setparity(GSM_StateMachine *s, gboolean parity)
+{
+	return s->Device.RecordedFunctions->DeviceSetParity(s, parity);
+}
+
+static GSM_Error record_setdtrrts(GSM_StateMachine *s, gboolean dtr, gboolean rts)
+{
+	return s->Device.RecordedFunctions->DeviceSetDtrRts(s, dtr, rts);
+}
+
+static GSM_Error record_setspeed(GSM_StateMachine *s, int speed)
+{
+	return s->Device.RecordedFunctions->DeviceSetSpeed(s, speed);
+}
+
+static int record_read(GSM_StateMachine *s, void *buf, size_t nbytes)
+{
+	int result;
+
+	result = s->Device.RecordedFunctions->ReadDevice(s, buf, nbytes);
+	if (result > 0) {
+		record_write_record(s, 'R', buf, result);
+	}
+	return result;
+}
+
+static int record_write(GSM_StateMachine *s, const void *buf, size_t nbytes)
+{
+	int result;
+
+	result = s->Device.RecordedFunctions->WriteDevice(s, buf, nbytes);
+	if (result > 0) {
+		record_write_record(s, 'W', buf, result);
+	}
+	return result;
+}
+
+/**
+ * Reads next record from the trace.
+ */
+static GSM_Error replay_next(GSM_StateMachine *s)
+{
+	GSM_Device_ReplayData *d = &s->Device.Replay;
+	char line[REPLAY_MAX_RECORD * 2 + 100];
+	char direction;
+	long sec, usec;
+	size_t length;
+	int pos;
+
+	d->Direction = 0;
+	d->Length = 0;
+	d->Position = 0;
+
+	while (fgets(line, sizeof(line), d->File) != NULL) {
+		d->Line++;
+
+		/* Comments, header and empty lines */
+		if (line[0] == '#' || strncmp(line, "connection ", 11) == 0 ||
+				line[0] == '\n' || line[0] == '\r') {
+			continue;
+		}
+
+		if (sscanf(line, "%c %ld.%ld%n", &direction, &sec, &usec, &pos) != 3 ||
+				(direction != 'O' && direction != 'R' && direction != 'W')) {
+			smprintf(s, "Invalid record on line %d of device trace\n", d->Line);
+			return ERR_FILENOTSUPPORTED;
+		}
+
+		/* Hex encoded data */
+		while (line[pos] == ' ') {
+			pos++;
+		}
+		length = strcspn(line + pos, "\r\n");
+		if (length % 2 != 0 || length / 2 > sizeof(d->Data) ||
+				!DecodeHexBin(d->Data, (unsigned char *)line + pos, length)) {
+			smprintf(s, "Invalid data on line %d of device trace\n", d->Line);
+			return ERR_FILENOTSUPPORTED;
+		}
+
+		d->Direction = direction;
+		d->Time = sec + usec / 1000000.0;
+		d->Length = length / 2;
+		return ERR_NONE;
+	}
+
+	return ERR_NONE;
+}
+
+/**
+ * Marks pending record as replayed and reads next one.
+ */
+static GSM_Error replay_consume(GSM_StateMachine *s)
+{
+	GSM_Device_ReplayData *d = &s->Device.Replay;
+
+	d->LastTime = d->Time;
+	d->Last = replay_now();
+
+	return replay_next(s);
+}
+
+GSM_Error GSM_ReadReplayConnection(GSM_StateMachine *s, char *connection, size_t size)
+{
+	char line[200];
+	size_t length;
+	FILE *f;
+
+	f = fopen(s->CurrentConfig->Device, "r");
+	if (f == NULL) {
+		smprintf(s, "Failed to open device trace %s\n", s->CurrentConfig->Device);
+		return ERR_DEVICENOTEXIST;
+	}
+
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (line[0] == '#') {
+			continue;
+		}
+		if (strncmp(line, "connection ", 11) != 0) {
+			break;
+		}
+		length = strcspn(line + 11, "\r\n");
+		if (length == 0 || length >= size) {
+			break;
+		}
+		memcpy(connection, line + 11, length);
+		connection[length] = 0;
+		fclose(f);
+		return ERR_NONE;
+	}
+
+	fclose(f);
+	smprintf(s, "Device trace %s does not contain connection\n", s->CurrentConfig->Device);
+	return ERR_FILENOTSUPPORTED;
+}
+
+void GSM_CloseDeviceTrace(GSM_StateMachine *s)
+{
+	GSM_Device_ReplayData *d = &s->Device.Replay;
+
+	if (d->File != NULL) {
+		/* Remember where next connection should continue */
+		if (s->Device.Functions == &ReplayDevice) {
+			d->Offset = ftell(d->File);
+		}
+		fclose(d->File);
+		d->File = NULL;
+	}
+}
+
+static GSM_Error replay_open(GSM_StateMachine *s)
+{
+	GSM_Device_ReplayData *d = &s->Device.Replay;
+	GSM_Error error;
+
+	if (d->File == NULL) {
+		d->File = fopen(s->CurrentConfig->Device, "r");
+		if (d->File == NULL) {
+			return ERR_DEVICENOTEXIST;
+		}
+		if (d->Offset > 0) {
+			/* Pending record was kept from previous connection */
+			if (fseek(d->File, d->Offset, SEEK_SET) != 0) {
+				return ERR_FILENOTSUPPORTED;
+			}
+		} else {
+			d->Line = 0;
+			error = replay_next(s);
+			if (error != ERR_NONE) {
+				return error;
+			}
+		}
+	}
+
+	/* Data which were not read before closing device */
+	while (d->Direction == 'R') {
+		error = replay_next(s);
+		if (error != ERR_NONE) {
+			return error;
+		}
+	}
+
+	if (d->Direction != 'O') {
+		smprintf(s, "Replay mismatch on line %d, device opened but not in trace\n", d->Line);
+		return ERR_DEVICEOPENERROR;
+	}
+
+	return replay_consume(s);
+}
+
+static GSM_Error replay_close(GSM_StateMachine *s)
+{
+	if (s->Device.Replay.Direction == 0) {
+		smprintf(s, "Replay finished\n");
+	}
+	return ERR_NONE;
+}
+
+static GSM_Error replay_setparity(GSM_StateMachine *s UNUSED, gboolean parity UNUSED)
+{
+	return ERR_NONE;
+}
+
+static GSM_Error replay_setdtrrts(GSM_StateMachine *s UNUSED, gboolean dtr UNUSED, gboolean rts UNUSED)
+{
+	return ERR_NONE;
+}
+
+static GSM_Error replay_setspeed(GSM_StateMachine *s UNUSED, int speed UNUSED)
+{
+	return ERR_NONE;
+}
+
+/**
+ * Serves recorded reads once their scaled delay after previous record
+ * has passed, the delay is counted from the time previous record was
+ * replayed, so that slower processing does not accumulate.
+ */
+static int replay_read(GSM_StateMachine *s, void *buf, size_t nbytes)
+{
+	GSM_Device_ReplayData *d = &s->Device.Replay;
+	double wait;
+	size_t count = 0, chunk;
+
+	while (d->Direction == 'R' && count < nbytes) {
+		wait = d->Last + (d->Time - d->LastTime) * s->CurrentConfig->ReplayTiming / 100.0 - replay_now();
+		if (wait > 0) {
+			/* Return what we have, the rest comes later */
+			if (count > 0) {
+				break;
+			}
+			if (wait > REPLAY_READ_TIMEOUT) {
+				usleep((long)(REPLAY_READ_TIMEOUT * 1000000));
+				return 0;
+			}
+			usleep((long)(wait * 1000000));
+		}
+
+		chunk = d->Length - d->Position;
+		if (chunk > nbytes - count) {
+			chunk = nbytes - count;
+		}
+		memcpy((unsigned char *)buf + count, d->Data + d->Position, chunk);
+		count += chunk;
+		d->Position += chunk;
+
+		if (d->Position == d->Length && replay_consume(s) != ERR_NONE) {
+			break;
+		}
+	}
+
+	return count;
+}
+
+/**
+ * Checks that written data match the trace.
+ */
+static int replay_write(GSM_StateMachine *s, const void *buf, size_t nbytes)
+{
+	GSM_Device_ReplayData *d = &s->Device.Replay;
+	const unsigned char *data = buf;
+	size_t count = 0, chunk;
+
+	while (count < nbytes) {
+		if (d->Direction != 'W') {
+			smprintf(s, "Replay mismatch on line %d, written data not in trace:\n", d->Line);
+			DumpMessage(GSM_GetDI(s), data + count, nbytes - count);
+			return -1;
+		}
+
+		chunk = d->Length - d->Position;
+		if (chunk > nbytes - count) {
+			chunk = nbytes - count;
+		}
+		if (memcmp(d->Data + d->Position, data + count, chunk) != 0) {
+			smprintf(s, "Replay mismatch on line %d, expected:\n", d->Line);
+			DumpMessage(GSM_GetDI(s), d->Data + d->Position, chunk);
+			smprintf(s, "Written:\n");
+			DumpMessage(GSM_GetDI(s), data + count, chunk);
+			return -1;
+		}
+		count += chunk;
+		d->Position += chunk;
+
+		if (d->Position == d->Length && replay_consume(s) != ERR_NONE) {
+			return -1;
+		}
+	}
+
+	return count;
+}
+
+GSM_Device_Functions RecordDevice = {
+	record_open,
+	record_close,
+	record_setparity,
+	record_setdtrrts,
+	record_setspeed,
+	record_read,
+	record_write
+};
+
+GSM_Device_Functions ReplayDevice = {
+	replay_open,
+	replay_close,
+	replay_setparity,
+	replay_setdtrrts,
+	replay_setspeed,
+	replay_read,
+	replay_write
+};
+
+/* How should editor hadle tabs in this file? Add editor commands here.
+ * vim: noexpandtab sw=8 ts=8 sts=8:
+ */
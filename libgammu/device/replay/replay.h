@@ -0,0 +1,91 @@
+#ifndef replay_device_h
+#define replay_device_h
+
+#include <stdio.h>
+
+#include <gammu-statemachine.h>
+
+#include "../../misc/misc.h"
+
+/**
+ * Maximal number of bytes stored in one trace record.
+ */
+#define REPLAY_MAX_RECORD 4096
+
+/**
+ * Longest time in seconds single replayed read waits for data.
+ */
+#define REPLAY_READ_TIMEOUT 0.05
+
+typedef struct {
+	/**
+	 * Trace being recorded or replayed.
+	 */
+	FILE *File;
+	/**
+	 * Time when trace recording started.
+	 */
+	double Start;
+	/**
+	 * Number of line in replayed trace.
+	 */
+	int Line;
+	/**
+	 * Position in replayed trace after pending record, where next
+	 * connection continues, 0 when trace was not yet replayed.
+	 */
+	long Offset;
+	/**
+	 * Direction of pending record (O for open, R for read, W for
+	 * write), 0 at the end of trace.
+	 */
+	char Direction;
+	/**
+	 * Recorded time of pending record.
+	 */
+	double Time;
+	/**
+	 * Recorded time of previous record.
+	 */
+	double LastTime;
+	/**
+	 * Time when previous record was replayed.
+	 */
+	double Last;
+	/**
+	 * Data of pending record.
+	 */
+	unsigned char Data[REPLAY_MAX_RECORD];
+	/**
+	 * Length of pending record.
+	 */
+	size_t Length;
+	/**
+	 * Number of already replayed bytes from pending record.
+	 */
+	size_t Position;
+} GSM_Device_ReplayData;
+
+/**
+ * Reads name of connection the replayed trace was recorded with.
+ *
+ * \param s State machine, trace is configured as device.
+ * \param connection Buffer for connection name.
+ * \param size Size of buffer.
+ *
+ * \return Error code.
+ */
+GSM_Error GSM_ReadReplayConnection(GSM_StateMachine *s, char *connection, size_t size);
+
+/**
+ * Closes recorded or replayed trace.
+ *
+ * \param s State machine.
+ */
+void GSM_CloseDeviceTrace(GSM_StateMachine *s);
+
+#endif
+
+/* How should editor hadle tabs in this file? Add editor commands here.
+ * vim: noexpandtab sw=8 ts=8 sts=8:
+ */
@@ -378,9 +378,13 @@ static int serial_read(GSM_StateMachine *s, void *buf, size_t nbytes)
 	timeout2.tv_sec     = 0;
 	timeout2.tv_usec    = 50000;
 
-	if (select(d->hPhone+1, &readfds, NULL, NULL, &timeout2)) {
+	if (select(d->hPhone+1, &readfds, NULL, NULL, &timeout2) > 0) {
 		actual = read(d->hPhone, buf, nbytes);
-		if (actual == -1) GSM_OSErrorInfo(s,"serial_read");
+		if (actual == -1) {
+			/* Interrupted read is not failure of device */
+			if (errno == EINTR || errno == EAGAIN) return 0;
+			GSM_OSErrorInfo(s,"serial_read");
+		}
 	}
 	return actual;
 }
@@ -0,0 +1,320 @@
+/* (c) 2015 Gammu contributors */
+
+/**
+ * \file socket.c
+ *
+ * Stream socket device.
+ *
+ * Talks to phone or modem exported over TCP (for example by ser2net or
+ * modem multiplexer) or over Unix domain socket. The device name is
+ * host:port for TCP connections and path to socket for Unix ones.
+ */
+
+#include "../../gsmstate.h"
+
+#ifdef GSM_ENABLE_SOCKETDEVICE
+#ifndef DJGPP
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#ifndef WIN32
+#  include <unistd.h>
+#  include <fcntl.h>
+#  include <errno.h>
+#  include <netdb.h>
+#  include <sys/time.h>
+#  include <sys/types.h>
+#  include <sys/socket.h>
+#  include <sys/un.h>
+#  include <netinet/in.h>
+#  include <netinet/tcp.h>
+#else
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#  include <winsock2.h>
+#  include <ws2tcpip.h>
+#endif
+
+#include "../../gsmcomon.h"
+#include "../devfunc.h"
+#include "socket.h"
+
+/**
+ * Checks whether current connection uses Unix domain socket.
+ */
+static gboolean socket_is_unix(GSM_StateMachine *s)
+{
+	return s->ConnectionType == GCT_UNIXAT ||
+		s->ConnectionType == GCT_UNIXFBUS2 ||
+		s->ConnectionType == GCT_UNIXOBEX;
+}
+
+/**
+ * Switches socket between blocking and non blocking mode.
+ */
+static gboolean socket_set_blocking(socket_type fd, gboolean blocking)
+{
+#ifdef WIN32
+	u_long nonblocking = blocking ? 0 : 1;
+
+	return ioctlsocket(fd, FIONBIO, &nonblocking) == 0;
+#else
+	int flags;
+
+	flags = fcntl(fd, F_GETFL, 0);
+	if (flags == -1) {
+		return FALSE;
+	}
+	if (blocking) {
+		flags &= ~O_NONBLOCK;
+	} else {
+		flags |= O_NONBLOCK;
+	}
+	return fcntl(fd, F_SETFL, flags) == 0;
+#endif
+}
+
+/**
+ * Connects socket without blocking for longer than
+ * SOCKET_CONNECT_TIMEOUT. Socket is switched back to blocking mode
+ * once connected, reads do not block anyway as they are guarded by
+ * select.
+ */
+static GSM_Error socket_connect_timeout(GSM_StateMachine *s, socket_type fd, const struct sockaddr *addr, socklen_t addrlen)
+{
+	fd_set		writefds;
+	struct timeval	timer;
+	int		ret, err = 0;
+	socklen_t	errlen = sizeof(err);
+
+	if (!socket_set_blocking(fd, FALSE)) {
+		GSM_OSErrorInfo(s, "socket nonblocking");
+		return ERR_DEVICEOPENERROR;
+	}
+
+	ret = connect(fd, addr, addrlen);
+	if (ret != 0) {
+#ifdef WIN32
+		if (WSAGetLastError() != WSAEWOULDBLOCK) {
+#else
+		if (errno != EINPROGRESS) {
+#endif
+			GSM_OSErrorInfo(s, "connect");
+			return ERR_DEVICEOPENERROR;
+		}
+
+		FD_ZERO(&writefds);
+		FD_SET(fd, &writefds);
+		timer.tv_sec = SOCKET_CONNECT_TIMEOUT;
+		timer.tv_usec = 0;
+
+		ret = select(fd + 1, NULL, &writefds, NULL, &timer);
+		if (ret == 0) {
+			smprintf(s, "Timeout while connecting socket\n");
+			return ERR_TIMEOUT;
+		}
+		if (ret < 0) {
+			GSM_OSErrorInfo(s, "select");
+			return ERR_DEVICEOPENERROR;
+		}
+		if (getsockopt(fd, SOL_SOCKET, SO_ERROR, (char *)&err, &errlen) != 0 || err != 0) {
+			smprintf(s, "Connecting socket failed: %s\n", strerror(err));
+			return ERR_DEVICEOPENERROR;
+		}
+	}
+
+	if (!socket_set_blocking(fd, TRUE)) {
+		GSM_OSErrorInfo(s, "socket blocking");
+		return ERR_DEVICEOPENERROR;
+	}
+	return ERR_NONE;
+}
+
+/**
+ * Opens TCP connection to host:port given as device. IPv6 address
+ * can be written in brackets, for example [::1]:2000.
+ */
+static GSM_Error socket_open_tcp(GSM_StateMachine *s)
+{
+	GSM_Device_SocketData	*d = &s->Device.Data.Socket;
+	struct addrinfo		hints, *result = NULL, *rp;
+	char			*host, *port, *end;
+	socket_type		fd = socket_invalid;
+	GSM_Error		error = ERR_DEVICENOTEXIST;
+	int			flag = 1;
+#ifdef WIN32
+	WSADATA			wsaData;
+
+	/* BCC comes with broken MAKEWORD, which emmits warnings */
+#ifdef __BORLANDC__
+#    pragma warn -8084
+#endif
+	WSAStartup(MAKEWORD(2,2), &wsaData);
+#ifdef __BORLANDC__
+#    pragma warn +8084
+#endif
+#endif
+
+	host = strdup(s->CurrentConfig->Device);
+	if (host == NULL) {
+		return ERR_MOREMEMORY;
+	}
+
+	port = strrchr(host, ':');
+	if (port == NULL || port[1] == 0) {
+		smprintf(s, "Device for TCP connection has to be in host:port form\n");
+		free(host);
+		return ERR_DEVICENOTEXIST;
+	}
+	*port++ = 0;
+	if (host[0] == '[') {
+		end = strchr(host, ']');
+		if (end != NULL) {
+			*end = 0;
+		}
+		memmove(host, host + 1, strlen(host));
+	}
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+
+	if (getaddrinfo(host, port, &hints, &result) != 0) {
+		smprintf(s, "Can not resolve %s port %s\n", host, port);
+		free(host);
+		return ERR_DEVICENOTEXIST;
+	}
+
+	for (rp = result; rp != NULL; rp = rp->ai_next) {
+		fd = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+		if (fd == socket_invalid) {
+			continue;
+		}
+		error = socket_connect_timeout(s, fd, rp->ai_addr, rp->ai_addrlen);
+		if (error == ERR_NONE) {
+			break;
+		}
+		socket_close(s, fd);
+		fd = socket_invalid;
+	}
+	freeaddrinfo(result);
+
+	if (fd == socket_invalid) {
+		smprintf(s, "Can not connect to %s port %s\n", host, port);
+		free(host);
+		return error;
+	}
+	free(host);
+
+	/* Commands are short, do not wait to coalesce them */
+	if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (char *)&flag, sizeof(flag)) != 0) {
+		GSM_OSErrorInfo(s, "setsockopt TCP_NODELAY");
+	}
+
+	d->hPhone = fd;
+	return ERR_NONE;
+}
+
+/**
+ * Opens connection to Unix domain socket given as device.
+ */
+static GSM_Error socket_open_unix(GSM_StateMachine *s)
+{
+#ifdef WIN32
+	smprintf(s, "Unix domain sockets are not supported on this platform\n");
+	return ERR_NOTSUPPORTED;
+#else
+	GSM_Device_SocketData	*d = &s->Device.Data.Socket;
+	struct sockaddr_un	addr;
+	socket_type		fd;
+	GSM_Error		error;
+
+	if (strlen(s->CurrentConfig->Device) >= sizeof(addr.sun_path)) {
+		smprintf(s, "Socket path is too long\n");
+		return ERR_DEVICENOTEXIST;
+	}
+	if (access(s->CurrentConfig->Device, F_OK) != 0) {
+		return ERR_DEVICENOTEXIST;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, s->CurrentConfig->Device);
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd == socket_invalid) {
+		GSM_OSErrorInfo(s, "socket");
+		return ERR_DEVICEOPENERROR;
+	}
+
+	error = socket_connect_timeout(s, fd, (struct sockaddr *)&addr, sizeof(addr));
+	if (error != ERR_NONE) {
+		socket_close(s, fd);
+		return error;
+	}
+
+	d->hPhone = fd;
+	return ERR_NONE;
+#endif
+}
+
+static GSM_Error socket_open(GSM_StateMachine *s)
+{
+	GSM_Error	error;
+#ifdef SO_NOSIGPIPE
+	int		flag = 1;
+#endif
+
+	if (socket_is_unix(s)) {
+		error = socket_open_unix(s);
+	} else {
+		error = socket_open_tcp(s);
+	}
+	if (error != ERR_NONE) {
+		return error;
+	}
+
+#ifdef SO_NOSIGPIPE
+	/* Writing to closed connection should not kill us on platforms
+	 * where send does not support MSG_NOSIGNAL */
+	if (setsockopt(s->Device.Data.Socket.hPhone, SOL_SOCKET, SO_NOSIGPIPE, (char *)&flag, sizeof(flag)) != 0) {
+		GSM_OSErrorInfo(s, "setsockopt SO_NOSIGPIPE");
+	}
+#endif
+	return ERR_NONE;
+}
+
+static int socket_device_read(GSM_StateMachine *s, void *buf, size_t nbytes)
+{
+	return socket_read(s, buf, nbytes, s->Device.Data.Socket.hPhone);
+}
+
+static int socket_device_write(GSM_StateMachine *s, const void *buf, size_t nbytes)
+{
+	return socket_write(s, buf, nbytes, s->Device.Data.Socket.hPhone);
+}
+
+static GSM_Error socket_device_close(GSM_StateMachine *s)
+{
+	return socket_close(s, s->Device.Data.Socket.hPhone);
+}
+
+GSM_Device_Functions SocketDevice = {
+	socket_open,
+	socket_device_close,
+	NONEFUNCTION,
+	NONEFUNCTION,
+	NONEFUNCTION,
+	socket_device_read,
+	socket_device_write
+};
+
+#endif
+#endif
+
+/* How should editor hadle tabs in this file? Add editor commands here.
+ * vim: noexpandtab sw=8 ts=8 sts=8:
+ */
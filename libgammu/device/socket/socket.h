@@ -0,0 +1,21 @@
+#ifndef DJGPP
+#ifndef socket_device_h
+#define socket_device_h
+
+#include "../../misc/misc.h"
+
+/**
+ * How long to wait for stream socket connection, in seconds.
+ */
+#define SOCKET_CONNECT_TIMEOUT 10
+
+typedef struct {
+	socket_type hPhone;
+} GSM_Device_SocketData;
+
+#endif
+#endif
+
+/* How should editor hadle tabs in this file? Add editor commands here.
+ * vim: noexpandtab sw=8 ts=8 sts=8:
+ */
@@ -483,6 +483,10 @@ int GSM_USB_Read(GSM_StateMachine *s, void *buf, size_t nbytes)
 			rc = 0;
 			break;
 		}
+		/* Phone has nothing to say, this is not failure of device */
+		if (rc == LIBUSB_ERROR_TIMEOUT) {
+			return 0;
+		}
 		if (rc != 0) {
 			smprintf(s, "Failed to read from usb (%d)!\n", rc);
 			GSM_USB_Error(s, rc);
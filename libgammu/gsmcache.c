@@ -0,0 +1,216 @@
+/**
+ * \file gsmcache.c
+ *
+ * Persistent cache of device capabilities.
+ *
+ * Probing phone capabilities takes several seconds on each connection,
+ * so the results are stored in file configured by CapabilityCache
+ * option and reused when connecting to same phone again.
+ */
+
+#include <gammu-config.h>
+#include <gammu-info.h>
+
+#include "gsmcache.h"
+#include "gsmphones.h"
+#include "gsmstate.h"
+#include "misc/misc.h"
+
+#include "debug.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+/**
+ * Returns value from cache section, empty string if not present.
+ */
+static const char *GSM_GetCacheValue(INI_Section *cache, const char *key)
+{
+	const char *value;
+
+	value = (const char *)INI_GetValue(cache, GSM_CACHE_SECTION, key, FALSE);
+	if (value == NULL) {
+		return "";
+	}
+	return value;
+}
+
+/**
+ * Checks whether capability cache is configured.
+ */
+static gboolean GSM_CacheConfigured(GSM_StateMachine *s)
+{
+	return s->CurrentConfig->CapabilityCache != NULL &&
+		s->CurrentConfig->CapabilityCache[0] != 0;
+}
+
+void GSM_FreeCapabilityCache(GSM_StateMachine *s)
+{
+	INI_Free(s->Phone.Data.CapabilityCache);
+	s->Phone.Data.CapabilityCache = NULL;
+}
+
+void GSM_LoadCapabilityCache(GSM_StateMachine *s)
+{
+	INI_Section	*cache = NULL;
+	GSM_Error	error;
+
+	GSM_FreeCapabilityCache(s);
+
+	if (!GSM_CacheConfigured(s)) {
+		return;
+	}
+
+	error = INI_ReadFile(s->CurrentConfig->CapabilityCache, FALSE, &cache);
+	if (error != ERR_NONE) {
+		smprintf(s, "Could not read capability cache %s, phone will be probed\n",
+				s->CurrentConfig->CapabilityCache);
+		return;
+	}
+
+	if (strcmp(GSM_GetCacheValue(cache, "Gammu"), GAMMU_VERSION) != 0 ||
+			strcmp(GSM_GetCacheValue(cache, "Device"), s->CurrentConfig->Device) != 0 ||
+			strcmp(GSM_GetCacheValue(cache, "Connection"), s->CurrentConfig->Connection) != 0 ||
+			GSM_GetCacheValue(cache, "Model")[0] == 0) {
+		smprintf(s, "Capability cache does not match current connection, phone will be probed\n");
+		INI_Free(cache);
+		return;
+	}
+
+	smprintf(s, "Using capability cache %s\n", s->CurrentConfig->CapabilityCache);
+	s->Phone.Data.CapabilityCache = cache;
+}
+
+void GSM_ApplyCachedFeatures(GSM_StateMachine *s)
+{
+	GSM_Feature	features[GSM_MAX_PHONE_FEATURES + 1];
+	const char	*value;
+	int		i;
+
+	if (s->Phone.Data.CapabilityCache == NULL || s->Phone.Data.ModelInfo == NULL) {
+		return;
+	}
+
+	value = GSM_GetCacheValue(s->Phone.Data.CapabilityCache, "Features");
+	if (value[0] == 0 || GSM_SetFeatureString(features, value) != ERR_NONE) {
+		return;
+	}
+	for (i = 0; features[i] != 0; i++) {
+		GSM_AddPhoneFeature(s->Phone.Data.ModelInfo, features[i]);
+	}
+}
+
+gboolean GSM_UseCachedModel(GSM_StateMachine *s)
+{
+	GSM_Phone_Data	*Data = &s->Phone.Data;
+	const char	*model;
+
+	if (Data->CapabilityCache == NULL) {
+		return FALSE;
+	}
+
+	model = GSM_GetCacheValue(Data->CapabilityCache, "Model");
+	if (strlen(model) > GSM_MAX_MODEL_LENGTH) {
+		return FALSE;
+	}
+	strcpy(Data->Model, model);
+	Data->ModelInfo = GetModelData(s, NULL, Data->Model, NULL);
+	GSM_ApplyCachedFeatures(s);
+
+	smprintf(s, "[Cached model     - \"%s\"]\n", Data->Model);
+	return TRUE;
+}
+
+gboolean GSM_CheckCapabilityCache(GSM_StateMachine *s)
+{
+	GSM_Phone_Data	*Data = &s->Phone.Data;
+	INI_Section	*cache = Data->CapabilityCache;
+
+	if (cache == NULL) {
+		return FALSE;
+	}
+
+	if (strcmp(GSM_GetCacheValue(cache, "Manufacturer"), Data->Manufacturer) != 0 ||
+			strcmp(GSM_GetCacheValue(cache, "Model"), Data->Model) != 0 ||
+			strcmp(GSM_GetCacheValue(cache, "Firmware"), Data->Version) != 0 ||
+			strcmp(GSM_GetCacheValue(cache, "IMEI"), Data->IMEI) != 0) {
+		smprintf(s, "Capability cache does not match connected phone\n");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+GSM_Error GSM_SaveCapabilityCache(GSM_StateMachine *s)
+{
+	GSM_Phone_Data	*Data = &s->Phone.Data;
+	FILE		*file;
+	GSM_Error	error;
+	const char	*feature;
+	char		*tmpname;
+	gboolean	first = TRUE;
+	int		i;
+
+	if (!GSM_CacheConfigured(s) || Data->Model[0] == 0) {
+		return ERR_NONE;
+	}
+
+	/* Write to temporary file, other instance might be reading the cache */
+	tmpname = (char *)malloc(strlen(s->CurrentConfig->CapabilityCache) + 5);
+	if (tmpname == NULL) {
+		return ERR_MOREMEMORY;
+	}
+	sprintf(tmpname, "%s.tmp", s->CurrentConfig->CapabilityCache);
+
+	file = fopen(tmpname, "w");
+	if (file == NULL) {
+		smprintf(s, "Could not write capability cache %s\n", tmpname);
+		free(tmpname);
+		return ERR_CANTOPENFILE;
+	}
+
+	fprintf(file, "; Capabilities of phone detected by Gammu, remove to probe phone again\n");
+	fprintf(file, "[%s]\n", GSM_CACHE_SECTION);
+	fprintf(file, "Gammu = %s\n", GAMMU_VERSION);
+	fprintf(file, "Device = %s\n", s->CurrentConfig->Device);
+	fprintf(file, "Connection = %s\n", s->CurrentConfig->Connection);
+	fprintf(file, "Manufacturer = %s\n", Data->Manufacturer);
+	fprintf(file, "Model = %s\n", Data->Model);
+	fprintf(file, "Firmware = %s\n", Data->Version);
+	fprintf(file, "IMEI = %s\n", Data->IMEI);
+	if (Data->ModelInfo != NULL) {
+		fprintf(file, "Features =");
+		for (i = 0; Data->ModelInfo->features[i] != 0; i++) {
+			feature = GSM_FeatureToString(Data->ModelInfo->features[i]);
+			if (feature != NULL) {
+				fprintf(file, "%s%s", first ? " " : ",", feature);
+				first = FALSE;
+			}
+		}
+		fprintf(file, "\n");
+	}
+
+#ifdef GSM_ENABLE_ATGEN
+	if (s->Phone.Functions == &ATGENPhone
+#ifdef GSM_ENABLE_ATOBEX
+			|| s->Phone.Functions == &ATOBEXPhone
+#endif
+#ifdef GSM_ENABLE_ALCATEL
+			|| s->Phone.Functions == &ALCATELPhone
+#endif
+			) {
+		ATGEN_SaveCapabilities(s, file);
+	}
+#endif
+
+	error = GSM_ReplaceFile(file, tmpname, s->CurrentConfig->CapabilityCache);
+	if (error != ERR_NONE) {
+		smprintf(s, "Could not write capability cache %s\n",
+				s->CurrentConfig->CapabilityCache);
+	}
+	free(tmpname);
+	return error;
+}
+
+/* How should editor hadle tabs in this file? Add editor commands here.
+ * vim: noexpandtab sw=8 ts=8 sts=8:
+ */
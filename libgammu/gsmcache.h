@@ -0,0 +1,75 @@
+/**
+ * \file gsmcache.h
+ *
+ * Persistent cache of device capabilities.
+ */
+#ifndef __gsmcache_h
+#define __gsmcache_h
+
+#include <stdio.h>
+
+#include <gammu-inifile.h>
+#include <gammu-statemachine.h>
+
+/**
+ * Section of cache file holding phone identification.
+ */
+#define GSM_CACHE_SECTION "device"
+
+/**
+ * Loads capability cache configured for current connection. The cache
+ * is used only when it was written by same Gammu version for same
+ * device and connection, otherwise it is ignored and will be rewritten
+ * once connection is established.
+ *
+ * \param s State machine pointer.
+ */
+void GSM_LoadCapabilityCache(GSM_StateMachine *s);
+
+/**
+ * Sets model and features from capability cache, so that phone
+ * driver can be chosen without probing the phone.
+ *
+ * \param s State machine pointer.
+ *
+ * \return TRUE if cache provided model.
+ */
+gboolean GSM_UseCachedModel(GSM_StateMachine *s);
+
+/**
+ * Adds features stored in capability cache to current model
+ * information.
+ *
+ * \param s State machine pointer.
+ */
+void GSM_ApplyCachedFeatures(GSM_StateMachine *s);
+
+/**
+ * Compares phone identification with capability cache.
+ *
+ * \param s State machine pointer.
+ *
+ * \return TRUE if cache describes connected phone.
+ */
+gboolean GSM_CheckCapabilityCache(GSM_StateMachine *s);
+
+/**
+ * Writes capabilities of connected phone to configured cache file.
+ *
+ * \param s State machine pointer.
+ *
+ * \return Error code.
+ */
+GSM_Error GSM_SaveCapabilityCache(GSM_StateMachine *s);
+
+/**
+ * Frees loaded capability cache.
+ *
+ * \param s State machine pointer.
+ */
+void GSM_FreeCapabilityCache(GSM_StateMachine *s);
+#endif
+
+/* How should editor hadle tabs in this file? Add editor commands here.
+ * vim: noexpandtab sw=8 ts=8 sts=8:
+ */
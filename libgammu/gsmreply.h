@@ -34,6 +34,7 @@ typedef enum {
 	ID_GetAlarm,
 	ID_GetMemory,
 	ID_GetMemoryStatus,
+	ID_GetMemoryRange,
 	ID_GetSMSC,
 	ID_GetSMSMessage,
 	ID_EnableEcho,
@@ -151,6 +152,7 @@ typedef enum {
 	ID_FileSystemStatus,
 	ID_GetFile,
 	ID_AddFile,
+	ID_AbortFile,
 	ID_AddFolder,
 	ID_DeleteFolder,
 	ID_DeleteFile,
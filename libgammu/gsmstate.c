@@ -14,6 +14,7 @@
 #include <gammu-misc.h>
 
 #include "debug.h"
+#include "gsmcache.h"
 #include "gsmcomon.h"
 #include "gsmphones.h"
 #include "gsmstate.h"
@@ -151,6 +152,14 @@ static const GSM_ConnectionInfo GSM_Connections[] = {
 	{"irdaobex", GCT_IRDAOBEX, FALSE},
 	{"irdagnapbus", GCT_IRDAGNAPBUS, FALSE},
 
+	/* stream sockets */
+	{"tcpat", GCT_TCPAT, FALSE},
+	{"unixat", GCT_UNIXAT, FALSE},
+	{"tcpfbus", GCT_TCPFBUS2, FALSE},
+	{"unixfbus", GCT_UNIXFBUS2, FALSE},
+	{"tcpobex", GCT_TCPOBEX, FALSE},
+	{"unixobex", GCT_UNIXOBEX, FALSE},
+
 	/* testing purposes */
 	{"none", GCT_NONE, FALSE},
 };
@@ -176,6 +185,24 @@ static GSM_Error GSM_RegisterAllConnections(GSM_StateMachine *s, const char *con
 {
 	size_t i;
 	char *buff, *nodtr_pos, *nopower_pos;
+	char recorded[100];
+	GSM_Error error;
+
+	/* Replayed trace knows connection it was recorded with */
+	if (strcasecmp(connection, "replay") == 0) {
+		error = GSM_ReadReplayConnection(s, recorded, sizeof(recorded));
+		if (error != ERR_NONE) {
+			return error;
+		}
+		if (strcasecmp(recorded, "replay") == 0) {
+			return ERR_FILENOTSUPPORTED;
+		}
+		error = GSM_RegisterAllConnections(s, recorded);
+		if (error == ERR_NONE) {
+			s->Device.Functions = &ReplayDevice;
+		}
+		return error;
+	}
 
 	/* Copy connection name, so that we can play with it */
 	buff = strdup(connection);
@@ -306,6 +333,18 @@ static GSM_Error GSM_RegisterAllConnections(GSM_StateMachine *s, const char *con
 #endif
 #ifdef GSM_ENABLE_BLUEOBEX
 	GSM_RegisterConnection(s, GCT_BLUEOBEX,   &BlueToothDevice,&OBEXProtocol);
+#endif
+#ifdef GSM_ENABLE_SOCKETAT
+	GSM_RegisterConnection(s, GCT_TCPAT, 	  &SocketDevice,  &ATProtocol);
+	GSM_RegisterConnection(s, GCT_UNIXAT, 	  &SocketDevice,  &ATProtocol);
+#endif
+#ifdef GSM_ENABLE_SOCKETFBUS2
+	GSM_RegisterConnection(s, GCT_TCPFBUS2,   &SocketDevice,  &FBUS2Protocol);
+	GSM_RegisterConnection(s, GCT_UNIXFBUS2,  &SocketDevice,  &FBUS2Protocol);
+#endif
+#ifdef GSM_ENABLE_SOCKETOBEX
+	GSM_RegisterConnection(s, GCT_TCPOBEX,    &SocketDevice,  &OBEXProtocol);
+	GSM_RegisterConnection(s, GCT_UNIXOBEX,   &SocketDevice,  &OBEXProtocol);
 #endif
 	if (s->Device.Functions == NULL || s->Protocol.Functions == NULL) {
 		smprintf(s, "Connection %s is know but was disabled on compile time\n", connection);
@@ -347,7 +386,8 @@ GSM_Error GSM_RegisterAllPhoneModules(GSM_StateMachine *s)
 		model = GetModelData(s, NULL, s->Phone.Data.Model, NULL);
 #ifdef GSM_ENABLE_ATGEN
 		/* With ATgen and auto model we can work with unknown models too */
-		if (s->ConnectionType==GCT_AT || s->ConnectionType==GCT_BLUEAT || s->ConnectionType==GCT_IRDAAT || s->ConnectionType==GCT_DKU2AT) {
+		if (s->ConnectionType==GCT_AT || s->ConnectionType==GCT_BLUEAT || s->ConnectionType==GCT_IRDAAT || s->ConnectionType==GCT_DKU2AT ||
+				s->ConnectionType==GCT_TCPAT || s->ConnectionType==GCT_UNIXAT) {
 #ifdef GSM_ENABLE_ALCATEL
 			/* If phone provides Alcatel specific functions, enable them */
 			if (model->model[0] != 0 && GSM_IsPhoneFeatureAvailable(model, F_ALCATEL)) {
@@ -371,7 +411,8 @@ GSM_Error GSM_RegisterAllPhoneModules(GSM_StateMachine *s)
 #endif
 		/* With OBEXgen and auto model we can work with unknown models too */
 #ifdef GSM_ENABLE_OBEXGEN
-		if (s->ConnectionType==GCT_BLUEOBEX || s->ConnectionType==GCT_IRDAOBEX) {
+		if (s->ConnectionType==GCT_BLUEOBEX || s->ConnectionType==GCT_IRDAOBEX ||
+				s->ConnectionType==GCT_TCPOBEX || s->ConnectionType==GCT_UNIXOBEX) {
 			smprintf(s,"[Module           - \"%s\"]\n",OBEXGENPhone.models);
 			s->Phone.Functions = &OBEXGENPhone;
 			return ERR_NONE;
@@ -415,7 +456,9 @@ GSM_Error GSM_RegisterAllPhoneModules(GSM_StateMachine *s)
 				s->ConnectionType ==  GCT_PHONETBLUE ||
 				s->ConnectionType ==  GCT_IRDAPHONET ||
 				s->ConnectionType ==  GCT_BLUEFBUS2 ||
-				s->ConnectionType ==  GCT_BLUEPHONET) {
+				s->ConnectionType ==  GCT_BLUEPHONET ||
+				s->ConnectionType ==  GCT_TCPFBUS2 ||
+				s->ConnectionType ==  GCT_UNIXFBUS2) {
 			/* Try to detect phone type */
 			if (strcmp(model->model, "unknown") == 0 && model->features[0] == 0) {
 				smprintf(s, "WARNING: phone not known, please report it to authors (see <http://wammu.eu/support/bugs/>). Thank you.\n");
@@ -459,7 +502,8 @@ GSM_Error GSM_RegisterAllPhoneModules(GSM_StateMachine *s)
 	s->Phone.Functions = NULL;
 #ifdef GSM_ENABLE_ATGEN
 	/* AT module can have the same models ID to "normal" Nokia modules */
-	if (s->ConnectionType==GCT_AT || s->ConnectionType==GCT_BLUEAT || s->ConnectionType==GCT_IRDAAT || s->ConnectionType==GCT_DKU2AT) {
+	if (s->ConnectionType==GCT_AT || s->ConnectionType==GCT_BLUEAT || s->ConnectionType==GCT_IRDAAT || s->ConnectionType==GCT_DKU2AT ||
+			s->ConnectionType==GCT_TCPAT || s->ConnectionType==GCT_UNIXAT) {
 		GSM_RegisterModule(s,&ATGENPhone);
 		if (s->Phone.Functions != NULL) return ERR_NONE;
 	}
@@ -522,6 +566,14 @@ GSM_Error GSM_OpenConnection(GSM_StateMachine *s)
 		if (error != ERR_NONE) return error;
 	}
 
+	/* Record raw traffic of real device if asked for */
+	if (s->CurrentConfig->DeviceTrace != NULL && s->CurrentConfig->DeviceTrace[0] != 0 &&
+			s->Device.Functions != &ReplayDevice &&
+			s->Device.Functions != &RecordDevice) {
+		s->Device.RecordedFunctions = s->Device.Functions;
+		s->Device.Functions = &RecordDevice;
+	}
+
 	/* Irda devices can set now model to some specific and
 	 * we don't have to make auto detection later */
 	error=s->Device.Functions->OpenDevice(s);
@@ -597,12 +649,16 @@ GSM_Error GSM_TryGetModel(GSM_StateMachine *s)
 			case GCT_BLUEAT:
 			case GCT_IRDAAT:
 			case GCT_DKU2AT:
+			case GCT_TCPAT:
+			case GCT_UNIXAT:
 				s->Phone.Functions = &ATGENPhone;
 				break;
 #endif
 #ifdef GSM_ENABLE_OBEXGEN
 			case GCT_IRDAOBEX:
 			case GCT_BLUEOBEX:
+			case GCT_TCPOBEX:
+			case GCT_UNIXOBEX:
 				s->Phone.Functions = &OBEXGENPhone;
 				break;
 #endif
@@ -631,6 +687,8 @@ GSM_Error GSM_TryGetModel(GSM_StateMachine *s)
 			case GCT_IRDAPHONET:
 			case GCT_BLUEFBUS2:
 			case GCT_BLUEPHONET:
+			case GCT_TCPFBUS2:
+			case GCT_UNIXFBUS2:
 				s->Phone.Functions = &NAUTOPhone;
 				break;
 #endif
@@ -663,6 +721,7 @@ GSM_Error GSM_InitConnection_Log(GSM_StateMachine *s, int ReplyNum, GSM_Log_Func
 	GSM_Error	error;
 	GSM_DateTime	current_time;
 	int		i;
+	unsigned char	version_length;
 
 	for (i=0;i<s->ConfigNum;i++) {
 		s->CurrentConfig		  = &s->Config[i];
@@ -675,7 +734,9 @@ GSM_Error GSM_InitConnection_Log(GSM_StateMachine *s, int ReplyNum, GSM_Log_Func
 
 		s->Speed			  = 0;
 		s->ReplyNum			  = ReplyNum;
+		GSM_CloseDeviceTrace(s);
 		s->Phone.Data.ModelInfo		  = GetModelData(s, "unknown", NULL, NULL);
+		s->Phone.Data.IMEI[0]		  = 0;
 		s->Phone.Data.Manufacturer[0]	  = 0;
 		s->Phone.Data.Model[0]		  = 0;
 		s->Phone.Data.Version[0]	  = 0;
@@ -729,8 +790,9 @@ GSM_Error GSM_InitConnection_Log(GSM_StateMachine *s, int ReplyNum, GSM_Log_Func
 		}
 
 		if (GSM_GetDI(s)->dl == DL_BINARY) {
-			smprintf(s,"%c",((unsigned char)strlen(GAMMU_VERSION)));
-			smprintf(s,"%s",GAMMU_VERSION);
+			version_length = (unsigned char)strlen(GAMMU_VERSION);
+			dbg_write_binary(GSM_GetDI(s), &version_length, 1);
+			dbg_write_binary(GSM_GetDI(s), (const unsigned char *)GAMMU_VERSION, strlen(GAMMU_VERSION));
 		}
 
 		error = GSM_RegisterAllConnections(s, s->CurrentConfig->Connection);
@@ -739,6 +801,9 @@ GSM_Error GSM_InitConnection_Log(GSM_StateMachine *s, int ReplyNum, GSM_Log_Func
 			return error;
 		}
 
+		/* Capabilities detected on previous connection */
+		GSM_LoadCapabilityCache(s);
+
 autodetect:
 		/* Model auto */
 		/* Try to guess correct driver based on model */
@@ -746,9 +811,12 @@ autodetect:
 				s->ConnectionType != GCT_NONE &&
 				s->ConnectionType != GCT_IRDAOBEX &&
 				s->ConnectionType != GCT_BLUEOBEX &&
+				s->ConnectionType != GCT_TCPOBEX &&
+				s->ConnectionType != GCT_UNIXOBEX &&
 				s->ConnectionType != GCT_BLUEGNAPBUS &&
 				s->ConnectionType != GCT_IRDAGNAPBUS &&
-				s->ConnectionType != GCT_BLUES60) {
+				s->ConnectionType != GCT_BLUES60 &&
+				!GSM_UseCachedModel(s)) {
 			error = GSM_TryGetModel(s);
 			/* Fall back to other configuraitons if the device is not existing (or similar error) */
 			if ((i != s->ConfigNum - 1) && (
@@ -782,6 +850,11 @@ autodetect:
 			return error;
 		}
 
+		/* Cached model has to be confirmed by phone */
+		if (s->Phone.Data.CapabilityCache != NULL) {
+			s->Phone.Data.Model[0] = 0;
+		}
+
 		/* We didn't open device earlier ? Make it now */
 		if (!s->opened) {
 			error = GSM_OpenConnection(s);
@@ -804,6 +877,10 @@ autodetect:
 
 		/* Initialize phone layer */
 		error=s->Phone.Functions->Initialise(s);
+		if (error != ERR_NONE && s->Phone.Data.CapabilityCache != NULL) {
+			GSM_LogError(s, "Init:Phone->Initialise" , error);
+			goto drop_cache;
+		}
 		if (error == ERR_TIMEOUT && i != s->ConfigNum - 1) {
 			GSM_CloseConnection(s);
 			continue;
@@ -825,6 +902,10 @@ autodetect:
 
 		/* For debug it's good to have firmware and real model version and manufacturer */
 		error=s->Phone.Functions->GetManufacturer(s);
+		if (error != ERR_NONE && error != ERR_NOTSUPPORTED && s->Phone.Data.CapabilityCache != NULL) {
+			GSM_LogError(s, "Init:Phone->GetManufacturer" , error);
+			goto drop_cache;
+		}
 		if (error == ERR_TIMEOUT && i != s->ConfigNum - 1) {
 			GSM_CloseConnection(s);
 			continue;
@@ -835,19 +916,59 @@ autodetect:
 		}
 
 		error=s->Phone.Functions->GetModel(s);
+		if (error != ERR_NONE && error != ERR_NOTSUPPORTED && s->Phone.Data.CapabilityCache != NULL) {
+			GSM_LogError(s, "Init:Phone->GetModel" , error);
+			goto drop_cache;
+		}
 		if (error != ERR_NONE && error != ERR_NOTSUPPORTED) {
 			GSM_LogError(s, "Init:Phone->GetModel" , error);
 			return error;
 		}
 
 		error=s->Phone.Functions->GetFirmware(s);
+		if (error != ERR_NONE && error != ERR_NOTSUPPORTED && s->Phone.Data.CapabilityCache != NULL) {
+			GSM_LogError(s, "Init:Phone->GetFirmware" , error);
+			goto drop_cache;
+		}
 		if (error != ERR_NONE && error != ERR_NOTSUPPORTED) {
 			GSM_LogError(s, "Init:Phone->GetFirmware" , error);
 			return error;
 		}
 
+		if (s->CurrentConfig->CapabilityCache != NULL && s->CurrentConfig->CapabilityCache[0] != 0) {
+			/* IMEI identifies phone behind the device, we don't care about errors */
+			s->Phone.Functions->GetIMEI(s);
+
+			if (s->Phone.Data.CapabilityCache == NULL) {
+				GSM_SaveCapabilityCache(s);
+			} else if (!GSM_CheckCapabilityCache(s)) {
+				smprintf(s, "Capability cache is stale\n");
+				goto drop_cache;
+			}
+		}
+
 		smprintf(s,"[Connected]\n");
 		return ERR_NONE;
+
+drop_cache:
+		/* Cache does not describe connected phone, probe it again */
+		smprintf(s, "Dropping capability cache, reinitializing\n");
+		GSM_FreeCapabilityCache(s);
+		error = s->Phone.Functions->Terminate(s);
+		if (error != ERR_NONE) {
+			GSM_LogError(s, "Init:Phone->Terminate" , error);
+			return error;
+		}
+		error = GSM_CloseConnection(s);
+		if (error != ERR_NONE) {
+			GSM_LogError(s, "Init:GSM_CloseConnection" , error);
+			return error;
+		}
+		s->opened			  = FALSE;
+		s->Phone.Functions		  = NULL;
+		s->Phone.Data.ModelInfo		  = GetModelData(s, "unknown", NULL, NULL);
+		s->Phone.Data.IMEI[0]		  = 0;
+		goto autodetect;
 	}
 	return ERR_UNCONFIGURED;
 }
@@ -875,7 +996,8 @@ int GSM_ReadDevice (GSM_StateMachine *s, gboolean waitforreply)
 		if (!waitforreply) {
 			break;
 		}
-		if (res > 0) {
+		/* Data or failure of device */
+		if (res != 0) {
 			break;
 		}
 		usleep(5000);
@@ -900,6 +1022,10 @@ GSM_Error GSM_TerminateConnection(GSM_StateMachine *s)
 	}
 
 	if (s->Phone.Functions != NULL) {
+		/* Store capabilities detected during this session */
+		GSM_SaveCapabilityCache(s);
+		GSM_FreeCapabilityCache(s);
+
 		error=s->Phone.Functions->Terminate(s);
 		if (error!=ERR_NONE) return error;
 	}
@@ -907,6 +1033,8 @@ GSM_Error GSM_TerminateConnection(GSM_StateMachine *s)
 	error = GSM_CloseConnection(s);
 	if (error != ERR_NONE) return error;
 
+	GSM_CloseDeviceTrace(s);
+
 	GSM_SetDebugFileDescriptor(NULL, FALSE, &(s->di));
 
 	s->opened = FALSE;
@@ -918,6 +1046,45 @@ gboolean GSM_IsConnected(GSM_StateMachine *s) {
 	return (s != NULL) && s->Phone.Functions != NULL && s->opened;
 }
 
+int GSM_GetDeviceDescriptor(GSM_StateMachine *s)
+{
+#if !defined(WIN32) && !defined(DJGPP)
+	GSM_Device_Functions *functions;
+#endif
+
+	if (!GSM_IsConnected(s)) {
+		return -1;
+	}
+#if !defined(WIN32) && !defined(DJGPP)
+	/* Recording does not change underlying device */
+	functions = s->Device.Functions;
+	if (functions == &RecordDevice) {
+		functions = s->Device.RecordedFunctions;
+	}
+#ifdef GSM_ENABLE_SERIALDEVICE
+	if (functions == &SerialDevice) {
+		return s->Device.Data.Serial.hPhone;
+	}
+#endif
+#ifdef GSM_ENABLE_IRDADEVICE
+	if (functions == &IrdaDevice) {
+		return s->Device.Data.Irda.hPhone;
+	}
+#endif
+#if defined(GSM_ENABLE_BLUETOOTHDEVICE) && !defined(OSX_BLUE_FOUND)
+	if (functions == &BlueToothDevice) {
+		return s->Device.Data.BlueTooth.hPhone;
+	}
+#endif
+#ifdef GSM_ENABLE_SOCKETDEVICE
+	if (functions == &SocketDevice) {
+		return s->Device.Data.Socket.hPhone;
+	}
+#endif
+#endif
+	return -1;
+}
+
 GSM_Error GSM_AbortOperation(GSM_StateMachine * s)
 {
 	s->Abort = TRUE;
@@ -929,7 +1096,7 @@ GSM_Error GSM_WaitForOnce(GSM_StateMachine *s, unsigned const char *buffer,
 {
 	GSM_Phone_Data *Phone = &s->Phone.Data;
 	GSM_Protocol_Message sentmsg;
-	int i = 0;
+	int i = 0, res;
 
 	do {
 		if (length != 0) {
@@ -941,8 +1108,17 @@ GSM_Error GSM_WaitForOnce(GSM_StateMachine *s, unsigned const char *buffer,
 		}
 
 		/* Some data received. Reset timer */
-		if (GSM_ReadDevice(s, TRUE) > 0) {
+		res = GSM_ReadDevice(s, TRUE);
+		if (res > 0) {
 			i = 0;
+		} else if (res < 0) {
+			if (length != 0) {
+				free(sentmsg.Buffer);
+				sentmsg.Buffer = NULL;
+				Phone->SentMsg = NULL;
+			}
+			smprintf(s, "Device does not work\n");
+			return ERR_DEVICENOTWORK;
 		} else {
 			if (s->Abort) {
 				return ERR_ABORTED;
@@ -1295,6 +1471,7 @@ GSM_Error GSM_ReadConfig(INI_Section *cfg_info, GSM_Config *cfg, int num)
 	static const char *DefaultDebugLevel		= "";
 	static gboolean DefaultLockDevice		= FALSE;
 	static gboolean DefaultStartInfo		= FALSE;
+	static int DefaultReplayTiming			= 100;
 
 	/* By default all debug output will go to one filedescriptor */
 	static const gboolean DefaultUseGlobalDebugFile 	= TRUE;
@@ -1366,6 +1543,26 @@ GSM_Error GSM_ReadConfig(INI_Section *cfg_info, GSM_Config *cfg, int num)
 	/* Set file locking */
 	cfg->LockDevice  = INI_GetBool(cfg_info, section, "use_locking", DefaultLockDevice);
 
+	/* Set capability cache */
+	free(cfg->CapabilityCache);
+	cfg->CapabilityCache = INI_GetValue(cfg_info, section, "capabilitycache", 	FALSE);
+	if (cfg->CapabilityCache != NULL) {
+		cfg->CapabilityCache		 = strdup(cfg->CapabilityCache);
+		GSM_ExpandUserPath(&cfg->CapabilityCache);
+	}
+
+	/* Set device trace recording and replaying */
+	free(cfg->DeviceTrace);
+	cfg->DeviceTrace = INI_GetValue(cfg_info, section, "devicetrace", 	FALSE);
+	if (cfg->DeviceTrace != NULL) {
+		cfg->DeviceTrace		 = strdup(cfg->DeviceTrace);
+		GSM_ExpandUserPath(&cfg->DeviceTrace);
+	}
+	cfg->ReplayTiming = INI_GetInt(cfg_info, section, "replaytiming", DefaultReplayTiming);
+	if (cfg->ReplayTiming < 0) {
+		cfg->ReplayTiming = 0;
+	}
+
 	/* Set model */
 	Temp		 = INI_GetValue(cfg_info, section, "model", 		FALSE);
 	if (Temp == NULL || strcmp(Temp, "auto") == 0) {
@@ -1467,6 +1664,7 @@ fail:
 		strcpy(cfg->Model,DefaultModel);
 		strcpy(cfg->DebugLevel,DefaultDebugLevel);
 		cfg->StartInfo	 		 = DefaultStartInfo;
+		cfg->ReplayTiming		 = DefaultReplayTiming;
 		strcpy(cfg->TextReminder,"Reminder");
 		strcpy(cfg->TextMeeting,"Meeting");
 		strcpy(cfg->TextCall,"Call");
@@ -1508,20 +1706,19 @@ void GSM_DumpMessageLevel2Recv(GSM_StateMachine *s, unsigned const char *message
 
 void GSM_DumpMessageLevel3_Custom(GSM_StateMachine *s, unsigned const char *message, int messagesize, int type, int direction)
 {
-	int i=0;
+	unsigned char header[4];
 	GSM_Debug_Info *curdi;
 
 	curdi = GSM_GetDI(s);
 
 	if (curdi->dl == DL_BINARY) {
-		smprintf(s,"%c", direction);
-		smprintf(s,"%c",type);
-		smprintf(s,"%c",messagesize/256);
-		smprintf(s,"%c",messagesize%256);
+		header[0] = direction;
+		header[1] = type;
+		header[2] = messagesize / 256;
+		header[3] = messagesize % 256;
 
-		for (i=0;i<messagesize;i++) {
-			smprintf(s,"%c",message[i]);
-		}
+		dbg_write_binary(curdi, header, sizeof(header));
+		dbg_write_binary(curdi, message, messagesize);
 	}
 }
 void GSM_DumpMessageLevel3(GSM_StateMachine *s, unsigned const char *message, int messagesize, int type)
@@ -1641,7 +1838,13 @@ void GSM_FreeStateMachine(GSM_StateMachine *s)
 		s->Config[i].Connection = NULL;
 		free(s->Config[i].DebugFile);
 		s->Config[i].DebugFile = NULL;
+		free(s->Config[i].CapabilityCache);
+		s->Config[i].CapabilityCache = NULL;
+		free(s->Config[i].DeviceTrace);
+		s->Config[i].DeviceTrace = NULL;
 	}
+	GSM_FreeCapabilityCache(s);
+	GSM_CloseDeviceTrace(s);
 	free(s);
 	s = NULL;
 }
@@ -132,9 +132,18 @@ typedef struct _GSM_User	 	GSM_User;
 #ifndef GSM_USED_BLUEGNAPBUS
 #  undef GSM_ENABLE_BLUEGNAPBUS
 #endif
+#ifndef GSM_USED_SOCKETAT
+#  undef GSM_ENABLE_SOCKETAT
+#endif
+#ifndef GSM_USED_SOCKETFBUS2
+#  undef GSM_ENABLE_SOCKETFBUS2
+#endif
+#ifndef GSM_USED_SOCKETOBEX
+#  undef GSM_ENABLE_SOCKETOBEX
+#endif
 
 #include "protocol/protocol.h"
-#if defined(GSM_ENABLE_FBUS2) || defined(GSM_ENABLE_FBUS2IRDA) || defined(GSM_ENABLE_FBUS2DLR3) || defined(GSM_ENABLE_FBUS2BLUE) || defined(GSM_ENABLE_BLUEFBUS2) || defined(GSM_ENABLE_DKU5FBUS2) || defined(GSM_ENABLE_FBUS2PL2303)
+#if defined(GSM_ENABLE_FBUS2) || defined(GSM_ENABLE_FBUS2IRDA) || defined(GSM_ENABLE_FBUS2DLR3) || defined(GSM_ENABLE_FBUS2BLUE) || defined(GSM_ENABLE_BLUEFBUS2) || defined(GSM_ENABLE_DKU5FBUS2) || defined(GSM_ENABLE_FBUS2PL2303) || defined(GSM_ENABLE_SOCKETFBUS2)
 #  include "protocol/nokia/fbus2.h"
 #endif
 #ifdef GSM_ENABLE_MBUS2
@@ -143,13 +152,13 @@ typedef struct _GSM_User	 	GSM_User;
 #if defined(GSM_ENABLE_PHONETBLUE) || defined(GSM_ENABLE_IRDAPHONET) || defined(GSM_ENABLE_BLUEPHONET) || defined(GSM_ENABLE_DKU2PHONET)
 #  include "protocol/nokia/phonet.h"
 #endif
-#if defined(GSM_ENABLE_AT) || defined(GSM_ENABLE_BLUEAT) || defined(GSM_ENABLE_IRDAAT) || defined(GSM_ENABLE_DKU2AT)
+#if defined(GSM_ENABLE_AT) || defined(GSM_ENABLE_BLUEAT) || defined(GSM_ENABLE_IRDAAT) || defined(GSM_ENABLE_DKU2AT) || defined(GSM_ENABLE_SOCKETAT)
 #  include "protocol/at/at.h"
 #endif
 #ifdef GSM_ENABLE_ALCABUS
 #  include "protocol/alcatel/alcabus.h"
 #endif
-#if defined(GSM_ENABLE_IRDAOBEX) || defined(GSM_ENABLE_BLUEOBEX) || defined(GSM_ENABLE_ATOBEX)
+#if defined(GSM_ENABLE_IRDAOBEX) || defined(GSM_ENABLE_BLUEOBEX) || defined(GSM_ENABLE_ATOBEX) || defined(GSM_ENABLE_SOCKETOBEX)
 #  include "protocol/obex/obex.h"
 #endif
 #if defined(GSM_ENABLE_BLUEGNAPBUS) || defined(GSM_ENABLE_IRDAGNAPBUS)
@@ -179,6 +188,10 @@ typedef struct _GSM_User	 	GSM_User;
 #ifndef GSM_USED_BLUETOOTHDEVICE
 #  undef GSM_ENABLE_BLUETOOTHDEVICE
 #endif
+#define GSM_ENABLE_SOCKETDEVICE
+#ifndef GSM_USED_SOCKETDEVICE
+#  undef GSM_ENABLE_SOCKETDEVICE
+#endif
 
 #ifdef DJGPP
 #  undef GSM_ENABLE_IRDADEVICE
@@ -196,6 +209,10 @@ typedef struct _GSM_User	 	GSM_User;
 #  undef GSM_ENABLE_BLUEGNAPBUS
 #  undef GSM_ENABLE_PHONETBLUE
 #  undef GSM_ENABLE_FBUS2BLUE
+#  undef GSM_ENABLE_SOCKETDEVICE
+#  undef GSM_ENABLE_SOCKETAT
+#  undef GSM_ENABLE_SOCKETFBUS2
+#  undef GSM_ENABLE_SOCKETOBEX
 #endif
 
 #ifdef GSM_ENABLE_SERIALDEVICE
@@ -212,6 +229,10 @@ typedef struct _GSM_User	 	GSM_User;
 #ifdef GSM_ENABLE_BLUETOOTHDEVICE
 #  include "device/bluetoth/bluetoth.h"
 #endif
+#ifdef GSM_ENABLE_SOCKETDEVICE
+#  include "device/socket/socket.h"
+#endif
+#include "device/replay/replay.h"
 
 #include "debug.h"
 #include "gsmreply.h"
@@ -271,6 +292,20 @@ extern GSM_Device_Functions IrdaDevice;
  */
 extern GSM_Device_Functions BlueToothDevice;
 #endif
+#ifdef GSM_ENABLE_SOCKETDEVICE
+/**
+ * Stream socket device functions.
+ */
+extern GSM_Device_Functions SocketDevice;
+#endif
+/**
+ * Device recording traffic of real device.
+ */
+extern GSM_Device_Functions RecordDevice;
+/**
+ * Device replaying recorded trace.
+ */
+extern GSM_Device_Functions ReplayDevice;
 #ifdef GSM_ENABLE_USBDEVICE
 /**
  * Serial device functions.
@@ -307,6 +342,12 @@ typedef struct {
 		 */
 		GSM_Device_BlueToothData	BlueTooth;
 #endif
+#ifdef GSM_ENABLE_SOCKETDEVICE
+		/**
+		 * Data for TCP or Unix socket device.
+		 */
+		GSM_Device_SocketData		Socket;
+#endif
 #ifdef GSM_ENABLE_USBDEVICE
 		/**
 		 * Data for libusb-1.0 backend.
@@ -314,6 +355,14 @@ typedef struct {
 		GSM_Device_USBData		USB;
 #endif
 	} Data;
+	/**
+	 * Data for recording or replaying device trace.
+	 */
+	GSM_Device_ReplayData Replay;
+	/**
+	 * Functions of real device while its traffic is recorded.
+	 */
+	GSM_Device_Functions *RecordedFunctions;
 	/**
 	 * Functions for currently used device.
 	 */
@@ -348,19 +397,19 @@ typedef struct {
 #ifdef GSM_ENABLE_MBUS2
 	extern GSM_Protocol_Functions MBUS2Protocol;
 #endif
-#if defined(GSM_ENABLE_FBUS2) || defined(GSM_ENABLE_FBUS2IRDA) || defined(GSM_ENABLE_FBUS2DLR3) || defined(GSM_ENABLE_DKU5FBUS2) || defined(GSM_ENABLE_FBUS2BLUE) || defined(GSM_ENABLE_BLUEFBUS2) || defined(GSM_ENABLE_FBUS2PL2303)
+#if defined(GSM_ENABLE_FBUS2) || defined(GSM_ENABLE_FBUS2IRDA) || defined(GSM_ENABLE_FBUS2DLR3) || defined(GSM_ENABLE_DKU5FBUS2) || defined(GSM_ENABLE_FBUS2BLUE) || defined(GSM_ENABLE_BLUEFBUS2) || defined(GSM_ENABLE_FBUS2PL2303) || defined(GSM_ENABLE_SOCKETFBUS2)
 	extern GSM_Protocol_Functions FBUS2Protocol;
 #endif
 #if defined(GSM_ENABLE_PHONETBLUE) || defined(GSM_ENABLE_IRDAPHONET) || defined(GSM_ENABLE_BLUEPHONET) || defined(GSM_ENABLE_DKU2PHONET)
 	extern GSM_Protocol_Functions PHONETProtocol;
 #endif
-#if defined(GSM_ENABLE_AT) || defined(GSM_ENABLE_BLUEAT) || defined(GSM_ENABLE_IRDAAT) || defined(GSM_ENABLE_DKU2AT)
+#if defined(GSM_ENABLE_AT) || defined(GSM_ENABLE_BLUEAT) || defined(GSM_ENABLE_IRDAAT) || defined(GSM_ENABLE_DKU2AT) || defined(GSM_ENABLE_SOCKETAT)
 	extern GSM_Protocol_Functions ATProtocol;
 #endif
 #ifdef GSM_ENABLE_ALCABUS
 	extern GSM_Protocol_Functions ALCABUSProtocol;
 #endif
-#if defined(GSM_ENABLE_IRDAOBEX) || defined(GSM_ENABLE_BLUEOBEX) || defined(GSM_ENABLE_ATOBEX)
+#if defined(GSM_ENABLE_IRDAOBEX) || defined(GSM_ENABLE_BLUEOBEX) || defined(GSM_ENABLE_ATOBEX) || defined(GSM_ENABLE_SOCKETOBEX)
 	extern GSM_Protocol_Functions OBEXProtocol;
 #endif
 #if defined(GSM_ENABLE_BLUEGNAPBUS) || defined(GSM_ENABLE_IRDAGNAPBUS)
@@ -381,19 +430,19 @@ typedef struct {
 #ifdef GSM_ENABLE_MBUS2
 		GSM_Protocol_MBUS2Data		MBUS2;
 #endif
-#if defined(GSM_ENABLE_FBUS2) || defined(GSM_ENABLE_FBUS2IRDA) || defined(GSM_ENABLE_FBUS2DLR3) || defined(GSM_ENABLE_DKU5FBUS2) || defined(GSM_ENABLE_FBUS2PL2303) || defined(GSM_ENABLE_FBUS2BLUE) || defined(GSM_ENABLE_BLUEFBUS2)
+#if defined(GSM_ENABLE_FBUS2) || defined(GSM_ENABLE_FBUS2IRDA) || defined(GSM_ENABLE_FBUS2DLR3) || defined(GSM_ENABLE_DKU5FBUS2) || defined(GSM_ENABLE_FBUS2PL2303) || defined(GSM_ENABLE_FBUS2BLUE) || defined(GSM_ENABLE_BLUEFBUS2) || defined(GSM_ENABLE_SOCKETFBUS2)
 		GSM_Protocol_FBUS2Data		FBUS2;
 #endif
 #if defined(GSM_ENABLE_PHONETBLUE) || defined(GSM_ENABLE_IRDAPHONET) || defined(GSM_ENABLE_BLUEPHONET) || defined(GSM_ENABLE_DKU2PHONET)
 		GSM_Protocol_PHONETData		PHONET;
 #endif
-#if defined(GSM_ENABLE_AT) || defined(GSM_ENABLE_BLUEAT) || defined(GSM_ENABLE_IRDAAT) || defined(GSM_ENABLE_DKU2AT)
+#if defined(GSM_ENABLE_AT) || defined(GSM_ENABLE_BLUEAT) || defined(GSM_ENABLE_IRDAAT) || defined(GSM_ENABLE_DKU2AT) || defined(GSM_ENABLE_SOCKETAT)
 		GSM_Protocol_ATData		AT;
 #endif
 #ifdef GSM_ENABLE_ALCABUS
 		GSM_Protocol_ALCABUSData	ALCABUS;
 #endif
-#if defined(GSM_ENABLE_IRDAOBEX) || defined(GSM_ENABLE_BLUEOBEX) || defined(GSM_ENABLE_ATOBEX)
+#if defined(GSM_ENABLE_IRDAOBEX) || defined(GSM_ENABLE_BLUEOBEX) || defined(GSM_ENABLE_ATOBEX) || defined(GSM_ENABLE_SOCKETOBEX)
 		GSM_Protocol_OBEXData		OBEX;
 #endif
 #if defined(GSM_ENABLE_BLUEGNAPBUS) || defined(GSM_ENABLE_IRDAGNAPBUS)
@@ -672,6 +721,11 @@ typedef struct {
 	 * Error returned by function in phone module.
 	 */
 	GSM_Error		DispatchError;
+	/**
+	 * Capabilities stored by previous connection, NULL if not
+	 * available, see gsmcache.h.
+	 */
+	INI_Section		*CapabilityCache;
 
 	/**
 	 * Structure with private phone modules data.
@@ -1292,6 +1346,26 @@ typedef struct {
 	 * Sets phone power state
 	 */
 	GSM_Error (*SetPower)	(GSM_StateMachine *s, gboolean on);
+	/**
+	 * Reads all SMS messages and passes them to callback.
+	 */
+	GSM_Error (*GetAllSMS)	(GSM_StateMachine *s, GSM_GetAllSMSCallback callback, void *user_data);
+	/**
+	 * Reads whole file passing its data to sink.
+	 */
+	GSM_Error (*GetFileStream)	(GSM_StateMachine *s, GSM_File *File, GSM_FileSink sink, void *user_data);
+	/**
+	 * Adds file reading its data from source.
+	 */
+	GSM_Error (*AddFileStream)	(GSM_StateMachine *s, GSM_File *File, GSM_FileSource source, void *user_data);
+	/**
+	 * Reports phonebook changes since last synchronisation.
+	 */
+	GSM_Error (*GetMemoryChanges)	(GSM_StateMachine *s, GSM_MemoryType type, const char *state_file, GSM_MemoryChangeCallback callback, void *user_data);
+	/**
+	 * Reports calendar changes since last synchronisation.
+	 */
+	GSM_Error (*GetCalendarChanges)	(GSM_StateMachine *s, const char *state_file, GSM_CalendarChangeCallback callback, void *user_data);
 } GSM_Phone_Functions;
 
 	extern GSM_Phone_Functions NAUTOPhone;
@@ -349,38 +349,71 @@ void EncodeBCD (unsigned char *dest, const unsigned char *src, int len, gboolean
 	if (fill && (len & 0x01)) dest[current]=dest[current] | 0xf0;
 }
 
-int DecodeWithHexBinAlphabet (unsigned char mychar)
-{
-	if (mychar >= 'A' && mychar <= 'F')
-		return mychar - 'A' + 10;
-
-	if (mychar >= 'a' && mychar <= 'f')
-		return mychar - 'a' + 10;
+/* Value of hex digit for every char, -1 for chars which are not hex digits */
+static const signed char HexBinDecodeTable[256] = {
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+	-1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
 
-	if (mychar >= '0' && mychar <= '9')
-		return mychar - '0';
+static const char HexBinEncodeTable[16] = {
+	'0', '1', '2', '3', '4', '5', '6', '7',
+	'8', '9', 'A', 'B', 'C', 'D', 'E', 'F',
+};
 
-	return -1;
+int DecodeWithHexBinAlphabet (unsigned char mychar)
+{
+	return HexBinDecodeTable[mychar];
 }
 
 char EncodeWithHexBinAlphabet (int digit)
 {
-	if (digit >= 0 && digit <= 9) return '0'+(digit);
-	if (digit >=10 && digit <=15) return 'A'+(digit-10);
+	if (digit >= 0 && digit <= 15) return HexBinEncodeTable[digit];
 	return 0;
 }
 
+size_t FindNonHexChar(const char *src, size_t len)
+{
+	const unsigned char *in = (const unsigned char *)src;
+	size_t i = 0;
+
+	/* Any invalid char makes the result negative */
+	while (i + 4 <= len &&
+			(HexBinDecodeTable[in[i]] | HexBinDecodeTable[in[i + 1]] |
+			 HexBinDecodeTable[in[i + 2]] | HexBinDecodeTable[in[i + 3]]) >= 0) {
+		i += 4;
+	}
+	while (i < len && HexBinDecodeTable[in[i]] >= 0) {
+		i++;
+	}
+	return i;
+}
+
 void DecodeHexUnicode (unsigned char *dest, const char *src, size_t len)
 {
+	const unsigned char *in = (const unsigned char *)src;
 	size_t i, current = 0;
 
 	for (i = 0; i < len ; i += 4) {
 		dest[current++] =
-			(DecodeWithHexBinAlphabet(src[i + 0]) << 4) +
-			DecodeWithHexBinAlphabet(src[i + 1]);
+			(HexBinDecodeTable[in[i + 0]] << 4) +
+			HexBinDecodeTable[in[i + 1]];
 		dest[current++] =
-			(DecodeWithHexBinAlphabet(src[i + 2]) << 4) +
-			DecodeWithHexBinAlphabet(src[i + 3]);
+			(HexBinDecodeTable[in[i + 2]] << 4) +
+			HexBinDecodeTable[in[i + 3]];
 	}
 	dest[current++] = 0;
 	dest[current] = 0;
@@ -393,27 +426,27 @@ void EncodeHexUnicode (char *dest, const unsigned char *src, size_t len)
 
 gboolean DecodeHexBin (unsigned char *dest, const unsigned char *src, int len)
 {
-	int i,current=0, low, high;
+	int i, low, high;
 
 	for (i = 0; i < len/2 ; i++) {
-		low = DecodeWithHexBinAlphabet(src[i*2+1]);
-		high = DecodeWithHexBinAlphabet(src[i*2]);
-		if (low < 0 || high < 0) return FALSE;
-		dest[current++] = (high << 4) | low;
+		high = HexBinDecodeTable[src[i*2]];
+		low = HexBinDecodeTable[src[i*2+1]];
+		if ((low | high) < 0) return FALSE;
+		dest[i] = (high << 4) | low;
 	}
-	dest[current] = 0;
+	dest[i] = 0;
 	return TRUE;
 }
 
 void EncodeHexBin (char *dest, const unsigned char *src, size_t len)
 {
-	size_t i, outpos = 0;
+	size_t i;
 
 	for (i = 0; i < len; i++) {
-		dest[outpos++] = EncodeWithHexBinAlphabet(src[i] >> 4);
-		dest[outpos++] = EncodeWithHexBinAlphabet(src[i] & 0xF);
+		dest[i * 2] = HexBinEncodeTable[src[i] >> 4];
+		dest[i * 2 + 1] = HexBinEncodeTable[src[i] & 0xF];
 	}
-	dest[outpos] = 0;
+	dest[len * 2] = 0;
 }
 
 /* ETSI GSM 03.38, section 6.2.1: Default alphabet for SMS messages */
@@ -477,9 +510,47 @@ static unsigned char GSM_DefaultAlphabetCharsExtension[][3] =
 	{0x00,0x00,0x00}
 };
 
+/**
+ * Cache for decoding of extension chars, indexed by second char of the
+ * escape sequence. Entry is index into GSM_DefaultAlphabetCharsExtension
+ * plus one, GSM_EXTENSION_NONE if there is no such extension char or zero
+ * if not yet looked up.
+ */
+static unsigned char GSM_DefaultAlphabetExtensionCache[256];
+
+#define GSM_EXTENSION_NONE 0xff
+
+/**
+ * Finds extension char for second char of escape sequence.
+ *
+ * \return Index into GSM_DefaultAlphabetCharsExtension or -1.
+ */
+static int GSM_FindExtension(unsigned char code)
+{
+	unsigned char cached;
+	int i;
+
+	cached = GSM_DefaultAlphabetExtensionCache[code];
+	if (cached == 0) {
+		cached = GSM_EXTENSION_NONE;
+		for (i = 0; GSM_DefaultAlphabetCharsExtension[i][0] != 0x00; i++) {
+			if (GSM_DefaultAlphabetCharsExtension[i][0] == code) {
+				cached = i + 1;
+				break;
+			}
+		}
+		GSM_DefaultAlphabetExtensionCache[code] = cached;
+	}
+	if (cached == GSM_EXTENSION_NONE) {
+		return -1;
+	}
+	return cached - 1;
+}
+
 void DecodeDefault (unsigned char *dest, const unsigned char *src, size_t len, gboolean UseExtensions, unsigned char *ExtraAlphabet)
 {
 	size_t 	pos, current = 0, i;
+	int	ext;
 
 #ifdef DEBUG
 	DumpMessageText(&GSM_global_debug, src, len);
@@ -487,16 +558,12 @@ void DecodeDefault (unsigned char *dest, const unsigned char *src, size_t len, g
 
 	for (pos = 0; pos < len; pos++) {
 		if ((pos < (len - 1)) && UseExtensions && src[pos] == 0x1b) {
-			for (i = 0; GSM_DefaultAlphabetCharsExtension[i][0] != 0x00; i++) {
-				if (GSM_DefaultAlphabetCharsExtension[i][0] == src[pos + 1]) {
-					dest[current++] = GSM_DefaultAlphabetCharsExtension[i][1];
-					dest[current++] = GSM_DefaultAlphabetCharsExtension[i][2];
-					pos++;
-					break;
-				}
-			}
+			ext = GSM_FindExtension(src[pos + 1]);
 			/* Skip rest if we've found something */
-			if (GSM_DefaultAlphabetCharsExtension[i][0] != 0x00) {
+			if (ext >= 0) {
+				dest[current++] = GSM_DefaultAlphabetCharsExtension[ext][1];
+				dest[current++] = GSM_DefaultAlphabetCharsExtension[ext][2];
+				pos++;
 				continue;
 			}
 		}
@@ -538,78 +605,133 @@ static unsigned char ConvertTable[] =
 "\x00\x74\x01\x66\x00\x54\x01\x67\x00\x74\x00\xd9\x00\x55\x00\xda\x00\x55\x00\xfa\x00\x75\x00\xdb\x00\x55\x00\xfb\x00\x75\x01\x68\x00\x55\x01\x69\x00\x75\x01\x6a\x00\x55\x01\x6b\x00\x75\x01\x6c\x00\x55\x01\x6d\x00\x75\x01\x6e\x00\x55\x01\x6f\x00\x75\x01\x70\x00\x55\x01\x71\x00\x75\x01\x72\x00\x55\x01\x73\x00\x75\x01\xaf\x00\x55\x01\xb0\x00\x75\x01\xd3\x00\x55\x01\xd4\x00\x75\x01\xd5\x00\x55\x01\xd6\x00\x75\x01\xd7\x00\x55\x01\xd8\x00\x75\x01\xd9\x00\x55\x01\xda\x00\x75\x01\xdb\x00\x55\x01\xdc\x00\x75\x1e\xe4\x00\x55\x1e\xe5\x00\x75\x1e\xe6\x00\x55\x1e\xe7\x00\x75\x1e\xe8\x00\x55\x1e\xe9\x00\x75\x1e\xea\x00\x55\x1e\xeb\x00\x75\x1e\xec\x00\x55\x1e\xed\x00\x75\x1e\xee\x00\x55\x1e\xef\x00\x75\x1e\xf0\x00\x55\x1e\xf1\x00\x75\x01\x74\x00\x57\x01\x75\x00\x77\x1e\x80\x00\x57\x1e\x81\x00\x77\x1e\x82"\
 "\x00\x57\x1e\x83\x00\x77\x1e\x84\x00\x57\x1e\x85\x00\x77\x00\xdd\x00\x59\x00\xfd\x00\x79\x00\xff\x00\x79\x01\x76\x00\x59\x01\x77\x00\x79\x01\x78\x00\x59\x1e\xf2\x00\x59\x1e\xf3\x00\x75\x1e\xf4\x00\x59\x1e\xf5\x00\x79\x1e\xf6\x00\x59\x1e\xf7\x00\x79\x1e\xf8\x00\x59\x1e\xf9\x00\x79\x01\x79\x00\x5a\x01\x7a\x00\x7a\x01\x7b\x00\x5a\x01\x7c\x00\x7a\x01\x7d\x00\x5a\x01\x7e\x00\x7a\x01\xfc\x00\xc6\x01\xfd\x00\xe6\x01\xfe\x00\xd8\x01\xff\x00\xf8\x00\x00";
 
+/**
+ * Finds default alphabet char which can replace given Unicode char using
+ * ConvertTable.
+ *
+ * \return TRUE if replacement was found.
+ */
+static gboolean GSM_ConvertDefault(unsigned char hi, unsigned char lo, unsigned char *ret)
+{
+	size_t	j, z;
+
+	for (j = 0; ConvertTable[j*4] != 0x00 || ConvertTable[j*4+1] != 0x00; j++) {
+		if (hi != ConvertTable[j*4] || lo != ConvertTable[j*4+1]) {
+			continue;
+		}
+		for (z = 0; GSM_DefaultAlphabetUnicode[z][1] != 0x00; z++) {
+			if (ConvertTable[j*4+2]	== GSM_DefaultAlphabetUnicode[z][0] &&
+			    ConvertTable[j*4+3]	== GSM_DefaultAlphabetUnicode[z][1]) {
+				*ret = z;
+				return TRUE;
+			}
+		}
+	}
+	return FALSE;
+}
+
+/* Flags stored in GSM_DefaultAlphabetCache, lower byte is the GSM char */
+#define GSM_CACHE_DONE		0x8000
+#define GSM_CACHE_EXTENSION	0x0100
+#define GSM_CACHE_NORMAL	0x0200
+#define GSM_CACHE_CONVERT	0x0400
+#define GSM_CACHE_CODE		0x00ff
+
+/**
+ * Cache of Unicode to GSM default alphabet mapping, indexed by UCS-2
+ * code. Entries are computed on first use of each char, so searching
+ * the tables above happens only once per char. Zero means the entry was
+ * not yet computed, each entry is written at once, so concurrent callers
+ * can at worst compute same value twice.
+ */
+static unsigned short GSM_DefaultAlphabetCache[0x10000];
+
+/**
+ * Looks up how Unicode char is represented in GSM default alphabet,
+ * returns GSM_CACHE_* flags with the GSM char.
+ */
+static unsigned short GSM_DefaultAlphabetLookup(unsigned char hi, unsigned char lo)
+{
+	unsigned short	result;
+	unsigned char	code;
+	size_t		j;
+
+	result = GSM_DefaultAlphabetCache[(hi << 8) | lo];
+	if (result != 0) {
+		return result;
+	}
+
+	result = GSM_CACHE_DONE;
+	for (j = 0; GSM_DefaultAlphabetCharsExtension[j][0] != 0x00; j++) {
+		if (hi == GSM_DefaultAlphabetCharsExtension[j][1] &&
+		    lo == GSM_DefaultAlphabetCharsExtension[j][2]) {
+			result |= GSM_CACHE_EXTENSION | GSM_DefaultAlphabetCharsExtension[j][0];
+			break;
+		}
+	}
+	if ((result & GSM_CACHE_EXTENSION) == 0) {
+		for (j = 0; GSM_DefaultAlphabetUnicode[j][1] != 0x00; j++) {
+			if (hi == GSM_DefaultAlphabetUnicode[j][0] &&
+			    lo == GSM_DefaultAlphabetUnicode[j][1]) {
+				result |= GSM_CACHE_NORMAL | j;
+				break;
+			}
+		}
+	}
+	if ((result & (GSM_CACHE_EXTENSION | GSM_CACHE_NORMAL)) == 0 &&
+	    GSM_ConvertDefault(hi, lo, &code)) {
+		result |= GSM_CACHE_CONVERT | code;
+	}
+
+	GSM_DefaultAlphabetCache[(hi << 8) | lo] = result;
+	return result;
+}
+
 void EncodeDefault(unsigned char *dest, const unsigned char *src, size_t *len, gboolean UseExtensions, unsigned char *ExtraAlphabet)
 {
-	size_t 	i,current=0,j,z;
-	char 	ret;
-	gboolean	FoundSpecial,FoundNormal;
+	size_t 	i,current=0,j;
+	unsigned short	found;
+	unsigned char	ret;
+	gboolean	FoundSpecial;
 
 #ifdef DEBUG
 	DumpMessageText(&GSM_global_debug, src, (*len)*2);
 #endif
 
 	for (i = 0; i < *len; i++) {
-		FoundSpecial = FALSE;
-		j = 0;
-		while (GSM_DefaultAlphabetCharsExtension[j][0]!=0x00 && UseExtensions) {
-			if (src[i*2] 	== GSM_DefaultAlphabetCharsExtension[j][1] &&
-			    src[i*2+1] 	== GSM_DefaultAlphabetCharsExtension[j][2]) {
-				dest[current++] = 0x1b;
-				dest[current++] = GSM_DefaultAlphabetCharsExtension[j][0];
-				FoundSpecial 	= TRUE;
-				break;
-			}
-			j++;
+		found = GSM_DefaultAlphabetLookup(src[i*2], src[i*2+1]);
+		if (UseExtensions && (found & GSM_CACHE_EXTENSION)) {
+			dest[current++] = 0x1b;
+			dest[current++] = found & GSM_CACHE_CODE;
+			continue;
 		}
-		if (!FoundSpecial) {
-			ret 		= '?';
-			FoundNormal 	= FALSE;
-			j 		= 0;
-			while (GSM_DefaultAlphabetUnicode[j][1]!=0x00) {
-				if (src[i*2]	== GSM_DefaultAlphabetUnicode[j][0] &&
-				    src[i*2+1]	== GSM_DefaultAlphabetUnicode[j][1]) {
-					ret 		= j;
-					FoundNormal 	= TRUE;
+		if (found & GSM_CACHE_NORMAL) {
+			dest[current++] = found & GSM_CACHE_CODE;
+			continue;
+		}
+		ret 		= '?';
+		FoundSpecial 	= FALSE;
+		if (ExtraAlphabet!=NULL) {
+			j = 0;
+			while (ExtraAlphabet[j] != 0x00 || ExtraAlphabet[j+1] != 0x00 || ExtraAlphabet[j+2] != 0x00) {
+				if (ExtraAlphabet[j+1] == src[i*2] &&
+				    ExtraAlphabet[j+2] == src[i*2 + 1]) {
+					ret		= ExtraAlphabet[j];
+					FoundSpecial	= TRUE;
 					break;
 				}
-				j++;
-			}
-			if (ExtraAlphabet!=NULL && !FoundNormal) {
-				j = 0;
-				while (ExtraAlphabet[j] != 0x00 || ExtraAlphabet[j+1] != 0x00 || ExtraAlphabet[j+2] != 0x00) {
-					if (ExtraAlphabet[j+1] == src[i*2] &&
-					    ExtraAlphabet[j+2] == src[i*2 + 1]) {
-						ret		= ExtraAlphabet[j];
-						FoundSpecial	= TRUE;
-						break;
-					}
-					j=j+3;
-				}
+				j=j+3;
 			}
-			if (!FoundNormal && !FoundSpecial) {
-				j = 0;
-				FoundNormal = FALSE;
-				while (ConvertTable[j*4]   != 0x00 ||
-				       ConvertTable[j*4+1] != 0x00) {
-					if (src[i*2]   == ConvertTable[j*4] &&
-					    src[i*2+1] == ConvertTable[j*4+1]) {
-						z = 0;
-						while (GSM_DefaultAlphabetUnicode[z][1]!=0x00) {
-							if (ConvertTable[j*4+2]	== GSM_DefaultAlphabetUnicode[z][0] &&
-							    ConvertTable[j*4+3]	== GSM_DefaultAlphabetUnicode[z][1]) {
-								ret 		= z;
-								FoundNormal 	= TRUE;
-								break;
-							}
-							z++;
-						}
-						if (FoundNormal) break;
-					}
-					j++;
-				}
+		}
+		if (!FoundSpecial) {
+			if (found & GSM_CACHE_CONVERT) {
+				ret = found & GSM_CACHE_CODE;
+			} else if (found & GSM_CACHE_EXTENSION) {
+				/* Extension chars are not converted in the cache */
+				GSM_ConvertDefault(src[i*2], src[i*2+1], &ret);
 			}
-			dest[current++]=ret;
 		}
+		dest[current++]=ret;
 	}
 	dest[current]=0;
 #ifdef DEBUG
@@ -619,38 +741,393 @@ void EncodeDefault(unsigned char *dest, const unsigned char *src, size_t *len, g
 	*len = current;
 }
 
+int GSM_DefaultAlphabetSeptets(unsigned char hi, unsigned char lo)
+{
+	unsigned short found;
+
+	found = GSM_DefaultAlphabetLookup(hi, lo);
+	if (found & GSM_CACHE_EXTENSION) {
+		return 2;
+	}
+	if (found & GSM_CACHE_NORMAL) {
+		return 1;
+	}
+	return 0;
+}
+
+/* 3GPP TS 23.038, annex A: National language tables. Locking shift
+ * tables list only chars which differ from default alphabet, single
+ * shift tables replace GSM_DefaultAlphabetCharsExtension. Format is
+ * same as in GSM_DefaultAlphabetCharsExtension:
+ * 1. GSM char 2. Unicode char
+ */
+static const unsigned char GSM_TurkishLockingShift[][3] =
+{
+	{0x04,0x20,0xAC},	/* Euro */
+	{0x07,0x01,0x31},	/* dotless i */
+	{0x0B,0x01,0x1E},	/* G breve */
+	{0x0C,0x01,0x1F},	/* g breve */
+	{0x1C,0x01,0x5E},	/* S cedilla */
+	{0x1D,0x01,0x5F},	/* s cedilla */
+	{0x40,0x01,0x30},	/* I dot */
+	{0x60,0x00,0xE7},	/* c cedilla */
+	{0x00,0x00,0x00}
+};
+
+static const unsigned char GSM_TurkishSingleShift[][3] =
+{
+	{0x0a,0x00,0x0c},	/* \f	*/
+	{0x14,0x00,0x5e},	/* ^	*/
+	{0x28,0x00,0x7b},	/* {	*/
+	{0x29,0x00,0x7d},	/* }	*/
+	{0x2f,0x00,0x5c},	/* \	*/
+	{0x3c,0x00,0x5b},	/* [	*/
+	{0x3d,0x00,0x7E},	/* ~	*/
+	{0x3e,0x00,0x5d},	/* ]	*/
+	{0x40,0x00,0x7C},	/* |	*/
+	{0x47,0x01,0x1E},	/* G breve */
+	{0x49,0x01,0x30},	/* I dot */
+	{0x53,0x01,0x5E},	/* S cedilla */
+	{0x63,0x00,0xE7},	/* c cedilla */
+	{0x65,0x20,0xAC},	/* Euro */
+	{0x67,0x01,0x1F},	/* g breve */
+	{0x69,0x01,0x31},	/* dotless i */
+	{0x73,0x01,0x5F},	/* s cedilla */
+	{0x00,0x00,0x00}
+};
+
+static const unsigned char GSM_SpanishSingleShift[][3] =
+{
+	{0x09,0x00,0xE7},	/* c cedilla */
+	{0x0a,0x00,0x0c},	/* \f	*/
+	{0x14,0x00,0x5e},	/* ^	*/
+	{0x28,0x00,0x7b},	/* {	*/
+	{0x29,0x00,0x7d},	/* }	*/
+	{0x2f,0x00,0x5c},	/* \	*/
+	{0x3c,0x00,0x5b},	/* [	*/
+	{0x3d,0x00,0x7E},	/* ~	*/
+	{0x3e,0x00,0x5d},	/* ]	*/
+	{0x40,0x00,0x7C},	/* |	*/
+	{0x41,0x00,0xC1},	/* A acute */
+	{0x49,0x00,0xCD},	/* I acute */
+	{0x4F,0x00,0xD3},	/* O acute */
+	{0x55,0x00,0xDA},	/* U acute */
+	{0x61,0x00,0xE1},	/* a acute */
+	{0x65,0x20,0xAC},	/* Euro */
+	{0x69,0x00,0xED},	/* i acute */
+	{0x6F,0x00,0xF3},	/* o acute */
+	{0x75,0x00,0xFA},	/* u acute */
+	{0x00,0x00,0x00}
+};
+
+static const unsigned char GSM_PortugueseLockingShift[][3] =
+{
+	{0x04,0x00,0xEA},	/* e circumflex */
+	{0x06,0x00,0xFA},	/* u acute */
+	{0x07,0x00,0xED},	/* i acute */
+	{0x08,0x00,0xF3},	/* o acute */
+	{0x09,0x00,0xE7},	/* c cedilla */
+	{0x0B,0x00,0xD4},	/* O circumflex */
+	{0x0C,0x00,0xF4},	/* o circumflex */
+	{0x0E,0x00,0xC1},	/* A acute */
+	{0x0F,0x00,0xE1},	/* a acute */
+	{0x12,0x00,0xAA},	/* feminine ordinal */
+	{0x13,0x00,0xC7},	/* C cedilla */
+	{0x14,0x00,0xC0},	/* A grave */
+	{0x15,0x22,0x1E},	/* infinity */
+	{0x16,0x00,0x5E},	/* ^	*/
+	{0x17,0x00,0x5C},	/* \	*/
+	{0x18,0x20,0xAC},	/* Euro */
+	{0x19,0x00,0xD3},	/* O acute */
+	{0x1A,0x00,0x7C},	/* |	*/
+	{0x1C,0x00,0xC2},	/* A circumflex */
+	{0x1D,0x00,0xE2},	/* a circumflex */
+	{0x1E,0x00,0xCA},	/* E circumflex */
+	{0x24,0x00,0xBA},	/* masculine ordinal */
+	{0x40,0x00,0xCD},	/* I acute */
+	{0x5B,0x00,0xC3},	/* A tilde */
+	{0x5C,0x00,0xD5},	/* O tilde */
+	{0x5D,0x00,0xDA},	/* U acute */
+	{0x5E,0x00,0xDC},	/* U diaeresis */
+	{0x5F,0x00,0xA7},	/* section */
+	{0x60,0x00,0x7E},	/* ~	*/
+	{0x7B,0x00,0xE3},	/* a tilde */
+	{0x7C,0x00,0xF5},	/* o tilde */
+	{0x7D,0x00,0x60},	/* `	*/
+	{0x7E,0x00,0xFC},	/* u diaeresis */
+	{0x7F,0x00,0xE0},	/* a grave */
+	{0x00,0x00,0x00}
+};
+
+static const unsigned char GSM_PortugueseSingleShift[][3] =
+{
+	{0x05,0x00,0xEA},	/* e circumflex */
+	{0x09,0x00,0xE7},	/* c cedilla */
+	{0x0a,0x00,0x0c},	/* \f	*/
+	{0x0B,0x00,0xD4},	/* O circumflex */
+	{0x0C,0x00,0xF4},	/* o circumflex */
+	{0x0E,0x00,0xC1},	/* A acute */
+	{0x0F,0x00,0xE1},	/* a acute */
+	{0x12,0x03,0xA6},	/* Phi */
+	{0x13,0x03,0x93},	/* Gamma */
+	{0x14,0x00,0x5e},	/* ^	*/
+	{0x15,0x03,0xA9},	/* Omega */
+	{0x16,0x03,0xA0},	/* Pi */
+	{0x17,0x03,0xA8},	/* Psi */
+	{0x18,0x03,0xA3},	/* Sigma */
+	{0x19,0x03,0x98},	/* Theta */
+	{0x1F,0x00,0xCA},	/* E circumflex */
+	{0x28,0x00,0x7b},	/* {	*/
+	{0x29,0x00,0x7d},	/* }	*/
+	{0x2f,0x00,0x5c},	/* \	*/
+	{0x3c,0x00,0x5b},	/* [	*/
+	{0x3d,0x00,0x7E},	/* ~	*/
+	{0x3e,0x00,0x5d},	/* ]	*/
+	{0x40,0x00,0x7C},	/* |	*/
+	{0x41,0x00,0xC0},	/* A grave */
+	{0x49,0x00,0xCD},	/* I acute */
+	{0x4F,0x00,0xD3},	/* O acute */
+	{0x55,0x00,0xDA},	/* U acute */
+	{0x5B,0x00,0xC3},	/* A tilde */
+	{0x5C,0x00,0xD5},	/* O tilde */
+	{0x61,0x00,0xC2},	/* A circumflex */
+	{0x65,0x20,0xAC},	/* Euro */
+	{0x69,0x00,0xED},	/* i acute */
+	{0x6F,0x00,0xF3},	/* o acute */
+	{0x75,0x00,0xFA},	/* u acute */
+	{0x7B,0x00,0xE3},	/* a tilde */
+	{0x7C,0x00,0xF5},	/* o tilde */
+	{0x7F,0x00,0xE2},	/* a circumflex */
+	{0x00,0x00,0x00}
+};
+
+/**
+ * Tables for national languages indexed by language identifier used in
+ * the UDH, NULL means default alphabet or its extension table.
+ */
+static const struct {
+	const unsigned char (*LockingShift)[3];
+	const unsigned char (*SingleShift)[3];
+} GSM_NationalTables[] = {
+	{NULL, NULL},
+	{GSM_TurkishLockingShift, GSM_TurkishSingleShift},
+	{NULL, GSM_SpanishSingleShift},
+	{GSM_PortugueseLockingShift, GSM_PortugueseSingleShift},
+};
+
+#define GSM_NATIONAL_TABLES (sizeof(GSM_NationalTables) / sizeof(GSM_NationalTables[0]))
+
+/**
+ * Finds Unicode char for GSM char in national table.
+ *
+ * \return Index into the table or -1.
+ */
+static int GSM_NationalFindCode(const unsigned char (*table)[3], unsigned char code)
+{
+	int i;
+
+	for (i = 0; table[i][0] != 0x00; i++) {
+		if (table[i][0] == code) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/**
+ * Finds GSM char for Unicode char in national table.
+ *
+ * \return GSM char or -1.
+ */
+static int GSM_NationalFindChar(const unsigned char (*table)[3], unsigned char hi, unsigned char lo)
+{
+	int i;
+
+	for (i = 0; table[i][0] != 0x00; i++) {
+		if (table[i][1] == hi && table[i][2] == lo) {
+			return table[i][0];
+		}
+	}
+	return -1;
+}
+
+/**
+ * Looks up Unicode char in national tables.
+ *
+ * \return GSM char with GSM_CACHE_NORMAL or GSM_CACHE_EXTENSION flag
+ * or zero if char can not be stored.
+ */
+static unsigned short GSM_NationalLookup(unsigned char hi, unsigned char lo, int LockingShift, int SingleShift)
+{
+	const unsigned char	(*locking)[3] = NULL;
+	const unsigned char	(*single)[3] = NULL;
+	unsigned short		found;
+	int			code;
+
+	if (LockingShift > 0 && (size_t)LockingShift < GSM_NATIONAL_TABLES) {
+		locking = GSM_NationalTables[LockingShift].LockingShift;
+	}
+	if (SingleShift > 0 && (size_t)SingleShift < GSM_NATIONAL_TABLES) {
+		single = GSM_NationalTables[SingleShift].SingleShift;
+	}
+
+	found = GSM_DefaultAlphabetLookup(hi, lo);
+	if (locking == NULL) {
+		if (found & GSM_CACHE_NORMAL) {
+			return found & (GSM_CACHE_NORMAL | GSM_CACHE_CODE);
+		}
+	} else {
+		code = GSM_NationalFindChar(locking, hi, lo);
+		if (code >= 0) {
+			return GSM_CACHE_NORMAL | code;
+		}
+		/* Default char is usable unless its code is reused */
+		if ((found & GSM_CACHE_NORMAL) &&
+		    GSM_NationalFindCode(locking, found & GSM_CACHE_CODE) < 0) {
+			return found & (GSM_CACHE_NORMAL | GSM_CACHE_CODE);
+		}
+	}
+	if (single == NULL) {
+		if (found & GSM_CACHE_EXTENSION) {
+			return found & (GSM_CACHE_EXTENSION | GSM_CACHE_CODE);
+		}
+	} else {
+		code = GSM_NationalFindChar(single, hi, lo);
+		if (code >= 0) {
+			return GSM_CACHE_EXTENSION | code;
+		}
+	}
+	return 0;
+}
+
+int GSM_NationalAlphabetSeptets(unsigned char hi, unsigned char lo, int LockingShift, int SingleShift)
+{
+	unsigned short found;
+
+	if (LockingShift == 0 && SingleShift == 0) {
+		return GSM_DefaultAlphabetSeptets(hi, lo);
+	}
+	found = GSM_NationalLookup(hi, lo, LockingShift, SingleShift);
+	if (found & GSM_CACHE_EXTENSION) {
+		return 2;
+	}
+	if (found & GSM_CACHE_NORMAL) {
+		return 1;
+	}
+	return 0;
+}
+
+void EncodeNational(unsigned char *dest, const unsigned char *src, size_t *len, int LockingShift, int SingleShift)
+{
+	size_t		i, current = 0;
+	unsigned short	found;
+	unsigned char	ret;
+
+	if (LockingShift == 0 && SingleShift == 0) {
+		EncodeDefault(dest, src, len, TRUE, NULL);
+		return;
+	}
+
+	for (i = 0; i < *len; i++) {
+		found = GSM_NationalLookup(src[i*2], src[i*2+1], LockingShift, SingleShift);
+		if (found & GSM_CACHE_EXTENSION) {
+			dest[current++] = 0x1b;
+			dest[current++] = found & GSM_CACHE_CODE;
+			continue;
+		}
+		if (found & GSM_CACHE_NORMAL) {
+			dest[current++] = found & GSM_CACHE_CODE;
+			continue;
+		}
+		/* Try replacement from ConvertTable, it has to fit into locking shift table */
+		ret = '?';
+		if (GSM_ConvertDefault(src[i*2], src[i*2+1], &ret)) {
+			found = GSM_NationalLookup(GSM_DefaultAlphabetUnicode[ret][0],
+				GSM_DefaultAlphabetUnicode[ret][1], LockingShift, 0);
+			if (found & GSM_CACHE_NORMAL) {
+				ret = found & GSM_CACHE_CODE;
+			} else {
+				ret = '?';
+			}
+		}
+		dest[current++] = ret;
+	}
+	dest[current] = 0;
+
+	*len = current;
+}
+
+void DecodeNational(unsigned char *dest, const unsigned char *src, size_t len, int LockingShift, int SingleShift)
+{
+	const unsigned char	(*locking)[3] = NULL;
+	const unsigned char	(*single)[3] = NULL;
+	size_t			pos, current = 0;
+	int			i;
+
+	if (LockingShift > 0 && (size_t)LockingShift < GSM_NATIONAL_TABLES) {
+		locking = GSM_NationalTables[LockingShift].LockingShift;
+	}
+	if (SingleShift > 0 && (size_t)SingleShift < GSM_NATIONAL_TABLES) {
+		single = GSM_NationalTables[SingleShift].SingleShift;
+	}
+	if (locking == NULL && single == NULL) {
+		DecodeDefault(dest, src, len, TRUE, NULL);
+		return;
+	}
+
+	for (pos = 0; pos < len; pos++) {
+		if ((pos < (len - 1)) && src[pos] == 0x1b) {
+			if (single == NULL) {
+				i = GSM_FindExtension(src[pos + 1]);
+				if (i >= 0) {
+					dest[current++] = GSM_DefaultAlphabetCharsExtension[i][1];
+					dest[current++] = GSM_DefaultAlphabetCharsExtension[i][2];
+					pos++;
+					continue;
+				}
+			} else {
+				i = GSM_NationalFindCode(single, src[pos + 1]);
+				if (i >= 0) {
+					dest[current++] = single[i][1];
+					dest[current++] = single[i][2];
+					pos++;
+					continue;
+				}
+			}
+		}
+		if (locking != NULL) {
+			i = GSM_NationalFindCode(locking, src[pos]);
+			if (i >= 0) {
+				dest[current++] = locking[i][1];
+				dest[current++] = locking[i][2];
+				continue;
+			}
+		}
+		dest[current++] = GSM_DefaultAlphabetUnicode[src[pos] & 0x7f][0];
+		dest[current++] = GSM_DefaultAlphabetUnicode[src[pos] & 0x7f][1];
+	}
+	dest[current++] = 0;
+	dest[current] = 0;
+}
+
 /* You don't have to use ConvertTable here - 1 char is replaced there by 1 char */
 void FindDefaultAlphabetLen(const unsigned char *src, size_t *srclen, size_t *smslen, size_t maxlen)
 {
-	size_t 	current=0,j,i;
-	gboolean	FoundSpecial;
+	size_t 	current=0,i,size;
 
 	i = 0;
 	while (src[i*2] != 0x00 || src[i*2+1] != 0x00) {
-		FoundSpecial = FALSE;
-		j = 0;
-		while (GSM_DefaultAlphabetCharsExtension[j][0]!=0x00) {
-			if (src[i*2] 	== GSM_DefaultAlphabetCharsExtension[j][1] &&
-			    src[i*2+1] 	== GSM_DefaultAlphabetCharsExtension[j][2]) {
-				FoundSpecial = TRUE;
-				if (current+2 > maxlen) {
-					*srclen = i;
-					*smslen = current;
-					return;
-				}
-				current+=2;
-				break;
-			}
-			j++;
+		if (GSM_DefaultAlphabetLookup(src[i*2], src[i*2+1]) & GSM_CACHE_EXTENSION) {
+			size = 2;
+		} else {
+			size = 1;
 		}
-		if (!FoundSpecial) {
-			if (current+1 > maxlen) {
-				*srclen = i;
-				*smslen = current;
-				return;
-			}
-			current++;
+		if (current+size > maxlen) {
+			*srclen = i;
+			*smslen = current;
+			return;
 		}
+		current += size;
 		i++;
 	}
 	*srclen = i;
@@ -659,6 +1136,37 @@ void FindDefaultAlphabetLen(const unsigned char *src, size_t *srclen, size_t *sm
 
 #define ByteMask ((1 << Bits) - 1)
 
+/**
+ * Unpacks 7 octets into 8 septets.
+ */
+static INLINE void GSM_UnpackGroup(const unsigned char *in, unsigned char *out)
+{
+	out[0] = in[0] & 0x7f;
+	out[1] = ((in[1] << 1) | (in[0] >> 7)) & 0x7f;
+	out[2] = ((in[2] << 2) | (in[1] >> 6)) & 0x7f;
+	out[3] = ((in[3] << 3) | (in[2] >> 5)) & 0x7f;
+	out[4] = ((in[4] << 4) | (in[3] >> 4)) & 0x7f;
+	out[5] = ((in[5] << 5) | (in[4] >> 3)) & 0x7f;
+	out[6] = ((in[6] << 6) | (in[5] >> 2)) & 0x7f;
+	out[7] = in[6] >> 1;
+}
+
+/**
+ * Packs 8 septets into 7 octets. The eighth output octet gets the
+ * overflow of last input char, same as the generic code does.
+ */
+static INLINE void GSM_PackGroup(const unsigned char *in, unsigned char *out)
+{
+	out[0] = (unsigned char)(in[0] | (in[1] << 7));
+	out[1] = (unsigned char)((in[1] >> 1) | (in[2] << 6));
+	out[2] = (unsigned char)((in[2] >> 2) | (in[3] << 5));
+	out[3] = (unsigned char)((in[3] >> 3) | (in[4] << 4));
+	out[4] = (unsigned char)((in[4] >> 4) | (in[5] << 3));
+	out[5] = (unsigned char)((in[5] >> 5) | (in[6] << 2));
+	out[6] = (unsigned char)((in[6] >> 6) | (in[7] << 1));
+	out[7] = in[7] >> 7;
+}
+
 int GSM_UnpackEightBitsToSeven(int offset, int in_length, int out_length,
                            const unsigned char *input, unsigned char *output)
 {
@@ -673,6 +1181,16 @@ int GSM_UnpackEightBitsToSeven(int offset, int in_length, int out_length,
 
         while ((input_pos - input) < in_length) {
 
+                /* Whole groups of 7 octets when we are aligned to them */
+                while (Bits == 7 &&
+                                in_length - (input_pos - input) >= 7 &&
+                                out_length - (output_pos - output) > 7) {
+                        GSM_UnpackGroup(input_pos, output_pos);
+                        input_pos += 7;
+                        output_pos += 8;
+                }
+                if ((input_pos - input) >= in_length) break;
+
                 *output_pos = ((*input_pos & ByteMask) << (7 - Bits)) | Rest;
                 Rest = *input_pos >> Bits;
 
@@ -717,7 +1235,17 @@ int GSM_PackSevenBitsToEight(int offset, const unsigned char *input, unsigned ch
         }
 
         while ((input_pos - input) < length) {
-                unsigned char Byte = *input_pos;
+                unsigned char Byte;
+
+                /* Whole groups of 8 septets when we are aligned to them */
+                while (Bits == 7 && length - (input_pos - input) >= 8) {
+                        GSM_PackGroup(input_pos, output_pos);
+                        input_pos += 8;
+                        output_pos += 7;
+                }
+                if ((input_pos - input) >= length) break;
+
+                Byte = *input_pos;
 
                 *output_pos = Byte >> (7 - Bits);
                 /* If we don't write at 0th bit of the octet, we should write
@@ -914,6 +1442,45 @@ void CopyUnicodeString(unsigned char *Dest, const unsigned char *Source)
 	Dest[j+1]	= 0;
 }
 
+size_t CopyUnicodeStringLen(unsigned char *Dest, const unsigned char *Source)
+{
+	GSM_UnicodeView view;
+
+	view = UnicodeView(Source);
+	return UnicodeViewCopy(Dest, &view);
+}
+
+GSM_UnicodeView UnicodeView(const unsigned char *text)
+{
+	GSM_UnicodeView view;
+
+	view.Text = text;
+	view.Length = UnicodeLength(text);
+	return view;
+}
+
+gboolean UnicodeViewEqual(const GSM_UnicodeView *a, const GSM_UnicodeView *b)
+{
+	if (a->Length != b->Length) {
+		return FALSE;
+	}
+	if (a->Length == 0) {
+		return TRUE;
+	}
+	return memcmp(a->Text, b->Text, a->Length * 2) == 0;
+}
+
+size_t UnicodeViewCopy(unsigned char *dest, const GSM_UnicodeView *src)
+{
+	/* memmove as callers sometimes copy text within same buffer */
+	if (dest != src->Text && src->Length > 0) {
+		memmove(dest, src->Text, src->Length * 2);
+	}
+	dest[src->Length * 2] = 0;
+	dest[src->Length * 2 + 1] = 0;
+	return src->Length;
+}
+
 /* Changes minor/major order in Unicode string */
 void ReverseUnicodeString(unsigned char *String)
 {
@@ -1367,17 +1934,22 @@ GSM_Error MyGetLine(char *Buffer, size_t *Pos, char *OutBuffer, size_t MaxLen, s
 	return ERR_NONE;
 }
 
-GSM_Error GSM_GetVCSLine(char **OutBuffer, char *Buffer, size_t *Pos, size_t MaxLen, gboolean MergeLines)
+GSM_Error GSM_GetVCSLine(char **OutBuffer, size_t *OutSize, char *Buffer, size_t *Pos, size_t MaxLen, gboolean MergeLines)
 {
 	gboolean skip = FALSE;
 	gboolean quoted_printable = FALSE;
 	gboolean was_cr = FALSE, was_lf = FALSE;
 	size_t pos=0;
-	int tmp=0;
-	size_t OutLen = 200;
-
-	*OutBuffer = (char *)malloc(OutLen);
-	if (*OutBuffer == NULL) return ERR_MOREMEMORY;
+	size_t tmp=0;
+	char *tmpbuffer;
+
+	/* Reuse buffer from previous line */
+	if (*OutBuffer == NULL || *OutSize < 200) {
+		free(*OutBuffer);
+		*OutSize = 200;
+		*OutBuffer = (char *)malloc(*OutSize);
+		if (*OutBuffer == NULL) return ERR_MOREMEMORY;
+	}
 	(*OutBuffer)[0] = 0;
 	pos = 0;
 	if (Buffer == NULL) return ERR_NONE;
@@ -1422,7 +1994,7 @@ GSM_Error GSM_GetVCSLine(char **OutBuffer, char *Buffer, size_t *Pos, size_t Max
 			break;
 		default:
 			/* Detect quoted printable for possible escaping */
-			if (Buffer[*Pos] == ':' &&
+			if (Buffer[*Pos] == ':' && !quoted_printable &&
 					strstr(*OutBuffer, ";ENCODING=QUOTED-PRINTABLE") != NULL) {
 				quoted_printable = TRUE;
 			}
@@ -1430,10 +2002,12 @@ GSM_Error GSM_GetVCSLine(char **OutBuffer, char *Buffer, size_t *Pos, size_t Max
 			(*OutBuffer)[pos]     = Buffer[*Pos];
 			pos++;
 			(*OutBuffer)[pos] = 0;
-			if (pos + 2 >= OutLen) {
-				OutLen += 100;
-				*OutBuffer = (char *)realloc(*OutBuffer, OutLen);
-				if (*OutBuffer == NULL) return ERR_MOREMEMORY;
+			if (pos + 2 >= *OutSize) {
+				/* Grow geometrically, photos can be quite long */
+				tmpbuffer = (char *)realloc(*OutBuffer, *OutSize * 2);
+				if (tmpbuffer == NULL) return ERR_MOREMEMORY;
+				*OutBuffer = tmpbuffer;
+				*OutSize *= 2;
 			}
 		}
 		(*Pos)++;
@@ -1546,16 +2120,26 @@ gboolean EncodeUTF8QuotedPrintable(char *dest, const unsigned char *src)
 	return retval;
 }
 
-gboolean EncodeUTF8(char *dest, const unsigned char *src)
+size_t EncodeUTF8Len(char *dest, const unsigned char *src, size_t len)
 {
-	size_t i, j=0, z, len;
-	unsigned char	mychar[8];
-	gboolean		retval = FALSE;
+	size_t i = 0, j = 0;
 	unsigned long value, second;
 
-	len = UnicodeLength(src);
-
-	for (i = 0; i < len; i++) {
+	while (i < len) {
+		/* Plain ASCII, four chars at once */
+		while (i + 4 <= len &&
+				(src[i * 2] | src[i * 2 + 2] | src[i * 2 + 4] | src[i * 2 + 6]) == 0 &&
+				((src[i * 2 + 1] | src[i * 2 + 3] | src[i * 2 + 5] | src[i * 2 + 7]) & 0x80) == 0) {
+			dest[j] = src[i * 2 + 1];
+			dest[j + 1] = src[i * 2 + 3];
+			dest[j + 2] = src[i * 2 + 5];
+			dest[j + 3] = src[i * 2 + 7];
+			i += 4;
+			j += 4;
+		}
+		if (i >= len) {
+			break;
+		}
 		value = src[i * 2] * 256 + src[i * 2 + 1];
 		/* Decode UTF-16 */
 		if (value >= 0xD800 && value <= 0xDBFF && (i + 1) < len) {
@@ -1565,15 +2149,21 @@ gboolean EncodeUTF8(char *dest, const unsigned char *src)
 				value = ((value - 0xD800) << 10) + (second - 0xDC00) + 0x010000;
 			}
 		}
-		z = EncodeWithUTF8Alphabet(value, mychar);
-		memcpy(dest + j, mychar, z);
-		j += z;
-		if (z > 1) {
-			retval = TRUE;
-		}
+		j += EncodeWithUTF8Alphabet(value, (unsigned char *)dest + j);
+		i++;
 	}
 	dest[j] = 0;
-	return retval;
+	return j;
+}
+
+gboolean EncodeUTF8(char *dest, const unsigned char *src)
+{
+	size_t len;
+
+	len = UnicodeLength(src);
+
+	/* Every non ASCII char takes more than one byte */
+	return EncodeUTF8Len(dest, src, len) != len;
 }
 
 /* Decode UTF8 char to Unicode char */
@@ -1657,23 +2247,81 @@ void DecodeUTF8QuotedPrintable(unsigned char *dest, const char *src, int len)
 	dest[j] = 0;
 }
 
-void DecodeUTF8(unsigned char *dest, const char *src, int len)
+size_t DecodeUTF8Len(unsigned char *dest, const char *src, size_t len)
 {
-	int 		i=0,j=0,z;
-	wchar_t		ret;
+	const unsigned char *in = (const unsigned char *)src;
+	size_t		i = 0, j = 0;
+	unsigned long	value;
+	int		z;
+	wchar_t		ret = 0;
 
+	/*
+	 * Invalid bytes which can not be converted by locale keep previous
+	 * char in ret, so it has to be updated on all code paths.
+	 */
 	while (i < len) {
-		z = DecodeWithUTF8Alphabet(src+i,&ret,len-i);
-		if (z<2) {
-			i+=EncodeWithUnicodeAlphabet(&src[i], &ret);
+		/* Plain ASCII, eight chars at once */
+		while (i + 8 <= len &&
+				((in[i] | in[i + 1] | in[i + 2] | in[i + 3] |
+				  in[i + 4] | in[i + 5] | in[i + 6] | in[i + 7]) & 0x80) == 0) {
+			for (z = 0; z < 8; z++) {
+				dest[j * 2] = 0;
+				dest[j * 2 + 1] = in[i + z];
+				j++;
+			}
+			ret = in[i + 7];
+			i += 8;
+		}
+		if (i >= len) {
+			break;
+		}
+		if (in[i] < 0x80) {
+			ret = in[i];
+			dest[j * 2] = 0;
+			dest[j * 2 + 1] = ret;
+			i++;
+			j++;
+			continue;
+		}
+		/* Chars outside BMP are stored as UTF-16 surrogate pair */
+		if (in[i] >= 0xF0 && in[i] <= 0xF4 && i + 3 < len &&
+				(in[i + 1] & 0xC0) == 0x80 &&
+				(in[i + 2] & 0xC0) == 0x80 &&
+				(in[i + 3] & 0xC0) == 0x80) {
+			value = ((unsigned long)(in[i] & 0x07) << 18) |
+				((unsigned long)(in[i + 1] & 0x3F) << 12) |
+				((in[i + 2] & 0x3F) << 6) |
+				(in[i + 3] & 0x3F);
+			if (value >= 0x10000 && value <= 0x10FFFF) {
+				value -= 0x10000;
+				dest[j * 2] = 0xD8 | ((value >> 18) & 0x03);
+				dest[j * 2 + 1] = (value >> 10) & 0xff;
+				dest[j * 2 + 2] = 0xDC | ((value >> 8) & 0x03);
+				dest[j * 2 + 3] = value & 0xff;
+				ret = 0xDC00 | (value & 0x3FF);
+				i += 4;
+				j += 2;
+				continue;
+			}
+		}
+		z = DecodeWithUTF8Alphabet(in + i, &ret, len - i);
+		if (z < 2) {
+			i += EncodeWithUnicodeAlphabet(&src[i], &ret);
 		} else {
-			i+=z;
+			i += z;
 		}
-		dest[j++] = (ret >> 8) & 0xff;
-		dest[j++] = ret & 0xff;
+		dest[j * 2] = (ret >> 8) & 0xff;
+		dest[j * 2 + 1] = ret & 0xff;
+		j++;
 	}
-	dest[j++] = 0;
-	dest[j] = 0;
+	dest[j * 2] = 0;
+	dest[j * 2 + 1] = 0;
+	return j;
+}
+
+void DecodeUTF8(unsigned char *dest, const char *src, int len)
+{
+	DecodeUTF8Len(dest, src, len);
 }
 
 void DecodeXMLUTF8(unsigned char *dest, const char *src, int len)
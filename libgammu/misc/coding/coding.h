@@ -30,6 +30,46 @@ typedef		int wint_t;
 /* ---------------------------- Unicode ------------------------------------ */
 gboolean 		myiswspace	  		(unsigned const char *src);
 
+/**
+ * Unicode text with known length. It allows passing text together with
+ * its length, so that it does not have to be found again by
+ * UnicodeLength. Text still has to be terminated by double zero.
+ */
+typedef struct {
+	/**
+	 * Text in big endian UCS-2.
+	 */
+	const unsigned char *Text;
+	/**
+	 * Length of text in chars.
+	 */
+	size_t Length;
+} GSM_UnicodeView;
+
+/**
+ * Creates view on terminated Unicode text.
+ */
+GSM_UnicodeView	UnicodeView			(const unsigned char *text);
+
+/**
+ * Compares two Unicode texts.
+ */
+gboolean	UnicodeViewEqual		(const GSM_UnicodeView *a, const GSM_UnicodeView *b);
+
+/**
+ * Copies text from view including terminating zero.
+ *
+ * \return Length of copied text in chars.
+ */
+size_t		UnicodeViewCopy			(unsigned char *dest, const GSM_UnicodeView *src);
+
+/**
+ * Copies Unicode string including terminating zero.
+ *
+ * \return Length of copied string in chars.
+ */
+size_t		CopyUnicodeStringLen		(unsigned char *Dest, const unsigned char *Source);
+
 
 void 		ReverseUnicodeString		(unsigned char *String);
 
@@ -46,6 +86,17 @@ int		DecodeWithBCDAlphabet		(unsigned char value);
 void		DecodeBCD			(unsigned char *dest, const unsigned char *src, int len);
 void		EncodeBCD			(unsigned char *dest, const unsigned char *src, int len, gboolean fill);
 
+/* ------------------------------- HEX ------------------------------------- */
+int		DecodeWithHexBinAlphabet	(unsigned char mychar);
+char		EncodeWithHexBinAlphabet	(int digit);
+
+/**
+ * Finds first char which is not a hex digit.
+ *
+ * \return Position of the char, len if there is none.
+ */
+size_t		FindNonHexChar			(const char *src, size_t len);
+
 /* ------------------------------ UTF7 ------------------------------------- */
 void 		DecodeUTF7			(unsigned char *dest, const unsigned char *src, int len);
 
@@ -68,6 +119,33 @@ void 		EncodeDefault			(unsigned char *dest, const unsigned char *src, size_t *l
 void		DecodeDefault			(unsigned char *dest, const unsigned char *src, size_t len, gboolean UseExtensions,  unsigned char *ExtraAlphabet);
 void 		FindDefaultAlphabetLen		(const unsigned char *src, size_t *srclen, size_t *smslen, size_t maxlen);
 
+/**
+ * Returns number of septets needed to store Unicode char in GSM default
+ * alphabet (2 for chars from extension table), 0 if it can not be
+ * stored without conversion.
+ */
+int		GSM_DefaultAlphabetSeptets	(unsigned char hi, unsigned char lo);
+
+/**
+ * Returns number of septets needed to store Unicode char using national
+ * language locking and single shift tables (3GPP TS 23.038), 0 if it
+ * can not be stored. Language 0 means default alphabet and its
+ * extension table, unknown languages are handled same way.
+ */
+int		GSM_NationalAlphabetSeptets	(unsigned char hi, unsigned char lo, int LockingShift, int SingleShift);
+
+/**
+ * Same as EncodeDefault with extensions, but uses national language
+ * tables.
+ */
+void		EncodeNational			(unsigned char *dest, const unsigned char *src, size_t *len, int LockingShift, int SingleShift);
+
+/**
+ * Same as DecodeDefault with extensions, but uses national language
+ * tables.
+ */
+void		DecodeNational			(unsigned char *dest, const unsigned char *src, size_t len, int LockingShift, int SingleShift);
+
 int GSM_PackSevenBitsToEight	(int offset, const unsigned char *input, unsigned char *output, int length);
 int GSM_UnpackEightBitsToSeven	(int offset, int in_length, int out_length,
 				 const unsigned char *input, unsigned char *output);
@@ -119,6 +197,13 @@ int ClearBit (unsigned char *Buffer, size_t BitNum);
 
 void StringToDouble	(char *text, double *d);
 
+/**
+ * Length to pass as MaxLen to line reading functions when data is NUL
+ * terminated. Reading stops on NUL, so there is no need to compute
+ * length of possibly huge buffer for each line.
+ */
+#define GSM_LINE_UNBOUNDED ((size_t)-1)
+
 /**
  * Gets VCS line from buffer.
  *
@@ -126,12 +211,14 @@ void StringToDouble	(char *text, double *d);
  * continuation or quoted printable continutaion.
  * @param Buffer: Data source to parse.
  * @param Pos: Current position in data.
- * @param OutBuffer: Pointer to buffer pointer, which will be allocated.
+ * @param OutBuffer: Pointer to buffer pointer, which will be allocated
+ * or reused if it is big enough.
+ * @param OutSize: Size of allocated OutBuffer, 0 if none is allocated.
  * @param MaxLen: Maximal length of data to process.
  *
  * \return ERR_NONE on success, ERR_MOREMEMORY if buffer is too small.
  */
-GSM_Error GSM_GetVCSLine(char **OutBuffer, char *Buffer, size_t *Pos, size_t MaxLen, gboolean MergeLines);
+GSM_Error GSM_GetVCSLine(char **OutBuffer, size_t *OutSize, char *Buffer, size_t *Pos, size_t MaxLen, gboolean MergeLines);
 
 /**
  * Gets line from buffer.
@@ -727,6 +727,28 @@ void StripSpaces(char *buff)
 
 }
 
+GSM_Error GSM_ReplaceFile(FILE *file, const char *tmpname, const char *name)
+{
+	gboolean failed;
+
+	failed = ferror(file);
+	if (fclose(file) != 0) {
+		failed = TRUE;
+	}
+	if (!failed) {
+#ifdef WIN32
+		/* Windows can not rename over existing file */
+		remove(name);
+#endif
+		failed = (rename(tmpname, name) != 0);
+	}
+	if (failed) {
+		remove(tmpname);
+		return ERR_WRITING_FILE;
+	}
+	return ERR_NONE;
+}
+
 /* How should editor hadle tabs in this file? Add editor commands here.
  * vim: noexpandtab sw=8 ts=8 sts=8:
  */
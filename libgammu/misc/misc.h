@@ -25,6 +25,7 @@
 #include <gammu-datetime.h>
 #include <gammu-misc.h>
 #include <gammu-debug.h>
+#include <gammu-error.h>
 
 /* ------------------------------------------------------------------------- */
 
@@ -122,6 +123,19 @@ typedef int socket_type;
  */
 void StripSpaces(char *buff);
 
+/**
+ * Closes file written under temporary name and moves it over final
+ * name, so that partially written file is never visible. Temporary
+ * file is removed on failure.
+ *
+ * \param file Temporary file, it is closed.
+ * \param tmpname Name of temporary file.
+ * \param name Final name of file.
+ *
+ * \return Error code.
+ */
+GSM_Error GSM_ReplaceFile(FILE *file, const char *tmpname, const char *name);
+
 #if defined(_MSC_VER) && defined(__cplusplus)
 
     }
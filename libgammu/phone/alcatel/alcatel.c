@@ -2321,6 +2321,14 @@ static GSM_Error ALCATEL_GetNextSMS(GSM_StateMachine *s, GSM_MultiSMSMessage *sm
 	return ATGEN_GetNextSMS(s, sms, start);
 }
 
+static GSM_Error ALCATEL_GetAllSMS(GSM_StateMachine *s, GSM_GetAllSMSCallback callback, void *user_data)
+{
+	GSM_Error error;
+
+	if ((error = ALCATEL_SetATMode(s))!= ERR_NONE) return error;
+	return ATGEN_GetAllSMS(s, callback, user_data);
+}
+
 static GSM_Error ALCATEL_GetSMSStatus(GSM_StateMachine *s, GSM_SMSMemoryStatus *status)
 {
 	GSM_Error error;
@@ -4200,7 +4208,12 @@ GSM_Phone_Functions ALCATELPhone = {
 	NOTSUPPORTED,			/* 	GetGPRSAccessPoint	*/
 	NOTSUPPORTED,			/* 	SetGPRSAccessPoint	*/
 	NOTSUPPORTED,			/* 	GetScreenshot		*/
-	NOTSUPPORTED			/* 	SetPower		*/
+	NOTSUPPORTED,			/* 	SetPower		*/
+	ALCATEL_GetAllSMS,
+	NOTIMPLEMENTED,			/* 	GetFileStream		*/
+	NOTIMPLEMENTED,			/* 	AddFileStream		*/
+	NOTIMPLEMENTED,			/* 	GetMemoryChanges	*/
+	NOTIMPLEMENTED			/* 	GetCalendarChanges	*/
 };
 
 #endif
@@ -477,7 +477,8 @@ GSM_Error ATGEN_DecodePDUMessage(GSM_StateMachine *s, const char *PDU, const int
 
 	/* Decode hex encoded binary data */
 	if (!DecodeHexBin(buffer, PDU, length)) {
-		smprintf(s, "Failed to decode hex string!\n");
+		smprintf(s, "Failed to decode hex string at position %ld!\n",
+			(long)FindNonHexChar(PDU, length));
 		free(buffer);
 		return ERR_CORRUPTED;
 	}
@@ -1144,6 +1145,48 @@ GSM_Error ATGEN_ReplyGetMessageList(GSM_Protocol_Message *msg, GSM_StateMachine
 	return ERR_NONE;
 }
 
+/**
+ * Lists messages in currently selected memory into SMS cache.
+ *
+ * \param used Number of messages in memory according to memory status.
+ */
+static GSM_Error ATGEN_ReadSMSList(GSM_StateMachine *s, int used)
+{
+	GSM_Error error;
+	GSM_Phone_ATGENData *Priv = &s->Phone.Data.Priv.ATGEN;
+
+	Priv->LastSMSRead = 0;
+	Priv->SMSCount = 0;
+
+	if (Priv->SMSCache != NULL) {
+		free(Priv->SMSCache);
+		Priv->SMSCache = NULL;
+	}
+	smprintf(s, "Getting SMS locations\n");
+
+	if (Priv->SMSMode == SMS_AT_TXT) {
+		error = ATGEN_WaitForAutoLen(s, "AT+CMGL=\"ALL\"\r", 0x00, 500, ID_GetSMSMessage);
+	} else {
+		error = ATGEN_WaitForAutoLen(s, "AT+CMGL=4\r", 0x00, 500, ID_GetSMSMessage);
+	}
+	if (error == ERR_NOTSUPPORTED) {
+		error = ATGEN_WaitForAutoLen(s, "AT+CMGL\r", 0x00, 500, ID_GetSMSMessage);
+	}
+	/*
+	 * We did not read anything, but it is correct, indicate that
+	 * cache should be used (even if it is empty).
+	 */
+	if (error == ERR_NONE && Priv->SMSCache == NULL) {
+		Priv->SMSCache = (GSM_AT_SMS_Cache *)realloc(Priv->SMSCache, sizeof(GSM_AT_SMS_Cache));
+	}
+	if (used != Priv->SMSCount && (error == ERR_NONE || error == ERR_EMPTY)) {
+		smprintf(s, "WARNING: Used messages according to CPMS %d, but CMGL returned %d. Expect problems!\n", used, Priv->SMSCount);
+		smprintf(s, "HINT: Your might want to use F_USE_SMSTEXTMODE flag\n");
+		return ERR_NONE;
+	}
+	return error;
+}
+
 GSM_Error ATGEN_GetSMSList(GSM_StateMachine *s, gboolean first)
 {
 	GSM_Error error;
@@ -1201,43 +1244,18 @@ GSM_Error ATGEN_GetSMSList(GSM_StateMachine *s, gboolean first)
 			return ERR_NOTSUPPORTED;
 		}
 	}
-	Priv->LastSMSRead = 0;
-	Priv->SMSCount = 0;
-
-	if (Priv->SMSCache != NULL) {
-		free(Priv->SMSCache);
-		Priv->SMSCache = NULL;
-	}
-	smprintf(s, "Getting SMS locations\n");
-
-	if (Priv->SMSMode == SMS_AT_TXT) {
-		error = ATGEN_WaitForAutoLen(s, "AT+CMGL=\"ALL\"\r", 0x00, 500, ID_GetSMSMessage);
-	} else {
-		error = ATGEN_WaitForAutoLen(s, "AT+CMGL=4\r", 0x00, 500, ID_GetSMSMessage);
-	}
-	if (error == ERR_NOTSUPPORTED) {
-		error = ATGEN_WaitForAutoLen(s, "AT+CMGL\r", 0x00, 500, ID_GetSMSMessage);
-	}
-	/*
-	 * We did not read anything, but it is correct, indicate that
-	 * cache should be used (even if it is empty).
-	 */
-	if (error == ERR_NONE && Priv->SMSCache == NULL) {
-		Priv->SMSCache = (GSM_AT_SMS_Cache *)realloc(Priv->SMSCache, sizeof(GSM_AT_SMS_Cache));
-	}
-	if (used != Priv->SMSCount && (error == ERR_NONE || error == ERR_EMPTY)) {
-		smprintf(s, "WARNING: Used messages according to CPMS %d, but CMGL returned %d. Expect problems!\n", used, Priv->SMSCount);
-		smprintf(s, "HINT: Your might want to use F_USE_SMSTEXTMODE flag\n");
-		return ERR_NONE;
-	}
-	return error;
+	return ATGEN_ReadSMSList(s, used);
 }
 
-GSM_Error ATGEN_GetNextSMS(GSM_StateMachine *s, GSM_MultiSMSMessage *sms, gboolean start)
+/**
+ * Detects available SMS memories.
+ *
+ * \return ERR_NOTSUPPORTED if there is no SMS memory.
+ */
+static GSM_Error ATGEN_CheckSMSMemories(GSM_StateMachine *s)
 {
 	GSM_Error error;
 	GSM_Phone_ATGENData *Priv = &s->Phone.Data.Priv.ATGEN;
-	int usedsms = 0, i = 0, found = -1, tmpfound = -1;
 
 	if (Priv->PhoneSMSMemory == 0) {
 		error = ATGEN_SetSMSMemory(s, FALSE, FALSE, FALSE);
@@ -1255,6 +1273,153 @@ GSM_Error ATGEN_GetNextSMS(GSM_StateMachine *s, GSM_MultiSMSMessage *sms, gboole
 	}
 	if (Priv->SIMSMSMemory == AT_NOTAVAILABLE && Priv->PhoneSMSMemory == AT_NOTAVAILABLE) return ERR_NOTSUPPORTED;
 
+	return ERR_NONE;
+}
+
+/**
+ * Reads message from SMS cache, PDU from listing is used if
+ * available, otherwise the message is read from phone.
+ */
+static GSM_Error ATGEN_GetCachedSMS(GSM_StateMachine *s, GSM_MultiSMSMessage *sms, int index)
+{
+	GSM_Error error;
+	GSM_Phone_ATGENData *Priv = &s->Phone.Data.Priv.ATGEN;
+
+	sms->SMS[0].Folder = 0;
+	sms->Number = 1;
+	sms->SMS[0].Memory = Priv->SMSMemory;
+	sms->SMS[0].Location = Priv->SMSCache[index].Location;
+
+	if (Priv->SMSCache[index].State != -1) {
+		/* Get message from cache */
+		GSM_SetDefaultReceivedSMSData(&sms->SMS[0]);
+		s->Phone.Data.GetSMSMessage = sms;
+		smprintf(s, "Getting message from cache\n");
+		smprintf(s, "%s\n", Priv->SMSCache[index].PDU);
+		error = ATGEN_DecodePDUMessage(s,
+				Priv->SMSCache[index].PDU,
+				Priv->SMSCache[index].State);
+
+		/* Is the entry corrupted? */
+		if (error != ERR_CORRUPTED) {
+			return error;
+		}
+		/* Mark it as invalid */
+		Priv->SMSCache[index].State = -1;
+		/* And fall back to normal reading */
+	}
+
+	/* Finally read the message */
+	smprintf(s, "Reading next message on location %d\n", sms->SMS[0].Location);
+	return ATGEN_GetSMS(s, sms);
+}
+
+GSM_Error ATGEN_GetAllSMS(GSM_StateMachine *s, GSM_GetAllSMSCallback callback, void *user_data)
+{
+	GSM_Error error;
+	GSM_Phone_ATGENData *Priv = &s->Phone.Data.Priv.ATGEN;
+	GSM_MultiSMSMessage *sms;
+	gboolean SIM;
+	int used, i;
+
+	error = ATGEN_CheckSMSMemories(s);
+
+	if (error != ERR_NONE) {
+		return error;
+	}
+
+	/* Without listing messages have to be read one by one */
+	if (GSM_IsPhoneFeatureAvailable(s->Phone.Data.ModelInfo, F_DISABLE_CMGL)) {
+		return ERR_NOTIMPLEMENTED;
+	}
+
+	error = ATGEN_GetSMSMode(s);
+
+	if (error != ERR_NONE) {
+		return error;
+	}
+
+	/* Status of both memories is returned at once */
+	error = ATGEN_GetSMSStatus(s, &Priv->LastSMSStatus);
+
+	if (error != ERR_NONE) {
+		return error;
+	}
+
+	sms = (GSM_MultiSMSMessage *)malloc(sizeof(GSM_MultiSMSMessage));
+
+	if (sms == NULL) {
+		return ERR_MOREMEMORY;
+	}
+
+	/* SIM memory goes first as first folder, then phone memory */
+	for (Priv->SMSReadFolder = 1; Priv->SMSReadFolder <= 2; Priv->SMSReadFolder++) {
+		if (Priv->SMSReadFolder == 1 && Priv->SIMSMSMemory == AT_AVAILABLE) {
+			SIM = TRUE;
+			used = Priv->LastSMSStatus.SIMUsed;
+		} else if (Priv->PhoneSMSMemory == AT_AVAILABLE) {
+			SIM = FALSE;
+			used = Priv->LastSMSStatus.PhoneUsed;
+		} else {
+			break;
+		}
+
+		error = ATGEN_SetSMSMemory(s, SIM, FALSE, FALSE);
+
+		if (error != ERR_NONE) {
+			break;
+		}
+		error = ATGEN_ReadSMSList(s, used);
+
+		if (error == ERR_NOTSUPPORTED && Priv->SMSReadFolder == 1) {
+			/* Listing does not work, read messages one by one */
+			error = ERR_NOTIMPLEMENTED;
+			break;
+		}
+		if (error == ERR_NOTSUPPORTED || error == ERR_EMPTY) {
+			error = ERR_NONE;
+		} else if (error != ERR_NONE) {
+			break;
+		}
+
+		for (i = 0; i < Priv->SMSCount; i++) {
+			error = ATGEN_GetCachedSMS(s, sms, i);
+
+			if (error == ERR_CORRUPTED || error == ERR_EMPTY) {
+				smprintf(s, "Skipping message on location %d\n", sms->SMS[0].Location);
+				error = ERR_NONE;
+				continue;
+			}
+			if (error != ERR_NONE) {
+				break;
+			}
+			error = callback(s, sms, user_data);
+
+			if (error != ERR_NONE) {
+				break;
+			}
+		}
+		if (error != ERR_NONE || !SIM) {
+			break;
+		}
+	}
+
+	free(sms);
+	return error;
+}
+
+GSM_Error ATGEN_GetNextSMS(GSM_StateMachine *s, GSM_MultiSMSMessage *sms, gboolean start)
+{
+	GSM_Error error;
+	GSM_Phone_ATGENData *Priv = &s->Phone.Data.Priv.ATGEN;
+	int usedsms = 0, i = 0, found = -1, tmpfound = -1;
+
+	error = ATGEN_CheckSMSMemories(s);
+
+	if (error != ERR_NONE) {
+		return error;
+	}
+
 	/* On start we need to init everything */
 	if (start) {
 		/* Start from beginning */
@@ -1327,33 +1492,7 @@ GSM_Error ATGEN_GetNextSMS(GSM_StateMachine *s, GSM_MultiSMSMessage *sms, gboole
 
 		/* We might get no messages in listing above */
 		if (Priv->SMSCache != NULL) {
-			sms->SMS[0].Folder = 0;
-			sms->Number = 1;
-			sms->SMS[0].Memory = Priv->SMSMemory;
-			sms->SMS[0].Location = Priv->SMSCache[found].Location;
-
-			if (Priv->SMSCache[found].State != -1) {
-				/* Get message from cache */
-				GSM_SetDefaultReceivedSMSData(&sms->SMS[0]);
-				s->Phone.Data.GetSMSMessage = sms;
-				smprintf(s, "Getting message from cache\n");
-				smprintf(s, "%s\n", Priv->SMSCache[found].PDU);
-				error = ATGEN_DecodePDUMessage(s,
-						Priv->SMSCache[found].PDU,
-						Priv->SMSCache[found].State);
-
-				/* Is the entry corrupted? */
-				if (error != ERR_CORRUPTED) {
-					return error;
-				}
-				/* Mark it as invalid */
-				Priv->SMSCache[found].State = -1;
-				/* And fall back to normal reading */
-			}
-
-			/* Finally read the message */
-			smprintf(s, "Reading next message on location %d\n", sms->SMS[0].Location);
-			return ATGEN_GetSMS(s, sms);
+			return ATGEN_GetCachedSMS(s, sms, found);
 		}
 	}
 
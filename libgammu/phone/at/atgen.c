@@ -24,6 +24,7 @@
 #include <ctype.h>
 #include <stdarg.h>
 
+#include "../../gsmcache.h"
 #include "../../gsmcomon.h"
 #include "../../gsmphones.h"
 #include "../../misc/coding/coding.h"
@@ -439,14 +440,7 @@ GSM_Error ATGEN_WaitFor(GSM_StateMachine *s, const char * cmd, size_t len,
  */
 INLINE gboolean ATGEN_HasOnlyHexChars(const char *text, const size_t length)
 {
-	size_t i = 0;
-
-	for (i = 0; i < length; i++) {
-		if (!isxdigit((int)text[i])) {
-			return FALSE;
-		}
-	}
-	return TRUE;
+	return FindNonHexChar(text, length) == length;
 }
 
 /**
@@ -2047,6 +2041,94 @@ GSM_Error ATGEN_GetFirmware(GSM_StateMachine *s)
 	return error;
 }
 
+/**
+ * Section of capability cache used by AT driver.
+ */
+#define AT_CACHE_SECTION "atgen"
+
+/**
+ * Restores capabilities detected on previous connection from
+ * capability cache, so that they don't have to be probed again.
+ */
+static void ATGEN_LoadCapabilities(GSM_StateMachine *s)
+{
+	GSM_Phone_ATGENData	*Priv = &s->Phone.Data.Priv.ATGEN;
+	INI_Section		*cache = s->Phone.Data.CapabilityCache;
+	const char		*memories;
+
+	if (cache == NULL) {
+		return;
+	}
+
+	smprintf(s, "Loading cached capabilities\n");
+
+	Priv->NormalCharset	= INI_GetInt(cache, AT_CACHE_SECTION, "NormalCharset", 0);
+	Priv->IRACharset	= INI_GetInt(cache, AT_CACHE_SECTION, "IRACharset", 0);
+	Priv->GSMCharset	= INI_GetInt(cache, AT_CACHE_SECTION, "GSMCharset", 0);
+	Priv->UnicodeCharset	= INI_GetInt(cache, AT_CACHE_SECTION, "UnicodeCharset", 0);
+
+	/* All charsets are detected at once */
+	if (Priv->NormalCharset == 0 || Priv->IRACharset == 0 ||
+			Priv->GSMCharset == 0 || Priv->UnicodeCharset == 0) {
+		Priv->NormalCharset	= 0;
+		Priv->IRACharset	= 0;
+		Priv->GSMCharset	= 0;
+		Priv->UnicodeCharset	= 0;
+	}
+
+	Priv->PhoneSMSMemory	= INI_GetInt(cache, AT_CACHE_SECTION, "PhoneSMSMemory", 0);
+	Priv->SIMSMSMemory	= INI_GetInt(cache, AT_CACHE_SECTION, "SIMSMSMemory", 0);
+	Priv->PhoneSaveSMS	= INI_GetInt(cache, AT_CACHE_SECTION, "PhoneSaveSMS", 0);
+	Priv->SIMSaveSMS	= INI_GetInt(cache, AT_CACHE_SECTION, "SIMSaveSMS", 0);
+	Priv->MotorolaSMS	= INI_GetBool(cache, AT_CACHE_SECTION, "MotorolaSMS", FALSE);
+
+	Priv->PBKSBNR		= INI_GetInt(cache, AT_CACHE_SECTION, "PBKSBNR", 0);
+	Priv->PBK_SPBR		= INI_GetInt(cache, AT_CACHE_SECTION, "PBK_SPBR", 0);
+	Priv->PBK_MPBR		= INI_GetInt(cache, AT_CACHE_SECTION, "PBK_MPBR", 0);
+	Priv->PBKReadAhead	= INI_GetInt(cache, AT_CACHE_SECTION, "PBKReadAhead", 0);
+
+	memories = (const char *)INI_GetValue(cache, AT_CACHE_SECTION, "PBKMemories", FALSE);
+	if (memories != NULL && strlen(memories) <= AT_PBK_MAX_MEMORIES) {
+		strcpy(Priv->PBKMemories, memories);
+	}
+
+	Priv->CNMIMode			= INI_GetInt(cache, AT_CACHE_SECTION, "CNMIMode", -1);
+	Priv->CNMIProcedure		= INI_GetInt(cache, AT_CACHE_SECTION, "CNMIProcedure", -1);
+	Priv->CNMIDeliverProcedure	= INI_GetInt(cache, AT_CACHE_SECTION, "CNMIDeliverProcedure", -1);
+#ifdef GSM_ENABLE_CELLBROADCAST
+	Priv->CNMIBroadcastProcedure	= INI_GetInt(cache, AT_CACHE_SECTION, "CNMIBroadcastProcedure", -1);
+#endif
+}
+
+void ATGEN_SaveCapabilities(GSM_StateMachine *s, FILE *file)
+{
+	GSM_Phone_ATGENData	*Priv = &s->Phone.Data.Priv.ATGEN;
+
+	fprintf(file, "[%s]\n", AT_CACHE_SECTION);
+	fprintf(file, "NormalCharset = %d\n", Priv->NormalCharset);
+	fprintf(file, "IRACharset = %d\n", Priv->IRACharset);
+	fprintf(file, "GSMCharset = %d\n", Priv->GSMCharset);
+	fprintf(file, "UnicodeCharset = %d\n", Priv->UnicodeCharset);
+	fprintf(file, "PhoneSMSMemory = %d\n", Priv->PhoneSMSMemory);
+	fprintf(file, "SIMSMSMemory = %d\n", Priv->SIMSMSMemory);
+	fprintf(file, "PhoneSaveSMS = %d\n", Priv->PhoneSaveSMS);
+	fprintf(file, "SIMSaveSMS = %d\n", Priv->SIMSaveSMS);
+	fprintf(file, "MotorolaSMS = %s\n", Priv->MotorolaSMS ? "yes" : "no");
+	fprintf(file, "PBKSBNR = %d\n", Priv->PBKSBNR);
+	fprintf(file, "PBK_SPBR = %d\n", Priv->PBK_SPBR);
+	fprintf(file, "PBK_MPBR = %d\n", Priv->PBK_MPBR);
+	fprintf(file, "PBKReadAhead = %d\n", Priv->PBKReadAhead);
+	if (Priv->PBKMemories[0] != 0) {
+		fprintf(file, "PBKMemories = %s\n", Priv->PBKMemories);
+	}
+	fprintf(file, "CNMIMode = %d\n", Priv->CNMIMode);
+	fprintf(file, "CNMIProcedure = %d\n", Priv->CNMIProcedure);
+	fprintf(file, "CNMIDeliverProcedure = %d\n", Priv->CNMIDeliverProcedure);
+#ifdef GSM_ENABLE_CELLBROADCAST
+	fprintf(file, "CNMIBroadcastProcedure = %d\n", Priv->CNMIBroadcastProcedure);
+#endif
+}
+
 GSM_Error ATGEN_Initialise(GSM_StateMachine *s)
 {
 	GSM_Phone_ATGENData     *Priv = &s->Phone.Data.Priv.ATGEN;
@@ -2091,6 +2173,12 @@ GSM_Error ATGEN_Initialise(GSM_StateMachine *s)
 	Priv->MemoryUsed		= 0;
 	Priv->TextLength		= 0;
 	Priv->NumberLength		= 0;
+	Priv->PBKReadAhead		= 0;
+	Priv->PBKCache.Entries		= NULL;
+	Priv->PBKCache.First		= 0;
+	Priv->PBKCache.Last		= -1;
+	Priv->PBKCache.Count		= 0;
+	Priv->PBKCache.Failed		= FALSE;
 
 	Priv->CNMIMode			= -1;
 	Priv->CNMIProcedure		= -1;
@@ -2105,6 +2193,8 @@ GSM_Error ATGEN_Initialise(GSM_StateMachine *s)
 	Priv->SMSCache			= NULL;
 	Priv->ReplyState		= 0;
 
+	ATGEN_LoadCapabilities(s);
+
 	if (s->ConnectionType != GCT_IRDAAT && s->ConnectionType != GCT_BLUEAT) {
 		/* We try to escape AT+CMGS mode, at least Siemens M20
 		 * then needs to get some rest
@@ -2189,8 +2279,11 @@ GSM_Error ATGEN_Initialise(GSM_StateMachine *s)
 	/* Clear error flag */
 	error = ERR_NONE;
 
+	/* Features found by probing below were stored in capability cache */
+	if (s->Phone.Data.CapabilityCache != NULL) {
+		GSM_ApplyCachedFeatures(s);
 	/* Mode switching cabaple phones can switch using AT+MODE */
-	if (!Priv->Mode) {
+	} else if (!Priv->Mode) {
 		smprintf(s, "Checking for OBEX support\n");
 		/* We don't care about error here */
 		error = ATGEN_WaitForAutoLen(s, "AT+CPROT=?\r", 0x00, 20, ID_SetOBEX);
@@ -2220,7 +2313,7 @@ GSM_Error ATGEN_Initialise(GSM_StateMachine *s)
 #endif
 	}
 
-	if (!GSM_IsPhoneFeatureAvailable(s->Phone.Data.ModelInfo, F_MOBEX) && !GSM_IsPhoneFeatureAvailable(s->Phone.Data.ModelInfo, F_TSSPCSW) && !GSM_IsPhoneFeatureAvailable(s->Phone.Data.ModelInfo, F_NO_ATSYNCML)) {
+	if (s->Phone.Data.CapabilityCache == NULL && !GSM_IsPhoneFeatureAvailable(s->Phone.Data.ModelInfo, F_MOBEX) && !GSM_IsPhoneFeatureAvailable(s->Phone.Data.ModelInfo, F_TSSPCSW) && !GSM_IsPhoneFeatureAvailable(s->Phone.Data.ModelInfo, F_NO_ATSYNCML)) {
 		smprintf(s, "Checking for SYNCML/OBEX support\n");
 		/* We don't care about error here */
 		error = ATGEN_WaitForAutoLen(s, "AT+SYNCML=?\r", 0x00, 20, ID_SetOBEX);
@@ -3744,7 +3837,7 @@ GSM_Error ATGEN_GetMemoryStatus(GSM_StateMachine *s, GSM_MemoryStatus *Status)
 }
 
 /**
- * Parses reply on AT+CPBR=n.
+ * Parses single +CPBR line into phonebook entry.
  *
  * \todo Handle special replies from some phones:
  * LG C1200:
@@ -3756,210 +3849,200 @@ GSM_Error ATGEN_GetMemoryStatus(GSM_StateMachine *s, GSM_MemoryStatus *Status)
  * Samsung SGH-P900 reply:
  * +CPBR: 81,"#121#",129,"My Tempo",0
  */
-GSM_Error ATGEN_ReplyGetMemory(GSM_Protocol_Message *msg, GSM_StateMachine *s)
+static GSM_Error ATGEN_ParseMemoryEntry(GSM_StateMachine *s, const char *line, GSM_MemoryEntry *Memory)
 {
  	GSM_Phone_ATGENData 	*Priv = &s->Phone.Data.Priv.ATGEN;
- 	GSM_MemoryEntry		*Memory = s->Phone.Data.Memory;
 	GSM_Error		error;
 	unsigned char		buffer[500];
 	int offset, i;
 	int number_type, types[10];
 
-	switch (Priv->ReplyState) {
-	case AT_Reply_OK:
- 		smprintf(s, "Phonebook entry received\n");
-		/* Check for empty entries */
-		if (strcmp("OK", GetLineString(msg->Buffer, &Priv->Lines, 2)) == 0) {
-			Memory->EntriesNum = 0;
-			return ERR_EMPTY;
-		}
-
-		/* Set number type */
-		Memory->Entries[0].EntryType = PBK_Number_General;
-		Memory->Entries[0].Location = PBK_Location_Unknown;
-		Memory->Entries[0].VoiceTag = 0;
-		Memory->Entries[0].SMSList[0] = 0;
+	/* Set number type */
+	Memory->Entries[0].EntryType = PBK_Number_General;
+	Memory->Entries[0].Location = PBK_Location_Unknown;
+	Memory->Entries[0].VoiceTag = 0;
+	Memory->Entries[0].SMSList[0] = 0;
 
-		/* Set name type */
-		Memory->Entries[1].EntryType = PBK_Text_Name;
-		Memory->Entries[1].Location = PBK_Location_Unknown;
-
-		/* Try standard reply */
-		if (Priv->Manufacturer == AT_Motorola) {
-			/* Enable encoding guessing for Motorola */
-			error = ATGEN_ParseReply(s,
-						GetLineString(msg->Buffer, &Priv->Lines, 2),
-						"+CPBR: @i, @p, @I, @s",
-						&Memory->Location,
-						Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
-						&number_type,
-						Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text));
-		} else {
-			error = ATGEN_ParseReply(s,
-						GetLineString(msg->Buffer, &Priv->Lines, 2),
-						"+CPBR: @i, @p, @I, @e",
-						&Memory->Location,
-						Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
-						&number_type,
-						Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text));
-		}
-		if (error == ERR_NONE) {
-			smprintf(s, "Generic AT reply detected\n");
-			/* Adjust location */
-			Memory->Location = Memory->Location + 1 - Priv->FirstMemoryEntry;
-			/* Adjust number */
-			GSM_TweakInternationalNumber(Memory->Entries[0].Text, number_type);
-			/* Set number of entries */
-			Memory->EntriesNum = 2;
-			return ERR_NONE;
-		}
+	/* Set name type */
+	Memory->Entries[1].EntryType = PBK_Text_Name;
+	Memory->Entries[1].Location = PBK_Location_Unknown;
 
-		/* Try reply with extra unknown number (maybe group?), seen on Samsung SGH-P900 */
+	/* Try standard reply */
+	if (Priv->Manufacturer == AT_Motorola) {
+		/* Enable encoding guessing for Motorola */
 		error = ATGEN_ParseReply(s,
-					GetLineString(msg->Buffer, &Priv->Lines, 2),
-					"+CPBR: @i, @p, @I, @e, @i",
+					line,
+					"+CPBR: @i, @p, @I, @s",
 					&Memory->Location,
 					Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
 					&number_type,
-					Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text),
-					&i /* Don't know what this means */
-					);
-		if (error == ERR_NONE) {
-			smprintf(s, "AT reply with extra number detected\n");
-			/* Adjust location */
-			Memory->Location = Memory->Location + 1 - Priv->FirstMemoryEntry;
-			/* Adjust number */
-			GSM_TweakInternationalNumber(Memory->Entries[0].Text, number_type);
-			/* Set number of entries */
-			Memory->EntriesNum = 2;
-			return ERR_NONE;
-		}
-
-		/* Try reply with call date */
+					Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text));
+	} else {
 		error = ATGEN_ParseReply(s,
-					GetLineString(msg->Buffer, &Priv->Lines, 2),
-					"+CPBR: @i, @p, @I, @s, @d",
+					line,
+					"+CPBR: @i, @p, @I, @e",
 					&Memory->Location,
 					Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
 					&number_type,
-					Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text),
-					&Memory->Entries[2].Date);
-		if (error == ERR_NONE) {
-			smprintf(s, "Reply with date detected\n");
-			/* Adjust location */
-			Memory->Location = Memory->Location + 1 - Priv->FirstMemoryEntry;
-			/* Adjust number */
-			GSM_TweakInternationalNumber(Memory->Entries[0].Text, number_type);
-			/* Set date type */
-			Memory->Entries[2].EntryType = PBK_Date;
-			Memory->Entries[2].Location = PBK_Location_Unknown;
-			/* Set number of entries */
-			Memory->EntriesNum = 3;
-			/* Check whether date is correct */
-			if (!CheckTime(&Memory->Entries[2].Date) || !CheckDate(&Memory->Entries[2].Date)) {
-				smprintf(s, "Date looks invalid, ignoring!\n");
-				Memory->EntriesNum = 2;
-			}
-			return ERR_NONE;
+					Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text));
+	}
+	if (error == ERR_NONE) {
+		smprintf(s, "Generic AT reply detected\n");
+		/* Adjust location */
+		Memory->Location = Memory->Location + 1 - Priv->FirstMemoryEntry;
+		/* Adjust number */
+		GSM_TweakInternationalNumber(Memory->Entries[0].Text, number_type);
+		/* Set number of entries */
+		Memory->EntriesNum = 2;
+		return ERR_NONE;
+	}
+
+	/* Try reply with extra unknown number (maybe group?), seen on Samsung SGH-P900 */
+	error = ATGEN_ParseReply(s,
+				line,
+				"+CPBR: @i, @p, @I, @e, @i",
+				&Memory->Location,
+				Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
+				&number_type,
+				Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text),
+				&i /* Don't know what this means */
+				);
+	if (error == ERR_NONE) {
+		smprintf(s, "AT reply with extra number detected\n");
+		/* Adjust location */
+		Memory->Location = Memory->Location + 1 - Priv->FirstMemoryEntry;
+		/* Adjust number */
+		GSM_TweakInternationalNumber(Memory->Entries[0].Text, number_type);
+		/* Set number of entries */
+		Memory->EntriesNum = 2;
+		return ERR_NONE;
+	}
+
+	/* Try reply with call date */
+	error = ATGEN_ParseReply(s,
+				line,
+				"+CPBR: @i, @p, @I, @s, @d",
+				&Memory->Location,
+				Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
+				&number_type,
+				Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text),
+				&Memory->Entries[2].Date);
+	if (error == ERR_NONE) {
+		smprintf(s, "Reply with date detected\n");
+		/* Adjust location */
+		Memory->Location = Memory->Location + 1 - Priv->FirstMemoryEntry;
+		/* Adjust number */
+		GSM_TweakInternationalNumber(Memory->Entries[0].Text, number_type);
+		/* Set date type */
+		Memory->Entries[2].EntryType = PBK_Date;
+		Memory->Entries[2].Location = PBK_Location_Unknown;
+		/* Set number of entries */
+		Memory->EntriesNum = 3;
+		/* Check whether date is correct */
+		if (!CheckTime(&Memory->Entries[2].Date) || !CheckDate(&Memory->Entries[2].Date)) {
+			smprintf(s, "Date looks invalid, ignoring!\n");
+			Memory->EntriesNum = 2;
 		}
+		return ERR_NONE;
+	}
 
-		/*
-		 * Try reply with call date and some additional string.
-		 * I have no idea what should be stored there.
-		 * We store it in Entry 3, but do not use it for now.
-		 * Seen on T630.
-		 */
+	/*
+	 * Try reply with call date and some additional string.
+	 * I have no idea what should be stored there.
+	 * We store it in Entry 3, but do not use it for now.
+	 * Seen on T630.
+	 */
+	error = ATGEN_ParseReply(s,
+				line,
+				"+CPBR: @i, @s, @p, @I, @s, @d",
+				&Memory->Location,
+				Memory->Entries[3].Text, sizeof(Memory->Entries[3].Text),
+				Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
+				&number_type,
+				Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text),
+				&Memory->Entries[2].Date);
+	if (error == ERR_NONE) {
+		smprintf(s, "Reply with date detected\n");
+		/* Adjust location */
+		Memory->Location = Memory->Location + 1 - Priv->FirstMemoryEntry;
+		/* Adjust number */
+		GSM_TweakInternationalNumber(Memory->Entries[0].Text, number_type);
+		/* Set date type */
+		Memory->Entries[2].EntryType = PBK_Date;
+		/* Set number of entries */
+		Memory->EntriesNum = 3;
+		return ERR_NONE;
+	}
+
+	/**
+	 * Samsung format:
+	 * location,"number",type,"0x02surname0x03","0x02firstname0x03","number",
+	 * type,"number",type,"number",type,"number",type,"email","NA",
+	 * "0x02note0x03",category?,x,x,x,ringtone?,"NA","photo"
+	 *
+	 * NA fields were empty
+	 * x fields are some numbers, default is 1,65535,255,255,65535
+	 *
+	 * Samsung number types:
+	 * 2 - fax
+	 * 4 - cell
+	 * 5 - other
+	 * 6 - home
+	 * 7 - office
+	 */
+	if (Priv->Manufacturer == AT_Samsung) {
+		/* Parse reply */
 		error = ATGEN_ParseReply(s,
-					GetLineString(msg->Buffer, &Priv->Lines, 2),
-					"+CPBR: @i, @s, @p, @I, @s, @d",
-					&Memory->Location,
-					Memory->Entries[3].Text, sizeof(Memory->Entries[3].Text),
-					Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
-					&number_type,
-					Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text),
-					&Memory->Entries[2].Date);
+				line,
+				"+CPBR: @i,@p,@i,@S,@S,@p,@i,@p,@i,@p,@i,@p,@i,@s,@s,@S,@i,@i,@i,@i,@i,@s,@s",
+				&Memory->Location,
+				Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
+				&types[0],
+				Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text), /* surname */
+				Memory->Entries[2].Text, sizeof(Memory->Entries[2].Text), /* first name */
+				Memory->Entries[3].Text, sizeof(Memory->Entries[3].Text),
+				&types[3],
+				Memory->Entries[4].Text, sizeof(Memory->Entries[4].Text),
+				&types[4],
+				Memory->Entries[5].Text, sizeof(Memory->Entries[5].Text),
+				&types[5],
+				Memory->Entries[6].Text, sizeof(Memory->Entries[6].Text),
+				&types[6],
+				Memory->Entries[7].Text, sizeof(Memory->Entries[7].Text), /* email */
+				buffer, sizeof(buffer), /* We don't know this */
+				Memory->Entries[8].Text, sizeof(Memory->Entries[8].Text), /* note */
+				&Memory->Entries[9].Number, /* category */
+				&number_type, /* We don't know this */
+				&number_type, /* We don't know this */
+				&number_type, /* We don't know this */
+				&Memory->Entries[10].Number, /* ringtone ID */
+				buffer, sizeof(buffer), /* We don't know this */
+				Memory->Entries[11].Text, sizeof(Memory->Entries[11].Text) /* photo ID */
+				);
+
 		if (error == ERR_NONE) {
-			smprintf(s, "Reply with date detected\n");
+			smprintf(s, "Samsung reply detected\n");
+			/* Set types */
+			Memory->Entries[1].EntryType = PBK_Text_LastName;
+			Memory->Entries[1].Location = PBK_Location_Unknown;
+			Memory->Entries[2].EntryType = PBK_Text_FirstName;
+			Memory->Entries[2].Location = PBK_Location_Unknown;
+			Memory->Entries[7].EntryType = PBK_Text_Email;
+			Memory->Entries[7].Location = PBK_Location_Unknown;
+			Memory->Entries[8].EntryType = PBK_Text_Note;
+			Memory->Entries[8].Location = PBK_Location_Unknown;
+			Memory->Entries[9].EntryType = PBK_Category;
+			Memory->Entries[9].Location = PBK_Location_Unknown;
+			Memory->Entries[10].EntryType = PBK_RingtoneID;
+			Memory->Entries[10].Location = PBK_Location_Unknown;
+			Memory->Entries[11].EntryType = PBK_Text_PictureName;
+			Memory->Entries[11].Location = PBK_Location_Unknown;
+
 			/* Adjust location */
 			Memory->Location = Memory->Location + 1 - Priv->FirstMemoryEntry;
-			/* Adjust number */
-			GSM_TweakInternationalNumber(Memory->Entries[0].Text, number_type);
-			/* Set date type */
-			Memory->Entries[2].EntryType = PBK_Date;
-			/* Set number of entries */
-			Memory->EntriesNum = 3;
-			return ERR_NONE;
-		}
-
-		/**
-		 * Samsung format:
-		 * location,"number",type,"0x02surname0x03","0x02firstname0x03","number",
-		 * type,"number",type,"number",type,"number",type,"email","NA",
-		 * "0x02note0x03",category?,x,x,x,ringtone?,"NA","photo"
-		 *
-		 * NA fields were empty
-		 * x fields are some numbers, default is 1,65535,255,255,65535
-		 *
-		 * Samsung number types:
-		 * 2 - fax
-		 * 4 - cell
-		 * 5 - other
-		 * 6 - home
-		 * 7 - office
-		 */
-		if (Priv->Manufacturer == AT_Samsung) {
-			/* Parse reply */
-			error = ATGEN_ParseReply(s,
-					GetLineString(msg->Buffer, &Priv->Lines, 2),
-					"+CPBR: @i,@p,@i,@S,@S,@p,@i,@p,@i,@p,@i,@p,@i,@s,@s,@S,@i,@i,@i,@i,@i,@s,@s",
-					&Memory->Location,
-					Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
-					&types[0],
-					Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text), /* surname */
-					Memory->Entries[2].Text, sizeof(Memory->Entries[2].Text), /* first name */
-					Memory->Entries[3].Text, sizeof(Memory->Entries[3].Text),
-					&types[3],
-					Memory->Entries[4].Text, sizeof(Memory->Entries[4].Text),
-					&types[4],
-					Memory->Entries[5].Text, sizeof(Memory->Entries[5].Text),
-					&types[5],
-					Memory->Entries[6].Text, sizeof(Memory->Entries[6].Text),
-					&types[6],
-					Memory->Entries[7].Text, sizeof(Memory->Entries[7].Text), /* email */
-					buffer, sizeof(buffer), /* We don't know this */
-					Memory->Entries[8].Text, sizeof(Memory->Entries[8].Text), /* note */
-					&Memory->Entries[9].Number, /* category */
-					&number_type, /* We don't know this */
-					&number_type, /* We don't know this */
-					&number_type, /* We don't know this */
-					&Memory->Entries[10].Number, /* ringtone ID */
-					buffer, sizeof(buffer), /* We don't know this */
-					Memory->Entries[11].Text, sizeof(Memory->Entries[11].Text) /* photo ID */
-					);
 
-			if (error == ERR_NONE) {
-				smprintf(s, "Samsung reply detected\n");
-				/* Set types */
-				Memory->Entries[1].EntryType = PBK_Text_LastName;
-				Memory->Entries[1].Location = PBK_Location_Unknown;
-				Memory->Entries[2].EntryType = PBK_Text_FirstName;
-				Memory->Entries[2].Location = PBK_Location_Unknown;
-				Memory->Entries[7].EntryType = PBK_Text_Email;
-				Memory->Entries[7].Location = PBK_Location_Unknown;
-				Memory->Entries[8].EntryType = PBK_Text_Note;
-				Memory->Entries[8].Location = PBK_Location_Unknown;
-				Memory->Entries[9].EntryType = PBK_Category;
-				Memory->Entries[9].Location = PBK_Location_Unknown;
-				Memory->Entries[10].EntryType = PBK_RingtoneID;
-				Memory->Entries[10].Location = PBK_Location_Unknown;
-				Memory->Entries[11].EntryType = PBK_Text_PictureName;
-				Memory->Entries[11].Location = PBK_Location_Unknown;
-
-				/* Adjust location */
-				Memory->Location = Memory->Location + 1 - Priv->FirstMemoryEntry;
-
-				/* Shift entries when needed */
-				offset = 0;
+			/* Shift entries when needed */
+			offset = 0;
 
 #define SHIFT_ENTRIES(index) \
 	for (i = index - offset + 1; i < GSM_PHONEBOOK_ENTRIES; i++) { \
@@ -4007,53 +4090,64 @@ GSM_Error ATGEN_ReplyGetMemory(GSM_Protocol_Message *msg, GSM_StateMachine *s)
 							break; \
 					} \
 				}
-				CHECK_NUMBER(0);
-				CHECK_TEXT(1);
-				CHECK_TEXT(2);
-				CHECK_NUMBER(3);
-				CHECK_NUMBER(4);
-				CHECK_NUMBER(5);
-				CHECK_NUMBER(6);
-				CHECK_TEXT(7);
-				CHECK_TEXT(8);
-				if (Memory->Entries[10 - offset].Number == 65535) {
-					SHIFT_ENTRIES(10);
-				}
-				CHECK_TEXT(11);
+			CHECK_NUMBER(0);
+			CHECK_TEXT(1);
+			CHECK_TEXT(2);
+			CHECK_NUMBER(3);
+			CHECK_NUMBER(4);
+			CHECK_NUMBER(5);
+			CHECK_NUMBER(6);
+			CHECK_TEXT(7);
+			CHECK_TEXT(8);
+			if (Memory->Entries[10 - offset].Number == 65535) {
+				SHIFT_ENTRIES(10);
+			}
+			CHECK_TEXT(11);
 
 #undef CHECK_NUMBER
 #undef CHECK_TEXT
 #undef SHIFT_ENTRIES
-				/* Set number of entries */
-				Memory->EntriesNum = 12 - offset;
-				return ERR_NONE;
-			}
-
-		}
-
-		/*
-		 * Nokia 2730 adds some extra fields to the end, we ignore
-		 * them for now
-		 */
-		error = ATGEN_ParseReply(s,
-					GetLineString(msg->Buffer, &Priv->Lines, 2),
-					"+CPBR: @i, @p, @I, @e, @0",
-					&Memory->Location,
-					Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
-					&number_type,
-					Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text));
-		if (error == ERR_NONE) {
-			smprintf(s, "Extended AT reply detected\n");
-			/* Adjust location */
-			Memory->Location = Memory->Location + 1 - Priv->FirstMemoryEntry;
-			/* Adjust number */
-			GSM_TweakInternationalNumber(Memory->Entries[0].Text, number_type);
 			/* Set number of entries */
-			Memory->EntriesNum = 2;
+			Memory->EntriesNum = 12 - offset;
 			return ERR_NONE;
 		}
 
-		return ERR_UNKNOWNRESPONSE;
+	}
+
+	/*
+	 * Nokia 2730 adds some extra fields to the end, we ignore
+	 * them for now
+	 */
+	error = ATGEN_ParseReply(s,
+				line,
+				"+CPBR: @i, @p, @I, @e, @0",
+				&Memory->Location,
+				Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
+				&number_type,
+				Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text));
+	if (error == ERR_NONE) {
+		smprintf(s, "Extended AT reply detected\n");
+		/* Adjust location */
+		Memory->Location = Memory->Location + 1 - Priv->FirstMemoryEntry;
+		/* Adjust number */
+		GSM_TweakInternationalNumber(Memory->Entries[0].Text, number_type);
+		/* Set number of entries */
+		Memory->EntriesNum = 2;
+		return ERR_NONE;
+	}
+
+	return ERR_UNKNOWNRESPONSE;
+}
+
+/**
+ * Handles error replies on AT+CPBR=n.
+ */
+static GSM_Error ATGEN_ReplyGetMemoryError(GSM_StateMachine *s)
+{
+ 	GSM_Phone_ATGENData 	*Priv = &s->Phone.Data.Priv.ATGEN;
+	GSM_Error		error;
+
+	switch (Priv->ReplyState) {
 	case AT_Reply_CMEError:
 		if (Priv->ErrorCode == 100)
 			return ERR_EMPTY;
@@ -4076,6 +4170,68 @@ GSM_Error ATGEN_ReplyGetMemory(GSM_Protocol_Message *msg, GSM_StateMachine *s)
 	return ERR_UNKNOWNRESPONSE;
 }
 
+/**
+ * Parses reply on AT+CPBR=n.
+ */
+GSM_Error ATGEN_ReplyGetMemory(GSM_Protocol_Message *msg, GSM_StateMachine *s)
+{
+ 	GSM_Phone_ATGENData 	*Priv = &s->Phone.Data.Priv.ATGEN;
+ 	GSM_MemoryEntry		*Memory = s->Phone.Data.Memory;
+
+	if (Priv->ReplyState != AT_Reply_OK) {
+		return ATGEN_ReplyGetMemoryError(s);
+	}
+
+	smprintf(s, "Phonebook entry received\n");
+	/* Check for empty entries */
+	if (strcmp("OK", GetLineString(msg->Buffer, &Priv->Lines, 2)) == 0) {
+		Memory->EntriesNum = 0;
+		return ERR_EMPTY;
+	}
+	return ATGEN_ParseMemoryEntry(s, GetLineString(msg->Buffer, &Priv->Lines, 2), Memory);
+}
+
+GSM_Error ATGEN_ReplyGetMemoryRange(GSM_Protocol_Message *msg, GSM_StateMachine *s)
+{
+ 	GSM_Phone_ATGENData 	*Priv = &s->Phone.Data.Priv.ATGEN;
+	GSM_AT_PBK_Cache	*Cache = &Priv->PBKCache;
+	GSM_MemoryEntry		*Memory;
+	GSM_Error		error;
+	const char		*str;
+	int			line = 2;
+
+	if (Priv->ReplyState != AT_Reply_OK) {
+		return ATGEN_ReplyGetMemoryError(s);
+	}
+
+	smprintf(s, "Phonebook entries received\n");
+	Cache->Count = 0;
+	while (strcmp("OK", str = GetLineString(msg->Buffer, &Priv->Lines, line)) != 0) {
+		line++;
+		if (strncmp(str, "+CPBR:", 6) != 0) {
+			continue;
+		}
+		if (Cache->Count >= AT_PBK_READAHEAD) {
+			smprintf(s, "Too many entries in reply, ignoring rest!\n");
+			break;
+		}
+		Memory = &Cache->Entries[Cache->Count];
+		Memory->MemoryType = Cache->MemoryType;
+		error = ATGEN_ParseMemoryEntry(s, str, Memory);
+		if (error != ERR_NONE) {
+			return error;
+		}
+		/* Some phones wrongly return several lines with same location,
+		 * single entry read uses the first one as well. */
+		if (Cache->Count > 0 && Memory->Location == Cache->Entries[Cache->Count - 1].Location) {
+			continue;
+		}
+		Cache->Count++;
+	}
+	smprintf(s, "Read %d entries from locations %d-%d\n", Cache->Count, Cache->First, Cache->Last);
+	return ERR_NONE;
+}
+
 GSM_Error ATGEN_PrivGetMemory (GSM_StateMachine *s, GSM_MemoryEntry *entry, int endlocation)
 {
 	GSM_Error 		error;
@@ -4151,6 +4307,127 @@ GSM_Error ATGEN_GetMemory (GSM_StateMachine *s, GSM_MemoryEntry *entry)
 	return ATGEN_PrivGetMemory(s, entry, 0);
 }
 
+/**
+ * Drops phonebook entries read ahead, needed whenever phonebook changes.
+ */
+static void ATGEN_InvalidatePBKCache(GSM_StateMachine *s)
+{
+	GSM_Phone_ATGENData	*Priv = &s->Phone.Data.Priv.ATGEN;
+
+	Priv->PBKCache.First = 0;
+	Priv->PBKCache.Last = -1;
+	Priv->PBKCache.Count = 0;
+	Priv->PBKCache.Failed = FALSE;
+}
+
+/**
+ * Reads range of phonebook entries starting at given location into
+ * read ahead cache. When the range fails to be read, only this range is
+ * marked to be read one by one.
+ *
+ * \return ERR_NOTSUPPORTED if phone can not read ranges at all, entries
+ * have to be read one by one then.
+ */
+static GSM_Error ATGEN_ReadMemoryRange(GSM_StateMachine *s, GSM_MemoryType type, int start)
+{
+	GSM_Phone_ATGENData	*Priv = &s->Phone.Data.Priv.ATGEN;
+	GSM_AT_PBK_Cache	*Cache = &Priv->PBKCache;
+	GSM_Error		error;
+	char			req[50];
+	size_t			len;
+
+	if (Cache->Entries == NULL) {
+		Cache->Entries = (GSM_MemoryEntry *)malloc(AT_PBK_READAHEAD * sizeof(GSM_MemoryEntry));
+		if (Cache->Entries == NULL) {
+			return ERR_MOREMEMORY;
+		}
+	}
+
+	/* For reading we prefer unicode */
+	error = ATGEN_SetCharset(s, AT_PREF_CHARSET_UNICODE);
+	if (error != ERR_NONE) return error;
+
+	if (Priv->FirstMemoryEntry == -1) {
+		error = ATGEN_GetMemoryInfo(s, NULL, AT_First);
+		if (error != ERR_NONE) return error;
+	}
+
+	Cache->MemoryType = type;
+	Cache->First = start;
+	Cache->Last = MIN(Priv->MemorySize, start + AT_PBK_READAHEAD - 1);
+	Cache->Count = 0;
+	Cache->Failed = FALSE;
+
+	len = snprintf(req, sizeof(req), "AT+CPBR=%i,%i\r",
+		Cache->First + Priv->FirstMemoryEntry - 1,
+		Cache->Last + Priv->FirstMemoryEntry - 1);
+	smprintf(s, "Getting phonebook entries\n");
+	error = ATGEN_WaitFor(s, req, len, 0x00, 50, ID_GetMemoryRange);
+	if (error == ERR_EMPTY) {
+		Cache->Count = 0;
+		return ERR_NONE;
+	}
+	if (error != ERR_NONE) {
+		/* Some Samsung phones fail to read more entries at once */
+		if (Priv->ReplyState != AT_Reply_OK && Priv->PBKReadAhead != AT_AVAILABLE) {
+			smprintf(s, "Phone can not read range of entries, reading them one by one\n");
+			Priv->PBKReadAhead = AT_NOTAVAILABLE;
+			ATGEN_InvalidatePBKCache(s);
+			return ERR_NOTSUPPORTED;
+		}
+		/* Reply we could not parse, do not give up on ranges yet */
+		smprintf(s, "Failed to read range of entries, reading locations %d-%d one by one\n",
+			Cache->First, Cache->Last);
+		Cache->Count = 0;
+		Cache->Failed = TRUE;
+		return ERR_NONE;
+	}
+	Priv->PBKReadAhead = AT_AVAILABLE;
+	return ERR_NONE;
+}
+
+/**
+ * Gets next phonebook entry from read ahead cache, reading next range
+ * when needed.
+ */
+static GSM_Error ATGEN_GetNextMemoryCached(GSM_StateMachine *s, GSM_MemoryEntry *entry, gboolean start)
+{
+	GSM_Phone_ATGENData	*Priv = &s->Phone.Data.Priv.ATGEN;
+	GSM_AT_PBK_Cache	*Cache = &Priv->PBKCache;
+	GSM_Error		error;
+	int			location, i;
+
+	if (start) {
+		ATGEN_InvalidatePBKCache(s);
+		location = 1;
+	} else {
+		location = entry->Location + 1;
+	}
+
+	while (location <= Priv->MemorySize) {
+		if (Cache->MemoryType != entry->MemoryType ||
+				location < Cache->First || location > Cache->Last) {
+			error = ATGEN_ReadMemoryRange(s, entry->MemoryType, location);
+			if (error != ERR_NONE) return error;
+		}
+		if (Cache->Failed) {
+			entry->Location = location;
+			error = ATGEN_PrivGetMemory(s, entry, 0);
+			if (error != ERR_EMPTY && error != ERR_INVALIDLOCATION) return error;
+			location++;
+			continue;
+		}
+		for (i = 0; i < Cache->Count; i++) {
+			if (Cache->Entries[i].Location >= location) {
+				*entry = Cache->Entries[i];
+				return ERR_NONE;
+			}
+		}
+		location = Cache->Last + 1;
+	}
+	return ERR_EMPTY;
+}
+
 GSM_Error ATGEN_GetNextMemory (GSM_StateMachine *s, GSM_MemoryEntry *entry, gboolean start)
 {
 	GSM_Phone_ATGENData	*Priv = &s->Phone.Data.Priv.ATGEN;
@@ -4182,6 +4459,16 @@ GSM_Error ATGEN_GetNextMemory (GSM_StateMachine *s, GSM_MemoryEntry *entry, gboo
 		}
 	}
 
+	/* Read whole ranges with AT+CPBR when possible */
+	if ((entry->MemoryType != MEM_ME ||
+				(Priv->PBKSBNR != AT_AVAILABLE &&
+				 Priv->PBK_SPBR != AT_AVAILABLE &&
+				 Priv->PBK_MPBR != AT_AVAILABLE)) &&
+			Priv->PBKReadAhead != AT_NOTAVAILABLE) {
+		error = ATGEN_GetNextMemoryCached(s, entry, start);
+		if (error != ERR_NOTSUPPORTED) return error;
+	}
+
 	if (start) {
 		entry->Location = 1;
 	} else {
@@ -4213,6 +4500,8 @@ GSM_Error ATGEN_DeleteAllMemory(GSM_StateMachine *s, GSM_MemoryType type)
 	GSM_Phone_ATGENData	*Priv = &s->Phone.Data.Priv.ATGEN;
 	size_t len;
 
+	ATGEN_InvalidatePBKCache(s);
+
 	error = ATGEN_SetPBKMemory(s, type);
 	if (error != ERR_NONE) return error;
 
@@ -4887,6 +5176,7 @@ GSM_Error ATGEN_DeleteMemory(GSM_StateMachine *s, GSM_MemoryEntry *entry)
 	if (entry->Location < 1) {
 		return ERR_INVALIDLOCATION;
 	}
+	ATGEN_InvalidatePBKCache(s);
 	error = ATGEN_SetPBKMemory(s, entry->MemoryType);
 
 	if (error != ERR_NONE) {
@@ -4930,6 +5220,7 @@ GSM_Error ATGEN_PrivSetMemory(GSM_StateMachine *s, GSM_MemoryEntry *entry)
 	if (entry->Location == 0) {
 		return ERR_INVALIDLOCATION;
 	}
+	ATGEN_InvalidatePBKCache(s);
 	if (entry->MemoryType == MEM_ME) {
 		if (Priv->PBK_SPBR == 0) {
 			ATGEN_CheckSPBR(s);
@@ -5528,6 +5819,8 @@ GSM_Error ATGEN_Terminate(GSM_StateMachine *s)
 	Priv->file.Buffer = NULL;
 	free(Priv->SMSCache);
 	Priv->SMSCache = NULL;
+	free(Priv->PBKCache.Entries);
+	Priv->PBKCache.Entries = NULL;
 	return ERR_NONE;
 }
 
@@ -5994,6 +6287,7 @@ GSM_Reply_Function ATGENReplyFunctions[] = {
 {ATGEN_ReplyGetCharset,		"AT+CSCS?"		,0x00,0x00,ID_GetMemoryCharset	 },
 {ATGEN_GenericReply,		"AT+CSCS="		,0x00,0x00,ID_SetMemoryCharset	 },
 {ATGEN_ReplyGetMemory,		"AT+CPBR="		,0x00,0x00,ID_GetMemory		 },
+{ATGEN_ReplyGetMemoryRange,	"AT+CPBR="		,0x00,0x00,ID_GetMemoryRange	 },
 {SIEMENS_ReplyGetMemoryInfo,	"AT^SBNR=?"		,0x00,0x00,ID_GetMemory		 },
 {SAMSUNG_ReplyGetMemoryInfo,	"AT+SPBR=?"		,0x00,0x00,ID_GetMemory		 },
 {MOTOROLA_ReplyGetMemoryInfo,	"AT+MPBR=?"		,0x00,0x00,ID_GetMemory		 },
@@ -6267,7 +6561,12 @@ GSM_Phone_Functions ATGENPhone = {
 	NOTSUPPORTED,			/* 	GetGPRSAccessPoint	*/
 	NOTSUPPORTED,			/* 	SetGPRSAccessPoint	*/
 	SONYERICSSON_GetScreenshot,
-	ATGEN_SetPower
+	ATGEN_SetPower,
+	ATGEN_GetAllSMS,
+	NOTIMPLEMENTED,			/* 	GetFileStream		*/
+	NOTIMPLEMENTED,			/* 	AddFileStream		*/
+	NOTIMPLEMENTED,			/* 	GetMemoryChanges	*/
+	NOTIMPLEMENTED			/* 	GetCalendarChanges	*/
 };
 
 #endif
@@ -23,6 +23,8 @@
 #ifndef atgen_h
 #define atgen_h
 
+#include <stdio.h>
+
 #include <gammu-types.h>
 #include <gammu-error.h>
 #include <gammu-statemachine.h>
@@ -41,6 +43,9 @@
 #ifndef GSM_USED_IRDAAT
 #  define GSM_USED_IRDAAT
 #endif
+#ifndef GSM_USED_SOCKETAT
+#  define GSM_USED_SOCKETAT
+#endif
 
 #define MAX_VCALENDAR_LOCATION 50
 
@@ -230,6 +235,43 @@ typedef struct {
  */
 #define AT_PBK_MAX_MEMORIES	200
 
+/**
+ * Number of phonebook entries read at once by ATGEN_GetNextMemory.
+ */
+#define AT_PBK_READAHEAD	20
+
+/**
+ * Phonebook entries read ahead by ATGEN_GetNextMemory.
+ */
+typedef struct {
+	/**
+	 * Memory the entries are from.
+	 */
+	GSM_MemoryType		MemoryType;
+	/**
+	 * First location covered by last read range.
+	 */
+	int			First;
+	/**
+	 * Last location covered by last read range, cache is empty when
+	 * it is lower than First.
+	 */
+	int			Last;
+	/**
+	 * Number of non empty entries in the range.
+	 */
+	int			Count;
+	/**
+	 * Reading of the range failed, entries in it are read one by one.
+	 */
+	gboolean		Failed;
+	/**
+	 * Entries sorted by location, allocated for AT_PBK_READAHEAD
+	 * entries.
+	 */
+	GSM_MemoryEntry		*Entries;
+} GSM_AT_PBK_Cache;
+
 typedef struct {
 	/**
 	 * Who is manufacturer
@@ -305,6 +347,14 @@ typedef struct {
 	int			MemorySize;
 	int			MotorolaMemorySize;
 	int			MemoryUsed;
+	/**
+	 * Whether phone can read ranges of phonebook entries.
+	 */
+	GSM_AT_Feature		PBKReadAhead;
+	/**
+	 * Entries read ahead by ATGEN_GetNextMemory.
+	 */
+	GSM_AT_PBK_Cache	PBKCache;
 
 	GSM_SMSMemoryStatus	LastSMSStatus;
 	int			LastSMSRead;
@@ -542,6 +592,12 @@ int ATGEN_ExtractOneParameter(unsigned char *input, unsigned char *output);
  */
 GSM_Error ATGEN_DecodeDateTime(GSM_StateMachine *s, GSM_DateTime *dt, unsigned char *_input);
 
+/**
+ * Writes capabilities detected by AT driver to capability cache file,
+ * they are read back in ATGEN_Initialise.
+ */
+void ATGEN_SaveCapabilities(GSM_StateMachine *s, FILE *file);
+
 #endif
 /*@}*/
 /*@}*/
@@ -132,11 +132,13 @@ static GSM_Error WaitFor(GSM_StateMachine *s, const char *t, int ttl)
         sec = Date.Second;
 
 	n = s->Device.Functions->ReadDevice(s, readbuf, sizeof(readbuf) - 1);
+	if (n < 0) return ERR_DEVICENOTWORK;
 	readbuf[n] = '\0';
 
 	while (strstr(readbuf, t) == NULL && (sec + ttl) >= Date.Second) {
 		usleep(500000);
 		n = s->Device.Functions->ReadDevice(s, readbuf, sizeof(readbuf) - 1);
+		if (n < 0) return ERR_DEVICENOTWORK;
 		readbuf[n] = '\0';
         	GSM_GetCurrentDateTime (&Date);
 	}
@@ -373,6 +373,14 @@ GSM_Error ATOBEX_GetNextSMS(GSM_StateMachine *s, GSM_MultiSMSMessage *sms, gbool
 	return ATGEN_GetNextSMS(s, sms, start);
 }
 
+GSM_Error ATOBEX_GetAllSMS(GSM_StateMachine *s, GSM_GetAllSMSCallback callback, void *user_data)
+{
+	GSM_Error error;
+
+	if ((error = ATOBEX_SetATMode(s))!= ERR_NONE) return error;
+	return ATGEN_GetAllSMS(s, callback, user_data);
+}
+
 GSM_Error ATOBEX_GetSMSStatus(GSM_StateMachine *s, GSM_SMSMemoryStatus *status)
 {
 	GSM_Error error;
@@ -680,6 +688,28 @@ GSM_Error ATOBEX_GetFilePart(GSM_StateMachine *s, GSM_File *File, int *Handle, i
 	return OBEXGEN_GetFilePart(s, File, Handle, Size);
 }
 
+GSM_Error ATOBEX_GetFileStream(GSM_StateMachine *s, GSM_File *File, GSM_FileSink sink, void *user_data)
+{
+	GSM_Error error;
+
+	error = ATOBEX_SetOBEXMode(s, OBEX_BrowsingFolders);
+	if (error != ERR_NONE) {
+		return error;
+	}
+	return OBEXGEN_GetFileStream(s, File, sink, user_data);
+}
+
+GSM_Error ATOBEX_AddFileStream(GSM_StateMachine *s, GSM_File *File, GSM_FileSource source, void *user_data)
+{
+	GSM_Error error;
+
+	error = ATOBEX_SetOBEXMode(s, OBEX_BrowsingFolders);
+	if (error != ERR_NONE) {
+		return error;
+	}
+	return OBEXGEN_AddFileStream(s, File, source, user_data);
+}
+
 GSM_Error ATOBEX_GetNextFileFolder(GSM_StateMachine *s, GSM_File *File, gboolean start)
 {
 	GSM_Error error;
@@ -798,6 +828,21 @@ atgen:
 	return ATGEN_GetNextMemory(s, entry, start);
 }
 
+GSM_Error ATOBEX_GetMemoryChanges(GSM_StateMachine *s, GSM_MemoryType type, const char *state_file, GSM_MemoryChangeCallback callback, void *user_data)
+{
+	GSM_Error 		error;
+	GSM_Phone_ATOBEXData	*Priv = &s->Phone.Data.Priv.ATOBEX;
+
+	if (!ATOBEX_UseObex (s, type)) {
+		return ERR_NOTIMPLEMENTED;
+	}
+	error = ATOBEX_SetOBEXMode(s, Priv->DataService);
+	if (error != ERR_NONE) {
+		return ERR_NOTIMPLEMENTED;
+	}
+	return OBEXGEN_GetMemoryChanges(s, type, state_file, callback, user_data);
+}
+
 GSM_Error ATOBEX_SetMemory(GSM_StateMachine *s, GSM_MemoryEntry *entry)
 {
 	GSM_Error 		error;
@@ -1009,6 +1054,18 @@ GSM_Error ATOBEX_GetNextCalendar(GSM_StateMachine *s, GSM_CalendarEntry *Note, g
 	return OBEXGEN_GetNextCalendar(s, Note, start);
 }
 
+GSM_Error ATOBEX_GetCalendarChanges(GSM_StateMachine *s, const char *state_file, GSM_CalendarChangeCallback callback, void *user_data)
+{
+	GSM_Error 		error;
+	GSM_Phone_ATOBEXData	*Priv = &s->Phone.Data.Priv.ATOBEX;
+
+	error = ATOBEX_SetOBEXMode(s, Priv->DataService);
+	if (error != ERR_NONE) {
+		return error;
+	}
+	return OBEXGEN_GetCalendarChanges(s, state_file, callback, user_data);
+}
+
 GSM_Error ATOBEX_DeleteCalendar(GSM_StateMachine *s, GSM_CalendarEntry *Note)
 {
 	GSM_Error 		error;
@@ -1677,7 +1734,12 @@ GSM_Phone_Functions ATOBEXPhone = {
 	NOTSUPPORTED,			/* 	GetGPRSAccessPoint	*/
 	NOTSUPPORTED,			/* 	SetGPRSAccessPoint	*/
 	SONYERICSSON_GetScreenshot,			/* 	GetScreenshot		*/
-	ATOBEX_SetPower
+	ATOBEX_SetPower,
+	ATOBEX_GetAllSMS,
+	ATOBEX_GetFileStream,
+	ATOBEX_AddFileStream,
+	ATOBEX_GetMemoryChanges,
+	ATOBEX_GetCalendarChanges
 };
 
 #endif
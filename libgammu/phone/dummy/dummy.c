@@ -2073,7 +2073,12 @@ GSM_Phone_Functions DUMMYPhone = {
 	NOTSUPPORTED,			/* 	GetGPRSAccessPoint	*/
 	NOTSUPPORTED,			/* 	SetGPRSAccessPoint	*/
 	NOTSUPPORTED,			/* 	GetScreenshot		*/
-	NOTSUPPORTED			/* 	SetPower		*/
+	NOTSUPPORTED,			/* 	SetPower		*/
+	NOTIMPLEMENTED,			/* 	GetAllSMS		*/
+	NOTIMPLEMENTED,			/* 	GetFileStream		*/
+	NOTIMPLEMENTED,			/* 	AddFileStream		*/
+	NOTIMPLEMENTED,			/* 	GetMemoryChanges	*/
+	NOTIMPLEMENTED			/* 	GetCalendarChanges	*/
 };
 
 /*@}*/
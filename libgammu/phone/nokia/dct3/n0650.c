@@ -156,7 +156,12 @@ GSM_Phone_Functions N650Phone = {
 	NOTSUPPORTED,			/* 	GetGPRSAccessPoint	*/
 	NOTSUPPORTED,			/* 	SetGPRSAccessPoint	*/
 	NOTSUPPORTED,			/* 	GetScreenshot		*/
-	NOTSUPPORTED			/* 	SetPower		*/
+	NOTSUPPORTED,			/* 	SetPower		*/
+	NOTIMPLEMENTED,			/* 	GetAllSMS		*/
+	NOTIMPLEMENTED,			/* 	GetFileStream		*/
+	NOTIMPLEMENTED,			/* 	AddFileStream		*/
+	NOTIMPLEMENTED,			/* 	GetMemoryChanges	*/
+	NOTIMPLEMENTED			/* 	GetCalendarChanges	*/
 };
 
 #endif
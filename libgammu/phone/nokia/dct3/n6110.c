@@ -2935,7 +2935,12 @@ GSM_Phone_Functions N6110Phone = {
         NOTSUPPORTED,                   /*      GetGPRSAccessPoint      */
 	NOTSUPPORTED,			/* 	SetGPRSAccessPoint	*/
 	NOTSUPPORTED,			/* 	GetScreenshot		*/
-	NOTSUPPORTED			/* 	SetPower		*/
+	NOTSUPPORTED,			/* 	SetPower		*/
+	NOTIMPLEMENTED,			/* 	GetAllSMS		*/
+	NOTIMPLEMENTED,			/* 	GetFileStream		*/
+	NOTIMPLEMENTED,			/* 	AddFileStream		*/
+	NOTIMPLEMENTED,			/* 	GetMemoryChanges	*/
+	NOTIMPLEMENTED			/* 	GetCalendarChanges	*/
 };
 
 #endif
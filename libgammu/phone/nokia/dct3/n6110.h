@@ -29,6 +29,9 @@ typedef struct {
 #ifndef GSM_USED_FBUS2
 #  define GSM_USED_FBUS2
 #endif
+#ifndef GSM_USED_SOCKETFBUS2
+#  define GSM_USED_SOCKETFBUS2
+#endif
 #ifndef GSM_USED_FBUS2IRDA
 #  define GSM_USED_FBUS2IRDA
 #endif
@@ -25,6 +25,9 @@ typedef struct {
 #ifndef GSM_USED_FBUS2
 #  define GSM_USED_FBUS2
 #endif
+#ifndef GSM_USED_SOCKETFBUS2
+#  define GSM_USED_SOCKETFBUS2
+#endif
 #ifndef GSM_USED_FBUS2DLR3
 #  define GSM_USED_FBUS2DLR3
 #endif
@@ -16,6 +16,7 @@
 #include "../../../pfunc.h"
 #include "../dct4func.h"
 #include "n6510.h"
+#include "6510file.h"
 #include "../../../../../helper/string.h"
 
 /* shared */
@@ -74,28 +75,39 @@ static GSM_Error N6510_AllocFileCache(GSM_StateMachine *s, int requested)
 	return ERR_NONE;
 }
 
-static int N6510_FindFileCheckSum12(GSM_StateMachine *s, unsigned char *ptr, int len)
+/**
+ * Adds data to file checksum, so that it can be calculated part by part.
+ */
+static void N6510_UpdateFileCheckSum12(int *acc, int *accx, const unsigned char *ptr, int len)
 {
-	int acc, i, accx;
+	int i;
 
-	accx = 0;
-	acc  = 0xffff;
 	while (len--) {
-		accx = (accx & 0xffff00ff) | (acc & 0xff00);
-		acc  = (acc  & 0xffff00ff) | (*ptr++ << 8);
+		*accx = (*accx & 0xffff00ff) | (*acc & 0xff00);
+		*acc  = (*acc  & 0xffff00ff) | (*ptr++ << 8);
 		for (i = 0; i < 8; i++) {
-			acc <<= 1;
-			if (acc & 0x10000)     acc ^= 0x1021;
-			if (accx & 0x80000000) acc ^= 0x1021;
-			accx <<= 1;
+			*acc <<= 1;
+			if (*acc & 0x10000)     *acc ^= 0x1021;
+			if (*accx & 0x80000000) *acc ^= 0x1021;
+			*accx <<= 1;
 		}
 	}
+}
+
+static int N6510_FindFileCheckSum12(GSM_StateMachine *s, unsigned char *ptr, int len)
+{
+	int acc, accx;
+
+	accx = 0;
+	acc  = 0xffff;
+	N6510_UpdateFileCheckSum12(&acc, &accx, ptr, len);
 	smprintf(s, "Checksum from Gammu is %04X\n",(acc & 0xffff));
 	return (acc & 0xffff);
 }
 
 GSM_Error N6510_ReplyGetFilePart12(GSM_Protocol_Message *msg, GSM_StateMachine *s)
 {
+	GSM_Phone_N6510Data	*Priv = &s->Phone.Data.Priv.N6510;
 	int old;
 
 	smprintf(s,"File part received\n");
@@ -109,6 +121,21 @@ GSM_Error N6510_ReplyGetFilePart12(GSM_Protocol_Message *msg, GSM_StateMachine *
 			msg->Buffer[7]*256*256+
 			msg->Buffer[8]*256+
 			msg->Buffer[9]);
+	if (s->Phone.Data.File->Used - old > msg->Length - 10) {
+		smprintf(s, "File part does not fit in message!\n");
+		s->Phone.Data.File->Used = old;
+		return ERR_UNKNOWNRESPONSE;
+	}
+	if (Priv->FileSink != NULL) {
+		/* Pass data to caller instead of storing them */
+		N6510_UpdateFileCheckSum12(&Priv->FileCheckAcc, &Priv->FileCheckAccx,
+			msg->Buffer + 10, s->Phone.Data.File->Used - old);
+		return Priv->FileSink(s, s->Phone.Data.File,
+			msg->Buffer + 10,
+			s->Phone.Data.File->Used - old,
+			Priv->FileSize,
+			Priv->FileStreamData);
+	}
 	s->Phone.Data.File->Buffer = (unsigned char *)realloc(s->Phone.Data.File->Buffer,s->Phone.Data.File->Used);
 	memcpy(s->Phone.Data.File->Buffer+old,msg->Buffer+10,s->Phone.Data.File->Used-old);
 	return ERR_NONE;
@@ -382,7 +409,7 @@ static GSM_Error N6510_GetFileSystemStatus1(GSM_StateMachine *s, GSM_FileSystemS
 static GSM_Error N6510_GetFilePart1(GSM_StateMachine *s, GSM_File *File, int *Handle UNUSED, int *Size)
 {
 	GSM_Phone_N6510Data     *Priv = &s->Phone.Data.Priv.N6510;
-	int		     	old;
+	int		     	old, checksum;
 	GSM_Error	       	error;
 	unsigned char	   	req[] = {
 		N7110_FRAME_HEADER, 0x0E, 0x00, 0x00, 0x00, 0x01,
@@ -398,6 +425,7 @@ static GSM_Error N6510_GetFilePart1(GSM_StateMachine *s, GSM_File *File, int *Ha
 		if (File->Folder) return ERR_SHOULDBEFILE;
 
 		(*Size) 	= File->Used;
+		Priv->FileSize	= File->Used;
 		File->Used 	= 0;
 	}
 
@@ -417,8 +445,14 @@ static GSM_Error N6510_GetFilePart1(GSM_StateMachine *s, GSM_File *File, int *Ha
 		error = N6510_GetFileCRC1(s, File->ID_FullName);
 		if (error != ERR_NONE) return error;
 
-		if (N6510_FindFileCheckSum12(s, File->Buffer, File->Used) != Priv->FileCheckSum) {
-			smprintf(s,"File2 checksum is %i, File checksum is %i\n",N6510_FindFileCheckSum12(s, File->Buffer, File->Used),Priv->FileCheckSum);
+		/* When streaming, data are not kept and checksum is counted as they come */
+		if (Priv->FileSink != NULL) {
+			checksum = Priv->FileCheckAcc & 0xffff;
+		} else {
+			checksum = N6510_FindFileCheckSum12(s, File->Buffer, File->Used);
+		}
+		if (checksum != Priv->FileCheckSum) {
+			smprintf(s,"File2 checksum is %i, File checksum is %i\n",checksum,Priv->FileCheckSum);
 			return ERR_WRONGCRC;
 		}
 		return ERR_EMPTY;
@@ -1186,9 +1220,26 @@ static GSM_Error N6510_GetNextFileFolder2(GSM_StateMachine *s, GSM_File *File, g
 	return error;
 }
 
+/**
+ * Sets file name from last component of its ID.
+ */
+static void N6510_SetFileName2(GSM_File *File)
+{
+	int j;
+
+	for (j=UnicodeLength(File->ID_FullName)-1;j>0;j--) {
+		if (File->ID_FullName[j*2+1] == '\\' || File->ID_FullName[j*2+1] == '/') break;
+	}
+	if (File->ID_FullName[j*2+1] == '\\' || File->ID_FullName[j*2+1] == '/') {
+		CopyUnicodeString(File->Name,File->ID_FullName+j*2+2);
+	} else {
+		CopyUnicodeString(File->Name,File->ID_FullName);
+	}
+}
+
 static GSM_Error N6510_GetFilePart2(GSM_StateMachine *s, GSM_File *File, int *Handle, int *Size)
 {
-	int		    	old,j;
+	int		    	old;
 	GSM_Error	       	error;
 	GSM_Phone_N6510Data     *Priv = &s->Phone.Data.Priv.N6510;
 	unsigned char	   	req[] = {
@@ -1207,14 +1258,7 @@ static GSM_Error N6510_GetFilePart2(GSM_StateMachine *s, GSM_File *File, int *Ha
 		error = N6510_OpenFile2(s, File->ID_FullName, Handle, FALSE);
 		if (error != ERR_NONE) return error;
 
-		for (j=UnicodeLength(File->ID_FullName)-1;j>0;j--) {
-			if (File->ID_FullName[j*2+1] == '\\' || File->ID_FullName[j*2+1] == '/') break;
-		}
-		if (File->ID_FullName[j*2+1] == '\\' || File->ID_FullName[j*2+1] == '/') {
-			CopyUnicodeString(File->Name,File->ID_FullName+j*2+2);
-		} else {
-			CopyUnicodeString(File->Name,File->ID_FullName);
-		}
+		N6510_SetFileName2(File);
 
 		(*Size) 	= File->Used;
 		File->Used 	= 0;
@@ -1253,6 +1297,106 @@ static GSM_Error N6510_GetFilePart2(GSM_StateMachine *s, GSM_File *File, int *Ha
 	return ERR_NONE;
 }
 
+/**
+ * Reads whole file from filesystem 2 passing its parts to sink.
+ *
+ * Requests are still answered one by one, but parts are as big as the
+ * phone accepts. When phone sends smaller part than requested, the
+ * smaller size is used for rest of the session.
+ */
+static GSM_Error N6510_GetFileStream2(GSM_StateMachine *s, GSM_File *File)
+{
+	GSM_Phone_N6510Data     *Priv = &s->Phone.Data.Priv.N6510;
+	GSM_Error	       	error;
+	int			Handle = 0, old, part, received;
+	unsigned char	   	req[] = {
+		N7110_FRAME_HEADER, 0x5E, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x01,		/* file handle */
+		0x00, 0x00, 0x00, 0x00, 	/* position */
+		0x00, 0x00, 0x03, 0xE8, 	/* length */
+		0x00, 0x00, 0x03, 0xE8};	/* buffer length */
+
+	error = N6510_GetFileFolderInfo2(s, File);
+	if (error != ERR_NONE) return error;
+
+	if (File->Folder) return ERR_SHOULDBEFILE;
+
+	Priv->FileSize = File->Used;
+	File->Used = 0;
+
+	error = N6510_OpenFile2(s, File->ID_FullName, &Handle, FALSE);
+	if (error != ERR_NONE) return error;
+
+	N6510_SetFileName2(File);
+
+	req[6]		 = Handle / (256*256*256);
+	req[7]		 = Handle / (256*256);
+	req[8]		 = Handle / 256;
+	req[9]		 = Handle % 256;
+
+	Priv->FileCheckAcc = 0xffff;
+	Priv->FileCheckAccx = 0;
+	part = Priv->FilePartSize;
+
+	while (1) {
+		old		 = File->Used;
+		req[10]		 = old / (256*256*256);
+		req[11]		 = old / (256*256);
+		req[12]		 = old / 256;
+		req[13]		 = old % 256;
+		req[14]		 = part / (256*256*256);
+		req[15]		 = part / (256*256);
+		req[16]		 = part / 256;
+		req[17]		 = part % 256;
+		memcpy(req + 18, req + 14, 4);
+
+		s->Phone.Data.File = File;
+		smprintf(s, "Getting file part %d (%d bytes) from filesystem\n", old, part);
+		error = GSM_WaitFor (s, req, 22, 0x6D, 4, ID_GetFile);
+		received = File->Used - old;
+
+		/* Phone does not like big parts, use safe size */
+		if (received == 0 && part > N6510_FILE_PART &&
+				File->Used < Priv->FileSize) {
+			smprintf(s, "Phone did not send part of %d bytes, using %d bytes\n", part, N6510_FILE_PART);
+			part = N6510_FILE_PART;
+			Priv->FilePartSize = part;
+			continue;
+		}
+		if (error != ERR_NONE) {
+			N6510_CloseFile2(s, &Handle);
+			return error;
+		}
+
+		if (received == part) {
+			if (Priv->FileSize == 0 || File->Used < Priv->FileSize) continue;
+		} else if (received > 0 && Priv->FileSize != 0 && File->Used < Priv->FileSize) {
+			/* Phone sends smaller parts than requested */
+			smprintf(s, "Phone sends parts of %d bytes\n", received);
+			part = received;
+			Priv->FilePartSize = part;
+			continue;
+		}
+		break;
+	}
+
+	error = N6510_GetFileCRC2(s, &Handle);
+	if (error != ERR_NONE) {
+		N6510_CloseFile2(s, &Handle);
+		return error;
+	}
+
+	error = N6510_CloseFile2(s, &Handle);
+	if (error != ERR_NONE) return error;
+
+	smprintf(s, "Checksum from Gammu is %04X\n", Priv->FileCheckAcc & 0xffff);
+	if ((Priv->FileCheckAcc & 0xffff) != Priv->FileCheckSum) {
+		smprintf(s,"File2 checksum is %i, File checksum is %i\n", Priv->FileCheckAcc & 0xffff, Priv->FileCheckSum);
+		return ERR_WRONGCRC;
+	}
+	return ERR_NONE;
+}
+
 GSM_Error N6510_ReplySetFileDate2(GSM_Protocol_Message *msg UNUSED, GSM_StateMachine *s UNUSED)
 {
 	return ERR_NONE;
@@ -1711,6 +1855,40 @@ GSM_Error N6510_GetFilePart(GSM_StateMachine *s, GSM_File *File, int *Handle, in
 	}
 }
 
+GSM_Error N6510_GetFileStream(GSM_StateMachine *s, GSM_File *File, GSM_FileSink sink, void *user_data)
+{
+	GSM_Phone_N6510Data	*Priv = &s->Phone.Data.Priv.N6510;
+	GSM_Error       	error;
+	int			Handle = 0, Size = 0;
+
+	if (GSM_IsPhoneFeatureAvailable(s->Phone.Data.ModelInfo, F_NOFILESYSTEM)) return ERR_NOTSUPPORTED;
+
+	File->Used = 0;
+	File->Buffer = NULL;
+
+	Priv->FileSink = sink;
+	Priv->FileStreamData = user_data;
+	Priv->FileSize = 0;
+	Priv->FileCheckAcc = 0xffff;
+	Priv->FileCheckAccx = 0;
+	if (DecodeUnicodeString(File->ID_FullName)[0] == 'c' ||
+	    DecodeUnicodeString(File->ID_FullName)[0] == 'C') {
+		/* Filesystem 1 does not support bigger parts */
+		do {
+			error = N6510_GetFilePart(s, File, &Handle, &Size);
+		} while (error == ERR_NONE);
+		if (error == ERR_EMPTY) error = ERR_NONE;
+	} else if (GSM_IsPhoneFeatureAvailable(s->Phone.Data.ModelInfo, F_FILES2)) {
+		error = N6510_GetFileStream2(s, File);
+	} else {
+		error = ERR_NOTSUPPORTED;
+	}
+	Priv->FileSink = NULL;
+	Priv->FileStreamData = NULL;
+
+	return error;
+}
+
 GSM_Error N6510_AddFilePart(GSM_StateMachine *s, GSM_File *File, int *Pos, int *Handle)
 {
 	GSM_File	File2;
@@ -1,4 +1,15 @@
 
+/**
+ * Size of file part which works with all phones.
+ */
+#define N6510_FILE_PART		0x03E8
+
+/**
+ * Size of file part requested from filesystem 2 over Phonet, phone
+ * might reply with smaller parts.
+ */
+#define N6510_FILE_PART_MAX	0x4000
+
 GSM_Error N6510_GetFileSystemStatus		(GSM_StateMachine *s, GSM_FileSystemStatus *status);
 GSM_Error N6510_GetNextFileFolder		(GSM_StateMachine *s, GSM_File *File, gboolean start);
 GSM_Error N6510_GetFolderListing		(GSM_StateMachine *s, GSM_File *File, gboolean start);
@@ -6,6 +17,7 @@ GSM_Error N6510_AddFolder			(GSM_StateMachine *s, GSM_File *File);
 GSM_Error N6510_DeleteFolder			(GSM_StateMachine *s, unsigned char *ID);
 GSM_Error N6510_GetFilePart			(GSM_StateMachine *s, GSM_File *File, int *Handle, int *Size);
 GSM_Error N6510_AddFilePart			(GSM_StateMachine *s, GSM_File *File, int *Pos, int *Handle);
+GSM_Error N6510_GetFileStream			(GSM_StateMachine *s, GSM_File *File, GSM_FileSink sink, void *user_data);
 GSM_Error N6510_DeleteFile			(GSM_StateMachine *s, unsigned char *ID);
 GSM_Error N6510_SetFileAttributes		(GSM_StateMachine *s, GSM_File *File);
 GSM_Error N6510_GetNextRootFolder		(GSM_StateMachine *s, GSM_File *File);
@@ -48,9 +48,19 @@ static GSM_Error N6510_Initialise (GSM_StateMachine *s)
 	s->Phone.Data.Priv.N6510.FilesLocationsAvail = 0;
 	s->Phone.Data.Priv.N6510.FilesLocationsUsed = 0;
 	s->Phone.Data.Priv.N6510.FilesCache = NULL;
+	s->Phone.Data.Priv.N6510.FileSink = NULL;
+	s->Phone.Data.Priv.N6510.FileStreamData = NULL;
 	s->Phone.Data.Priv.N6510.ScreenWidth = 0;
 	s->Phone.Data.Priv.N6510.ScreenHeight = 0;
 
+	/* Phonet carries big frames, FBUS splits them to small ones anyway */
+	s->Phone.Data.Priv.N6510.FilePartSize = N6510_FILE_PART;
+	if (s->ConnectionType == GCT_DKU2PHONET || s->ConnectionType == GCT_FBUS2USB ||
+			s->ConnectionType == GCT_PHONETBLUE || s->ConnectionType == GCT_BLUEPHONET ||
+			s->ConnectionType == GCT_IRDAPHONET) {
+		s->Phone.Data.Priv.N6510.FilePartSize = N6510_FILE_PART_MAX;
+	}
+
 	/* Default timeout for cables */
 	s->Phone.Data.Priv.N6510.Timeout = 8;
 	if (s->ConnectionType == GCT_IRDAPHONET || s->ConnectionType == GCT_FBUS2IRDA) {
@@ -4586,7 +4596,12 @@ GSM_Phone_Functions N6510Phone = {
 	N6510_GetGPRSAccessPoint,
 	N6510_SetGPRSAccessPoint,
 	DCT4_Screenshot,
-	NOTSUPPORTED			/* 	SetPower		*/
+	NOTSUPPORTED,			/* 	SetPower		*/
+	NOTIMPLEMENTED,			/* 	GetAllSMS		*/
+	N6510_GetFileStream,
+	NOTIMPLEMENTED,			/* 	AddFileStream		*/
+	NOTIMPLEMENTED,			/* 	GetMemoryChanges	*/
+	NOTIMPLEMENTED			/* 	GetCalendarChanges	*/
 };
 
 #endif
@@ -46,6 +46,24 @@ typedef struct {
 	int				FileToken;
 	int				ParentID;
 	int				FileCheckSum;
+	/**
+	 * Size of file part requested from filesystem 2.
+	 */
+	int				FilePartSize;
+	/**
+	 * Callback receiving file data, see \ref GSM_GetFileStream.
+	 */
+	GSM_FileSink			FileSink;
+	void				*FileStreamData;
+	/**
+	 * Total size of streamed file.
+	 */
+	size_t				FileSize;
+	/**
+	 * State of checksum calculated over streamed data.
+	 */
+	int				FileCheckAcc;
+	int				FileCheckAccx;
 	gboolean				FilesEnd;
 	gboolean				UseFs1;
 	GSM_Error			filesystem2error;
@@ -95,6 +113,9 @@ void N6510_DecodeFMFrequency(double *freq, unsigned char *buff);
 #ifndef GSM_USED_FBUS2
 #  define GSM_USED_FBUS2
 #endif
+#ifndef GSM_USED_SOCKETFBUS2
+#  define GSM_USED_SOCKETFBUS2
+#endif
 #ifndef GSM_USED_FBUS2DLR3
 #  define GSM_USED_FBUS2DLR3
 #endif
@@ -11,6 +11,9 @@
 #ifndef GSM_USED_FBUS2
 #  define GSM_USED_FBUS2
 #endif
+#ifndef GSM_USED_SOCKETFBUS2
+#  define GSM_USED_SOCKETFBUS2
+#endif
 
 typedef struct {
 	int				LastCalendarYear;
@@ -18,6 +18,8 @@
 
 static GSM_Error N3650_ReplyGetFilePart(GSM_Protocol_Message *msg, GSM_StateMachine *s)
 {
+	GSM_Phone_N3650Data	*Priv = &s->Phone.Data.Priv.N3650;
+	GSM_Error		error;
 	int old;
 
 	smprintf(s,"File part received\n");
@@ -37,8 +39,18 @@ static GSM_Error N3650_ReplyGetFilePart(GSM_Protocol_Message *msg, GSM_StateMach
 			msg->Buffer[11]*256*256+
 			msg->Buffer[12]*256+
 			msg->Buffer[13]);
-	s->Phone.Data.File->Buffer = (unsigned char *)realloc(s->Phone.Data.File->Buffer,s->Phone.Data.File->Used);
-	memcpy(s->Phone.Data.File->Buffer+old,msg->Buffer+18,s->Phone.Data.File->Used-old);
+	if (Priv->FileSink != NULL) {
+		/* Pass data to caller instead of storing them */
+		error = Priv->FileSink(s, s->Phone.Data.File,
+			msg->Buffer + 18,
+			s->Phone.Data.File->Used - old,
+			0,
+			Priv->FileStreamData);
+		if (error != ERR_NONE) return error;
+	} else {
+		s->Phone.Data.File->Buffer = (unsigned char *)realloc(s->Phone.Data.File->Buffer,s->Phone.Data.File->Used);
+		memcpy(s->Phone.Data.File->Buffer+old,msg->Buffer+18,s->Phone.Data.File->Used-old);
+	}
 	if (s->Phone.Data.File->Used-old < 0x03 * 256 + 0xD4) return ERR_EMPTY;
 	return ERR_NONE;
 }
@@ -99,6 +111,27 @@ static GSM_Error N3650_GetFilePart(GSM_StateMachine *s, GSM_File *File, int *Han
 	return error;
 }
 
+static GSM_Error N3650_GetFileStream(GSM_StateMachine *s, GSM_File *File, GSM_FileSink sink, void *user_data)
+{
+	GSM_Phone_N3650Data	*Priv = &s->Phone.Data.Priv.N3650;
+	GSM_Error		error;
+	int			Handle = 0, Size = 0;
+
+	File->Used = 0;
+	File->Buffer = NULL;
+
+	Priv->FileSink = sink;
+	Priv->FileStreamData = user_data;
+	do {
+		error = N3650_GetFilePart(s, File, &Handle, &Size);
+	} while (error == ERR_NONE);
+	Priv->FileSink = NULL;
+	Priv->FileStreamData = NULL;
+
+	if (error == ERR_EMPTY) return ERR_NONE;
+	return error;
+}
+
 static GSM_Error N3650_ReplyGetFolderInfo(GSM_Protocol_Message *msg, GSM_StateMachine *s)
 {
 	GSM_File	 	*File = s->Phone.Data.FileInfo;
@@ -242,6 +275,9 @@ static GSM_Error N3650_Initialise (GSM_StateMachine *s)
 	GSM_Phone_N3650Data 	*Priv = &s->Phone.Data.Priv.N3650;
 	int			i=0;
 
+	Priv->FileSink = NULL;
+	Priv->FileStreamData = NULL;
+
 	for (i=0;i<10000;i++) {
 		Priv->Files[i] = (GSM_File *)malloc(sizeof(GSM_File));
 	        if (Priv->Files[i] == NULL) return ERR_MOREMEMORY;
@@ -416,7 +452,12 @@ GSM_Phone_Functions N3650Phone = {
 	NOTSUPPORTED,			/* 	GetGPRSAccessPoint	*/
 	NOTSUPPORTED,			/* 	SetGPRSAccessPoint	*/
 	NOTSUPPORTED,			/* 	GetScreenshot		*/
-	NOTSUPPORTED			/* 	SetPower		*/
+	NOTSUPPORTED,			/* 	SetPower		*/
+	NOTIMPLEMENTED,			/* 	GetAllSMS		*/
+	N3650_GetFileStream,
+	NOTIMPLEMENTED,			/* 	AddFileStream		*/
+	NOTIMPLEMENTED,			/* 	GetMemoryChanges	*/
+	NOTIMPLEMENTED			/* 	GetCalendarChanges	*/
 };
 
 #endif
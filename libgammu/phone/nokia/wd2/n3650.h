@@ -12,6 +12,9 @@
 #ifndef GSM_USED_FBUS2
 #  define GSM_USED_FBUS2
 #endif
+#ifndef GSM_USED_SOCKETFBUS2
+#  define GSM_USED_SOCKETFBUS2
+#endif
 
 typedef struct {
 	int				FileLev;
@@ -19,6 +22,11 @@ typedef struct {
 	int				FilesLocationsCurrent;
 	GSM_File			*Files[10000];
 	int				FileEntries;
+	/**
+	 * Callback receiving file data, see \ref GSM_GetFileStream.
+	 */
+	GSM_FileSink			FileSink;
+	void				*FileStreamData;
 } GSM_Phone_N3650Data;
 
 #endif
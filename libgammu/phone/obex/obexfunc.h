@@ -13,6 +13,8 @@ extern void OBEXGEN_FreeVars(GSM_StateMachine *s);
 extern GSM_Error OBEXGEN_GetFilePart	(GSM_StateMachine *s, GSM_File *File, int *Handle, int *Size);
 extern GSM_Error OBEXGEN_AddFilePart	(GSM_StateMachine *s, GSM_File *File, int *Pos, int *Handle);
 extern GSM_Error OBEXGEN_SendFilePart	(GSM_StateMachine *s, GSM_File *File, int *Pos, int *Handle);
+extern GSM_Error OBEXGEN_GetFileStream	(GSM_StateMachine *s, GSM_File *File, GSM_FileSink sink, void *user_data);
+extern GSM_Error OBEXGEN_AddFileStream	(GSM_StateMachine *s, GSM_File *File, GSM_FileSource source, void *user_data);
 extern GSM_Error OBEXGEN_GetNextFileFolder(GSM_StateMachine *s, GSM_File *File, gboolean start);
 extern GSM_Error OBEXGEN_Disconnect	(GSM_StateMachine *s);
 extern GSM_Error OBEXGEN_Connect	(GSM_StateMachine *s, OBEX_Service service);
@@ -20,6 +22,7 @@ extern GSM_Error OBEXGEN_DeleteFile(GSM_StateMachine *s, unsigned char *ID);
 extern GSM_Error OBEXGEN_AddFolder(GSM_StateMachine *s, GSM_File *File);
 extern GSM_Error OBEXGEN_GetMemoryStatus(GSM_StateMachine *s, GSM_MemoryStatus *Status);
 extern GSM_Error OBEXGEN_GetNextMemory(GSM_StateMachine *s, GSM_MemoryEntry *entry, gboolean start);
+extern GSM_Error OBEXGEN_GetMemoryChanges(GSM_StateMachine *s, GSM_MemoryType type, const char *state_file, GSM_MemoryChangeCallback callback, void *user_data);
 extern GSM_Error OBEXGEN_GetMemory(GSM_StateMachine *s, GSM_MemoryEntry *Entry);
 extern GSM_Error OBEXGEN_AddMemory(GSM_StateMachine *s, GSM_MemoryEntry *Entry);
 extern GSM_Error OBEXGEN_SetMemory(GSM_StateMachine *s, GSM_MemoryEntry *Entry);
@@ -28,6 +31,7 @@ extern GSM_Error OBEXGEN_DeleteAllMemory(GSM_StateMachine *, GSM_MemoryType Memo
 extern GSM_Error OBEXGEN_GetCalendarStatus(GSM_StateMachine *s, GSM_CalendarStatus *Status);
 extern GSM_Error OBEXGEN_GetCalendar(GSM_StateMachine *s, GSM_CalendarEntry *Entry);
 extern GSM_Error OBEXGEN_GetNextCalendar(GSM_StateMachine *s, GSM_CalendarEntry *Entry, gboolean start);
+extern GSM_Error OBEXGEN_GetCalendarChanges(GSM_StateMachine *s, const char *state_file, GSM_CalendarChangeCallback callback, void *user_data);
 extern GSM_Error OBEXGEN_AddCalendar(GSM_StateMachine *s, GSM_CalendarEntry *Entry);
 extern GSM_Error OBEXGEN_SetCalendar(GSM_StateMachine *s, GSM_CalendarEntry *Entry);
 extern GSM_Error OBEXGEN_DeleteCalendar(GSM_StateMachine *s, GSM_CalendarEntry *Entry);
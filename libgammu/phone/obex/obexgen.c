@@ -22,6 +22,7 @@
  */
 
 #include <string.h>
+#include <ctype.h>
 #include <time.h>
 
 #include <gammu-config.h>
@@ -46,6 +47,21 @@ GSM_Error OBEXGEN_GetModel(GSM_StateMachine *s);
  */
 #define OBEX_TIMEOUT 10
 
+/**
+ * Maximal size of packet we accept, the protocol limit.
+ */
+#define OBEX_MAX_FRAME_SIZE 0xFFFF
+
+/**
+ * Size of packet used before phone tells us its limit.
+ */
+#define OBEX_DEFAULT_FRAME_SIZE 0x400
+
+/**
+ * Space reserved for headers in file transfer packets.
+ */
+#define OBEX_HEADERS_SIZE 2000
+
 /**
  * Handles various error codes in OBEX protocol.
  */
@@ -187,7 +203,8 @@ GSM_Error OBEXGEN_Connect(GSM_StateMachine *s, OBEX_Service service)
 	unsigned char 	req[200] = {
 		0x10,			/* Version 1.0 			*/
 		0x00,			/* no flags 			*/
-		0x04,0x00};		/* max size of packet (changed bellow for m-obex) */
+		OBEX_MAX_FRAME_SIZE / 256,	/* max size of packet	*/
+		OBEX_MAX_FRAME_SIZE % 256};
 
 	/* Are we requsted for initial service? */
 	if (service == 0) {
@@ -235,8 +252,6 @@ GSM_Error OBEXGEN_Connect(GSM_StateMachine *s, OBEX_Service service)
 		OBEXAddBlock(req, &Current, 0x46, req2, 16);
 		break;
 	case OBEX_m_OBEX:
-		/* Bigger frame size for m-OBEX */
-		req[2] = 0x20;
 		/* IrMC Service UUID */
 		req2[0] = 'M'; req2[1] = 'O'; req2[2] = 'B';
 		req2[3] = 'E'; req2[4] = 'X';
@@ -274,6 +289,12 @@ GSM_Error OBEXGEN_InitialiseVars(GSM_StateMachine *s)
 
 	Priv->Service = 0;
 	Priv->InitialService = 0;
+	Priv->FrameSize = OBEX_DEFAULT_FRAME_SIZE;
+	Priv->FileSink = NULL;
+	Priv->FileSource = NULL;
+	Priv->FileAbort = FALSE;
+	Priv->FileStreamData = NULL;
+	Priv->FileSize = 0;
 	Priv->PbLUID = NULL;
 	Priv->PbLUIDCount = 0;
 	Priv->PbIndex = NULL;
@@ -398,12 +419,9 @@ GSM_Error OBEXGEN_Initialise(GSM_StateMachine *s)
 }
 
 /**
- * Frees internal OBEX variables.
- *
- * \todo This should be done on terminate, but not on termination from
- * Sony-Ericsson.
+ * Frees cached phonebook listing, it is read again on next access.
  */
-void OBEXGEN_FreeVars(GSM_StateMachine *s)
+static void OBEXGEN_FreePbLUID(GSM_StateMachine *s)
 {
 	GSM_Phone_OBEXGENData	*Priv = &s->Phone.Data.Priv.OBEXGEN;
 	int i=0;
@@ -414,17 +432,25 @@ void OBEXGEN_FreeVars(GSM_StateMachine *s)
 	}
 	free(Priv->PbLUID);
 	Priv->PbLUID=NULL;
+	Priv->PbLUIDCount=0;
 	free(Priv->PbData);
 	Priv->PbData=NULL;
+	free(Priv->PbIndex);
+	Priv->PbIndex=NULL;
+	Priv->PbIndexCount=0;
+	free(Priv->PbOffsets);
+	Priv->PbOffsets=NULL;
+	Priv->PbCount=0;
+}
 
-	for (i = 1; i <= Priv->NoteLUIDCount; i++) {
-		free(Priv->NoteLUID[i]);
-		Priv->NoteLUID[i]=NULL;
-	}
-	free(Priv->NoteLUID);
-	Priv->NoteLUID=NULL;
-	free(Priv->NoteData);
-	Priv->NoteData=NULL;
+/**
+ * Frees cached calendar and todo listing, it is read again on next
+ * access.
+ */
+static void OBEXGEN_FreeCalLUID(GSM_StateMachine *s)
+{
+	GSM_Phone_OBEXGENData	*Priv = &s->Phone.Data.Priv.OBEXGEN;
+	int i=0;
 
 	for (i = 1; i <= Priv->CalLUIDCount; i++) {
 		free(Priv->CalLUID[i]);
@@ -432,6 +458,7 @@ void OBEXGEN_FreeVars(GSM_StateMachine *s)
 	}
 	free(Priv->CalLUID);
 	Priv->CalLUID=NULL;
+	Priv->CalLUIDCount=0;
 	free(Priv->CalData);
 	Priv->CalData=NULL;
 
@@ -441,22 +468,47 @@ void OBEXGEN_FreeVars(GSM_StateMachine *s)
 	}
 	free(Priv->TodoLUID);
 	Priv->TodoLUID=NULL;
-	free(Priv->PbIndex);
-	Priv->PbIndex=NULL;
-	free(Priv->NoteIndex);
-	Priv->NoteIndex=NULL;
+	Priv->TodoLUIDCount=0;
 	free(Priv->CalIndex);
 	Priv->CalIndex=NULL;
+	Priv->CalIndexCount=0;
 	free(Priv->TodoIndex);
 	Priv->TodoIndex=NULL;
-	free(Priv->PbOffsets);
-	Priv->PbOffsets=NULL;
-	free(Priv->NoteOffsets);
-	Priv->NoteOffsets=NULL;
+	Priv->TodoIndexCount=0;
 	free(Priv->CalOffsets);
 	Priv->CalOffsets=NULL;
+	Priv->CalCount=0;
 	free(Priv->TodoOffsets);
 	Priv->TodoOffsets=NULL;
+	Priv->TodoCount=0;
+}
+
+/**
+ * Frees internal OBEX variables.
+ *
+ * \todo This should be done on terminate, but not on termination from
+ * Sony-Ericsson.
+ */
+void OBEXGEN_FreeVars(GSM_StateMachine *s)
+{
+	GSM_Phone_OBEXGENData	*Priv = &s->Phone.Data.Priv.OBEXGEN;
+	int i=0;
+
+	OBEXGEN_FreePbLUID(s);
+	OBEXGEN_FreeCalLUID(s);
+
+	for (i = 1; i <= Priv->NoteLUIDCount; i++) {
+		free(Priv->NoteLUID[i]);
+		Priv->NoteLUID[i]=NULL;
+	}
+	free(Priv->NoteLUID);
+	Priv->NoteLUID=NULL;
+	free(Priv->NoteData);
+	Priv->NoteData=NULL;
+	free(Priv->NoteIndex);
+	Priv->NoteIndex=NULL;
+	free(Priv->NoteOffsets);
+	Priv->NoteOffsets=NULL;
 	free(Priv->OBEXCapability);
 	Priv->OBEXCapability=NULL;
 	free(Priv->OBEXDevinfo);
@@ -752,12 +804,19 @@ GSM_Error OBEXGEN_PrivAddFilePart(GSM_StateMachine *s, GSM_File *File, int *Pos,
 	GSM_Error		error;
 	size_t			j;
 	int		Current = 0;
-	unsigned char 		req[2000];
+	unsigned char 		*req;
 	unsigned char		hard_delete_header[2] = {'\x12', '\x0'};
+	unsigned char		type;
+	gboolean		empty;
 	GSM_Phone_OBEXGENData	*Priv = &s->Phone.Data.Priv.OBEXGEN;
 
 	s->Phone.Data.File = File;
 
+	req = (unsigned char *)malloc(OBEX_HEADERS_SIZE + OBEX_MAX_FRAME_SIZE);
+	if (req == NULL) {
+		return ERR_MOREMEMORY;
+	}
+
 	if (Priv->Service == OBEX_BrowsingFolders || Priv->Service == OBEX_m_OBEX) {
 		OBEXGEN_AddConnectionID(s, req, &Current);
 	}
@@ -766,11 +825,11 @@ GSM_Error OBEXGEN_PrivAddFilePart(GSM_StateMachine *s, GSM_File *File, int *Pos,
 	if (*Pos == 0) {
 		if (!strcmp(DecodeUnicodeString(File->ID_FullName),"")) {
 			error = OBEXGEN_Connect(s,OBEX_None);
-			if (error != ERR_NONE) return error;
+			if (error != ERR_NONE) goto done;
 		} else {
 			if (Priv->Service == OBEX_BrowsingFolders) {
 				error = OBEXGEN_ChangeToFilePath(s, File->ID_FullName, FALSE, NULL);
-				if (error != ERR_NONE) return error;
+				if (error != ERR_NONE) goto done;
 			}
 		}
 
@@ -787,12 +846,17 @@ GSM_Error OBEXGEN_PrivAddFilePart(GSM_StateMachine *s, GSM_File *File, int *Pos,
 		}
 
 		/* Adding empty file is special on mobex */
-		if (Priv->Service == OBEX_m_OBEX && File->Buffer == NULL) {
+		if (Priv->FileSource != NULL) {
+			empty = (File->Used == 0);
+		} else {
+			empty = (File->Buffer == NULL);
+		}
+		if (Priv->Service == OBEX_m_OBEX && empty) {
 			error = GSM_WaitFor (s, req, Current, 0x82, OBEX_TIMEOUT * 10, ID_AddFile);
 			if (error == ERR_NONE) {
-				return ERR_EMPTY;
+				error = ERR_EMPTY;
 			}
-			return error;
+			goto done;
 		}
 
 		/* File size block */
@@ -808,25 +872,49 @@ GSM_Error OBEXGEN_PrivAddFilePart(GSM_StateMachine *s, GSM_File *File, int *Pos,
 		}
 	}
 
-	j = Priv->FrameSize - Current - 20;
-	if (j > 1000) j = 1000;
+	/* Fill rest of packet negotiated with phone by file data */
+	if (Priv->FrameSize > Current + 20 + 255) {
+		j = Priv->FrameSize - Current - 20;
+	} else {
+		j = 255;
+	}
 
 	if (File->Used - *Pos < j) {
 		j = File->Used - *Pos;
 		/* End of file body block */
-		OBEXAddBlock(req, &Current, 0x49, File->Buffer+(*Pos), j);
+		type = 0x49;
+	} else {
+		/* File body block */
+		type = 0x48;
+	}
+
+	if (Priv->FileSource != NULL) {
+		OBEXAddBlock(req, &Current, type, NULL, j);
+		error = Priv->FileSource(s, File, req + Current, j, Priv->FileStreamData);
+		if (error != ERR_NONE) {
+			/* Phone already has first part */
+			Priv->FileAbort = (*Pos != 0);
+			goto done;
+		}
+		Current += j;
+	} else {
+		OBEXAddBlock(req, &Current, type, File->Buffer+(*Pos), j);
+	}
+
+	if (type == 0x49) {
 		smprintf(s, "Adding last file part %i %ld\n", *Pos, (long)j);
 		*Pos = *Pos + j;
 		error = GSM_WaitFor (s, req, Current, 0x82, OBEX_TIMEOUT * 10, ID_AddFile);
-		if (error != ERR_NONE) return error;
-		return ERR_EMPTY;
+		if (error == ERR_NONE) {
+			error = ERR_EMPTY;
+		}
 	} else {
-		/* File body block */
-		OBEXAddBlock(req, &Current, 0x48, File->Buffer+(*Pos), j);
 		smprintf(s, "Adding file part %i %ld\n", *Pos, (long)j);
 		*Pos = *Pos + j;
 		error=GSM_WaitFor (s, req, Current, 0x02, OBEX_TIMEOUT * 10, ID_AddFile);
 	}
+done:
+	free(req);
 	return error;
 }
 
@@ -877,6 +965,7 @@ static GSM_Error OBEXGEN_ReplyGetFilePart(GSM_Protocol_Message *msg, GSM_StateMa
 {
 	size_t old,Pos=0,len2,pos2;
 	GSM_Phone_OBEXGENData	*Priv = &s->Phone.Data.Priv.OBEXGEN;
+	GSM_Error		error;
 
 	/* Non standard Sharp GX reply */
 	if (msg->Type == 0x80) {
@@ -905,14 +994,28 @@ static GSM_Error OBEXGEN_ReplyGetFilePart(GSM_Protocol_Message *msg, GSM_StateMa
 				s->Phone.Data.File->Used += msg->Buffer[Pos+1]*256+msg->Buffer[Pos+2]-3;
 				smprintf(s,"Length of file part: %i\n",
 						msg->Buffer[Pos+1]*256+msg->Buffer[Pos+2]-3);
+				if (Priv->FileSink != NULL) {
+					/* Pass data to caller instead of storing them */
+					error = Priv->FileSink(s, s->Phone.Data.File,
+						msg->Buffer + Pos + 3,
+						s->Phone.Data.File->Used - old,
+						Priv->FileSize,
+						Priv->FileStreamData);
+					if (error != ERR_NONE && !Priv->FileLastPart) {
+						Priv->FileAbort = TRUE;
+					}
+					return error;
+				}
 				s->Phone.Data.File->Buffer = (unsigned char *)realloc(s->Phone.Data.File->Buffer,s->Phone.Data.File->Used);
 				memcpy(s->Phone.Data.File->Buffer+old,msg->Buffer+Pos+3,s->Phone.Data.File->Used-old);
 				return ERR_NONE;
 			case 0xc3:
 				/* Length */
-				/**
-				 * @todo Length is ignored now
-				 */
+				Priv->FileSize = ((size_t)msg->Buffer[Pos + 1] << 24) +
+					((size_t)msg->Buffer[Pos + 2] << 16) +
+					((size_t)msg->Buffer[Pos + 3] << 8) +
+					msg->Buffer[Pos + 4];
+				smprintf(s, "File length: %ld\n", (long)Priv->FileSize);
 				Pos += 5;
 				break;
 			case 0xcb:
@@ -1022,6 +1125,7 @@ static GSM_Error OBEXGEN_PrivGetFilePart(GSM_StateMachine *s, GSM_File *File, gb
 	}
 
 	Priv->FileLastPart = FALSE;
+	Priv->FileSize = 0;
 
 	/* Include m-obex application data */
 	if (Priv->Service == OBEX_m_OBEX && Priv->m_obex_appdata != NULL && Priv->m_obex_appdata_len != 0) {
@@ -1081,6 +1185,102 @@ GSM_Error OBEXGEN_GetFilePart(GSM_StateMachine *s, GSM_File *File, int *Handle,
 	return error;
 }
 
+static GSM_Error OBEXGEN_ReplyAbort(GSM_Protocol_Message *msg, GSM_StateMachine *s)
+{
+	if (msg->Type == 0xA0) {
+		smprintf(s, "Operation aborted\n");
+		return ERR_NONE;
+	}
+	return OBEXGEN_HandleError(msg, s);
+}
+
+/**
+ * Aborts file transfer in progress, used when caller refuses to handle
+ * more data of streamed file.
+ */
+static void OBEXGEN_AbortFile(GSM_StateMachine *s)
+{
+	GSM_Phone_OBEXGENData	*Priv = &s->Phone.Data.Priv.OBEXGEN;
+	unsigned char		req[10];
+	int			Current = 0;
+	GSM_Error		error;
+
+	Priv->FileAbort = FALSE;
+
+	if (Priv->Service == OBEX_BrowsingFolders || Priv->Service == OBEX_m_OBEX) {
+		OBEXGEN_AddConnectionID(s, req, &Current);
+	}
+
+	smprintf(s, "Aborting file transfer\n");
+	error = GSM_WaitFor (s, req, Current, 0xFF, OBEX_TIMEOUT, ID_AbortFile);
+	if (error != ERR_NONE) {
+		/* Original error is reported to caller, this one is only logged */
+		smprintf(s, "Failed to abort file transfer: %s\n", GSM_ErrorString(error));
+	}
+}
+
+GSM_Error OBEXGEN_GetFileStream(GSM_StateMachine *s, GSM_File *File, GSM_FileSink sink, void *user_data)
+{
+	GSM_Error		error;
+	GSM_Phone_OBEXGENData	*Priv = &s->Phone.Data.Priv.OBEXGEN;
+
+	/* Go to default service */
+	error = OBEXGEN_Connect(s, 0);
+	if (error != ERR_NONE) return error;
+
+	File->Used = 0;
+	File->Buffer = NULL;
+
+	Priv->FileSink = sink;
+	Priv->FileStreamData = user_data;
+	Priv->FileAbort = FALSE;
+	error = OBEXGEN_PrivGetFilePart(s, File, FALSE);
+	Priv->FileSink = NULL;
+	Priv->FileStreamData = NULL;
+
+	if (Priv->FileAbort) {
+		OBEXGEN_AbortFile(s);
+	}
+
+	if (error == ERR_EMPTY) {
+		return ERR_NONE;
+	}
+	return error;
+}
+
+GSM_Error OBEXGEN_AddFileStream(GSM_StateMachine *s, GSM_File *File, GSM_FileSource source, void *user_data)
+{
+	GSM_Error		error;
+	GSM_Phone_OBEXGENData	*Priv = &s->Phone.Data.Priv.OBEXGEN;
+	int			Pos = 0, Handle = 0;
+
+	/* Go to default service */
+	error = OBEXGEN_Connect(s, 0);
+	if (error != ERR_NONE) return error;
+
+	smprintf(s,"Adding file\n");
+	Priv->FileSource = source;
+	Priv->FileStreamData = user_data;
+	Priv->FileAbort = FALSE;
+	do {
+		error = OBEXGEN_PrivAddFilePart(s, File, &Pos, &Handle, FALSE);
+	} while (error == ERR_NONE);
+	Priv->FileSource = NULL;
+	Priv->FileStreamData = NULL;
+
+	if (Priv->FileAbort) {
+		OBEXGEN_AbortFile(s);
+	}
+
+	if (error != ERR_EMPTY) {
+		return error;
+	}
+
+	/* Calculate path of added file */
+	OBEXGEN_CreateFileName(File->ID_FullName, File->ID_FullName, File->Name);
+	return ERR_NONE;
+}
+
 
 /**
  * List OBEX folder.
@@ -1695,7 +1895,7 @@ GSM_Error OBEXGEN_InitLUID(GSM_StateMachine *s, const char *Name,
 					(*Count)++;
 					/* Do we need to reallocate? */
 					if (*Count >= Size) {
-						Size += 20;
+						Size = Size * 2 + 20;
 						*Offsets = (int *)realloc(*Offsets, Size * sizeof(int));
 						if (*Offsets == NULL) {
 							return ERR_MOREMEMORY;
@@ -1718,7 +1918,7 @@ GSM_Error OBEXGEN_InitLUID(GSM_StateMachine *s, const char *Name,
 					(*LUIDCount)++;
 					/* Do we need to reallocate? */
 					if (*LUIDCount >= LUIDSize) {
-						LUIDSize += 20;
+						LUIDSize = LUIDSize * 2 + 20;
 						*LUIDStorage = (char **)realloc(*LUIDStorage, LUIDSize * sizeof(char *));
 						if (*LUIDStorage == NULL) {
 							return ERR_MOREMEMORY;
@@ -1734,7 +1934,7 @@ GSM_Error OBEXGEN_InitLUID(GSM_StateMachine *s, const char *Name,
 					(*IndexCount)++;
 					/* Do we need to reallocate? */
 					if (*IndexCount >= IndexSize) {
-						IndexSize += 20;
+						IndexSize = IndexSize * 2 + 20;
 						*IndexStorage = (int *)realloc(*IndexStorage, IndexSize * sizeof(int));
 						if (*IndexStorage == NULL) {
 							return ERR_MOREMEMORY;
@@ -3517,6 +3717,638 @@ GSM_Error OBEXGEN_DeleteAllNotes(GSM_StateMachine *s)
 
 /*@}*/
 
+/**
+ * \defgroup IrMCsync IrMC incremental synchronisation
+ * \ingroup OBEXPhone
+ * @{
+ */
+
+/**
+ * Frees synchronisation state.
+ */
+void OBEXGEN_FreeSyncState(IRMC_SyncState *State)
+{
+	int i;
+
+	for (i = 1; i <= State->LUIDCount; i++) {
+		free(State->LUID[i]);
+	}
+	free(State->LUID);
+	free(State->DID);
+	free(State->CC);
+	State->LUID = NULL;
+	State->LUIDCount = 0;
+	State->DID = NULL;
+	State->CC = NULL;
+}
+
+/**
+ * Replaces LUID map in synchronisation state by given list.
+ */
+static GSM_Error OBEXGEN_SetSyncLUID(IRMC_SyncState *State, char **LUID, int LUIDCount)
+{
+	int i;
+
+	for (i = 1; i <= State->LUIDCount; i++) {
+		free(State->LUID[i]);
+	}
+	free(State->LUID);
+	State->LUIDCount = 0;
+
+	State->LUID = (char **)malloc((LUIDCount + 1) * sizeof(char *));
+	if (State->LUID == NULL) {
+		return ERR_MOREMEMORY;
+	}
+	State->LUID[0] = NULL;
+	for (i = 1; i <= LUIDCount; i++) {
+		State->LUID[i] = (LUID[i] == NULL) ? NULL : strdup(LUID[i]);
+	}
+	State->LUIDCount = LUIDCount;
+	return ERR_NONE;
+}
+
+/**
+ * Finds location of LUID in synchronisation state, optionally adding
+ * it at the end.
+ *
+ * \return Location or 0 if not found.
+ */
+static int OBEXGEN_FindSyncLUID(IRMC_SyncState *State, const char *LUID, gboolean Add)
+{
+	char	**tmp;
+	int	i;
+
+	for (i = 1; i <= State->LUIDCount; i++) {
+		if (State->LUID[i] != NULL && strcmp(State->LUID[i], LUID) == 0) {
+			return i;
+		}
+	}
+	if (!Add) {
+		return 0;
+	}
+	tmp = (char **)realloc(State->LUID, (State->LUIDCount + 2) * sizeof(char *));
+	if (tmp == NULL) {
+		return 0;
+	}
+	State->LUID = tmp;
+	State->LUIDCount++;
+	State->LUID[0] = NULL;
+	State->LUID[State->LUIDCount] = strdup(LUID);
+	return State->LUIDCount;
+}
+
+/**
+ * Loads synchronisation state of object store from file. Missing or
+ * different store state is not an error, state is empty then.
+ */
+GSM_Error OBEXGEN_LoadSyncState(GSM_StateMachine *s, const char *FileName, const char *Store, IRMC_SyncState *State)
+{
+	INI_Section	*file = NULL;
+	INI_Entry	*entry;
+	const char	*value;
+	int		location;
+	GSM_Error	error;
+
+	State->DID = NULL;
+	State->CC = NULL;
+	State->LUID = NULL;
+	State->LUIDCount = 0;
+
+	if (FileName == NULL) {
+		return ERR_NONE;
+	}
+
+	error = INI_ReadFile(FileName, FALSE, &file);
+	if (error != ERR_NONE) {
+		smprintf(s, "Could not read synchronisation state %s\n", FileName);
+		return ERR_NONE;
+	}
+
+	value = (const char *)INI_GetValue(file, "irmc", "Store", FALSE);
+	if (value == NULL || strcmp(value, Store) != 0) {
+		smprintf(s, "Synchronisation state is not for %s store\n", Store);
+		INI_Free(file);
+		return ERR_NONE;
+	}
+
+	value = (const char *)INI_GetValue(file, "irmc", "DID", FALSE);
+	if (value != NULL) {
+		State->DID = strdup(value);
+	}
+	value = (const char *)INI_GetValue(file, "irmc", "CC", FALSE);
+	if (value != NULL) {
+		State->CC = strdup(value);
+	}
+
+	/* Find number of locations first */
+	for (entry = INI_FindLastSectionEntry(file, "luid", FALSE); entry != NULL; entry = entry->Prev) {
+		location = atoi(entry->EntryName);
+		if (location > State->LUIDCount) {
+			State->LUIDCount = location;
+		}
+	}
+	State->LUID = (char **)calloc(State->LUIDCount + 1, sizeof(char *));
+	if (State->LUID == NULL) {
+		State->LUIDCount = 0;
+		INI_Free(file);
+		return ERR_MOREMEMORY;
+	}
+	for (entry = INI_FindLastSectionEntry(file, "luid", FALSE); entry != NULL; entry = entry->Prev) {
+		location = atoi(entry->EntryName);
+		if (location > 0 && State->LUID[location] == NULL) {
+			State->LUID[location] = strdup(entry->EntryValue);
+		}
+	}
+
+	smprintf(s, "Loaded synchronisation state, DID %s, CC %s, %d locations\n",
+		State->DID == NULL ? "" : State->DID,
+		State->CC == NULL ? "" : State->CC,
+		State->LUIDCount);
+
+	INI_Free(file);
+	return ERR_NONE;
+}
+
+/**
+ * Saves synchronisation state of object store to file.
+ */
+GSM_Error OBEXGEN_SaveSyncState(GSM_StateMachine *s, const char *FileName, const char *Store, IRMC_SyncState *State)
+{
+	GSM_Error	error;
+	FILE	*file;
+	char	*tmpname;
+	int	i;
+
+	if (FileName == NULL) {
+		return ERR_NONE;
+	}
+
+	/* Write to temporary file first, so that state is not lost on failure */
+	tmpname = (char *)malloc(strlen(FileName) + 5);
+	if (tmpname == NULL) {
+		return ERR_MOREMEMORY;
+	}
+	sprintf(tmpname, "%s.tmp", FileName);
+
+	file = fopen(tmpname, "w");
+	if (file == NULL) {
+		smprintf(s, "Could not write synchronisation state %s\n", tmpname);
+		free(tmpname);
+		return ERR_CANTOPENFILE;
+	}
+
+	fprintf(file, "; IrMC synchronisation state written by Gammu, remove to read all entries again\n");
+	fprintf(file, "[irmc]\n");
+	fprintf(file, "Store = %s\n", Store);
+	if (State->DID != NULL) {
+		fprintf(file, "DID = %s\n", State->DID);
+	}
+	if (State->CC != NULL) {
+		fprintf(file, "CC = %s\n", State->CC);
+	}
+	fprintf(file, "[luid]\n");
+	for (i = 1; i <= State->LUIDCount; i++) {
+		if (State->LUID[i] != NULL) {
+			fprintf(file, "%d = %s\n", i, State->LUID[i]);
+		}
+	}
+
+	error = GSM_ReplaceFile(file, tmpname, FileName);
+	if (error != ERR_NONE) {
+		smprintf(s, "Could not write synchronisation state %s\n", FileName);
+	}
+	free(tmpname);
+	return error;
+}
+
+/**
+ * Records change of location, later change of same location replaces
+ * earlier one.
+ */
+static GSM_Error OBEXGEN_AddChange(IRMC_Change **Changes, int *Count, int Location, gboolean Deleted)
+{
+	IRMC_Change	*tmp;
+	int		i;
+
+	for (i = 0; i < *Count; i++) {
+		if ((*Changes)[i].Location == Location) {
+			(*Changes)[i].Deleted = Deleted;
+			return ERR_NONE;
+		}
+	}
+	tmp = (IRMC_Change *)realloc(*Changes, (*Count + 1) * sizeof(IRMC_Change));
+	if (tmp == NULL) {
+		return ERR_MOREMEMORY;
+	}
+	*Changes = tmp;
+	(*Changes)[*Count].Location = Location;
+	(*Changes)[*Count].Deleted = Deleted;
+	(*Count)++;
+	return ERR_NONE;
+}
+
+/**
+ * Parses IrMC change log and applies it to LUID map in synchronisation
+ * state. Lines in log look like:
+ *
+ * M:5::000012
+ * D:6:20080102T102030Z:00000A
+ *
+ * \param Full Set to TRUE when log does not describe all changes (it
+ * has overflowed or database was replaced) and all entries have to be
+ * read.
+ */
+GSM_Error OBEXGEN_ParseChangeLog(GSM_StateMachine *s, const char *data, IRMC_SyncState *State, IRMC_Change **Changes, int *Count, gboolean *Full)
+{
+	GSM_Error	error;
+	char		line[2000];
+	char		*luid;
+	size_t		pos = 0, len;
+	int		location;
+
+	*Full = FALSE;
+	len = strlen(data);
+
+	while (1) {
+		error = MyGetLine((char *)data, &pos, line, len, sizeof(line), FALSE);
+		if (error != ERR_NONE) return error;
+		if (pos >= len && strlen(line) == 0) break;
+		if (strlen(line) == 0) continue;
+
+		if (strncmp(line, "DID:", 4) == 0) {
+			if (State->DID != NULL && strcmp(State->DID, line + 4) != 0) {
+				smprintf(s, "Database ID changed from %s to %s\n", State->DID, line + 4);
+				*Full = TRUE;
+			}
+			free(State->DID);
+			State->DID = strdup(line + 4);
+		} else if (strcmp(line, "*") == 0) {
+			smprintf(s, "Change log does not contain all changes\n");
+			*Full = TRUE;
+		} else if (line[1] == ':' &&
+				(line[0] == 'M' || line[0] == 'D' || line[0] == 'H')) {
+			/* LUID is last field, timestamp before it is optional */
+			luid = strrchr(line, ':') + 1;
+			if (*luid == 0) {
+				smprintf(s, "Missing LUID in change: %s\n", line);
+				continue;
+			}
+			if (line[0] == 'M') {
+				location = OBEXGEN_FindSyncLUID(State, luid, TRUE);
+				if (location == 0) return ERR_MOREMEMORY;
+				smprintf(s, "Modified LUID %s at location %d\n", luid, location);
+				error = OBEXGEN_AddChange(Changes, Count, location, FALSE);
+			} else {
+				location = OBEXGEN_FindSyncLUID(State, luid, FALSE);
+				if (location == 0) {
+					smprintf(s, "Deleted unknown LUID %s\n", luid);
+					continue;
+				}
+				smprintf(s, "Deleted LUID %s at location %d\n", luid, location);
+				error = OBEXGEN_AddChange(Changes, Count, location, TRUE);
+			}
+			if (error != ERR_NONE) return error;
+		}
+		/* SN, Total-Records and Maximum-Records are not needed */
+	}
+
+	return ERR_NONE;
+}
+
+/**
+ * Reads change log for object store since change counter stored in
+ * synchronisation state and updates the state to current change
+ * counter.
+ */
+static GSM_Error OBEXGEN_ReadChanges(GSM_StateMachine *s, const char *Store, IRMC_SyncState *State, IRMC_Change **Changes, int *Count, gboolean *Full)
+{
+	GSM_Error	error;
+	char		path[100];
+	char		*cc = NULL, *data = NULL;
+	gboolean	full;
+	size_t		i;
+
+	*Full = TRUE;
+	*Changes = NULL;
+	*Count = 0;
+
+	/* Current change counter */
+	sprintf(path, "telecom/%s/luid/cc.log", Store);
+	error = OBEXGEN_GetTextFile(s, path, &cc);
+	if (error == ERR_FILENOTEXIST || error == ERR_BUG || error == ERR_PERMISSION || error == ERR_NOTSUPPORTED) {
+		smprintf(s, "Phone does not provide change counter\n");
+		free(State->CC);
+		State->CC = NULL;
+		return ERR_NONE;
+	}
+	if (error != ERR_NONE) return error;
+
+	/* Keep only the number */
+	for (i = 0; isdigit((int)(unsigned char)cc[i]); i++);
+	cc[i] = 0;
+	if (i == 0 || i > 20) {
+		smprintf(s, "Invalid change counter\n");
+		free(cc);
+		free(State->CC);
+		State->CC = NULL;
+		return ERR_NONE;
+	}
+	smprintf(s, "Current change counter: %s\n", cc);
+
+	if (State->CC != NULL && strspn(State->CC, "0123456789") == strlen(State->CC) && strlen(State->CC) <= 20) {
+		sprintf(path, "telecom/%s/luid/%s.log", Store, State->CC);
+		error = OBEXGEN_GetTextFile(s, path, &data);
+		if (error == ERR_NONE) {
+			error = OBEXGEN_ParseChangeLog(s, data, State, Changes, Count, Full);
+			free(data);
+			data = NULL;
+			if (error != ERR_NONE) {
+				free(cc);
+				return error;
+			}
+		} else if (error != ERR_FILENOTEXIST && error != ERR_BUG) {
+			free(cc);
+			return error;
+		}
+	}
+
+	if (*Full) {
+		free(*Changes);
+		*Changes = NULL;
+		*Count = 0;
+		/* Get current database ID, the log is empty */
+		free(State->DID);
+		State->DID = NULL;
+		sprintf(path, "telecom/%s/luid/%s.log", Store, cc);
+		error = OBEXGEN_GetTextFile(s, path, &data);
+		if (error == ERR_NONE) {
+			error = OBEXGEN_ParseChangeLog(s, data, State, Changes, Count, &full);
+			free(data);
+			data = NULL;
+			free(*Changes);
+			*Changes = NULL;
+			*Count = 0;
+		}
+		if (error != ERR_NONE) {
+			smprintf(s, "Could not read database ID\n");
+		}
+	}
+
+	free(State->CC);
+	State->CC = cc;
+	return ERR_NONE;
+}
+
+/**
+ * Reads vCard or vCalendar of entry identified by LUID.
+ */
+static GSM_Error OBEXGEN_GetSyncEntry(GSM_StateMachine *s, const char *Store, const char *Extension, const char *LUID, char **data)
+{
+	char		*path;
+	GSM_Error	error;
+
+	path = (char *)malloc(strlen(Store) + strlen(LUID) + strlen(Extension) + 20);
+	if (path == NULL) {
+		return ERR_MOREMEMORY;
+	}
+	sprintf(path, "telecom/%s/luid/%s.%s", Store, LUID, Extension);
+	smprintf(s, "Getting changed entry %s\n", path);
+	error = OBEXGEN_GetTextFile(s, path, data);
+	free(path);
+	return error;
+}
+
+GSM_Error OBEXGEN_GetMemoryChanges(GSM_StateMachine *s, GSM_MemoryType type, const char *state_file, GSM_MemoryChangeCallback callback, void *user_data)
+{
+	GSM_Phone_OBEXGENData	*Priv = &s->Phone.Data.Priv.OBEXGEN;
+	GSM_Error		error;
+	IRMC_SyncState		State;
+	IRMC_Change		*Changes = NULL;
+	GSM_MemoryEntry		*Entry;
+	gboolean		Full;
+	char			*data = NULL;
+	size_t			pos;
+	int			Count = 0, i;
+
+	/* Only IrMC level 4 phones have change logs */
+	if (Priv->Service == OBEX_m_OBEX) {
+		return ERR_NOTIMPLEMENTED;
+	}
+	if (type != MEM_ME) {
+		return ERR_NOTSUPPORTED;
+	}
+
+	error = OBEXGEN_Connect(s, OBEX_IRMC);
+	if (error != ERR_NONE) return error;
+
+	if (Priv->PbCap.IEL == -1) {
+		error = OBEXGEN_GetPbInformation(s, NULL, NULL);
+		if (error != ERR_NONE) return error;
+	}
+	if (Priv->PbCap.IEL != 0x8 && Priv->PbCap.IEL != 0x10) {
+		return ERR_NOTIMPLEMENTED;
+	}
+
+	Entry = (GSM_MemoryEntry *)malloc(sizeof(GSM_MemoryEntry));
+	if (Entry == NULL) {
+		return ERR_MOREMEMORY;
+	}
+
+	OBEXGEN_LoadSyncState(s, state_file, "pb", &State);
+
+	error = OBEXGEN_ReadChanges(s, "pb", &State, &Changes, &Count, &Full);
+	if (error != ERR_NONE) goto done;
+
+	if (Full) {
+		smprintf(s, "Reading whole phonebook\n");
+		/* Listing cached by earlier calls might be outdated */
+		OBEXGEN_FreePbLUID(s);
+		error = OBEXGEN_InitPbLUID(s);
+		if (error != ERR_NONE) goto done;
+
+		/* Entries without LUID can not be tracked */
+		if (Priv->PbLUIDCount == Priv->PbCount) {
+			error = OBEXGEN_SetSyncLUID(&State, Priv->PbLUID, Priv->PbLUIDCount);
+		} else {
+			error = OBEXGEN_SetSyncLUID(&State, NULL, 0);
+			free(State.CC);
+			State.CC = NULL;
+		}
+		if (error != ERR_NONE) goto done;
+
+		error = callback(s, GSM_Change_Reset, NULL, user_data);
+		if (error != ERR_NONE) goto done;
+
+		for (i = 1; i <= Priv->PbCount; i++) {
+			Entry->MemoryType = MEM_ME;
+			Entry->Location = i;
+			pos = 0;
+			error = GSM_DecodeVCARD(&(s->di), Priv->PbData + Priv->PbOffsets[i], &pos, Entry, SonyEricsson_VCard21_Phone);
+			if (error != ERR_NONE) goto done;
+			error = callback(s, GSM_Change_Modified, Entry, user_data);
+			GSM_FreeMemoryEntry(Entry);
+			if (error != ERR_NONE) goto done;
+		}
+	} else {
+		smprintf(s, "Reading %d changed phonebook entries\n", Count);
+		for (i = 0; i < Count; i++) {
+			Entry->MemoryType = MEM_ME;
+			Entry->Location = Changes[i].Location;
+			Entry->EntriesNum = 0;
+			if (!Changes[i].Deleted) {
+				error = OBEXGEN_GetSyncEntry(s, "pb", "vcf", State.LUID[Changes[i].Location], &data);
+				if (error == ERR_NONE) {
+					pos = 0;
+					error = GSM_DecodeVCARD(&(s->di), data, &pos, Entry, SonyEricsson_VCard21_Phone);
+					free(data);
+					data = NULL;
+					if (error != ERR_NONE) goto done;
+				} else if (error == ERR_FILENOTEXIST) {
+					/* Deleted after reading change log */
+					Changes[i].Deleted = TRUE;
+				} else {
+					goto done;
+				}
+			}
+			if (Changes[i].Deleted) {
+				free(State.LUID[Changes[i].Location]);
+				State.LUID[Changes[i].Location] = NULL;
+				error = callback(s, GSM_Change_Deleted, Entry, user_data);
+			} else {
+				error = callback(s, GSM_Change_Modified, Entry, user_data);
+				GSM_FreeMemoryEntry(Entry);
+			}
+			if (error != ERR_NONE) goto done;
+		}
+	}
+
+	error = OBEXGEN_SaveSyncState(s, state_file, "pb", &State);
+done:
+	OBEXGEN_FreeSyncState(&State);
+	free(Changes);
+	free(Entry);
+	return error;
+}
+
+GSM_Error OBEXGEN_GetCalendarChanges(GSM_StateMachine *s, const char *state_file, GSM_CalendarChangeCallback callback, void *user_data)
+{
+	GSM_Phone_OBEXGENData	*Priv = &s->Phone.Data.Priv.OBEXGEN;
+	GSM_Error		error;
+	IRMC_SyncState		State;
+	IRMC_Change		*Changes = NULL;
+	GSM_CalendarEntry	*Entry;
+	GSM_ToDoEntry		*ToDo;
+	gboolean		Full;
+	char			*data = NULL;
+	size_t			pos;
+	int			Count = 0, i;
+
+	/* Only IrMC level 4 phones have change logs */
+	if (Priv->Service == OBEX_m_OBEX) {
+		return ERR_NOTIMPLEMENTED;
+	}
+
+	error = OBEXGEN_Connect(s, OBEX_IRMC);
+	if (error != ERR_NONE) return error;
+
+	if (Priv->CalCap.IEL == -1) {
+		error = OBEXGEN_GetCalInformation(s, NULL, NULL);
+		if (error != ERR_NONE) return error;
+	}
+	if (Priv->CalCap.IEL != 0x8 && Priv->CalCap.IEL != 0x10) {
+		return ERR_NOTIMPLEMENTED;
+	}
+
+	Entry = (GSM_CalendarEntry *)malloc(sizeof(GSM_CalendarEntry));
+	ToDo = (GSM_ToDoEntry *)malloc(sizeof(GSM_ToDoEntry));
+	if (Entry == NULL || ToDo == NULL) {
+		free(Entry);
+		free(ToDo);
+		return ERR_MOREMEMORY;
+	}
+
+	OBEXGEN_LoadSyncState(s, state_file, "cal", &State);
+
+	error = OBEXGEN_ReadChanges(s, "cal", &State, &Changes, &Count, &Full);
+	if (error != ERR_NONE) goto done;
+
+	if (Full) {
+		smprintf(s, "Reading whole calendar\n");
+		/* Listing cached by earlier calls might be outdated */
+		OBEXGEN_FreeCalLUID(s);
+		error = OBEXGEN_InitCalLUID(s);
+		if (error != ERR_NONE) goto done;
+
+		/* Entries without LUID can not be tracked */
+		if (Priv->CalLUIDCount == Priv->CalCount) {
+			error = OBEXGEN_SetSyncLUID(&State, Priv->CalLUID, Priv->CalLUIDCount);
+		} else {
+			error = OBEXGEN_SetSyncLUID(&State, NULL, 0);
+			free(State.CC);
+			State.CC = NULL;
+		}
+		if (error != ERR_NONE) goto done;
+
+		error = callback(s, GSM_Change_Reset, NULL, user_data);
+		if (error != ERR_NONE) goto done;
+
+		for (i = 1; i <= Priv->CalCount; i++) {
+			Entry->Location = i;
+			pos = 0;
+			error = GSM_DecodeVCALENDAR_VTODO(&(s->di), Priv->CalData + Priv->CalOffsets[i], &pos, Entry, ToDo, SonyEricsson_VCalendar, SonyEricsson_VToDo);
+			if (error != ERR_NONE) goto done;
+			error = callback(s, GSM_Change_Modified, Entry, user_data);
+			if (error != ERR_NONE) goto done;
+		}
+	} else {
+		smprintf(s, "Reading %d changed calendar entries\n", Count);
+		for (i = 0; i < Count; i++) {
+			Entry->Location = Changes[i].Location;
+			Entry->EntriesNum = 0;
+			if (!Changes[i].Deleted) {
+				error = OBEXGEN_GetSyncEntry(s, "cal", "vcs", State.LUID[Changes[i].Location], &data);
+				if (error == ERR_NONE) {
+					pos = 0;
+					error = GSM_DecodeVCALENDAR_VTODO(&(s->di), data, &pos, Entry, ToDo, SonyEricsson_VCalendar, SonyEricsson_VToDo);
+					free(data);
+					data = NULL;
+					if (error != ERR_NONE && error != ERR_EMPTY) goto done;
+					/* Calendar store contains todo entries as well */
+					if (Entry->EntriesNum == 0) {
+						smprintf(s, "Skipping entry which is not calendar event\n");
+						free(State.LUID[Changes[i].Location]);
+						State.LUID[Changes[i].Location] = NULL;
+						continue;
+					}
+				} else if (error == ERR_FILENOTEXIST) {
+					/* Deleted after reading change log */
+					Changes[i].Deleted = TRUE;
+				} else {
+					goto done;
+				}
+			}
+			if (Changes[i].Deleted) {
+				free(State.LUID[Changes[i].Location]);
+				State.LUID[Changes[i].Location] = NULL;
+				error = callback(s, GSM_Change_Deleted, Entry, user_data);
+			} else {
+				error = callback(s, GSM_Change_Modified, Entry, user_data);
+			}
+			if (error != ERR_NONE) goto done;
+		}
+	}
+
+	error = OBEXGEN_SaveSyncState(s, state_file, "cal", &State);
+done:
+	OBEXGEN_FreeSyncState(&State);
+	free(Changes);
+	free(Entry);
+	free(ToDo);
+	return error;
+}
+
+/*@}*/
+
 /**
  * \defgroup OBEXcap Phone information using OBEX capability XML or IrMC devinfo
  * \ingroup OBEXPhone
@@ -3701,6 +4533,7 @@ GSM_Reply_Function OBEXGENReplyFunctions[] = {
 	{OBEXGEN_ReplyConnect,		"\xA0",0x00,0x00,ID_Initialise			},
 	{OBEXGEN_ReplyAddFilePart,	"\xA0",0x00,0x00,ID_AddFile			},
 	{OBEXGEN_ReplyGetFilePart,	"\xA0",0x00,0x00,ID_GetFile			},
+	{OBEXGEN_ReplyAbort,		"\xA0",0x00,0x00,ID_AbortFile			},
 
 	/* FOLDER CREATED block */
 	{OBEXGEN_ReplyChangePath,	"\xA1",0x00,0x00,ID_SetPath			},
@@ -3709,6 +4542,7 @@ GSM_Reply_Function OBEXGENReplyFunctions[] = {
 	{OBEXGEN_ReplyConnect,		"\xC0",0x00,0x00,ID_Initialise			},
 	{OBEXGEN_ReplyGetFilePart,	"\xC0",0x00,0x00,ID_GetFile			},
 	{OBEXGEN_ReplyAddFilePart,	"\xC0",0x00,0x00,ID_AddFile			},
+	{OBEXGEN_ReplyAbort,		"\xC0",0x00,0x00,ID_AbortFile			},
 
 	/* Not allowed block */
 	{OBEXGEN_ReplyConnect,		"\xC1",0x00,0x00,ID_Initialise			},
@@ -3754,12 +4588,14 @@ GSM_Reply_Function OBEXGENReplyFunctions[] = {
 	{OBEXGEN_ReplyChangePath,	"\xD0",0x00,0x00,ID_SetPath			},
 	{OBEXGEN_ReplyGetFilePart,	"\xD0",0x00,0x00,ID_GetFile			},
 	{OBEXGEN_ReplyAddFilePart,	"\xD0",0x00,0x00,ID_AddFile			},
+	{OBEXGEN_ReplyAbort,		"\xD0",0x00,0x00,ID_AbortFile			},
 
 	/* Not implemented */
 	{OBEXGEN_ReplyConnect,		"\xD1",0x00,0x00,ID_Initialise			},
 	{OBEXGEN_ReplyChangePath,	"\xD1",0x00,0x00,ID_SetPath			},
 	{OBEXGEN_ReplyGetFilePart,	"\xD1",0x00,0x00,ID_GetFile			},
 	{OBEXGEN_ReplyAddFilePart,	"\xD1",0x00,0x00,ID_AddFile			},
+	{OBEXGEN_ReplyAbort,		"\xD1",0x00,0x00,ID_AbortFile			},
 
 	/* Service not available */
 	{OBEXGEN_ReplyConnect,		"\xD3",0x00,0x00,ID_Initialise			},
@@ -3922,7 +4758,12 @@ GSM_Phone_Functions OBEXGENPhone = {
 	NOTSUPPORTED,			/* 	GetGPRSAccessPoint	*/
 	NOTSUPPORTED,			/* 	SetGPRSAccessPoint	*/
 	NOTSUPPORTED,			/* 	GetScreenshot		*/
-	NOTSUPPORTED			/* 	SetPower		*/
+	NOTSUPPORTED,			/* 	SetPower		*/
+	NOTIMPLEMENTED,			/* 	GetAllSMS		*/
+	OBEXGEN_GetFileStream,
+	OBEXGEN_AddFileStream,
+	OBEXGEN_GetMemoryChanges,
+	OBEXGEN_GetCalendarChanges
 };
 
 #endif
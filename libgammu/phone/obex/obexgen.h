@@ -23,6 +23,9 @@
 #ifndef GSM_USED_BLUEOBEX
 #  define GSM_USED_BLUEOBEX
 #endif
+#ifndef GSM_USED_SOCKETOBEX
+#  define GSM_USED_SOCKETOBEX
+#endif
 
 /**
  * Service type we want to use on OBEX.
@@ -60,12 +63,75 @@ typedef struct {
 	gboolean HD;
 } IRMC_Capability;
 
+/**
+ * Synchronisation state of IrMC object store, it is kept between
+ * sessions in state file.
+ */
+typedef struct {
+	/**
+	 * Database ID reported by phone in change log.
+	 */
+	char *DID;
+	/**
+	 * Change counter at last synchronisation.
+	 */
+	char *CC;
+	/**
+	 * LUID - location translation map, indexed from 1.
+	 */
+	char **LUID;
+	/**
+	 * Number of entries in LUID list.
+	 */
+	int LUIDCount;
+} IRMC_SyncState;
+
+/**
+ * Change of entry in IrMC object store.
+ */
+typedef struct {
+	/**
+	 * Location of changed entry in LUID map.
+	 */
+	int Location;
+	/**
+	 * Whether entry was deleted.
+	 */
+	gboolean Deleted;
+} IRMC_Change;
+
 typedef struct {
 	int				FilesLocationsUsed;
 	int				FilesLocationsCurrent;
 	GSM_File			Files[500];
 	gboolean				FileLastPart;
+	/**
+	 * Callback receiving data of streamed file, NULL when file is
+	 * stored in GSM_File buffer.
+	 */
+	GSM_FileSink			FileSink;
+	/**
+	 * Callback providing data of streamed file, NULL when file is
+	 * taken from GSM_File buffer.
+	 */
+	GSM_FileSource			FileSource;
+	/**
+	 * User data for FileSink and FileSource.
+	 */
+	void				*FileStreamData;
+	/**
+	 * Set when FileSink or FileSource failed in the middle of
+	 * transfer, the operation then has to be aborted.
+	 */
+	gboolean			FileAbort;
+	/**
+	 * Size of file announced by phone in Length header.
+	 */
+	size_t				FileSize;
 
+	/**
+	 * Maximal size of packet negotiated with phone.
+	 */
 	int				FrameSize;
 	OBEX_Service			Service;
 	/**
@@ -294,6 +360,10 @@ typedef struct {
 GSM_Error OBEXGEN_GetBinaryFile(GSM_StateMachine *s, const char *FileName, unsigned char ** Buffer, size_t *len);
 GSM_Error OBEXGEN_GetTextFile(GSM_StateMachine *s, const char *FileName, char ** Buffer);
 GSM_Error OBEXGEN_SetFile(GSM_StateMachine *s, const char *FileName, const unsigned char *Buffer, size_t Length, gboolean HardDelete);
+GSM_Error OBEXGEN_ParseChangeLog(GSM_StateMachine *s, const char *data, IRMC_SyncState *State, IRMC_Change **Changes, int *Count, gboolean *Full);
+GSM_Error OBEXGEN_LoadSyncState(GSM_StateMachine *s, const char *FileName, const char *Store, IRMC_SyncState *State);
+GSM_Error OBEXGEN_SaveSyncState(GSM_StateMachine *s, const char *FileName, const char *Store, IRMC_SyncState *State);
+void OBEXGEN_FreeSyncState(IRMC_SyncState *State);
 
 #endif
 /*@}*/
@@ -196,13 +196,7 @@ static GSM_Error ALCABUS_StateMachine(GSM_StateMachine *s, unsigned char rx_char
 				smprintf(s, "0x%02x / 0x%04lX", d->Msg.Type, (long)d->Msg.Length);
 				DumpMessage(&s->di, d->Msg.Buffer, d->Msg.Length);
 			}
-			if (s->di.dl==DL_BINARY) {
-				smprintf(s,"%c",0x02);	/* Receiving */
-				smprintf(s,"%c",d->Msg.Type);
-				smprintf(s,"%c",(int)d->Msg.Length/256);
-				smprintf(s,"%c",(int)d->Msg.Length%256);
-				for (i=0;i<d->Msg.Length;i++) smprintf(s,"%c",d->Msg.Buffer[i]);
-			}
+			GSM_DumpMessageLevel3Recv(s, d->Msg.Buffer, d->Msg.Length, d->Msg.Type);
 			if (d->Msg.Type != ALCATEL_CONTROL) {
 				d->next_frame 	= ALCATEL_DATA;
 				d->busy 	= FALSE;
@@ -32,6 +32,11 @@ typedef struct {
 #    define GSM_USED_IRDADEVICE
 #  endif
 #endif
+#if defined(GSM_ENABLE_SOCKETAT)
+#  ifndef GSM_USED_SOCKETDEVICE
+#    define GSM_USED_SOCKETDEVICE
+#  endif
+#endif
 
 #endif
 
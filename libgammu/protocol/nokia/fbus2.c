@@ -16,7 +16,7 @@
 
 #include "../../gsmstate.h"
 
-#if defined(GSM_ENABLE_FBUS2) || defined(GSM_ENABLE_FBUS2IRDA) || defined(GSM_ENABLE_FBUS2DLR3) || defined(GSM_ENABLE_FBUS2BLUE) || defined(GSM_ENABLE_BLUEFBUS2) || defined(GSM_ENABLE_DKU5FBUS2) || defined(GSM_ENABLE_FBUS2PL2303)
+#if defined(GSM_ENABLE_FBUS2) || defined(GSM_ENABLE_FBUS2IRDA) || defined(GSM_ENABLE_FBUS2DLR3) || defined(GSM_ENABLE_FBUS2BLUE) || defined(GSM_ENABLE_BLUEFBUS2) || defined(GSM_ENABLE_DKU5FBUS2) || defined(GSM_ENABLE_FBUS2PL2303) || defined(GSM_ENABLE_SOCKETFBUS2)
 
 #include <stdio.h>
 #include <string.h>
@@ -281,6 +281,8 @@ static GSM_Error FBUS2_StateMachine(GSM_StateMachine *s, unsigned char rx_char)
 			case GCT_FBUS2PL2303:
 			case GCT_FBUS2BLUE:
 			case GCT_BLUEFBUS2:
+			case GCT_TCPFBUS2:
+			case GCT_UNIXFBUS2:
 				if (rx_char == FBUS2_FRAME_ID) correct = TRUE;
 				break;
 			case GCT_FBUS2IRDA:
@@ -449,6 +451,8 @@ static GSM_Error FBUS2_Initialise(GSM_StateMachine *s)
 		break;
 #endif
 	case GCT_FBUS2:
+	case GCT_TCPFBUS2:
+	case GCT_UNIXFBUS2:
 		error = Device->DeviceSetSpeed(s,115200);
 		if (error != ERR_NONE) return error;
 
@@ -43,6 +43,11 @@ typedef struct {
 #    define GSM_USED_BLUETOOTHDEVICE
 #  endif
 #endif
+#if defined(GSM_ENABLE_SOCKETFBUS2)
+#  ifndef GSM_USED_SOCKETDEVICE
+#    define GSM_USED_SOCKETDEVICE
+#  endif
+#endif
 
 #endif
 
@@ -132,7 +132,7 @@ static GSM_Error PHONET_StateMachine(GSM_StateMachine *s, unsigned char rx_char)
 
 static GSM_Error PHONET_Initialise(GSM_StateMachine *s)
 {
-	int 				total = 0, write_data=0;
+	int 				total = 0, write_data=0, read_data;
 	GSM_Protocol_PHONETData 	*d = &s->Protocol.Data.PHONET;
 	unsigned char			req[10]={0};
 
@@ -178,7 +178,11 @@ static GSM_Error PHONET_Initialise(GSM_StateMachine *s)
 		}
 
 		while (total < 7) {
-			total += s->Device.Functions->ReadDevice(s, req + total, sizeof(req) - total);
+			read_data = s->Device.Functions->ReadDevice(s, req + total, sizeof(req) - total);
+			if (read_data < 0) {
+				return ERR_DEVICENOTWORK;
+			}
+			total += read_data;
 		}
 		if (req[0] != d->frame_id) {
 			smprintf_level(s, D_ERROR, "Phonet_init: invalid frame id 0x%02x!\n", req[0]);
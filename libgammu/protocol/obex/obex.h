@@ -23,6 +23,11 @@ typedef struct {
 #    define GSM_USED_IRDADEVICE
 #  endif
 #endif
+#if defined(GSM_ENABLE_SOCKETOBEX)
+#  ifndef GSM_USED_SOCKETDEVICE
+#    define GSM_USED_SOCKETDEVICE
+#  endif
+#endif
 
 void OBEXAddBlock(char *Buffer, int *Pos, unsigned char ID, const char *AddData, int AddLength);
 
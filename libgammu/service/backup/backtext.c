@@ -34,6 +34,7 @@ GSM_Error FindBackupChecksum(const char *FileName, gboolean UseUnicode, char *ch
 	INI_Entry		*e;
 	char			*buffer = NULL,buff[100]={0};
 	int			len=0;
+	GSM_UnicodeView		text;
 	GSM_Error		error;
 
 	error = INI_ReadFile(FileName, UseUnicode, &file_info);
@@ -46,17 +47,17 @@ GSM_Error FindBackupChecksum(const char *FileName, gboolean UseUnicode, char *ch
 			EncodeUnicode(buff,"Checksum",8);
 			if (mywstrncasecmp(buff, h->SectionName, 8)) continue;
 
-			buffer = (unsigned char *)realloc(buffer,len+UnicodeLength(h->SectionName)*2+2);
-			CopyUnicodeString(buffer+len,h->SectionName);
-			len+=UnicodeLength(h->SectionName)*2;
+			text = UnicodeView(h->SectionName);
+			buffer = (unsigned char *)realloc(buffer,len+text.Length*2+2);
+			len+=UnicodeViewCopy(buffer+len,&text)*2;
 
 		        for (e = h->SubEntries; e != NULL; e = e->Next) {
-				buffer = (unsigned char *)realloc(buffer,len+UnicodeLength(e->EntryName)*2+2);
-				CopyUnicodeString(buffer+len,e->EntryName);
-				len+=UnicodeLength(e->EntryName)*2;
-				buffer = (unsigned char *)realloc(buffer,len+UnicodeLength(e->EntryValue)*2+2);
-				CopyUnicodeString(buffer+len,e->EntryValue);
-				len+=UnicodeLength(e->EntryValue)*2;
+				text = UnicodeView(e->EntryName);
+				buffer = (unsigned char *)realloc(buffer,len+text.Length*2+2);
+				len+=UnicodeViewCopy(buffer+len,&text)*2;
+				text = UnicodeView(e->EntryValue);
+				buffer = (unsigned char *)realloc(buffer,len+text.Length*2+2);
+				len+=UnicodeViewCopy(buffer+len,&text)*2;
 			}
 		}
 	} else {
@@ -232,6 +233,7 @@ static GSM_Error SaveBackupBase64(FILE *file, char *myname, unsigned char *data,
 static gboolean ReadBackupTextLen(INI_Section *file_info, const char *section, const char *myname, char *myvalue, const size_t maxlen, const gboolean UseUnicode)
 {
 	unsigned char paramname[10000],*readvalue, decodedvalue[10000];
+	size_t len;
 	gboolean ret = TRUE;
 
 	if (UseUnicode) {
@@ -245,9 +247,12 @@ static gboolean ReadBackupTextLen(INI_Section *file_info, const char *section, c
 				dbgprintf(NULL, "String too long!\n");
 				ret = FALSE;
 			}
-			CopyUnicodeString(myvalue, decodedvalue);
-			myvalue[UnicodeLength(myvalue)*2-2]=0;
-			myvalue[UnicodeLength(myvalue)*2-1]=0;
+			/* Strip trailing quote */
+			len = CopyUnicodeStringLen(myvalue, decodedvalue);
+			if (len > 0) {
+				myvalue[len*2-2]=0;
+				myvalue[len*2-1]=0;
+			}
 
 			dbgprintf(NULL, "Cfg read: %s\n",DecodeUnicodeString(readvalue));
 		} else {
@@ -1684,6 +1684,7 @@ GSM_Error GSM_DecodeVCALENDAR_VTODO(GSM_Debug_Info *di, char *Buffer, size_t *Po
 	gboolean		is_date_only;
 	gboolean		date_only = FALSE;
 	int		lBuffer;
+	size_t		MaxLen = GSM_LINE_UNBOUNDED;
  	int 		Time=-1;
 	char		*rrule = NULL;
 
@@ -1691,16 +1692,18 @@ GSM_Error GSM_DecodeVCALENDAR_VTODO(GSM_Debug_Info *di, char *Buffer, size_t *Po
 
 	Calendar->EntriesNum 	= 0;
 	ToDo->EntriesNum 	= 0;
-	lBuffer = strlen(Buffer);
 	trigger.Timezone = -999 * 3600;
 
+	/* Buffer is NUL terminated, it is not measured unless it is rewritten */
 	if (CalVer == Mozilla_iCalendar && *Pos ==0) {
+		lBuffer = strlen(Buffer);
 		error = GSM_Make_VCAL_Lines (Buffer, &lBuffer);
 		if (error != ERR_NONE) return error;
+		MaxLen = lBuffer;
 	}
 
 	while (1) {
-		error = MyGetLine(Buffer, Pos, Line, lBuffer, sizeof(Line), TRUE);
+		error = MyGetLine(Buffer, Pos, Line, MaxLen, sizeof(Line), TRUE);
 		if (error != ERR_NONE) return error;
 		if (strlen(Line) == 0) break;
 
@@ -1790,7 +1793,7 @@ GSM_Error GSM_DecodeVCALENDAR_VTODO(GSM_Debug_Info *di, char *Buffer, size_t *Po
 			}
 
 			if (strstr(Line,"BEGIN:VALARM")) {
-				error = MyGetLine(Buffer, Pos, Line, lBuffer, sizeof(Line), TRUE);
+				error = MyGetLine(Buffer, Pos, Line, MaxLen, sizeof(Line), TRUE);
 				if (error != ERR_NONE) return error;
 				if (strlen(Line) == 0) break;
 				if (ReadVCALText(Line, "TRIGGER;VALUE=DURATION", Buff, CalVer == Mozilla_iCalendar, NULL)) {
@@ -2030,7 +2033,7 @@ GSM_Error GSM_DecodeVNOTE(char *Buffer, size_t *Pos, GSM_NoteEntry *Note)
 	Note->Text[1] = 0;
 
 	while (1) {
-		error = MyGetLine(Buffer, Pos, Line, strlen(Buffer), sizeof(Line), TRUE);
+		error = MyGetLine(Buffer, Pos, Line, GSM_LINE_UNBOUNDED, sizeof(Line), TRUE);
 		if (error != ERR_NONE) return error;
 		if (strlen(Line) == 0) break;
 		switch (Level) {
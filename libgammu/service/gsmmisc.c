@@ -372,11 +372,11 @@ GSM_Error VC_StoreText(char *Buffer, const size_t buff_len, size_t *Pos, const u
 	if (buffer == NULL) return ERR_MOREMEMORY;
 
 	if (UTF8) {
-		EncodeUTF8(buffer, Text);
+		EncodeUTF8Len(buffer, Text, len);
 		error =  VC_StoreLine(Buffer, buff_len, Pos, "%s:%s", Start, buffer);
 	} else {
 		EncodeUTF8QuotedPrintable(buffer,Text);
-		if (UnicodeLength(Text) == strlen(buffer)) {
+		if (len == strlen(buffer)) {
 			/* Text is plain ASCII */
 			error =  VC_StoreLine(Buffer, buff_len, Pos, "%s:%s", Start, buffer);
 		} else {
@@ -481,6 +481,14 @@ gboolean ReadVCALText(char *Buffer, const char *Start, unsigned char *Value, con
 	Value[0] = 0x00;
 	Value[1] = 0x00;
 
+	/*
+	 * Decoders try each known property on every line, so reject other
+	 * properties before allocating anything.
+	 */
+	if (strncasecmp(Buffer, Start, strcspn(Start, ";")) != 0) {
+		return FALSE;
+	}
+
 	/* Count number of tokens */
 	len = strlen(Start);
 	numtokens = 1;
@@ -59,8 +59,7 @@ unsigned char *GSM_PhonebookGetEntryName (const GSM_MemoryEntry *entry)
 		CopyUnicodeString(dest, entry->Entries[name].Text);
 	} else {
 		if (last != -1 && first != -1) {
-			len = UnicodeLength(entry->Entries[last].Text);
-			CopyUnicodeString(dest, entry->Entries[last].Text);
+			len = CopyUnicodeStringLen(dest, entry->Entries[last].Text);
 			CopyUnicodeString(dest + 2*len, split);
 			CopyUnicodeString(dest + 2*len + 4, entry->Entries[first].Text);
 		} else if (last != -1) {
@@ -493,22 +492,19 @@ GSM_Error GSM_EncodeVCARD(GSM_Debug_Info *di, char *Buffer, const size_t buff_le
 		if (firstname != -1 || secondname != -1 || lastname != -1) {
 			pos = 0;
 			if (lastname != -1) {
-				CopyUnicodeString(buffer + 2*pos, pbk->Entries[lastname].Text);
-				pos += UnicodeLength(pbk->Entries[lastname].Text);
+				pos += CopyUnicodeStringLen(buffer + 2*pos, pbk->Entries[lastname].Text);
 			}
 			buffer[2*pos] = 0;
 			buffer[2*pos + 1] = ';';
 			pos++;
 			if (firstname != -1) {
-				CopyUnicodeString(buffer + 2*pos, pbk->Entries[firstname].Text);
-				pos += UnicodeLength(pbk->Entries[firstname].Text);
+				pos += CopyUnicodeStringLen(buffer + 2*pos, pbk->Entries[firstname].Text);
 			}
 			if (secondname != -1) {
 				buffer[2*pos] = 0;
 				buffer[2*pos + 1] = ' ';
 				pos++;
-				CopyUnicodeString(buffer + 2*pos, pbk->Entries[secondname].Text);
-				pos += UnicodeLength(pbk->Entries[secondname].Text);
+				pos += CopyUnicodeStringLen(buffer + 2*pos, pbk->Entries[secondname].Text);
 			}
 			buffer[2*pos] = 0;
 			buffer[2*pos + 1] = 0;
@@ -525,36 +521,31 @@ GSM_Error GSM_EncodeVCARD(GSM_Debug_Info *di, char *Buffer, const size_t buff_le
 			buffer[2*pos + 1] = ';';
 			pos++;
 			if (workaddress != -1) {
-				CopyUnicodeString(buffer + 2*pos, pbk->Entries[workaddress].Text);
-				pos += UnicodeLength(pbk->Entries[workaddress].Text);
+				pos += CopyUnicodeStringLen(buffer + 2*pos, pbk->Entries[workaddress].Text);
 			}
 			buffer[2*pos] = 0;
 			buffer[2*pos + 1] = ';';
 			pos++;
 			if (workcity != -1) {
-				CopyUnicodeString(buffer + 2*pos, pbk->Entries[workcity].Text);
-				pos += UnicodeLength(pbk->Entries[workcity].Text);
+				pos += CopyUnicodeStringLen(buffer + 2*pos, pbk->Entries[workcity].Text);
 			}
 			buffer[2*pos] = 0;
 			buffer[2*pos + 1] = ';';
 			pos++;
 			if (workstate != -1) {
-				CopyUnicodeString(buffer + 2*pos, pbk->Entries[workstate].Text);
-				pos += UnicodeLength(pbk->Entries[workstate].Text);
+				pos += CopyUnicodeStringLen(buffer + 2*pos, pbk->Entries[workstate].Text);
 			}
 			buffer[2*pos] = 0;
 			buffer[2*pos + 1] = ';';
 			pos++;
 			if (workzip != -1) {
-				CopyUnicodeString(buffer + 2*pos, pbk->Entries[workzip].Text);
-				pos += UnicodeLength(pbk->Entries[workzip].Text);
+				pos += CopyUnicodeStringLen(buffer + 2*pos, pbk->Entries[workzip].Text);
 			}
 			buffer[2*pos] = 0;
 			buffer[2*pos + 1] = ';';
 			pos++;
 			if (workcountry != -1) {
-				CopyUnicodeString(buffer + 2*pos, pbk->Entries[workcountry].Text);
-				pos += UnicodeLength(pbk->Entries[workcountry].Text);
+				pos += CopyUnicodeStringLen(buffer + 2*pos, pbk->Entries[workcountry].Text);
 			}
 			buffer[2*pos] = 0;
 			buffer[2*pos + 1] = 0;
@@ -571,36 +562,31 @@ GSM_Error GSM_EncodeVCARD(GSM_Debug_Info *di, char *Buffer, const size_t buff_le
 			buffer[2*pos + 1] = ';';
 			pos++;
 			if (address != -1) {
-				CopyUnicodeString(buffer + 2*pos, pbk->Entries[address].Text);
-				pos += UnicodeLength(pbk->Entries[address].Text);
+				pos += CopyUnicodeStringLen(buffer + 2*pos, pbk->Entries[address].Text);
 			}
 			buffer[2*pos] = 0;
 			buffer[2*pos + 1] = ';';
 			pos++;
 			if (city != -1) {
-				CopyUnicodeString(buffer + 2*pos, pbk->Entries[city].Text);
-				pos += UnicodeLength(pbk->Entries[city].Text);
+				pos += CopyUnicodeStringLen(buffer + 2*pos, pbk->Entries[city].Text);
 			}
 			buffer[2*pos] = 0;
 			buffer[2*pos + 1] = ';';
 			pos++;
 			if (state != -1) {
-				CopyUnicodeString(buffer + 2*pos, pbk->Entries[state].Text);
-				pos += UnicodeLength(pbk->Entries[state].Text);
+				pos += CopyUnicodeStringLen(buffer + 2*pos, pbk->Entries[state].Text);
 			}
 			buffer[2*pos] = 0;
 			buffer[2*pos + 1] = ';';
 			pos++;
 			if (zip != -1) {
-				CopyUnicodeString(buffer + 2*pos, pbk->Entries[zip].Text);
-				pos += UnicodeLength(pbk->Entries[zip].Text);
+				pos += CopyUnicodeStringLen(buffer + 2*pos, pbk->Entries[zip].Text);
 			}
 			buffer[2*pos] = 0;
 			buffer[2*pos + 1] = ';';
 			pos++;
 			if (country != -1) {
-				CopyUnicodeString(buffer + 2*pos, pbk->Entries[country].Text);
-				pos += UnicodeLength(pbk->Entries[country].Text);
+				pos += CopyUnicodeStringLen(buffer + 2*pos, pbk->Entries[country].Text);
 			}
 			buffer[2*pos] = 0;
 			buffer[2*pos + 1] = 0;
@@ -683,6 +669,7 @@ GSM_Error GSM_DecodeVCARD(GSM_Debug_Info *di, char *Buffer, size_t *Pos, GSM_Mem
 	int		version = 1;
 	GSM_Error	error;
 	char	*Line = NULL;
+	size_t	LineSize = 0;
 	GSM_EntryLocation location;
 
 	Buff[0]	 = 0;
@@ -693,9 +680,8 @@ GSM_Error GSM_DecodeVCARD(GSM_Debug_Info *di, char *Buffer, size_t *Pos, GSM_Mem
 	}
 
 	while (1) {
-		free(Line);
-		Line = NULL;
-		error = GSM_GetVCSLine(&Line, Buffer, Pos, strlen(Buffer), TRUE);
+		/* Line buffer is reused, no need to know length of data */
+		error = GSM_GetVCSLine(&Line, &LineSize, Buffer, Pos, GSM_LINE_UNBOUNDED, TRUE);
 		if (error != ERR_NONE) goto vcard_done;
 		if (strlen(Line) == 0) break;
 		switch (Level) {
@@ -759,8 +745,10 @@ GSM_Error GSM_DecodeVCARD(GSM_Debug_Info *di, char *Buffer, size_t *Pos, GSM_Mem
 
 				/* We allocate here more memory than is actually required */
 				Pbk->Entries[Pbk->EntriesNum].Picture.Buffer = (unsigned char *)malloc(strlen(s));
-				if (Pbk->Entries[Pbk->EntriesNum].Picture.Buffer == NULL)
-					return ERR_MOREMEMORY;
+				if (Pbk->Entries[Pbk->EntriesNum].Picture.Buffer == NULL) {
+					error = ERR_MOREMEMORY;
+					goto vcard_done;
+				}
 
 				Pbk->Entries[Pbk->EntriesNum].Picture.Length =
 					DecodeBASE64(s, Pbk->Entries[Pbk->EntriesNum].Picture.Buffer, strlen(s));
@@ -821,6 +821,11 @@ gboolean GSM_DecodeEMSMultiPartSMS(GSM_Debug_Info *di,
 			case 0x17:
 				smfprintf(di, "UDH part - Object Distribution Indicator (Media Rights Protecting) ignored now\n");
 				break;
+			case 0x24:
+			case 0x25:
+				/* Already handled when decoding text */
+				smfprintf(di, "UDH part - national language shift\n");
+				break;
 			default:
 				smfprintf(di, "UDH part - unknown block %02x\n",SMS->SMS[i].UDH.Text[w]);
 				Info->Unknown = TRUE;
@@ -78,7 +78,7 @@ GSM_Error GSM_AddSMS_Text_UDH(GSM_Debug_Info *di,
 		      		size_t			*CopiedText,
 		      		size_t			*CopiedSMSText)
 {
-	size_t FreeText,FreeBytes,Copy,i,j;
+	size_t FreeText,FreeBytes,Copy,i,j,Used;
 
 	smfprintf(di, "Checking used: ");
 	GSM_Find_Free_Used_SMS2(di, Coding,SMS->SMS[SMS->Number], UsedText, &FreeText, &FreeBytes);
@@ -117,17 +117,19 @@ GSM_Error GSM_AddSMS_Text_UDH(GSM_Debug_Info *di,
 		case SMS_Coding_Default_No_Compression:
 			FindDefaultAlphabetLen(Buffer,&i,&j,FreeText);
 			smfprintf(di, "Defalt text, length %ld %ld\n", (long)i, (long)j);
-			SMS->SMS[SMS->Number].Text[UnicodeLength(SMS->SMS[SMS->Number].Text)*2+i*2]   = 0;
-			SMS->SMS[SMS->Number].Text[UnicodeLength(SMS->SMS[SMS->Number].Text)*2+i*2+1] = 0;
-			memcpy(SMS->SMS[SMS->Number].Text+UnicodeLength(SMS->SMS[SMS->Number].Text)*2,Buffer,i*2);
+			Used = UnicodeLength(SMS->SMS[SMS->Number].Text);
+			SMS->SMS[SMS->Number].Text[Used*2+i*2]   = 0;
+			SMS->SMS[SMS->Number].Text[Used*2+i*2+1] = 0;
+			memcpy(SMS->SMS[SMS->Number].Text+Used*2,Buffer,i*2);
 			*CopiedText 	= i;
 			*CopiedSMSText 	= j;
 			SMS->SMS[SMS->Number].Length += i;
 			break;
 		case SMS_Coding_Unicode_No_Compression:
-			SMS->SMS[SMS->Number].Text[UnicodeLength(SMS->SMS[SMS->Number].Text)*2+Copy*2]   = 0;
-			SMS->SMS[SMS->Number].Text[UnicodeLength(SMS->SMS[SMS->Number].Text)*2+Copy*2+1] = 0;
-			memcpy(SMS->SMS[SMS->Number].Text+UnicodeLength(SMS->SMS[SMS->Number].Text)*2,Buffer,Copy*2);
+			Used = UnicodeLength(SMS->SMS[SMS->Number].Text);
+			SMS->SMS[SMS->Number].Text[Used*2+Copy*2]   = 0;
+			SMS->SMS[SMS->Number].Text[Used*2+Copy*2+1] = 0;
+			memcpy(SMS->SMS[SMS->Number].Text+Used*2,Buffer,Copy*2);
 			*CopiedText = *CopiedSMSText = Copy;
 			SMS->SMS[SMS->Number].Length += Copy;
 			break;
@@ -197,6 +199,339 @@ void GSM_MakeMultiPartSMS(GSM_Debug_Info *di, GSM_MultiSMSMessage	*SMS,
 	if (SMS->Number == 1) SMS->SMS[0].ReplaceMessage = ReplaceMessage;
 }
 
+/**
+ * Starts new message at given position of text.
+ */
+static void GSM_SplitNewPart(GSM_SMSSplitInfo *Info, size_t pos)
+{
+	Info->Parts++;
+	if (Info->Parts <= GSM_MAX_MULTI_SMS) {
+		Info->Start[Info->Parts - 1] = pos;
+		Info->Used[Info->Parts - 1] = 0;
+	} else if (Info->Parts == GSM_MAX_MULTI_SMS + 1) {
+		Info->Start[GSM_MAX_MULTI_SMS] = pos;
+	}
+	Info->CharsLeft = Info->Capacity;
+}
+
+/**
+ * Prepares same UDH as GSM_MakeMultiPartSMS puts in each part.
+ */
+static void GSM_SplitSMSUDH(GSM_Debug_Info *di, GSM_UDH UDHType, GSM_UDHHeader *UDH)
+{
+	UDH->Type	= UDHType;
+	UDH->Text[0]	= 0;
+	UDH->ID8bit	= 0;
+	UDH->ID16bit	= 0;
+	UDH->PartNumber	= -1;
+	UDH->AllParts	= 0;
+	GSM_EncodeUDHHeader(di, UDH);
+}
+
+/**
+ * Splits text using given UDH and coding.
+ *
+ * \param Strict Whether to fail when char can not be stored in default
+ * alphabet, otherwise it is counted as replacement char.
+ *
+ * \return FALSE if text can not be stored and Strict is set.
+ */
+static gboolean GSM_SplitSMSTextWith(const unsigned char *Text, size_t Length,
+	const GSM_UDHHeader *BaseUDH, GSM_Coding_Type Coding,
+	GSM_NationalLanguage LockingShift, GSM_NationalLanguage SingleShift,
+	gboolean Strict, GSM_SMSSplitInfo *Info)
+{
+	GSM_UDHHeader	UDH = *BaseUDH;
+	size_t		i, size, free_bytes;
+
+	if (GSM_EncodeUDHNationalLanguage(&UDH, LockingShift, SingleShift) != ERR_NONE) {
+		/* No room to say which tables are used */
+		return FALSE;
+	}
+	Info->UDHLength = UDH.Length;
+	Info->LockingShift = LockingShift;
+	Info->SingleShift = SingleShift;
+	free_bytes = GSM_MAX_8BIT_SMS_LENGTH - UDH.Length;
+
+	Info->Coding = Coding;
+	Info->Parts = 0;
+	switch (Coding) {
+		case SMS_Coding_Default_No_Compression:
+			Info->Capacity = free_bytes * 8 / 7;
+			break;
+		case SMS_Coding_Unicode_No_Compression:
+			Info->Capacity = free_bytes / 2;
+			break;
+		default:
+			Info->Capacity = free_bytes;
+			break;
+	}
+	GSM_SplitNewPart(Info, 0);
+
+	for (i = 0; i < Length; i++) {
+		size = 1;
+		if (Coding == SMS_Coding_Default_No_Compression) {
+			size = GSM_NationalAlphabetSeptets(Text[i * 2], Text[i * 2 + 1], LockingShift, SingleShift);
+			if (size == 0) {
+				if (Strict) {
+					return FALSE;
+				}
+				/* It will be replaced by single char */
+				size = 1;
+			}
+		}
+		if (size > Info->CharsLeft) {
+			GSM_SplitNewPart(Info, i);
+		}
+		Info->CharsLeft -= size;
+		if (Info->Parts <= GSM_MAX_MULTI_SMS) {
+			Info->Used[Info->Parts - 1] += size;
+		}
+	}
+	if (Info->Parts <= GSM_MAX_MULTI_SMS) {
+		Info->Start[Info->Parts] = Length;
+	}
+	return TRUE;
+}
+
+/**
+ * National language tables tried for text which does not fit into
+ * default alphabet, pairs of locking and single shift language.
+ */
+static const GSM_NationalLanguage GSM_NationalLanguageCandidates[][2] = {
+	{SMS_Language_Default, SMS_Language_Turkish},
+	{SMS_Language_Default, SMS_Language_Spanish},
+	{SMS_Language_Default, SMS_Language_Portuguese},
+	{SMS_Language_Turkish, SMS_Language_Default},
+	{SMS_Language_Turkish, SMS_Language_Turkish},
+	{SMS_Language_Portuguese, SMS_Language_Default},
+	{SMS_Language_Portuguese, SMS_Language_Portuguese},
+};
+
+/**
+ * Finds national language tables which can store the text in least
+ * messages.
+ *
+ * \return TRUE if some tables can store the text, Info then holds the
+ * split.
+ */
+static gboolean GSM_SplitSMSTextNational(const unsigned char *Text, size_t Length,
+	const GSM_UDHHeader *UDH, GSM_SMSSplitInfo *Info)
+{
+	GSM_SMSSplitInfo	current;
+	gboolean		found = FALSE;
+	size_t			i;
+
+	for (i = 0; i < sizeof(GSM_NationalLanguageCandidates) / sizeof(GSM_NationalLanguageCandidates[0]); i++) {
+		if (!GSM_SplitSMSTextWith(Text, Length, UDH, SMS_Coding_Default_No_Compression,
+				GSM_NationalLanguageCandidates[i][0],
+				GSM_NationalLanguageCandidates[i][1],
+				TRUE, &current)) {
+			continue;
+		}
+		if (!found || current.Parts < Info->Parts ||
+		    (current.Parts == Info->Parts && current.CharsLeft > Info->CharsLeft)) {
+			*Info = current;
+			found = TRUE;
+		}
+	}
+	return found;
+}
+
+GSM_Error GSM_SplitSMSText(GSM_Debug_Info *di, const unsigned char *Text,
+	size_t Length, GSM_UDH UDHType, GSM_Coding_Type Coding,
+	GSM_SMSSplitInfo *Info)
+{
+	GSM_UDHHeader	UDH;
+	GSM_SMSSplitInfo	national;
+
+	GSM_SplitSMSUDH(di, UDHType, &UDH);
+
+	if (Coding != 0 &&
+	    Coding != SMS_Coding_Default_No_Compression &&
+	    Coding != SMS_Coding_Unicode_No_Compression &&
+	    Coding != SMS_Coding_8bit) {
+		return ERR_NOTSUPPORTED;
+	}
+
+	if (Coding != 0) {
+		GSM_SplitSMSTextWith(Text, Length, &UDH, Coding,
+			SMS_Language_Default, SMS_Language_Default, FALSE, Info);
+	} else if (!GSM_SplitSMSTextWith(Text, Length, &UDH, SMS_Coding_Default_No_Compression,
+			SMS_Language_Default, SMS_Language_Default, TRUE, Info)) {
+		/* Char can not be stored, national tables have to be better than Unicode */
+		GSM_SplitSMSTextWith(Text, Length, &UDH, SMS_Coding_Unicode_No_Compression,
+			SMS_Language_Default, SMS_Language_Default, FALSE, Info);
+		if (GSM_SplitSMSTextNational(Text, Length, &UDH, &national) &&
+		    national.Parts < Info->Parts) {
+			*Info = national;
+		}
+	}
+
+	smfprintf(di, "Text of %ld chars needs %d messages, %ld chars left\n",
+		(long)Length, Info->Parts, (long)Info->CharsLeft);
+	return ERR_NONE;
+}
+
+GSM_Error GSM_EncodeSplitSMS(GSM_Debug_Info *di, const unsigned char *Text,
+	const GSM_SMSSplitInfo *Info, GSM_UDH UDHType, int Class,
+	GSM_SMSPartCallback Callback, void *user_data)
+{
+	GSM_SMSMessage	SMS;
+	GSM_DateTime	Date;
+	GSM_Error	error;
+	unsigned char	UDHID;
+	size_t		len;
+	int		i;
+
+	if (Info->Parts > GSM_MAX_MULTI_SMS) {
+		return ERR_MOREMEMORY;
+	}
+
+	UDHID = GSM_MakeSMSIDFromTime();
+	GSM_GetCurrentDateTime (&Date);
+	for (i = 0; i < Info->Parts; i++) {
+		GSM_SetDefaultSMSData(&SMS);
+		SMS.Class		= Class;
+		SMS.Coding		= Info->Coding;
+		SMS.UDH.Type		= UDHType;
+		SMS.UDH.ID8bit		= UDHID;
+		SMS.UDH.ID16bit		= UDHID + 256 * Date.Hour;
+		SMS.UDH.PartNumber	= i + 1;
+		SMS.UDH.AllParts	= Info->Parts;
+		GSM_EncodeUDHHeader(di, &SMS.UDH);
+		error = GSM_EncodeUDHNationalLanguage(&SMS.UDH, Info->LockingShift, Info->SingleShift);
+		if (error != ERR_NONE) {
+			return error;
+		}
+
+		len = Info->Start[i + 1] - Info->Start[i];
+		if (Info->Coding == SMS_Coding_8bit) {
+			memcpy(SMS.Text, Text + Info->Start[i], len);
+		} else {
+			memcpy(SMS.Text, Text + Info->Start[i] * 2, len * 2);
+			SMS.Text[len * 2] = 0;
+			SMS.Text[len * 2 + 1] = 0;
+		}
+		SMS.Length = len;
+
+		error = Callback(&SMS, user_data);
+		if (error != ERR_NONE) {
+			return error;
+		}
+	}
+	return ERR_NONE;
+}
+
+/**
+ * Stores message passed by GSM_EncodeSplitSMS into GSM_MultiSMSMessage.
+ */
+static GSM_Error GSM_AddSplitSMS(GSM_SMSMessage *SMS, void *user_data)
+{
+	GSM_MultiSMSMessage *MultiSMS = (GSM_MultiSMSMessage *)user_data;
+
+	MultiSMS->SMS[MultiSMS->Number++] = *SMS;
+	return ERR_NONE;
+}
+
+/**
+ * Encodes text which can not be stored in default alphabet using
+ * national language tables, but only if it needs less messages than
+ * Unicode.
+ *
+ * \return TRUE if message was encoded.
+ */
+static gboolean GSM_EncodeNationalMultiPartSMS(GSM_Debug_Info *di,
+	GSM_MultiPartSMSInfo *Info, GSM_MultiSMSMessage *SMS)
+{
+	GSM_SMSSplitInfo	national, unicode;
+	GSM_UDHHeader		UDH;
+	GSM_UDH			UDHType = UDH_NoUDH, LongUDH = UDH_ConcatenatedMessages;
+	const unsigned char	*Text = Info->Entries[0].Buffer;
+	size_t			Length = UnicodeLength(Text);
+
+	if (Info->Entries[0].ID == SMS_ConcatenatedAutoTextLong16bit) {
+		LongUDH = UDH_ConcatenatedMessages16bit;
+	}
+
+	/* Short text takes one message in Unicode anyway */
+	GSM_SplitSMSText(di, Text, Length, UDH_NoUDH, SMS_Coding_Unicode_No_Compression, &unicode);
+	if (unicode.Parts == 1) {
+		return FALSE;
+	}
+	GSM_SplitSMSText(di, Text, Length, LongUDH, SMS_Coding_Unicode_No_Compression, &unicode);
+
+	GSM_SplitSMSUDH(di, UDH_NoUDH, &UDH);
+	if (!GSM_SplitSMSTextNational(Text, Length, &UDH, &national)) {
+		return FALSE;
+	}
+	if (national.Parts > 1) {
+		UDHType = LongUDH;
+		GSM_SplitSMSUDH(di, UDHType, &UDH);
+		GSM_SplitSMSTextNational(Text, Length, &UDH, &national);
+	}
+	if (national.Parts >= unicode.Parts || national.Parts > GSM_MAX_MULTI_SMS) {
+		return FALSE;
+	}
+	smfprintf(di, "Using national language tables %d/%d, %d messages instead of %d\n",
+		national.LockingShift, national.SingleShift, national.Parts, unicode.Parts);
+
+	SMS->Number = 0;
+	if (GSM_EncodeSplitSMS(di, Text, &national, UDHType, Info->Class, GSM_AddSplitSMS, SMS) != ERR_NONE) {
+		SMS->Number = 0;
+		return FALSE;
+	}
+	if (SMS->Number == 1) {
+		SMS->SMS[0].ReplaceMessage = Info->ReplaceMessage;
+	}
+	return TRUE;
+}
+
+/**
+ * Encodes text using national language tables given in Info, chars
+ * which are not in the tables are replaced.
+ */
+static GSM_Error GSM_EncodeNationalTextSMS(GSM_Debug_Info *di,
+	GSM_MultiPartSMSInfo *Info, const unsigned char *Text, GSM_MultiSMSMessage *SMS)
+{
+	GSM_SMSSplitInfo	split;
+	GSM_UDHHeader		UDH;
+	GSM_UDH			UDHType = UDH_NoUDH;
+	size_t			Length = UnicodeLength(Text);
+	GSM_Error		error;
+
+	GSM_SplitSMSUDH(di, UDH_NoUDH, &UDH);
+	if (!GSM_SplitSMSTextWith(Text, Length, &UDH, SMS_Coding_Default_No_Compression,
+			Info->LockingShift, Info->SingleShift, FALSE, &split)) {
+		return ERR_MOREMEMORY;
+	}
+	if (split.Parts > 1) {
+		UDHType = UDH_ConcatenatedMessages;
+		if (Info->Entries[0].ID == SMS_ConcatenatedTextLong16bit) {
+			UDHType = UDH_ConcatenatedMessages16bit;
+		}
+		GSM_SplitSMSUDH(di, UDHType, &UDH);
+		if (!GSM_SplitSMSTextWith(Text, Length, &UDH, SMS_Coding_Default_No_Compression,
+				Info->LockingShift, Info->SingleShift, FALSE, &split)) {
+			return ERR_MOREMEMORY;
+		}
+	}
+	if (split.Parts > GSM_MAX_MULTI_SMS) {
+		return ERR_MOREMEMORY;
+	}
+
+	SMS->Number = 0;
+	error = GSM_EncodeSplitSMS(di, Text, &split, UDHType, Info->Class, GSM_AddSplitSMS, SMS);
+	if (error != ERR_NONE) {
+		SMS->Number = 0;
+		return error;
+	}
+	if (SMS->Number == 1) {
+		SMS->SMS[0].ReplaceMessage = Info->ReplaceMessage;
+	}
+	return ERR_NONE;
+}
+
 /* Calculates number of SMS and number of left chars in SMS */
 void GSM_SMSCounter(GSM_Debug_Info *di,
 		    unsigned char 	*MessageBuffer,
@@ -206,12 +541,34 @@ void GSM_SMSCounter(GSM_Debug_Info *di,
 		    size_t 		*CharsLeft)
 {
 	size_t			UsedText,FreeBytes;
-	GSM_MultiSMSMessage 	MultiSMS;
+	GSM_MultiSMSMessage 	*MultiSMS;
+	GSM_SMSSplitInfo	Info;
+
+	if (Coding != 0 &&
+	    GSM_SplitSMSText(di, MessageBuffer, UnicodeLength(MessageBuffer), UDHType, Coding, &Info) == ERR_NONE) {
+		if (Info.Parts > GSM_MAX_MULTI_SMS) {
+			/* Encoding stops after GSM_MAX_MULTI_SMS messages */
+			*SMSNum = GSM_MAX_MULTI_SMS;
+			*CharsLeft = Info.Capacity - Info.Used[GSM_MAX_MULTI_SMS - 1];
+		} else {
+			*SMSNum = Info.Parts;
+			*CharsLeft = Info.CharsLeft;
+		}
+		return;
+	}
 
-	MultiSMS.Number = 0;
-	GSM_MakeMultiPartSMS(di, &MultiSMS,MessageBuffer,UnicodeLength(MessageBuffer),UDHType,Coding,-1,FALSE);
-	GSM_Find_Free_Used_SMS2(di, Coding,MultiSMS.SMS[MultiSMS.Number-1], &UsedText, CharsLeft, &FreeBytes);
-	*SMSNum = MultiSMS.Number;
+	/* Codings not handled by GSM_SplitSMSText */
+	MultiSMS = (GSM_MultiSMSMessage *)malloc(sizeof(GSM_MultiSMSMessage));
+	if (MultiSMS == NULL) {
+		*SMSNum = 0;
+		*CharsLeft = 0;
+		return;
+	}
+	MultiSMS->Number = 0;
+	GSM_MakeMultiPartSMS(di, MultiSMS,MessageBuffer,UnicodeLength(MessageBuffer),UDHType,Coding,-1,FALSE);
+	GSM_Find_Free_Used_SMS2(di, Coding,MultiSMS->SMS[MultiSMS->Number-1], &UsedText, CharsLeft, &FreeBytes);
+	*SMSNum = MultiSMS->Number;
+	free(MultiSMS);
 }
 
 /* Nokia Smart Messaging 3.0 */
@@ -219,6 +576,7 @@ static void GSM_EncodeSMS30MultiPartSMS(GSM_MultiPartSMSInfo *Info,
 					char *Buffer, size_t *Length)
 {
 	size_t len;
+	GSM_UnicodeView text;
 
 	/*SM version. Here 3.0*/
 	Buffer[(*Length)++] = 0x30;
@@ -228,9 +586,9 @@ static void GSM_EncodeSMS30MultiPartSMS(GSM_MultiPartSMSInfo *Info,
 			if (Info->Entries[0].Buffer[0]!=0x00 || Info->Entries[0].Buffer[1]!=0x00) {
 				Buffer[(*Length)++] = SM30_PROFILENAME;
 				Buffer[(*Length)++] = 0x00;
-				Buffer[(*Length)++] = 2*UnicodeLength(Info->Entries[0].Buffer);
-				CopyUnicodeString(Buffer+(*Length),Info->Entries[0].Buffer);
-				*Length = *Length + 2*UnicodeLength(Info->Entries[0].Buffer);
+				text = UnicodeView(Info->Entries[0].Buffer);
+				Buffer[(*Length)++] = 2*text.Length;
+				*Length = *Length + 2*UnicodeViewCopy(Buffer+(*Length),&text);
 			}
 		}
 		if (Info->Entries[0].Ringtone != NULL) {
@@ -258,20 +616,21 @@ static void GSM_EncodeSMS30MultiPartSMS(GSM_MultiPartSMSInfo *Info,
 		Buffer[(*Length)++] = 0x00;
 		NOKIA_CopyBitmap(GSM_NokiaPictureImage, &Info->Entries[0].Bitmap->Bitmap[0], Buffer, Length);
 		if (Info->Entries[0].Bitmap->Bitmap[0].Text[0]!=0 || Info->Entries[0].Bitmap->Bitmap[0].Text[1]!=0) {
+			text = UnicodeView(Info->Entries[0].Bitmap->Bitmap[0].Text);
 			if (Info->UnicodeCoding) {
 				Buffer[(*Length)++] = SM30_UNICODETEXT;
 				/* Length for text part */
 				Buffer[(*Length)++] = 0x00;
-				Buffer[(*Length)++] = UnicodeLength(Info->Entries[0].Bitmap->Bitmap[0].Text)*2;
-				memcpy(Buffer+(*Length),Info->Entries[0].Bitmap->Bitmap[0].Text,UnicodeLength(Info->Entries[0].Bitmap->Bitmap[0].Text)*2);
-				*Length = *Length + UnicodeLength(Info->Entries[0].Bitmap->Bitmap[0].Text)*2;
+				Buffer[(*Length)++] = text.Length*2;
+				memcpy(Buffer+(*Length),text.Text,text.Length*2);
+				*Length = *Length + text.Length*2;
 			} else {
 				/*ID for ISO-8859-1 text*/
 				Buffer[(*Length)++] = SM30_ISOTEXT;
 				Buffer[(*Length)++] = 0x00;
-				Buffer[(*Length)++] = UnicodeLength(Info->Entries[0].Bitmap->Bitmap[0].Text);
-				memcpy(Buffer+(*Length),DecodeUnicodeString(Info->Entries[0].Bitmap->Bitmap[0].Text),UnicodeLength(Info->Entries[0].Bitmap->Bitmap[0].Text));
-				*Length = *Length +UnicodeLength(Info->Entries[0].Bitmap->Bitmap[0].Text);
+				Buffer[(*Length)++] = text.Length;
+				memcpy(Buffer+(*Length),DecodeUnicodeString(text.Text),text.Length);
+				*Length = *Length + text.Length;
 			}
 		}
 	}
@@ -668,10 +1027,9 @@ GSM_Error GSM_EncodeMultiPartSMS(GSM_Debug_Info *di,
 		}
 		UDHHeader.Type = UDH;
 		GSM_EncodeUDHHeader(di, &UDHHeader);
-		memcpy(Buffer,Info->Entries[0].Buffer,UnicodeLength(Info->Entries[0].Buffer)*2+2);
+		Length = CopyUnicodeStringLen(Buffer,Info->Entries[0].Buffer);
 		if (Info->UnicodeCoding) {
 			Coding = SMS_Coding_Unicode_No_Compression;
-			Length = UnicodeLength(Info->Entries[0].Buffer);
 			if (Length > (size_t)(140 - UDHHeader.Length) / 2) {
 				Length = (140 - UDHHeader.Length) / 2;
 			}
@@ -682,26 +1040,30 @@ GSM_Error GSM_EncodeMultiPartSMS(GSM_Debug_Info *di,
 		break;
 	case SMS_ConcatenatedAutoTextLong:
 	case SMS_ConcatenatedAutoTextLong16bit:
-		smslen = UnicodeLength(Info->Entries[0].Buffer);
+		Length = UnicodeLength(Info->Entries[0].Buffer);
+		smslen = Length;
 		memcpy(Buffer,Info->Entries[0].Buffer,smslen*2);
 		EncodeDefault(Buffer2, Buffer, &smslen, TRUE, NULL);
 		DecodeDefault(Buffer,  Buffer2, smslen, TRUE, NULL);
 #ifdef DEBUG
 		if (di->dl == DL_TEXTALL || di->dl == DL_TEXTALLDATE) {
 			smfprintf(di, "Info->Entries[0].Buffer:\n");
-			DumpMessage(di, Info->Entries[0].Buffer, UnicodeLength(Info->Entries[0].Buffer)*2);
+			DumpMessage(di, Info->Entries[0].Buffer, Length*2);
 			smfprintf(di, "Buffer:\n");
 			DumpMessage(di, Buffer, UnicodeLength(Buffer)*2);
 		}
 #endif
 		Info->UnicodeCoding = FALSE;
-		for (smslen = 0; smslen < UnicodeLength(Info->Entries[0].Buffer) * 2; smslen++) {
+		for (smslen = 0; smslen < Length * 2; smslen++) {
 			if (Info->Entries[0].Buffer[smslen] != Buffer[smslen]) {
 				Info->UnicodeCoding = TRUE;
 				smfprintf(di, "Setting to Unicode %ld\n", (long)smslen);
 				break;
 			}
 		}
+		if (Info->UnicodeCoding && GSM_EncodeNationalMultiPartSMS(di, Info, SMS)) {
+			return ERR_NONE;
+		}
 		/* No break here - we go to the SMS_ConcatenatedTextLong */
 	case SMS_ConcatenatedTextLong:
 	case SMS_ConcatenatedTextLong16bit:
@@ -710,9 +1072,15 @@ GSM_Error GSM_EncodeMultiPartSMS(GSM_Debug_Info *di,
 			Buffer[0] = 0;
 			Buffer[1] = 0;
 		} else {
-			memcpy(Buffer,Info->Entries[0].Buffer,UnicodeLength(Info->Entries[0].Buffer)*2+2);
+			CopyUnicodeStringLen(Buffer,Info->Entries[0].Buffer);
 		}
 		UDH = UDH_NoUDH;
+		if (!Info->UnicodeCoding &&
+		    (Info->LockingShift != SMS_Language_Default || Info->SingleShift != SMS_Language_Default) &&
+		    (Info->Entries[0].ID == SMS_ConcatenatedTextLong ||
+		     Info->Entries[0].ID == SMS_ConcatenatedTextLong16bit)) {
+			return GSM_EncodeNationalTextSMS(di, Info, Buffer, SMS);
+		}
 		if (Info->UnicodeCoding) {
 			Coding = SMS_Coding_Unicode_No_Compression;
 			Length = UnicodeLength(Buffer);
@@ -774,6 +1142,8 @@ void GSM_ClearMultiPartSMSInfo(GSM_MultiPartSMSInfo *Info)
 	Info->Class		= -1;
 	Info->ReplaceMessage	= 0;
 	Info->UnicodeCoding	= FALSE;
+	Info->LockingShift	= SMS_Language_Default;
+	Info->SingleShift	= SMS_Language_Default;
 }
 
 void GSM_FreeMultiPartSMSInfo(GSM_MultiPartSMSInfo *Info)
@@ -1058,6 +1428,7 @@ gboolean GSM_DecodeLinkedText(GSM_Debug_Info *di,
 			    GSM_MultiSMSMessage		*SMS)
 {
 	int i, Length = 0;
+	GSM_UnicodeView text;
 
 	Info->EntriesNum    = 1;
 	Info->Entries[0].ID = SMS_ConcatenatedTextLong;
@@ -1082,11 +1453,12 @@ gboolean GSM_DecodeLinkedText(GSM_Debug_Info *di,
 				Info->Entries[0].ID = SMS_ConcatenatedAutoTextLong16bit;
 			}
 		case SMS_Coding_Default_No_Compression:
-			Info->Entries[0].Buffer = (unsigned char *)realloc(Info->Entries[0].Buffer, Length + UnicodeLength(SMS->SMS[i].Text)*2 + 2);
+			text = UnicodeView(SMS->SMS[i].Text);
+			Info->Entries[0].Buffer = (unsigned char *)realloc(Info->Entries[0].Buffer, Length + text.Length*2 + 2);
 			if (Info->Entries[0].Buffer == NULL) return FALSE;
 
-			memcpy(Info->Entries[0].Buffer+Length,SMS->SMS[i].Text,UnicodeLength(SMS->SMS[i].Text)*2);
-			Length=Length+UnicodeLength(SMS->SMS[i].Text)*2;
+			memcpy(Info->Entries[0].Buffer+Length,text.Text,text.Length*2);
+			Length=Length+text.Length*2;
 			break;
 		default:
 			break;
@@ -1097,6 +1469,30 @@ gboolean GSM_DecodeLinkedText(GSM_Debug_Info *di,
 	return TRUE;
 }
 
+/**
+ * Checks whether message is single text with UDH holding only national
+ * language IEs.
+ */
+static gboolean GSM_IsNationalTextSMS(const GSM_MultiSMSMessage *SMS)
+{
+	GSM_NationalLanguage	locking, single;
+	int			length = 0;
+
+	if (SMS->Number != 1 ||
+	    SMS->SMS[0].UDH.Type != UDH_UserUDH ||
+	    SMS->SMS[0].Coding != SMS_Coding_Default_No_Compression) {
+		return FALSE;
+	}
+	GSM_DecodeUDHNationalLanguage(&SMS->SMS[0].UDH, &locking, &single);
+	if (locking != SMS_Language_Default) {
+		length += 3;
+	}
+	if (single != SMS_Language_Default) {
+		length += 3;
+	}
+	return length > 0 && SMS->SMS[0].UDH.Text[0] == length;
+}
+
 /* ----------------- Joining SMS from parts -------------------------------- */
 
 gboolean GSM_DecodeMultiPartSMS(GSM_Debug_Info *di,
@@ -1110,6 +1506,10 @@ gboolean GSM_DecodeMultiPartSMS(GSM_Debug_Info *di,
 	GSM_SiemensOTASMSInfo	SiemensInfo;
 
 	GSM_ClearMultiPartSMSInfo(Info);
+	/* Keep national tables, so that message can be encoded same way again */
+	if (SMS->Number > 0 && SMS->SMS[0].Coding == SMS_Coding_Default_No_Compression) {
+		GSM_DecodeUDHNationalLanguage(&SMS->SMS[0].UDH, &Info->LockingShift, &Info->SingleShift);
+	}
 	if (ems) {
 		emsexist = TRUE;
 		for (i=0;i<SMS->Number;i++) {
@@ -1192,9 +1592,10 @@ gboolean GSM_DecodeMultiPartSMS(GSM_Debug_Info *di,
 		return GSM_DecodeNokiaProfile(di, Info, SMS);
 	}
 
-	/* Linked sms */
+	/* Linked sms and text with national tables only */
 	if (SMS->SMS[0].UDH.Type == UDH_ConcatenatedMessages ||
-	    SMS->SMS[0].UDH.Type == UDH_ConcatenatedMessages16bit) {
+	    SMS->SMS[0].UDH.Type == UDH_ConcatenatedMessages16bit ||
+	    GSM_IsNationalTextSMS(SMS)) {
 		return GSM_DecodeLinkedText(di, Info, SMS);
 	}
 	/* MMS indication */
@@ -1205,6 +1606,29 @@ gboolean GSM_DecodeMultiPartSMS(GSM_Debug_Info *di,
 	return FALSE;
 }
 
+/**
+ * Copies used parts of message, input messages might be allocated with
+ * space for used parts only.
+ */
+static void GSM_CopyMultiSMS(GSM_MultiSMSMessage *dest, const GSM_MultiSMSMessage *src)
+{
+	dest->Number = src->Number;
+	memcpy(dest->SMS, src->SMS, src->Number * sizeof(GSM_SMSMessage));
+}
+
+/**
+ * Compares two numbers, unlike strcmp on DecodeUnicodeString results
+ * this does not share one static buffer for both sides.
+ */
+static gboolean GSM_SameNumber(const unsigned char *a, const unsigned char *b)
+{
+	GSM_UnicodeView va, vb;
+
+	va = UnicodeView(a);
+	vb = UnicodeView(b);
+	return UnicodeViewEqual(&va, &vb);
+}
+
 GSM_Error GSM_LinkSMS(GSM_Debug_Info *di, GSM_MultiSMSMessage **InputMessages, GSM_MultiSMSMessage **OutputMessages, gboolean ems)
 {
 	gboolean			*InputMessagesSorted, copyit,OtherNumbers[GSM_SMS_OTHER_NUMBERS+1],wrong=FALSE;
@@ -1306,7 +1730,7 @@ GSM_Error GSM_LinkSMS(GSM_Debug_Info *di, GSM_MultiSMSMessage **InputMessages, G
 					}
 					/* For SMS_Deliver compare also SMSC and Sender numbers */
 					if (InputMessages[z]->SMS[0].PDU == SMS_Deliver &&
-					    strcmp(DecodeUnicodeString(InputMessages[z]->SMS[0].SMSC.Number),DecodeUnicodeString(InputMessages[i]->SMS[0].SMSC.Number))) {
+					    !GSM_SameNumber(InputMessages[z]->SMS[0].SMSC.Number,InputMessages[i]->SMS[0].SMSC.Number)) {
 						z++;
 						continue;
 					}
@@ -1323,22 +1747,22 @@ GSM_Error GSM_LinkSMS(GSM_Debug_Info *di, GSM_MultiSMSMessage **InputMessages, G
 							wrong=TRUE;
 							for (p=0;p<InputMessages[i]->SMS[0].OtherNumbersNum+1;p++) {
 								if (OtherNumbers[p]) continue;
-								if (m==0 && p==0 && !strcmp(DecodeUnicodeString(InputMessages[z]->SMS[0].Number),DecodeUnicodeString(InputMessages[i]->SMS[0].Number))) {
+								if (m==0 && p==0 && GSM_SameNumber(InputMessages[z]->SMS[0].Number,InputMessages[i]->SMS[0].Number)) {
 									OtherNumbers[0]=TRUE;
 									wrong=FALSE;
 									break;
 								}
-								if (m==0 && p!=0 && !strcmp(DecodeUnicodeString(InputMessages[z]->SMS[0].Number),DecodeUnicodeString(InputMessages[i]->SMS[0].OtherNumbers[p-1]))) {
+								if (m==0 && p!=0 && GSM_SameNumber(InputMessages[z]->SMS[0].Number,InputMessages[i]->SMS[0].OtherNumbers[p-1])) {
 									OtherNumbers[p]=TRUE;
 									wrong=FALSE;
 									break;
 								}
-								if (m!=0 && p==0 && !strcmp(DecodeUnicodeString(InputMessages[z]->SMS[0].OtherNumbers[m-1]),DecodeUnicodeString(InputMessages[i]->SMS[0].Number))) {
+								if (m!=0 && p==0 && GSM_SameNumber(InputMessages[z]->SMS[0].OtherNumbers[m-1],InputMessages[i]->SMS[0].Number)) {
 									OtherNumbers[0]=TRUE;
 									wrong=FALSE;
 									break;
 								}
-								if (m!=0 && p!=0 && !strcmp(DecodeUnicodeString(InputMessages[z]->SMS[0].OtherNumbers[m-1]),DecodeUnicodeString(InputMessages[i]->SMS[0].OtherNumbers[p-1]))) {
+								if (m!=0 && p!=0 && GSM_SameNumber(InputMessages[z]->SMS[0].OtherNumbers[m-1],InputMessages[i]->SMS[0].OtherNumbers[p-1])) {
 									OtherNumbers[p]=TRUE;
 									wrong=FALSE;
 									break;
@@ -1409,7 +1833,7 @@ GSM_Error GSM_LinkSMS(GSM_Debug_Info *di, GSM_MultiSMSMessage **InputMessages, G
 				}
 				OutputMessages[OutputMessagesNum+1] = NULL;
 
-				memcpy(OutputMessages[OutputMessagesNum],InputMessages[i],sizeof(GSM_MultiSMSMessage));
+				GSM_CopyMultiSMS(OutputMessages[OutputMessagesNum],InputMessages[i]);
 				InputMessagesSorted[i]=TRUE;
 				OutputMessagesNum++;
 				i = 0;
@@ -1441,7 +1865,7 @@ GSM_Error GSM_LinkSMS(GSM_Debug_Info *di, GSM_MultiSMSMessage **InputMessages, G
 			}
 			OutputMessages[OutputMessagesNum+1] = NULL;
 
-			memcpy(OutputMessages[OutputMessagesNum],InputMessages[i],sizeof(GSM_MultiSMSMessage));
+			GSM_CopyMultiSMS(OutputMessages[OutputMessagesNum],InputMessages[i]);
 			InputMessagesSorted[i]=TRUE;
 			OutputMessagesNum++;
 			i = 0;
@@ -1507,7 +1931,7 @@ GSM_Error GSM_LinkSMS(GSM_Debug_Info *di, GSM_MultiSMSMessage **InputMessages, G
 					}
 					/* For SMS_Deliver compare also SMSC and Sender numbers */
 					if (InputMessages[z]->SMS[0].PDU == SMS_Deliver &&
-					    strcmp(DecodeUnicodeString(InputMessages[z]->SMS[0].SMSC.Number),DecodeUnicodeString(InputMessages[i]->SMS[0].SMSC.Number))) {
+					    !GSM_SameNumber(InputMessages[z]->SMS[0].SMSC.Number,InputMessages[i]->SMS[0].SMSC.Number)) {
 						z++;
 						continue;
 					}
@@ -1524,22 +1948,22 @@ GSM_Error GSM_LinkSMS(GSM_Debug_Info *di, GSM_MultiSMSMessage **InputMessages, G
 							wrong=TRUE;
 							for (p=0;p<InputMessages[i]->SMS[0].OtherNumbersNum+1;p++) {
 								if (OtherNumbers[p]) continue;
-								if (m==0 && p==0 && !strcmp(DecodeUnicodeString(InputMessages[z]->SMS[0].Number),DecodeUnicodeString(InputMessages[i]->SMS[0].Number))) {
+								if (m==0 && p==0 && GSM_SameNumber(InputMessages[z]->SMS[0].Number,InputMessages[i]->SMS[0].Number)) {
 									OtherNumbers[0]=TRUE;
 									wrong=FALSE;
 									break;
 								}
-								if (m==0 && p!=0 && !strcmp(DecodeUnicodeString(InputMessages[z]->SMS[0].Number),DecodeUnicodeString(InputMessages[i]->SMS[0].OtherNumbers[p-1]))) {
+								if (m==0 && p!=0 && GSM_SameNumber(InputMessages[z]->SMS[0].Number,InputMessages[i]->SMS[0].OtherNumbers[p-1])) {
 									OtherNumbers[p]=TRUE;
 									wrong=FALSE;
 									break;
 								}
-								if (m!=0 && p==0 && !strcmp(DecodeUnicodeString(InputMessages[z]->SMS[0].OtherNumbers[m-1]),DecodeUnicodeString(InputMessages[i]->SMS[0].Number))) {
+								if (m!=0 && p==0 && GSM_SameNumber(InputMessages[z]->SMS[0].OtherNumbers[m-1],InputMessages[i]->SMS[0].Number)) {
 									OtherNumbers[0]=TRUE;
 									wrong=FALSE;
 									break;
 								}
-								if (m!=0 && p!=0 && !strcmp(DecodeUnicodeString(InputMessages[z]->SMS[0].OtherNumbers[m-1]),DecodeUnicodeString(InputMessages[i]->SMS[0].OtherNumbers[p-1]))) {
+								if (m!=0 && p!=0 && GSM_SameNumber(InputMessages[z]->SMS[0].OtherNumbers[m-1],InputMessages[i]->SMS[0].OtherNumbers[p-1])) {
 									OtherNumbers[p]=TRUE;
 									wrong=FALSE;
 									break;
@@ -1605,7 +2029,7 @@ GSM_Error GSM_LinkSMS(GSM_Debug_Info *di, GSM_MultiSMSMessage **InputMessages, G
 				}
 				OutputMessages[OutputMessagesNum+1] = NULL;
 
-				memcpy(OutputMessages[OutputMessagesNum],InputMessages[i],sizeof(GSM_MultiSMSMessage));
+				GSM_CopyMultiSMS(OutputMessages[OutputMessagesNum],InputMessages[i]);
 				InputMessagesSorted[i]=TRUE;
 				OutputMessagesNum++;
 				i = 0;
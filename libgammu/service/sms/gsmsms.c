@@ -14,6 +14,7 @@
  */
 
 #include <ctype.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
@@ -118,10 +119,117 @@ static GSM_Error GSM_DecodeSMSDateTime(GSM_Debug_Info *di, GSM_DateTime *DT, con
 	return ERR_NONE;
 }
 
+/* 3GPP TS 23.040, section 9.2.3.24: National language shift IEs */
+#define UDH_IE_SINGLE_SHIFT	0x24
+#define UDH_IE_LOCKING_SHIFT	0x25
+
+/**
+ * Checks whether there is national language IE at given position of
+ * UDH text.
+ */
+static gboolean GSM_IsNationalLanguageIE(const unsigned char *Text, int pos)
+{
+	return (Text[pos] == UDH_IE_SINGLE_SHIFT || Text[pos] == UDH_IE_LOCKING_SHIFT) &&
+		Text[pos + 1] == 1 &&
+		pos + 2 <= Text[0] &&
+		pos + 2 < GSM_MAX_UDH_LENGTH;
+}
+
+/**
+ * Copies UDH text without national language IEs, so that the rest can
+ * be matched against known headers.
+ *
+ * \return TRUE if some IE was removed.
+ */
+static gboolean GSM_StripNationalLanguage(const unsigned char *Text, unsigned char *dest)
+{
+	int	pos = 1;
+	gboolean	removed = FALSE;
+
+	dest[0] = 0;
+	while (pos + 1 <= Text[0] && pos + 1 < GSM_MAX_UDH_LENGTH) {
+		if (GSM_IsNationalLanguageIE(Text, pos)) {
+			removed = TRUE;
+		} else {
+			if (pos + 2 + Text[pos + 1] > GSM_MAX_UDH_LENGTH) {
+				return FALSE;
+			}
+			memcpy(dest + dest[0] + 1, Text + pos, 2 + Text[pos + 1]);
+			dest[0] += 2 + Text[pos + 1];
+		}
+		pos += 2 + Text[pos + 1];
+	}
+	return removed;
+}
+
+GSM_Error GSM_EncodeUDHNationalLanguage(GSM_UDHHeader *UDH,
+	GSM_NationalLanguage LockingShift, GSM_NationalLanguage SingleShift)
+{
+	int	needed = 1;
+
+	if (LockingShift == SMS_Language_Default && SingleShift == SMS_Language_Default) {
+		return ERR_NONE;
+	}
+	if (UDH->Type == UDH_NoUDH) {
+		UDH->Text[0] = 0;
+	}
+	if (LockingShift != SMS_Language_Default) {
+		needed += 3;
+	}
+	if (SingleShift != SMS_Language_Default) {
+		needed += 3;
+	}
+	if (UDH->Text[0] + needed > GSM_MAX_UDH_LENGTH) {
+		return ERR_MOREMEMORY;
+	}
+	if (UDH->Type == UDH_NoUDH) {
+		UDH->Type = UDH_UserUDH;
+	}
+	if (LockingShift != SMS_Language_Default) {
+		UDH->Text[UDH->Text[0] + 1] = UDH_IE_LOCKING_SHIFT;
+		UDH->Text[UDH->Text[0] + 2] = 1;
+		UDH->Text[UDH->Text[0] + 3] = LockingShift;
+		UDH->Text[0] += 3;
+	}
+	if (SingleShift != SMS_Language_Default) {
+		UDH->Text[UDH->Text[0] + 1] = UDH_IE_SINGLE_SHIFT;
+		UDH->Text[UDH->Text[0] + 2] = 1;
+		UDH->Text[UDH->Text[0] + 3] = SingleShift;
+		UDH->Text[0] += 3;
+	}
+	UDH->Length = UDH->Text[0] + 1;
+	return ERR_NONE;
+}
+
+void GSM_DecodeUDHNationalLanguage(const GSM_UDHHeader *UDH,
+	GSM_NationalLanguage *LockingShift, GSM_NationalLanguage *SingleShift)
+{
+	int pos = 1;
+
+	*LockingShift = SMS_Language_Default;
+	*SingleShift = SMS_Language_Default;
+
+	if (UDH->Type == UDH_NoUDH) {
+		return;
+	}
+	while (pos + 1 <= UDH->Text[0] && pos + 1 < GSM_MAX_UDH_LENGTH) {
+		if (GSM_IsNationalLanguageIE(UDH->Text, pos)) {
+			if (UDH->Text[pos] == UDH_IE_LOCKING_SHIFT) {
+				*LockingShift = UDH->Text[pos + 2];
+			} else {
+				*SingleShift = UDH->Text[pos + 2];
+			}
+		}
+		pos += 2 + UDH->Text[pos + 1];
+	}
+}
+
 void GSM_DecodeUDHHeader(GSM_Debug_Info *di, GSM_UDHHeader *UDH)
 {
 	int	i, tmp, w;
 	gboolean	UDHOK;
+	unsigned char	stripped[GSM_MAX_UDH_LENGTH];
+	const unsigned char	*text = UDH->Text;
 
 	UDH->Type 	= UDH_UserUDH;
 	UDH->ID8bit	= -1;
@@ -129,12 +237,17 @@ void GSM_DecodeUDHHeader(GSM_Debug_Info *di, GSM_UDHHeader *UDH)
 	UDH->PartNumber	= -1;
 	UDH->AllParts	= -1;
 
+	/* Headers are matched without national language IEs */
+	if (GSM_StripNationalLanguage(UDH->Text, stripped)) {
+		text = stripped;
+	}
+
 	i=-1;
 	while (UDHHeaders[++i].Type != UDH_NoUDH) {
 
 		tmp=UDHHeaders[i].Length;
 		/* if length is the same */
-		if (tmp==UDH->Text[0]) {
+		if (tmp==text[0]) {
 
 			if (tmp == 0x05) {
 				/* three last bytes can be different for such UDH */
@@ -144,13 +257,13 @@ void GSM_DecodeUDHHeader(GSM_Debug_Info *di, GSM_UDHHeader *UDH)
 				/* three last bytes can be different for such UDH */
 				tmp = tmp - 3;
 			}
-			if (tmp == 0x06 && UDH->Text[1] == 0x08) {
+			if (tmp == 0x06 && text[1] == 0x08) {
 				tmp=tmp-4;
 			}
 
 			UDHOK = TRUE;
 			for (w = 0; w < tmp; w++) {
-				if (UDHHeaders[i].Text[w] != UDH->Text[w + 1]) {
+				if (UDHHeaders[i].Text[w] != text[w + 1]) {
 					UDHOK = FALSE;
 					break;
 				}
@@ -159,16 +272,16 @@ void GSM_DecodeUDHHeader(GSM_Debug_Info *di, GSM_UDHHeader *UDH)
 				UDH->Type=UDHHeaders[i].Type;
 
 				if (UDHHeaders[i].ID8bit !=-1) {
-					UDH->ID8bit = UDH->Text[UDHHeaders[i].ID8bit+1];
+					UDH->ID8bit = text[UDHHeaders[i].ID8bit+1];
 				}
 				if (UDHHeaders[i].ID16bit !=-1) {
-					UDH->ID16bit = UDH->Text[UDHHeaders[i].ID16bit+1]*256+UDH->Text[UDHHeaders[i].ID16bit+2];
+					UDH->ID16bit = text[UDHHeaders[i].ID16bit+1]*256+text[UDHHeaders[i].ID16bit+2];
 				}
 				if (UDHHeaders[i].PartNumber !=-1) {
-					UDH->PartNumber = UDH->Text[UDHHeaders[i].PartNumber+1];
+					UDH->PartNumber = text[UDHHeaders[i].PartNumber+1];
 				}
 				if (UDHHeaders[i].AllParts !=-1) {
-					UDH->AllParts = UDH->Text[UDHHeaders[i].AllParts+1];
+					UDH->AllParts = text[UDHHeaders[i].AllParts+1];
 				}
 				break;
 			}
@@ -312,6 +425,21 @@ GSM_Coding_Type GSM_GetMessageCoding(GSM_Debug_Info *di, const char TPDCS) {
 	return SMS_Coding_8bit;
 }
 
+/**
+ * Decodes text in default alphabet, using national language tables
+ * selected in the UDH.
+ */
+static void GSM_DecodeSMSDefaultText(GSM_SMSMessage *SMS, const unsigned char *input)
+{
+	GSM_NationalLanguage	locking = SMS_Language_Default;
+	GSM_NationalLanguage	single = SMS_Language_Default;
+
+	if (SMS->UDH.Length > 0) {
+		GSM_DecodeUDHNationalLanguage(&SMS->UDH, &locking, &single);
+	}
+	DecodeNational(SMS->Text, input, SMS->Length, locking, single);
+}
+
 GSM_Error GSM_DecodeSMSFrameText(GSM_Debug_Info *di, GSM_SMSMessage *SMS, unsigned char *buffer, GSM_SMSMessageLayout Layout)
 {
 	int		off=0;	 	/* length of the User Data Header */
@@ -352,7 +480,7 @@ GSM_Error GSM_DecodeSMSFrameText(GSM_Debug_Info *di, GSM_SMSMessage *SMS, unsign
 			}
 			GSM_UnpackEightBitsToSeven(w, buffer[Layout.TPUDL]-off, SMS->Length, buffer+(Layout.Text+off), output);
 			smfprintf(di, "7 bit SMS, length %i\n",SMS->Length);
-			DecodeDefault (SMS->Text, output, SMS->Length, TRUE, NULL);
+			GSM_DecodeSMSDefaultText(SMS, output);
 			smfprintf(di, "%s\n",DecodeUnicodeString(SMS->Text));
 			break;
 		case SMS_Coding_8bit:
@@ -762,7 +890,7 @@ GSM_Error GSM_DecodePDUFrame(GSM_Debug_Info *di, GSM_SMSMessage *SMS, const unsi
 				}
 				GSM_UnpackEightBitsToSeven(w, buffer[pos]-SMS->UDH.Length, SMS->Length, buffer+(pos + 1+SMS->UDH.Length), output);
 				smfprintf(di, "7 bit SMS, length %i\n",SMS->Length);
-				DecodeDefault (SMS->Text, output, SMS->Length, TRUE, NULL);
+				GSM_DecodeSMSDefaultText(SMS, output);
 				smfprintf(di, "%s\n",DecodeUnicodeString(SMS->Text));
 				break;
 			case SMS_Coding_8bit:
@@ -803,6 +931,234 @@ GSM_Error GSM_DecodePDUFrame(GSM_Debug_Info *di, GSM_SMSMessage *SMS, const unsi
 	return ERR_NONE;
 }
 
+/**
+ * Makes sure there is space for given number of bytes in batch storage.
+ */
+static GSM_Error GSM_PDUBatchReserve(GSM_SMSPDUBatch *Batch, size_t size)
+{
+	size_t newsize;
+	char *data;
+
+	if (Batch->DataUsed + size <= Batch->DataSize) {
+		return ERR_NONE;
+	}
+	newsize = Batch->DataSize * 2;
+	if (newsize < Batch->DataUsed + size) {
+		newsize = Batch->DataUsed + size;
+	}
+	data = (char *)realloc(Batch->Data, newsize);
+	if (data == NULL) {
+		return ERR_MOREMEMORY;
+	}
+	Batch->Data = data;
+	Batch->DataSize = newsize;
+	return ERR_NONE;
+}
+
+/**
+ * Stores Unicode text as UTF-8 in batch storage.
+ *
+ * \param offset Where to store offset of stored text.
+ */
+static GSM_Error GSM_PDUBatchAddText(GSM_SMSPDUBatch *Batch, const unsigned char *text, size_t len, size_t *offset)
+{
+	GSM_Error error;
+
+	if (len == 0) {
+		*offset = 0;
+		return ERR_NONE;
+	}
+	error = GSM_PDUBatchReserve(Batch, len * 3 + 1);
+	if (error != ERR_NONE) {
+		return error;
+	}
+	*offset = Batch->DataUsed;
+	Batch->DataUsed += EncodeUTF8Len(Batch->Data + Batch->DataUsed, text, len) + 1;
+	return ERR_NONE;
+}
+
+/**
+ * Stores raw data in batch storage, data are terminated by zero.
+ *
+ * \param offset Where to store offset of stored data.
+ */
+static GSM_Error GSM_PDUBatchAddData(GSM_SMSPDUBatch *Batch, const unsigned char *data, size_t len, size_t *offset)
+{
+	GSM_Error error;
+
+	if (len == 0) {
+		*offset = 0;
+		return ERR_NONE;
+	}
+	error = GSM_PDUBatchReserve(Batch, len + 1);
+	if (error != ERR_NONE) {
+		return error;
+	}
+	*offset = Batch->DataUsed;
+	memcpy(Batch->Data + Batch->DataUsed, data, len);
+	Batch->Data[Batch->DataUsed + len] = 0;
+	Batch->DataUsed += len + 1;
+	return ERR_NONE;
+}
+
+/**
+ * Stores decoded message in the batch.
+ *
+ * \param offsets Where to store offsets of number, SMSC, text and UDH.
+ */
+static GSM_Error GSM_PDUBatchStore(GSM_SMSPDUBatch *Batch, GSM_SMSPDUInfo *Info, const GSM_SMSMessage *SMS, size_t *offsets)
+{
+	GSM_Error error;
+
+	Info->PDU = SMS->PDU;
+	Info->Coding = SMS->Coding;
+	Info->Class = SMS->Class;
+	Info->MessageReference = SMS->MessageReference;
+	Info->DeliveryStatus = SMS->DeliveryStatus;
+	Info->ReplyViaSameSMSC = SMS->ReplyViaSameSMSC;
+	Info->DateTime = SMS->DateTime;
+	Info->SMSCTime = SMS->SMSCTime;
+	Info->UDHType = SMS->UDH.Type;
+	Info->ID8bit = SMS->UDH.ID8bit;
+	Info->ID16bit = SMS->UDH.ID16bit;
+	Info->PartNumber = SMS->UDH.PartNumber;
+	Info->AllParts = SMS->UDH.AllParts;
+
+	error = GSM_PDUBatchAddText(Batch, SMS->Number, UnicodeLength(SMS->Number), &offsets[0]);
+	if (error != ERR_NONE) {
+		return error;
+	}
+	error = GSM_PDUBatchAddText(Batch, SMS->SMSC.Number, UnicodeLength(SMS->SMSC.Number), &offsets[1]);
+	if (error != ERR_NONE) {
+		return error;
+	}
+	if (SMS->Coding == SMS_Coding_8bit) {
+		error = GSM_PDUBatchAddData(Batch, SMS->Text, SMS->Length, &offsets[2]);
+		Info->TextLength = SMS->Length;
+	} else {
+		error = GSM_PDUBatchAddText(Batch, SMS->Text, UnicodeLength(SMS->Text), &offsets[2]);
+		Info->TextLength = strlen(Batch->Data + offsets[2]);
+	}
+	if (error != ERR_NONE) {
+		return error;
+	}
+	error = GSM_PDUBatchAddData(Batch, SMS->UDH.Text, SMS->UDH.Length, &offsets[3]);
+	Info->UDHLength = SMS->UDH.Length;
+	return error;
+}
+
+GSM_Error GSM_DecodePDUBatch(GSM_Debug_Info *di, GSM_SMSPDUBatch *Batch,
+			const unsigned char * const *PDUs, const size_t *Lengths,
+			size_t Count, gboolean Hex, gboolean SMSC)
+{
+	GSM_SMSMessage *SMS;
+	GSM_SMSPDUInfo *Info;
+	unsigned char *buffer = NULL, *newbuffer;
+	const unsigned char *pdu;
+	size_t *offsets, i, length, buffer_size = 0, parse_len;
+	GSM_Error error = ERR_NONE;
+
+	Batch->Messages = NULL;
+	Batch->Count = 0;
+	Batch->Data = NULL;
+	Batch->DataUsed = 0;
+	Batch->DataSize = 0;
+
+	/* Single message structure is reused for all PDUs */
+	SMS = (GSM_SMSMessage *)malloc(sizeof(GSM_SMSMessage));
+	offsets = (size_t *)malloc(sizeof(size_t) * 4 * (Count + 1));
+	Batch->Messages = (GSM_SMSPDUInfo *)calloc(Count + 1, sizeof(GSM_SMSPDUInfo));
+	if (SMS == NULL || offsets == NULL || Batch->Messages == NULL) {
+		error = ERR_MOREMEMORY;
+		goto out;
+	}
+
+	/* Offset 0 is shared empty string */
+	error = GSM_PDUBatchReserve(Batch, Count * 32 + 1);
+	if (error != ERR_NONE) {
+		goto out;
+	}
+	Batch->Data[0] = 0;
+	Batch->DataUsed = 1;
+
+	for (i = 0; i < Count; i++) {
+		Info = &(Batch->Messages[i]);
+		memset(offsets + 4 * i, 0, sizeof(size_t) * 4);
+		pdu = PDUs[i];
+		length = Lengths[i];
+
+		if (Hex) {
+			if (length % 2 != 0) {
+				smfprintf(di, "Odd length of hex PDU %ld!\n", (long)i);
+				Info->Error = ERR_CORRUPTED;
+				continue;
+			}
+			if (buffer_size < length / 2 + 1) {
+				newbuffer = (unsigned char *)realloc(buffer, length / 2 + 1);
+				if (newbuffer == NULL) {
+					error = ERR_MOREMEMORY;
+					goto out;
+				}
+				buffer = newbuffer;
+				buffer_size = length / 2 + 1;
+			}
+			if (!DecodeHexBin(buffer, pdu, length)) {
+				smfprintf(di, "Failed to decode hex PDU %ld at position %ld!\n",
+					(long)i, (long)FindNonHexChar((const char *)pdu, length));
+				Info->Error = ERR_CORRUPTED;
+				continue;
+			}
+			pdu = buffer;
+			length /= 2;
+		}
+
+		if (length == 0) {
+			Info->Error = ERR_CORRUPTED;
+			continue;
+		}
+
+		Info->Error = GSM_DecodePDUFrame(di, SMS, pdu, length, &parse_len, SMSC);
+		if (Info->Error != ERR_NONE) {
+			continue;
+		}
+
+		error = GSM_PDUBatchStore(Batch, Info, SMS, offsets + 4 * i);
+		if (error != ERR_NONE) {
+			goto out;
+		}
+	}
+
+	/* Storage does not move anymore, we can convert offsets to pointers */
+	for (i = 0; i < Count; i++) {
+		Info = &(Batch->Messages[i]);
+		Info->Number = Batch->Data + offsets[4 * i];
+		Info->SMSC = Batch->Data + offsets[4 * i + 1];
+		Info->Text = Batch->Data + offsets[4 * i + 2];
+		Info->UDH = (const unsigned char *)Batch->Data + offsets[4 * i + 3];
+	}
+	Batch->Count = Count;
+
+out:
+	free(SMS);
+	free(offsets);
+	free(buffer);
+	if (error != ERR_NONE) {
+		GSM_FreePDUBatch(Batch);
+	}
+	return error;
+}
+
+void GSM_FreePDUBatch(GSM_SMSPDUBatch *Batch)
+{
+	free(Batch->Messages);
+	Batch->Messages = NULL;
+	free(Batch->Data);
+	Batch->Data = NULL;
+	Batch->Count = 0;
+	Batch->DataUsed = 0;
+	Batch->DataSize = 0;
+}
+
 GSM_Error GSM_DecodeSMSFrame(GSM_Debug_Info *di, GSM_SMSMessage *SMS, unsigned char *buffer, GSM_SMSMessageLayout Layout)
 {
 	GSM_DateTime	zerodt = {0,0,0,0,0,0,0};
@@ -935,7 +1291,8 @@ static int GSM_EncodeSMSFrameText(GSM_Debug_Info *di, GSM_SMSMessage *SMS, unsig
 	int	off = 0;	/*  length of the User Data Header */
 	int	size = 0, size2 = 0, w;
 	size_t p;
-	char	buff[200];
+	char	buff[GSM_MAX_SMS_CHARS_LENGTH * 2 + 1];
+	GSM_NationalLanguage	locking, single;
 
 	if (SMS->UDH.Type!=UDH_NoUDH) {
 		buffer[Layout.firstbyte] |= 0x40;			/* GSM 03.40 section 9.2.3.23 (TP-User-Data-Header-Indicator) */
@@ -963,13 +1320,11 @@ static int GSM_EncodeSMSFrameText(GSM_Debug_Info *di, GSM_SMSMessage *SMS, unsig
 			DumpMessageText(di, SMS->Text, SMS->Length);
 			break;
 		case SMS_Coding_Default_No_Compression:
-			p = 0;
-			do {
-				p+=7;
-				w=(p-off)%p;
-			} while (w<0);
+			/* Fill bits to align text to septet boundary */
+			w = (7 - (off * 8) % 7) % 7;
 			p = MIN(UnicodeLength(SMS->Text), 160);
-			EncodeDefault(buff, SMS->Text, &p, TRUE, NULL);
+			GSM_DecodeUDHNationalLanguage(&SMS->UDH, &locking, &single);
+			EncodeNational(buff, SMS->Text, &p, locking, single);
 			size = GSM_PackSevenBitsToEight(w, buff, buffer+(Layout.Text+off), p);
 			size += off;
 			size2 = (off*8 + w) / 7 + p;
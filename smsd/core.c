@@ -100,6 +100,7 @@ GSM_Error SMSD_Shutdown(GSM_SMSDConfig *Config)
 		return ERR_NOTRUNNING;
 	}
 	Config->shutdown = TRUE;
+	SMSD_Wakeup(Config);
 	return ERR_NONE;
 }
 
@@ -366,6 +367,8 @@ void SMSD_Log_Function(const char *text, void *data)
 GSM_SMSDConfig *SMSD_NewConfig(const char *name)
 {
 	GSM_SMSDConfig *Config;
+	int i;
+
 	Config = (GSM_SMSDConfig *)malloc(sizeof(GSM_SMSDConfig));
 	if (Config == NULL) return Config;
 
@@ -384,6 +387,21 @@ GSM_SMSDConfig *SMSD_NewConfig(const char *name)
 	Config->debug_level = 0;
 	Config->ServiceName = NULL;
 	Config->Service = NULL;
+	Config->SendQueue = NULL;
+	Config->SendQueueUsed = 0;
+	Config->RateLimits = NULL;
+	Config->RateLimitsCount = 0;
+	for (i = 0; i < SMSD_TIMER_LAST; i++) {
+		Config->Timers[i].Armed = FALSE;
+		Config->Timers[i].Due = 0;
+	}
+#ifdef WIN32
+	Config->WakeupEvent = NULL;
+#else
+	Config->WakeupPipe[0] = -1;
+	Config->WakeupPipe[1] = -1;
+	Config->WakeupFifo = -1;
+#endif
 
 #if defined(HAVE_MYSQL_MYSQL_H)
 	Config->conn.my = NULL;
@@ -393,6 +411,7 @@ GSM_SMSDConfig *SMSD_NewConfig(const char *name)
 #endif
 #if defined(HAVE_POSTGRESQL_LIBPQ_FE_H)
 	Config->conn.pg = NULL;
+	Config->listening = FALSE;
 #endif
 
 	/* Prepare lists */
@@ -488,6 +507,9 @@ void SMSD_FreeConfig(GSM_SMSDConfig *Config)
 
 	free(Config->gammu_log_buffer);
 
+	SMSD_SchedulerFree(Config);
+	SMSD_WakeupFree(Config);
+
 	INI_Free(Config->smsdcfgfile);
 
 	GSM_FreeStateMachine(Config->gsm);
@@ -809,6 +831,9 @@ GSM_Error SMSD_ReadConfig(const char *filename, GSM_SMSDConfig *Config, gboolean
 	SMSD_Log(DEBUG_NOTICE, Config, "mode: Send=%d, Receive=%d",
 			Config->enable_send, Config->enable_receive);
 
+	error = SMSD_SchedulerConfigure(Config);
+	if (error != ERR_NONE) return error;
+
 	Config->skipsmscnumber = INI_GetValue(Config->smsdcfgfile, "smsd", "skipsmscnumber", FALSE);
 	if (Config->skipsmscnumber == NULL) Config->skipsmscnumber="";
 
@@ -824,6 +849,7 @@ GSM_Error SMSD_ReadConfig(const char *filename, GSM_SMSDConfig *Config, gboolean
 
 	Config->RunOnReceive = INI_GetValue(Config->smsdcfgfile, "smsd", "runonreceive", FALSE);
 	Config->RunOnFailure = INI_GetValue(Config->smsdcfgfile, "smsd", "runonfailure", FALSE);
+	Config->wakeupfifo = INI_GetValue(Config->smsdcfgfile, "smsd", "wakeupfifo", FALSE);
 
 	str = INI_GetValue(Config->smsdcfgfile, "smsd", "smsc", FALSE);
 	if (str) {
@@ -1362,6 +1388,50 @@ success:
 	return TRUE;
 }
 
+/**
+ * State of reading messages from phone in SMSD_ReadDeleteSMS.
+ */
+typedef struct {
+	GSM_SMSDConfig *Config;
+	SMSD_MessagePool *Pool;
+	GSM_MultiSMSMessage **GetSMSData;
+	int allocated;
+	int GetSMSNumber;
+} SMSD_ReadState;
+
+/**
+ * Stores message read from phone for later processing.
+ */
+static GSM_Error SMSD_StoreReadSMS(GSM_StateMachine *s, GSM_MultiSMSMessage *sms, void *user_data)
+{
+	SMSD_ReadState *state = (SMSD_ReadState *)user_data;
+	GSM_MultiSMSMessage **GetSMSData;
+
+	if (state->Config->shutdown) {
+		return ERR_ABORTED;
+	}
+	if (!SMSD_ValidMessage(state->Config, sms)) {
+		return ERR_NONE;
+	}
+	if (state->allocated <= state->GetSMSNumber + 2) {
+		GetSMSData = (GSM_MultiSMSMessage **)realloc(state->GetSMSData, (state->allocated + 20) * sizeof(GSM_MultiSMSMessage *));
+		if (GetSMSData == NULL) {
+			return ERR_MOREMEMORY;
+		}
+		state->GetSMSData = GetSMSData;
+		state->allocated += 20;
+	}
+	state->GetSMSData[state->GetSMSNumber] = SMSD_PoolCopy(state->Pool, sms);
+
+	if (state->GetSMSData[state->GetSMSNumber] == NULL) {
+		return ERR_MOREMEMORY;
+	}
+
+	state->GetSMSNumber++;
+	state->GetSMSData[state->GetSMSNumber] = NULL;
+	return ERR_NONE;
+}
+
 /**
  * Reads message from phone, processes it and delete it from phone afterwards.
  *
@@ -1369,63 +1439,44 @@ success:
  */
 gboolean SMSD_ReadDeleteSMS(GSM_SMSDConfig *Config)
 {
-	gboolean start;
-	GSM_MultiSMSMessage sms;
-	GSM_MultiSMSMessage **GetSMSData = NULL, **SortedSMS;
+	gboolean ret = TRUE;
+	GSM_MultiSMSMessage **GetSMSData = NULL, **SortedSMS = NULL;
+	SMSD_MessagePool pool;
+	SMSD_ReadState state;
 	int allocated = 0;
 	GSM_Error error = ERR_NONE;
 	int GetSMSNumber = 0;
 	int i, j;
 
-	/* Read messages from phone */
-	start=TRUE;
-	sms.Number = 0;
-	sms.SMS[0].Location = 0;
-	while (error == ERR_NONE && !Config->shutdown) {
-		sms.SMS[0].Folder = 0;
-		error = GSM_GetNextSMS(Config->gsm, &sms, start);
-		switch (error) {
-			case ERR_EMPTY:
-				break;
-			case ERR_NONE:
-				if (SMSD_ValidMessage(Config, &sms)) {
-					if (allocated <= GetSMSNumber + 2) {
-						GetSMSData = (GSM_MultiSMSMessage **)realloc(GetSMSData, (allocated + 20) * sizeof(GSM_MultiSMSMessage *));
-						if (GetSMSData == NULL) {
-							SMSD_Log(DEBUG_ERROR, Config, "Failed to allocate memory");
-							return FALSE;
-						}
-						allocated += 20;
-					}
-					GetSMSData[GetSMSNumber] = malloc(sizeof(GSM_MultiSMSMessage));
-
-					if (GetSMSData[GetSMSNumber] == NULL) {
-						SMSD_Log(DEBUG_ERROR, Config, "Failed to allocate memory");
-						for (i = 0; GetSMSData[i] != NULL; i++) {
-							free(GetSMSData[i]);
-							GetSMSData[i] = NULL;
-						}
-						free(GetSMSData);
-						return FALSE;
-					}
-
-					*(GetSMSData[GetSMSNumber]) = sms;
-					GetSMSNumber++;
-					GetSMSData[GetSMSNumber] = NULL;
-				}
-				break;
-			default:
-				SMSD_LogError(DEBUG_INFO, Config, "Error getting SMS", error);
-				if (GetSMSData != NULL) {
-					for (i = 0; GetSMSData[i] != NULL; i++) {
-						free(GetSMSData[i]);
-						GetSMSData[i] = NULL;
-					}
-					free(GetSMSData);
-				}
-				return FALSE;
-		}
-		start = FALSE;
+	/* Read messages are stored only with used parts */
+	SMSD_PoolInit(&pool);
+
+	/* Read all messages from phone at once */
+	state.Config = Config;
+	state.Pool = &pool;
+	state.GetSMSData = NULL;
+	state.allocated = 0;
+	state.GetSMSNumber = 0;
+	error = GSM_GetAllSMS(Config->gsm, SMSD_StoreReadSMS, &state);
+	GetSMSData = state.GetSMSData;
+	allocated = state.allocated;
+	GetSMSNumber = state.GetSMSNumber;
+
+	switch (error) {
+		case ERR_NONE:
+		case ERR_EMPTY:
+		case ERR_ABORTED:
+			break;
+		case ERR_MOREMEMORY:
+			SMSD_Log(DEBUG_ERROR, Config, "Failed to allocate memory");
+			free(GetSMSData);
+			SMSD_PoolFree(&pool);
+			return FALSE;
+		default:
+			SMSD_LogError(DEBUG_INFO, Config, "Error getting SMS", error);
+			free(GetSMSData);
+			SMSD_PoolFree(&pool);
+			return FALSE;
 	}
 
 	/* Log how many messages were read */
@@ -1433,26 +1484,30 @@ gboolean SMSD_ReadDeleteSMS(GSM_SMSDConfig *Config)
 
 	/* No messages to process */
 	if (GetSMSNumber == 0) {
+		free(GetSMSData);
+		SMSD_PoolFree(&pool);
 		return TRUE;
 	}
 
-	/* Allocate memory for sorted messages */
+	/*
+	 * Allocate memory for sorted messages, read messages hold only
+	 * used parts, so they are passed to backends only as full linked
+	 * copies.
+	 */
 	SortedSMS = (GSM_MultiSMSMessage **)malloc(allocated * sizeof(GSM_MultiSMSMessage *));
 	if (SortedSMS == NULL) {
 		SMSD_Log(DEBUG_ERROR, Config, "Failed to allocate memory for linking messages");
-		SMSD_Log(DEBUG_ERROR, Config, "Skipping linking messages, long messages will not be connected");
-		SortedSMS = GetSMSData;
-	} else {
-		/* Link messages */
-		error = GSM_LinkSMS(GSM_GetDebug(Config->gsm), GetSMSData, SortedSMS, TRUE);
-		if (error != ERR_NONE) return FALSE;
-
-		/* Free memory */
-		for (i = 0; GetSMSData[i] != NULL; i++) {
-			free(GetSMSData[i]);
-			GetSMSData[i] = NULL;
-		}
-		free(GetSMSData);
+		ret = FALSE;
+		goto out;
+	}
+
+	/* Link messages */
+	error = GSM_LinkSMS(GSM_GetDebug(Config->gsm), GetSMSData, SortedSMS, TRUE);
+	if (error != ERR_NONE) {
+		free(SortedSMS);
+		SortedSMS = NULL;
+		ret = FALSE;
+		goto out;
 	}
 
 	/* Process messages */
@@ -1466,7 +1521,8 @@ gboolean SMSD_ReadDeleteSMS(GSM_SMSDConfig *Config)
 		error = SMSD_ProcessSMS(Config, SortedSMS[i]);
 		if (error != ERR_NONE) {
 			SMSD_LogError(DEBUG_INFO, Config, "Error processing SMS", error);
-			return FALSE;
+			ret = FALSE;
+			break;
 		}
 
 		/* Delete processed messages */
@@ -1479,16 +1535,31 @@ gboolean SMSD_ReadDeleteSMS(GSM_SMSDConfig *Config)
 					break;
 				default:
 					SMSD_LogError(DEBUG_INFO, Config, "Error deleting SMS", error);
-					return FALSE;
+					ret = FALSE;
+					break;
+			}
+			if (!ret) {
+				break;
 			}
 		}
+		if (!ret) {
+			break;
+		}
 
 cleanup:
 		free(SortedSMS[i]);
 		SortedSMS[i] = NULL;
 	}
+
+	/* Linked messages not processed due to error */
+	for (; SortedSMS[i] != NULL; i++) {
+		free(SortedSMS[i]);
+	}
 	free(SortedSMS);
-	return TRUE;
+out:
+	free(GetSMSData);
+	SMSD_PoolFree(&pool);
+	return ret;
 }
 
 /**
@@ -1553,38 +1624,86 @@ void SMSD_PhoneStatus(GSM_SMSDConfig *Config) {
 }
 
 /**
- * Sends a sms message which is provided by the service backend.
+ * Fetches messages from the service backend into the send queue.
+ *
+ * \return ERR_EMPTY or ERR_NOTSUPPORTED if there is nothing to send.
  */
-GSM_Error SMSD_SendSMS(GSM_SMSDConfig *Config)
+GSM_Error SMSD_FillSendQueue(GSM_SMSDConfig *Config)
 {
-	GSM_MultiSMSMessage  	sms;
-	GSM_DateTime         	Date;
-	GSM_Error            	error;
-	unsigned int         	j;
-	int			i, z;
+	SMSD_QueuedSMS		*entry, *shrunk;
+	GSM_Error            	error = ERR_NONE;
+	int			i;
+
+	while (!SMSD_SchedulerFull(Config) && !Config->shutdown) {
+		entry = (SMSD_QueuedSMS *)malloc(sizeof(SMSD_QueuedSMS));
+		if (entry == NULL) {
+			SMSD_Log(DEBUG_ERROR, Config, "Failed to allocate memory");
+			return ERR_MOREMEMORY;
+		}
 
-	/* Clean structure before use */
-	for (i = 0; i < GSM_MAX_MULTI_SMS; i++) {
-		GSM_SetDefaultSMSData(&sms.SMS[i]);
-	}
+		/* Clean structure before use, backends set up parts they fill */
+		entry->SMS.Number = 0;
+		GSM_SetDefaultSMSData(&entry->SMS.SMS[0]);
+		entry->ID[0] = 0;
+		Config->currpriority = SMSD_DEFAULT_PRIORITY;
 
-	error = Config->Service->FindOutboxSMS(&sms, Config, Config->SMSID);
+		error = Config->Service->FindOutboxSMS(&entry->SMS, Config, entry->ID);
 
-	if (error == ERR_EMPTY || error == ERR_NOTSUPPORTED) {
-		/* No outbox sms */
-		return error;
-	}
-	if (error != ERR_NONE) {
-		/* Unknown error - escape */
-		SMSD_Log(DEBUG_INFO, Config, "Error in outbox on '%s'", Config->SMSID);
-		for (i = 0; i < sms.Number; i++) {
-			Config->Status->Failed++;
-			Config->Service->AddSentSMSInfo(&sms, Config, Config->SMSID, i+1, SMSD_SEND_ERROR, -1);
+		if (error == ERR_EMPTY || error == ERR_NOTSUPPORTED) {
+			/* No outbox sms */
+			free(entry);
+			break;
+		}
+		if (error != ERR_NONE) {
+			/* Unknown error - escape */
+			SMSD_Log(DEBUG_INFO, Config, "Error in outbox on '%s'", entry->ID);
+			for (i = 0; i < entry->SMS.Number; i++) {
+				Config->Status->Failed++;
+				Config->Service->AddSentSMSInfo(&entry->SMS, Config, entry->ID, i+1, SMSD_SEND_ERROR, -1);
+			}
+			Config->Service->MoveSMS(&entry->SMS, Config, entry->ID, TRUE, FALSE);
+			free(entry);
+			return error;
+		}
+
+		/* Remember per message settings provided by the backend */
+		entry->Priority = Config->currpriority;
+		entry->DeliveryReport = Config->currdeliveryreport;
+		entry->RelativeValidity = Config->relativevalidity;
+
+		/* Keep only used parts while the message waits in the queue */
+		shrunk = (SMSD_QueuedSMS *)realloc(entry, SMSD_QUEUEDSMS_SIZE(entry->SMS.Number > 0 ? entry->SMS.Number : 1));
+		if (shrunk != NULL) {
+			entry = shrunk;
+		}
+
+		if (SMSD_SchedulerAdd(Config, entry) != ERR_NONE) {
+			/* Backend returned message we already have, there is nothing more */
+			free(entry);
+			break;
 		}
-		Config->Service->MoveSMS(&sms,Config, Config->SMSID, TRUE,FALSE);
-		return error;
 	}
 
+	if (Config->SendQueueUsed == 0) {
+		return (error == ERR_NONE) ? ERR_EMPTY : error;
+	}
+	return ERR_NONE;
+}
+
+/**
+ * Sends full copy of queued message.
+ */
+static GSM_Error SMSD_SendMultiSMS(GSM_SMSDConfig *Config, SMSD_QueuedSMS *entry, GSM_MultiSMSMessage *sms)
+{
+	GSM_DateTime         	Date;
+	GSM_Error            	error;
+	unsigned int         	j;
+	int			i, z;
+
+	strcpy(Config->SMSID, entry->ID);
+	Config->currdeliveryreport = entry->DeliveryReport;
+	Config->relativevalidity = entry->RelativeValidity;
+
 	if (Config->shutdown) {
 		return ERR_NONE;
 	}
@@ -1596,11 +1715,11 @@ GSM_Error SMSD_SendSMS(GSM_SMSDConfig *Config)
 			Config->retries = 0;
 			strcpy(Config->prevSMSID, "");
 			SMSD_Log(DEBUG_INFO, Config, "Moved to errorbox: %s", Config->SMSID);
-			for (i=0;i<sms.Number;i++) {
+			for (i=0;i<sms->Number;i++) {
 				Config->Status->Failed++;
-				Config->Service->AddSentSMSInfo(&sms, Config, Config->SMSID, i+1, SMSD_SEND_ERROR, -1);
+				Config->Service->AddSentSMSInfo(sms, Config, Config->SMSID, i+1, SMSD_SEND_ERROR, -1);
 			}
-			Config->Service->MoveSMS(&sms,Config, Config->SMSID, TRUE,FALSE);
+			Config->Service->MoveSMS(sms,Config, Config->SMSID, TRUE,FALSE);
 			return ERR_UNKNOWN;
 		}
 	} else {
@@ -1609,24 +1728,24 @@ GSM_Error SMSD_SendSMS(GSM_SMSDConfig *Config)
 		strcpy(Config->prevSMSID, Config->SMSID);
 	}
 
-	for (i = 0; i < sms.Number; i++) {
-		if (sms.SMS[i].SMSC.Location == 0 && UnicodeLength(sms.SMS[i].SMSC.Number) == 0 && Config->SMSC.Location == 0) {
+	for (i = 0; i < sms->Number; i++) {
+		if (sms->SMS[i].SMSC.Location == 0 && UnicodeLength(sms->SMS[i].SMSC.Number) == 0 && Config->SMSC.Location == 0) {
 			SMSD_Log(DEBUG_INFO, Config, "Message without SMSC, using configured one");
-			memcpy(&sms.SMS[i].SMSC,&Config->SMSC,sizeof(GSM_SMSC));
-			sms.SMS[i].SMSC.Location = 0;
+			memcpy(&sms->SMS[i].SMSC,&Config->SMSC,sizeof(GSM_SMSC));
+			sms->SMS[i].SMSC.Location = 0;
 			if (Config->relativevalidity != -1) {
-				sms.SMS[i].SMSC.Validity.Format	  = SMS_Validity_RelativeFormat;
-				sms.SMS[i].SMSC.Validity.Relative = Config->relativevalidity;
+				sms->SMS[i].SMSC.Validity.Format	  = SMS_Validity_RelativeFormat;
+				sms->SMS[i].SMSC.Validity.Relative = Config->relativevalidity;
 			}
 
 		}
-		if (sms.SMS[i].SMSC.Location == 0 && UnicodeLength(sms.SMS[i].SMSC.Number) == 0) {
+		if (sms->SMS[i].SMSC.Location == 0 && UnicodeLength(sms->SMS[i].SMSC.Number) == 0) {
 			SMSD_Log(DEBUG_INFO, Config, "Message without SMSC, assuming you want to use the one from phone");
-			sms.SMS[i].SMSC.Location = 1;
+			sms->SMS[i].SMSC.Location = 1;
 		}
-		if (sms.SMS[i].SMSC.Location != 0) {
-			if (Config->SMSCCache.Location != sms.SMS[i].SMSC.Location) {
-				Config->SMSCCache.Location = sms.SMS[i].SMSC.Location;
+		if (sms->SMS[i].SMSC.Location != 0) {
+			if (Config->SMSCCache.Location != sms->SMS[i].SMSC.Location) {
+				Config->SMSCCache.Location = sms->SMS[i].SMSC.Location;
 				error = GSM_GetSMSC(Config->gsm,&Config->SMSCCache);
 				if (error!=ERR_NONE) {
 					SMSD_Log(DEBUG_ERROR, Config, "Error getting SMSC from phone");
@@ -1634,24 +1753,24 @@ GSM_Error SMSD_SendSMS(GSM_SMSDConfig *Config)
 				}
 
 			}
-			memcpy(&sms.SMS[i].SMSC,&Config->SMSCCache,sizeof(GSM_SMSC));
-			sms.SMS[i].SMSC.Location = 0;
+			memcpy(&sms->SMS[i].SMSC,&Config->SMSCCache,sizeof(GSM_SMSC));
+			sms->SMS[i].SMSC.Location = 0;
 			if (Config->relativevalidity != -1) {
-				sms.SMS[i].SMSC.Validity.Format	  = SMS_Validity_RelativeFormat;
-				sms.SMS[i].SMSC.Validity.Relative = Config->relativevalidity;
+				sms->SMS[i].SMSC.Validity.Format	  = SMS_Validity_RelativeFormat;
+				sms->SMS[i].SMSC.Validity.Relative = Config->relativevalidity;
 			}
 		}
 
 		if (Config->currdeliveryreport == 1) {
-			sms.SMS[i].PDU = SMS_Status_Report;
+			sms->SMS[i].PDU = SMS_Status_Report;
 		} else if (Config->currdeliveryreport == -1 && strcmp(Config->deliveryreport, "no") != 0) {
-			sms.SMS[i].PDU = SMS_Status_Report;
+			sms->SMS[i].PDU = SMS_Status_Report;
 		}
 
 		SMSD_PhoneStatus(Config);
 		Config->TPMR = -1;
 		Config->SendingSMSStatus = ERR_TIMEOUT;
-		error = GSM_SendSMS(Config->gsm, &sms.SMS[i]);
+		error = GSM_SendSMS(Config->gsm, &sms->SMS[i]);
 		if (error != ERR_NONE) {
 			SMSD_LogError(DEBUG_INFO, Config, "Error sending SMS", error);
 			Config->TPMR = -1;
@@ -1685,16 +1804,16 @@ GSM_Error SMSD_SendSMS(GSM_SMSDConfig *Config)
 			goto failure_unsent;
 		}
 		Config->Status->Sent++;
-		error = Config->Service->AddSentSMSInfo(&sms, Config, Config->SMSID, i+1, SMSD_SEND_OK, Config->TPMR);
+		error = Config->Service->AddSentSMSInfo(sms, Config, Config->SMSID, i+1, SMSD_SEND_OK, Config->TPMR);
 		if (error != ERR_NONE) {
 			goto failure_sent;
 		}
 	}
 	strcpy(Config->prevSMSID, "");
-	error = Config->Service->MoveSMS(&sms,Config, Config->SMSID, FALSE, TRUE);
+	error = Config->Service->MoveSMS(sms,Config, Config->SMSID, FALSE, TRUE);
 	if (error != ERR_NONE) {
 		SMSD_LogError(DEBUG_ERROR, Config, "Error moving message", error);
-		Config->Service->MoveSMS(&sms,Config, Config->SMSID, TRUE, FALSE);
+		Config->Service->MoveSMS(sms,Config, Config->SMSID, TRUE, FALSE);
 	}
 	return ERR_NONE;
 failure_unsent:
@@ -1702,16 +1821,36 @@ failure_unsent:
 		SMSD_RunOn(Config->RunOnFailure, NULL, Config, Config->SMSID);
 	}
 	Config->Status->Failed++;
-	Config->Service->AddSentSMSInfo(&sms, Config, Config->SMSID, i + 1, SMSD_SEND_SENDING_ERROR, Config->TPMR);
-	Config->Service->MoveSMS(&sms,Config, Config->SMSID, TRUE, FALSE);
+	Config->Service->AddSentSMSInfo(sms, Config, Config->SMSID, i + 1, SMSD_SEND_SENDING_ERROR, Config->TPMR);
+	Config->Service->MoveSMS(sms,Config, Config->SMSID, TRUE, FALSE);
 	return ERR_UNKNOWN;
 failure_sent:
-	if (Config->Service->MoveSMS(&sms,Config, Config->SMSID, FALSE, TRUE) != ERR_NONE) {
-		Config->Service->MoveSMS(&sms,Config, Config->SMSID, TRUE, FALSE);
+	if (Config->Service->MoveSMS(sms,Config, Config->SMSID, FALSE, TRUE) != ERR_NONE) {
+		Config->Service->MoveSMS(sms,Config, Config->SMSID, TRUE, FALSE);
 	}
 	return ERR_UNKNOWN;
 }
 
+/**
+ * Sends a sms message which was chosen by the scheduler.
+ *
+ * Queued message holds only used parts, backends get full copy of it.
+ */
+GSM_Error SMSD_SendSMS(GSM_SMSDConfig *Config, SMSD_QueuedSMS *entry)
+{
+	GSM_MultiSMSMessage	*sms;
+	GSM_Error		error;
+
+	sms = SMSD_ExpandSMS(&entry->SMS);
+	if (sms == NULL) {
+		SMSD_Log(DEBUG_ERROR, Config, "Failed to allocate memory");
+		return ERR_MOREMEMORY;
+	}
+	error = SMSD_SendMultiSMS(Config, entry, sms);
+	free(sms);
+	return error;
+}
+
 /**
  * Initializes shared memory segment, writable if asked for it.
  */
@@ -1854,9 +1993,9 @@ GSM_Error SMSD_MainLoop(GSM_SMSDConfig *Config, gboolean exit_on_failure, int ma
 {
 	GSM_Error		error;
 	int                     errors = -1, initerrors=0;
- 	time_t			lastreceive = 0, lastreset = time(NULL), lasthardreset = time(NULL), lastnothingsent = 0, laststatus = 0;
-	time_t			lastloop = 0, current_time;
-	int i;
+	SMSD_Time		now, wait, deadline, receiveinterval, loopinterval, pollinterval;
+	SMSD_QueuedSMS		*entry;
+	int sendwait = 0;
 	gboolean first_start = TRUE, force_reset = FALSE, force_hard_reset = FALSE;
 
 	Config->failure = ERR_NONE;
@@ -1875,12 +2014,44 @@ GSM_Error SMSD_MainLoop(GSM_SMSDConfig *Config, gboolean exit_on_failure, int ma
 		goto done;
 	}
 
+	/* Init wakeup channel */
+	error = SMSD_WakeupInit(Config);
+	if (error != ERR_NONE) {
+		goto done;
+	}
+
+	/* Schedule periodic tasks, receiving and sending start right away */
+	loopinterval = 1000 * (SMSD_Time)Config->loopsleep;
+	receiveinterval = 1000 * (SMSD_Time)Config->receivefrequency;
+	if (receiveinterval < loopinterval) {
+		receiveinterval = loopinterval;
+	}
+	pollinterval = 1000 * (SMSD_Time)Config->commtimeout;
+	if (pollinterval < loopinterval) {
+		pollinterval = loopinterval;
+	}
+	now = SMSD_Now();
+	if (Config->enable_receive) {
+		SMSD_TimerFire(Config, SMSD_TIMER_RECEIVE);
+	}
+	if (Config->enable_send) {
+		SMSD_TimerFire(Config, SMSD_TIMER_SEND);
+	}
+	if (Config->statusfrequency > 0) {
+		SMSD_TimerFire(Config, SMSD_TIMER_STATUS);
+	}
+	if (Config->resetfrequency > 0) {
+		SMSD_TimerSet(Config, SMSD_TIMER_RESET, now, 1000 * (SMSD_Time)Config->resetfrequency);
+	}
+	if (Config->hardresetfrequency > 0) {
+		SMSD_TimerSet(Config, SMSD_TIMER_HARDRESET, now, 1000 * (SMSD_Time)Config->hardresetfrequency);
+	}
+
 	Config->running = TRUE;
 
 	Config->SendingSMSStatus = ERR_NONE;
 
 	while (!Config->shutdown) {
-		lastloop = time(NULL);
 		/* There were errors in communication - try to recover */
 		if (errors > 2 || first_start || force_reset || force_hard_reset) {
 			/* Should we disconnect from phone? */
@@ -1900,10 +2071,9 @@ GSM_Error SMSD_MainLoop(GSM_SMSDConfig *Config, gboolean exit_on_failure, int ma
 			if (initerrors++ > 3) {
 				SMSD_Log(DEBUG_INFO, Config, "Going to 30 seconds sleep because of too much connection errors");
 
-				for (i = 0; i < 60; i++) {
-					if (Config->shutdown)
-						break;
-					usleep(500000);
+				deadline = SMSD_Now() + 30000;
+				while (!Config->shutdown && (now = SMSD_Now()) < deadline) {
+					SMSD_WaitEvent(Config, deadline - now);
 				}
 			}
 			SMSD_Log(DEBUG_INFO, Config, "Starting phone communication...");
@@ -1951,14 +2121,22 @@ GSM_Error SMSD_MainLoop(GSM_SMSDConfig *Config, gboolean exit_on_failure, int ma
 				if (initerrors > 3 || force_reset ) {
 					error = GSM_Reset(Config->gsm, FALSE); /* soft reset */
 					SMSD_LogError(DEBUG_INFO, Config, "Soft reset return code", error);
-					lastreset = time(NULL);
+					if (Config->resetfrequency > 0) {
+						SMSD_TimerSet(Config, SMSD_TIMER_RESET, SMSD_Now(), 1000 * (SMSD_Time)Config->resetfrequency);
+					} else {
+						SMSD_TimerStop(Config, SMSD_TIMER_RESET);
+					}
 					sleep(5);
 					force_reset = FALSE;
 				}
 				if (force_hard_reset) {
 					error = GSM_Reset(Config->gsm, TRUE); /* hard reset */
 					SMSD_LogError(DEBUG_INFO, Config, "Hard reset return code", error);
-					lasthardreset = time(NULL);
+					if (Config->hardresetfrequency > 0) {
+						SMSD_TimerSet(Config, SMSD_TIMER_HARDRESET, SMSD_Now(), 1000 * (SMSD_Time)Config->hardresetfrequency);
+					} else {
+						SMSD_TimerStop(Config, SMSD_TIMER_HARDRESET);
+					}
 					sleep(5);
 					force_hard_reset = FALSE;
 				}
@@ -1976,8 +2154,9 @@ GSM_Error SMSD_MainLoop(GSM_SMSDConfig *Config, gboolean exit_on_failure, int ma
 		}
 
 		/* Should we receive? */
-		if (Config->enable_receive && ((difftime(time(NULL), lastreceive) >= Config->receivefrequency) || (Config->SendingSMSStatus != ERR_NONE))) {
-	 		lastreceive = time(NULL);
+		now = SMSD_Now();
+		if (Config->enable_receive && (SMSD_TimerDue(Config, SMSD_TIMER_RECEIVE, now) || (Config->SendingSMSStatus != ERR_NONE))) {
+			SMSD_TimerSet(Config, SMSD_TIMER_RECEIVE, now, receiveinterval);
 
 			/* Do we need to check security? */
 			if (Config->checksecurity) {
@@ -2004,40 +2183,75 @@ GSM_Error SMSD_MainLoop(GSM_SMSDConfig *Config, gboolean exit_on_failure, int ma
 
 
 		/* time for preventive reset */
-		current_time = time(NULL);
-		if (Config->resetfrequency > 0 && difftime(current_time, lastreset) >= Config->resetfrequency) {
+		now = SMSD_Now();
+		if (SMSD_TimerDue(Config, SMSD_TIMER_RESET, now)) {
 			force_reset = TRUE;
 			continue;
 		}
-		if (Config->hardresetfrequency > 0 && difftime(current_time, lasthardreset) >= Config->hardresetfrequency) {
+		if (SMSD_TimerDue(Config, SMSD_TIMER_HARDRESET, now)) {
 			force_hard_reset = TRUE;
 			continue;
 		}
 
 		/* Send any queued messages */
-		current_time = time(NULL);
-		if (Config->enable_send && (difftime(current_time, lastnothingsent) >= Config->commtimeout)) {
-			error = SMSD_SendSMS(Config);
+		if (Config->enable_send && SMSD_TimerDue(Config, SMSD_TIMER_SEND, now)) {
+			SMSD_SchedulerExpire(Config, time(NULL));
+			error = SMSD_FillSendQueue(Config);
 			if (error == ERR_EMPTY) {
-				lastnothingsent = current_time;
+				/* Nothing to send, poll outbox again after timeout */
+				SMSD_TimerSet(Config, SMSD_TIMER_SEND, now, pollinterval);
+			} else {
+				entry = SMSD_SchedulerNext(Config, time(NULL), &sendwait);
+				if (entry != NULL) {
+					SMSD_SendSMS(Config, entry);
+					free(entry);
+					/* There might be more messages waiting */
+					SMSD_TimerFire(Config, SMSD_TIMER_SEND);
+				} else if (sendwait > 0) {
+					/* Wake up when rate limit allows next message */
+					SMSD_TimerSet(Config, SMSD_TIMER_SEND, SMSD_Now(), 1000 * (SMSD_Time)sendwait);
+				} else {
+					/* Backend failure, try again later */
+					SMSD_TimerSet(Config, SMSD_TIMER_SEND, now, loopinterval);
+				}
 			}
 			/* We don't care about other errors here, they are handled in SMSD_SendSMS */
 		}
 
 		/* Refresh phone status in shared memory and in service */
-		current_time = time(NULL);
-		if ((Config->statusfrequency > 0) && (difftime(current_time, laststatus) >= Config->statusfrequency)) {
+		now = SMSD_Now();
+		if (SMSD_TimerDue(Config, SMSD_TIMER_STATUS, now)) {
 			SMSD_PhoneStatus(Config);
-			laststatus = current_time;
+			SMSD_TimerSet(Config, SMSD_TIMER_STATUS, now, 1000 * (SMSD_Time)Config->statusfrequency);
 			Config->Service->RefreshPhoneStatus(Config);
 		}
 
-		/* Sleep some time before another loop */
-		current_time = time(NULL);
-		if (Config->loopsleep == 1) {
-			sleep(1);
-		} else if (difftime(current_time, lastloop) < Config->loopsleep) {
-			sleep(Config->loopsleep - difftime(current_time, lastloop));
+		/* Wait for next due timer, data from phone or wakeup */
+		if (Config->shutdown) {
+			break;
+		}
+		now = SMSD_Now();
+		wait = SMSD_TimerNext(Config, now, SMSD_MAX_WAIT);
+		if (wait == 0) {
+			continue;
+		}
+		switch (SMSD_WaitEvent(Config, wait)) {
+			case SMSD_EVENT_DEVICE:
+				/* Unsolicited data from phone usually mean incoming message */
+				if (GSM_ReadDevice(Config->gsm, FALSE) <= 0) {
+					errors++;
+				} else if (Config->enable_receive) {
+					SMSD_TimerFire(Config, SMSD_TIMER_RECEIVE);
+				}
+				break;
+			case SMSD_EVENT_WAKEUP:
+				/* Something was put to outbox */
+				if (Config->enable_send) {
+					SMSD_TimerFire(Config, SMSD_TIMER_SEND);
+				}
+				break;
+			case SMSD_EVENT_TIMEOUT:
+				break;
 		}
 	}
 	Config->Service->Free(Config);
@@ -2070,6 +2284,51 @@ GSM_Error SMSD_InjectSMS(GSM_SMSDConfig		*Config, GSM_MultiSMSMessage *sms, char
 
 	/* Store message in outbox */
 	error = Config->Service->CreateOutboxSMS(sms, Config, NewID);
+	if (error == ERR_NONE) {
+		/* Let main loop know, either in this process or in the daemon */
+		SMSD_Wakeup(Config);
+		SMSD_WakeupDaemon(Config);
+	}
+	return error;
+}
+
+/**
+ * Function to inject several messages to service backend at once.
+ */
+GSM_Error SMSD_InjectSMSBatch(GSM_SMSDConfig *Config, GSM_MultiSMSMessage *sms, size_t count, size_t *injected)
+{
+	GSM_Error error;
+	size_t done = 0;
+
+	if (injected != NULL) {
+		*injected = 0;
+	}
+
+	/* Initialize service */
+	error = SMSD_Init(Config);
+	if (error != ERR_NONE) {
+		return error;
+	}
+
+	/* Store messages in outbox */
+	error = Config->Service->CreateOutboxSMSBatch(sms, count, Config, &done);
+	if (error == ERR_NOTSUPPORTED) {
+		/* Backend can store messages only one by one */
+		for (done = 0; done < count; done++) {
+			error = Config->Service->CreateOutboxSMS(&sms[done], Config, NULL);
+			if (error != ERR_NONE) {
+				break;
+			}
+		}
+	}
+
+	if (injected != NULL) {
+		*injected = done;
+	}
+	if (done > 0) {
+		SMSD_Wakeup(Config);
+		SMSD_WakeupDaemon(Config);
+	}
 	return error;
 }
 
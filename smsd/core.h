@@ -20,6 +20,9 @@
 #define SMSD_DB_VERSION (14)
 
 #include "log.h"
+#include "msgpool.h"
+#include "scheduler.h"
+#include "eventloop.h"
 
 #include "../helper/array.h"
 
@@ -67,6 +70,21 @@ typedef struct {
 	 * Reads configuration specific for this backend.
 	 */
 	GSM_Error	(*ReadConfiguration) (GSM_SMSDConfig *Config);
+	/**
+	 * Returns descriptor which becomes readable when outbox changes.
+	 */
+	GSM_Error	(*GetNotifyDescriptor) (GSM_SMSDConfig *Config, int *fd);
+	/**
+	 * Consumes pending outbox notifications.
+	 *
+	 * \return ERR_NONE if outbox has changed, ERR_EMPTY otherwise.
+	 */
+	GSM_Error	(*ReadNotify)         (GSM_SMSDConfig *Config);
+	/**
+	 * Stores several messages in outbox at once, ideally in single
+	 * transaction. Number of stored messages is written to done.
+	 */
+	GSM_Error	(*CreateOutboxSMSBatch) (GSM_MultiSMSMessage *sms, size_t count, GSM_SMSDConfig *Config, size_t *done);
 } GSM_SMSDService;
 
 struct _GSM_SMSDConfig {
@@ -85,6 +103,7 @@ struct _GSM_SMSDConfig {
 	const char	*PhoneID;
 	const char   *RunOnReceive;
 	const char   *RunOnFailure; /* run this command on phone communication failure */
+	const char   *wakeupfifo; /* fifo used to wake up daemon on new message */
 	gboolean checksecurity;
 	gboolean hangupcalls;
 	gboolean checkbattery;
@@ -102,6 +121,11 @@ struct _GSM_SMSDConfig {
 	int		relativevalidity;
 	unsigned int 	retries;
 	int		currdeliveryreport;
+	/**
+	 * Priority of message returned by FindOutboxSMS, lower is more
+	 * urgent, see SMSD_DEFAULT_PRIORITY.
+	 */
+	int		currpriority;
 	unsigned char 	SMSID[200],	 prevSMSID[200];
 	GSM_SMSC	SMSC, SMSCCache;
 	const char	*skipsmscnumber;
@@ -140,11 +164,23 @@ struct _GSM_SMSDConfig {
 	 * Address of the database (eg. hostname).
 	 */
 	const char	*host;
+	/**
+	 * PostgreSQL channel to listen on for outbox changes.
+	 */
+	const char	*notifychannel;
+	/**
+	 * Whether we're listening on notifychannel on current connection.
+	 */
+	gboolean	listening;
         char 		DT[40];
 	char		CreatorID[200];
 	/* database data structure */
 	struct GSM_SMSDdbobj *db;
 	SQL_conn conn;
+	/**
+	 * Whether transaction is open, reconnecting would silently lose it.
+	 */
+	gboolean in_transaction;
 	/* configurable SQL queries */
 	char * SMSDSQL_queries[SQL_QUERY_LAST_NO];
 #endif
@@ -185,6 +221,27 @@ struct _GSM_SMSDConfig {
 	 */
 	volatile int TPMR;
 
+	/**
+	 * Send scheduler, see scheduler.h.
+	 */
+	unsigned int sendqueuesize;
+	SMSD_QueuedSMS **SendQueue;
+	size_t SendQueueUsed;
+	SMSD_RateLimit ModemRateLimit;
+	SMSD_RateLimit *RateLimits;
+	size_t RateLimitsCount;
+
+	/**
+	 * Main loop timers and wakeup channel, see eventloop.h.
+	 */
+	SMSD_Timer Timers[SMSD_TIMER_LAST];
+#ifdef WIN32
+	HANDLE WakeupEvent;
+#else
+	int WakeupPipe[2];
+	int WakeupFifo;
+#endif
+
 	/**
 	 * Multipart messages processing.
 	 */
@@ -214,6 +271,13 @@ extern GSM_Error SMSD_NotSupportedFunction	(void);
 #define NOTIMPLEMENTED 	(void *) SMSD_NotImplementedFunction
 #define NOTSUPPORTED 	(void *) SMSD_NotSupportedFunction
 
+/**
+ * Fetches messages from the service backend into the send queue.
+ *
+ * \return ERR_EMPTY or ERR_NOTSUPPORTED if there is nothing to send.
+ */
+GSM_Error SMSD_FillSendQueue(GSM_SMSDConfig *Config);
+
 /**
  * Checks whether database version is up to date.
  */
@@ -0,0 +1,317 @@
+/**
+ * SMSD event loop helpers.
+ *
+ * Timers are kept in a small fixed table indexed by task, the main loop
+ * sleeps until the nearest one expires unless it is woken up earlier by
+ * the phone, by the service backend or by a wakeup request.
+ */
+
+#include <gammu-config.h>
+
+#include <time.h>
+#include <errno.h>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#endif
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <gammu.h>
+
+#include "core.h"
+#include "eventloop.h"
+
+SMSD_Time SMSD_Now(void)
+{
+#ifdef WIN32
+	/* GetTickCount wraps around after 49.7 days */
+	static DWORD last = 0;
+	static SMSD_Time high = 0;
+	DWORD ticks;
+
+	ticks = GetTickCount();
+	if (ticks < last) {
+		high += 0x100000000ULL;
+	}
+	last = ticks;
+	return high + ticks;
+#elif defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+		return (SMSD_Time)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+	}
+	return (SMSD_Time)time(NULL) * 1000;
+#else
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return (SMSD_Time)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+#endif
+}
+
+void SMSD_TimerSet(GSM_SMSDConfig *Config, SMSD_TimerID timer, SMSD_Time now, SMSD_Time msec)
+{
+	Config->Timers[timer].Armed = TRUE;
+	Config->Timers[timer].Due = now + msec;
+}
+
+void SMSD_TimerFire(GSM_SMSDConfig *Config, SMSD_TimerID timer)
+{
+	Config->Timers[timer].Armed = TRUE;
+	Config->Timers[timer].Due = 0;
+}
+
+void SMSD_TimerStop(GSM_SMSDConfig *Config, SMSD_TimerID timer)
+{
+	Config->Timers[timer].Armed = FALSE;
+}
+
+gboolean SMSD_TimerDue(GSM_SMSDConfig *Config, SMSD_TimerID timer, SMSD_Time now)
+{
+	return Config->Timers[timer].Armed && Config->Timers[timer].Due <= now;
+}
+
+SMSD_Time SMSD_TimerNext(GSM_SMSDConfig *Config, SMSD_Time now, SMSD_Time max)
+{
+	int i;
+	SMSD_Time result = max;
+
+	for (i = 0; i < SMSD_TIMER_LAST; i++) {
+		if (!Config->Timers[i].Armed) {
+			continue;
+		}
+		if (Config->Timers[i].Due <= now) {
+			return 0;
+		}
+		if (Config->Timers[i].Due - now < result) {
+			result = Config->Timers[i].Due - now;
+		}
+	}
+	return result;
+}
+
+GSM_Error SMSD_WakeupInit(GSM_SMSDConfig *Config)
+{
+#ifdef WIN32
+	if (Config->WakeupEvent == NULL) {
+		Config->WakeupEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+		if (Config->WakeupEvent == NULL) {
+			SMSD_Log(DEBUG_ERROR, Config, "Failed to create wakeup event!");
+			return ERR_UNKNOWN;
+		}
+	}
+#else
+	int i;
+
+	if (Config->WakeupPipe[0] != -1) {
+		return ERR_NONE;
+	}
+	if (pipe(Config->WakeupPipe) != 0) {
+		SMSD_LogErrno(Config, "Failed to create wakeup pipe");
+		Config->WakeupPipe[0] = -1;
+		Config->WakeupPipe[1] = -1;
+		return ERR_UNKNOWN;
+	}
+	for (i = 0; i < 2; i++) {
+		fcntl(Config->WakeupPipe[i], F_SETFL, fcntl(Config->WakeupPipe[i], F_GETFL) | O_NONBLOCK);
+		fcntl(Config->WakeupPipe[i], F_SETFD, FD_CLOEXEC);
+	}
+
+	if (Config->wakeupfifo != NULL) {
+#ifdef HAVE_MKFIFO
+		if (mkfifo(Config->wakeupfifo, 0660) != 0 && errno != EEXIST) {
+			SMSD_LogErrno(Config, "Failed to create wakeup fifo");
+			return ERR_UNKNOWN;
+		}
+#endif
+		/* Opening for writing as well avoids endless EOF once a writer closes it */
+		Config->WakeupFifo = open(Config->wakeupfifo, O_RDWR | O_NONBLOCK);
+		if (Config->WakeupFifo == -1) {
+			SMSD_LogErrno(Config, "Failed to open wakeup fifo");
+			return ERR_UNKNOWN;
+		}
+		fcntl(Config->WakeupFifo, F_SETFD, FD_CLOEXEC);
+		SMSD_Log(DEBUG_INFO, Config, "Waiting for wakeups on %s", Config->wakeupfifo);
+	}
+#endif
+	return ERR_NONE;
+}
+
+void SMSD_WakeupFree(GSM_SMSDConfig *Config)
+{
+#ifdef WIN32
+	if (Config->WakeupEvent != NULL) {
+		CloseHandle(Config->WakeupEvent);
+		Config->WakeupEvent = NULL;
+	}
+#else
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		if (Config->WakeupPipe[i] != -1) {
+			close(Config->WakeupPipe[i]);
+			Config->WakeupPipe[i] = -1;
+		}
+	}
+	if (Config->WakeupFifo != -1) {
+		close(Config->WakeupFifo);
+		Config->WakeupFifo = -1;
+	}
+#endif
+}
+
+void SMSD_Wakeup(GSM_SMSDConfig *Config)
+{
+#ifdef WIN32
+	if (Config->WakeupEvent != NULL) {
+		SetEvent(Config->WakeupEvent);
+	}
+#else
+	char c = 0;
+	int saved_errno = errno;
+
+	/* Pipe full means there is already pending wakeup */
+	if (Config->WakeupPipe[1] != -1 && write(Config->WakeupPipe[1], &c, 1) < 0) {
+		errno = saved_errno;
+	}
+#endif
+}
+
+void SMSD_WakeupDaemon(GSM_SMSDConfig *Config)
+{
+#ifndef WIN32
+	int fd;
+	char c = 0;
+
+	if (Config->wakeupfifo == NULL) {
+		return;
+	}
+	/* Fails with ENXIO when daemon is not running */
+	fd = open(Config->wakeupfifo, O_WRONLY | O_NONBLOCK);
+	if (fd == -1) {
+		SMSD_Log(DEBUG_NOTICE, Config, "Could not open wakeup fifo %s, daemon is probably not running", Config->wakeupfifo);
+		return;
+	}
+	if (write(fd, &c, 1) != 1) {
+		SMSD_Log(DEBUG_NOTICE, Config, "Could not write to wakeup fifo %s", Config->wakeupfifo);
+	}
+	close(fd);
+#endif
+}
+
+#ifndef WIN32
+/**
+ * Returns descriptor on which service backend signals outbox changes, -1
+ * if there is none.
+ */
+static int SMSD_ServiceDescriptor(GSM_SMSDConfig *Config)
+{
+	int fd = -1;
+
+	if (Config->Service == NULL || !Config->connected) {
+		return -1;
+	}
+	if (Config->Service->GetNotifyDescriptor(Config, &fd) != ERR_NONE) {
+		return -1;
+	}
+	return fd;
+}
+
+/**
+ * Adds descriptor to the set.
+ */
+static void SMSD_AddDescriptor(int fd, fd_set *set, int *maxfd)
+{
+	if (fd < 0 || fd >= FD_SETSIZE) {
+		return;
+	}
+	FD_SET(fd, set);
+	if (fd > *maxfd) {
+		*maxfd = fd;
+	}
+}
+
+/**
+ * Reads all pending data from nonblocking descriptor.
+ */
+static void SMSD_Drain(int fd)
+{
+	char buffer[64];
+
+	while (read(fd, buffer, sizeof(buffer)) > 0);
+}
+#endif
+
+SMSD_Event SMSD_WaitEvent(GSM_SMSDConfig *Config, SMSD_Time msec)
+{
+#ifdef WIN32
+	if (msec >= INFINITE) {
+		msec = INFINITE - 1;
+	}
+	if (Config->WakeupEvent == NULL) {
+		Sleep((DWORD)msec);
+		return SMSD_EVENT_TIMEOUT;
+	}
+	if (WaitForSingleObject(Config->WakeupEvent, (DWORD)msec) == WAIT_OBJECT_0) {
+		return SMSD_EVENT_WAKEUP;
+	}
+	return SMSD_EVENT_TIMEOUT;
+#else
+	fd_set readfds;
+	struct timeval timeout;
+	int device, service, maxfd = -1, ret;
+
+	FD_ZERO(&readfds);
+	device = GSM_GetDeviceDescriptor(Config->gsm);
+	service = SMSD_ServiceDescriptor(Config);
+
+	/* Backend might have received notification while processing query */
+	if (service >= 0 && Config->Service->ReadNotify(Config) == ERR_NONE) {
+		return SMSD_EVENT_WAKEUP;
+	}
+
+	SMSD_AddDescriptor(Config->WakeupPipe[0], &readfds, &maxfd);
+	SMSD_AddDescriptor(Config->WakeupFifo, &readfds, &maxfd);
+	SMSD_AddDescriptor(device, &readfds, &maxfd);
+	SMSD_AddDescriptor(service, &readfds, &maxfd);
+
+	timeout.tv_sec = msec / 1000;
+	timeout.tv_usec = (msec % 1000) * 1000;
+
+	ret = select(maxfd + 1, &readfds, NULL, NULL, &timeout);
+	if (ret <= 0) {
+		/* Timeout or interrupted by signal */
+		return SMSD_EVENT_TIMEOUT;
+	}
+	if (Config->WakeupPipe[0] != -1 && FD_ISSET(Config->WakeupPipe[0], &readfds)) {
+		SMSD_Drain(Config->WakeupPipe[0]);
+		return SMSD_EVENT_WAKEUP;
+	}
+	if (Config->WakeupFifo != -1 && FD_ISSET(Config->WakeupFifo, &readfds)) {
+		SMSD_Drain(Config->WakeupFifo);
+		return SMSD_EVENT_WAKEUP;
+	}
+	if (service >= 0 && service < FD_SETSIZE && FD_ISSET(service, &readfds)) {
+		if (Config->Service->ReadNotify(Config) == ERR_NONE) {
+			return SMSD_EVENT_WAKEUP;
+		}
+	}
+	if (device >= 0 && device < FD_SETSIZE && FD_ISSET(device, &readfds)) {
+		return SMSD_EVENT_DEVICE;
+	}
+	return SMSD_EVENT_TIMEOUT;
+#endif
+}
+
+/* How should editor hadle tabs in this file? Add editor commands here.
+ * vim: noexpandtab sw=8 ts=8 sts=8:
+ */
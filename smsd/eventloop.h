@@ -0,0 +1,133 @@
+/**
+ * SMSD event loop helpers
+ *
+ * Monotonic millisecond timers driving periodic tasks of the main loop
+ * and waiting for the next event: due timer, data from the phone, outbox
+ * notification from the service or an explicit wakeup (signal, shutdown,
+ * new message injected).
+ */
+#ifndef __smsd_eventloop_h__
+#define __smsd_eventloop_h__
+
+#include <gammu.h>
+#include <gammu-smsd.h>
+
+/**
+ * Longest time (in milliseconds) main loop waits when there is no timer
+ * armed.
+ */
+#define SMSD_MAX_WAIT (60000)
+
+/**
+ * Monotonic time in milliseconds.
+ */
+typedef unsigned long long SMSD_Time;
+
+/**
+ * Periodic tasks of the main loop.
+ */
+typedef enum {
+	SMSD_TIMER_RECEIVE = 0,
+	SMSD_TIMER_SEND,
+	SMSD_TIMER_STATUS,
+	SMSD_TIMER_RESET,
+	SMSD_TIMER_HARDRESET,
+	SMSD_TIMER_LAST
+} SMSD_TimerID;
+
+/**
+ * Single timer in the timer table.
+ */
+typedef struct {
+	/**
+	 * Whether timer is active.
+	 */
+	gboolean Armed;
+	/**
+	 * When the timer expires.
+	 */
+	SMSD_Time Due;
+} SMSD_Timer;
+
+/**
+ * Result of waiting for event.
+ */
+typedef enum {
+	/**
+	 * Timeout has expired.
+	 */
+	SMSD_EVENT_TIMEOUT = 0,
+	/**
+	 * Data are waiting on the device.
+	 */
+	SMSD_EVENT_DEVICE,
+	/**
+	 * Loop was woken up by \ref SMSD_Wakeup, \ref SMSD_WakeupDaemon or
+	 * by notification from service backend.
+	 */
+	SMSD_EVENT_WAKEUP
+} SMSD_Event;
+
+/**
+ * Returns current monotonic time.
+ */
+SMSD_Time SMSD_Now(void);
+
+/**
+ * Arms timer to expire after given number of milliseconds.
+ */
+void SMSD_TimerSet(GSM_SMSDConfig *Config, SMSD_TimerID timer, SMSD_Time now, SMSD_Time msec);
+
+/**
+ * Makes timer expire immediately.
+ */
+void SMSD_TimerFire(GSM_SMSDConfig *Config, SMSD_TimerID timer);
+
+/**
+ * Disables timer.
+ */
+void SMSD_TimerStop(GSM_SMSDConfig *Config, SMSD_TimerID timer);
+
+/**
+ * Checks whether timer has expired.
+ */
+gboolean SMSD_TimerDue(GSM_SMSDConfig *Config, SMSD_TimerID timer, SMSD_Time now);
+
+/**
+ * Returns number of milliseconds until first armed timer expires,
+ * limited by max.
+ */
+SMSD_Time SMSD_TimerNext(GSM_SMSDConfig *Config, SMSD_Time now, SMSD_Time max);
+
+/**
+ * Prepares wakeup channel, needs to be called before the loop starts.
+ */
+GSM_Error SMSD_WakeupInit(GSM_SMSDConfig *Config);
+
+/**
+ * Closes wakeup channel.
+ */
+void SMSD_WakeupFree(GSM_SMSDConfig *Config);
+
+/**
+ * Wakes up main loop waiting in \ref SMSD_WaitEvent. This is safe to be
+ * called from signal handler.
+ */
+void SMSD_Wakeup(GSM_SMSDConfig *Config);
+
+/**
+ * Wakes up daemon running in another process using WakeupFifo, does
+ * nothing if it is not configured or nobody is listening.
+ */
+void SMSD_WakeupDaemon(GSM_SMSDConfig *Config);
+
+/**
+ * Waits for some event, at most given number of milliseconds.
+ */
+SMSD_Event SMSD_WaitEvent(GSM_SMSDConfig *Config, SMSD_Time msec);
+
+#endif
+
+/* How should editor hadle tabs in this file? Add editor commands here.
+ * vim: noexpandtab sw=8 ts=8 sts=8:
+ */
@@ -5,10 +5,12 @@
 /* Licensend under GNU GPL 2 */
 
 #include <gammu-smsd.h>
+#include <gammu-unicode.h>
 #include <assert.h>
 #include <stdlib.h>
 #include <signal.h>
 #include <string.h>
+#include <stdio.h>
 #ifndef WIN32
 #include <unistd.h>
 #endif
@@ -25,6 +27,27 @@
 const char default_config[] = "/etc/gammu-smsdrc";
 #endif
 
+/**
+ * Number of messages passed to SMSD_InjectSMSBatch at once.
+ */
+#define INJECT_BATCH_SIZE 32
+
+/**
+ * Maximal length of line in recipients file or record in CSV file,
+ * longer ones are skipped.
+ */
+#define INJECT_LINE_LENGTH 2048
+
+/**
+ * File with list of recipients (--recipients).
+ */
+const char *recipients_file = NULL;
+
+/**
+ * CSV file with recipients and texts (--csv).
+ */
+const char *csv_file = NULL;
+
 NORETURN void version(void)
 {
 	printf("Gammu-smsd-inject version %s\n", GAMMU_VERSION);
@@ -88,6 +111,10 @@ void help(void)
 	print_option("L", "no-use-log", "do not use logging configuration from config file (default)");
 	print_option_param("c", "config", "CONFIG_FILE",
 			   "defines path to config file");
+	print_option_param("r", "recipients", "FILE",
+			   "sends message to all numbers listed in file (- for stdin)");
+	print_option_param("C", "csv", "FILE",
+			   "sends messages from CSV file with number,text lines (- for stdin)");
 	printf("\n");
 	printf("MSGTYPE and it's parameters are described in man page and Gammu documentation\n");
 }
@@ -109,15 +136,17 @@ int process_commandline(int argc, char **argv, SMSD_Parameters * params)
 		{"config", 1, 0, 'c'},
 		{"use-log", 0, 0, 'l'},
 		{"no-use-log", 0, 0, 'L'},
+		{"recipients", 1, 0, 'r'},
+		{"csv", 1, 0, 'C'},
 		{0, 0, 0, 0}
 	};
 	int option_index;
 
 	while ((opt =
-		getopt_long(argc, argv, "+hvc:lL", long_options,
+		getopt_long(argc, argv, "+hvc:lLr:C:", long_options,
 			    &option_index)) != -1) {
 #elif defined(HAVE_GETOPT)
-	while ((opt = getopt(argc, argv, "+hvc:lL")) != -1) {
+	while ((opt = getopt(argc, argv, "+hvc:lLr:C:")) != -1) {
 #else
 	/* Poor mans getopt replacement */
 	int i, optind = -1;
@@ -134,6 +163,12 @@ int process_commandline(int argc, char **argv, SMSD_Parameters * params)
 			case 'c':
 				params->config_file = optarg;
 				break;
+			case 'r':
+				recipients_file = optarg;
+				break;
+			case 'C':
+				csv_file = optarg;
+				break;
 			case 'v':
 				version();
 				break;
@@ -166,13 +201,270 @@ int process_commandline(int argc, char **argv, SMSD_Parameters * params)
 
 }
 
-#ifndef WIN32
-#endif
+/**
+ * Reads single line from file, strips end of line. With quotes set, line
+ * breaks inside double quoted field are kept as part of the line. Line
+ * which does not fit into buffer is read till its end and truncated.
+ *
+ * \param toolong Is set when line did not fit into buffer.
+ *
+ * \return FALSE on end of file.
+ */
+gboolean read_line(FILE *f, char *buffer, size_t size, gboolean quotes, gboolean *toolong)
+{
+	gboolean quoted = FALSE;
+	size_t len = 0;
+	int c;
+
+	*toolong = FALSE;
+	while ((c = fgetc(f)) != EOF) {
+		if (c == '"' && quotes) {
+			quoted = !quoted;
+		} else if (c == '\n' && !quoted) {
+			break;
+		}
+		if (len + 1 < size) {
+			buffer[len++] = c;
+		} else {
+			*toolong = TRUE;
+		}
+	}
+	if (c == EOF && len == 0 && !*toolong) {
+		return FALSE;
+	}
+	while (len > 0 && buffer[len - 1] == '\r') {
+		len--;
+	}
+	buffer[len] = 0;
+	return TRUE;
+}
+
+/**
+ * Checks whether line should be ignored (empty or comment).
+ */
+gboolean skip_line(const char *line)
+{
+	return line[0] == 0 || line[0] == '#';
+}
+
+/**
+ * Opens input file, - means standard input.
+ */
+FILE *open_input(const char *name)
+{
+	FILE *f;
+
+	if (strcmp(name, "-") == 0) {
+		return stdin;
+	}
+	f = fopen(name, "r");
+	if (f == NULL) {
+		fprintf(stderr, "Failed to open %s!\n", name);
+	}
+	return f;
+}
+
+/**
+ * Splits CSV line into number and text. Both fields can be enclosed in
+ * double quotes, double quote inside quoted field is written as "".
+ *
+ * \return FALSE if line does not contain both fields.
+ */
+gboolean parse_csv_line(char *line, char **number, char **text)
+{
+	char *field[2];
+	char *src, *dst;
+	int i;
+
+	src = line;
+	for (i = 0; i < 2; i++) {
+		field[i] = dst = src;
+		if (*src == '"') {
+			src++;
+			while (*src != 0) {
+				if (*src == '"') {
+					if (src[1] != '"') {
+						src++;
+						break;
+					}
+					src++;
+				}
+				*dst++ = *src++;
+			}
+		} else {
+			while (*src != 0 && (i == 1 || *src != ',')) {
+				*dst++ = *src++;
+			}
+		}
+		if (i == 0) {
+			if (*src != ',') {
+				return FALSE;
+			}
+			src++;
+		}
+		*dst = 0;
+	}
+	*number = field[0];
+	*text = field[1];
+	return TRUE;
+}
+
+/**
+ * Sets recipient number in all parts of the message.
+ */
+gboolean set_recipient(GSM_MultiSMSMessage *sms, const char *number)
+{
+	int i;
+
+	if (strlen(number) > GSM_MAX_NUMBER_LENGTH) {
+		fprintf(stderr, "Number too long, skipping: %s\n", number);
+		return FALSE;
+	}
+	for (i = 0; i < sms->Number; i++) {
+		EncodeUnicode(sms->SMS[i].Number, number, strlen(number));
+	}
+	return TRUE;
+}
+
+/**
+ * Injects messages collected in the batch.
+ */
+GSM_Error flush_batch(GSM_SMSDConfig *config, GSM_MultiSMSMessage *batch, size_t *count, long *total)
+{
+	GSM_Error error;
+	size_t done = 0;
+
+	if (*count == 0) {
+		return ERR_NONE;
+	}
+	error = SMSD_InjectSMSBatch(config, batch, *count, &done);
+	*total += done;
+	*count = 0;
+	return error;
+}
+
+/**
+ * Injects messages for all recipients listed in a file (--recipients)
+ * or for all lines of CSV file (--csv).
+ */
+int inject_bulk(GSM_SMSDConfig *config, int argc, int startarg, char **argv)
+{
+	GSM_Error error = ERR_NONE;
+	GSM_Message_Type type = SMS_SMSD;
+	GSM_MultiSMSMessage sms;
+	GSM_MultiSMSMessage *batch;
+	char line[INJECT_LINE_LENGTH];
+	char **csvargv = NULL;
+	char *number, *text;
+	size_t count = 0;
+	long total = 0;
+	gboolean toolong;
+	FILE *f;
+	int i;
+
+	batch = (GSM_MultiSMSMessage *)malloc(INJECT_BATCH_SIZE * sizeof(GSM_MultiSMSMessage));
+	if (batch == NULL) {
+		fprintf(stderr, "Failed to allocate memory!\n");
+		return 1;
+	}
+
+	if (csv_file != NULL) {
+		if (startarg + 1 >= argc) {
+			fprintf(stderr, "Missing recipient placeholder!\n");
+			free(batch);
+			return 1;
+		}
+		/* Copy of command line, recipient and text are filled in for each line */
+		csvargv = (char **)malloc((argc + 3) * sizeof(char *));
+		if (csvargv == NULL) {
+			fprintf(stderr, "Failed to allocate memory!\n");
+			free(batch);
+			return 1;
+		}
+		for (i = 0; i < argc; i++) {
+			csvargv[i] = argv[i];
+		}
+		csvargv[argc] = (char *)"-text";
+		csvargv[argc + 2] = NULL;
+		f = open_input(csv_file);
+	} else {
+		/* Same message for all recipients */
+		error = CreateMessage(&type, &sms, argc, startarg, argv, NULL);
+		if (error != ERR_NONE) {
+			printf("Failed to create message: %s\n",
+			       GSM_ErrorString(error));
+			free(batch);
+			return 1;
+		}
+		f = open_input(recipients_file);
+	}
+	if (f == NULL) {
+		free(csvargv);
+		free(batch);
+		return 1;
+	}
+
+	while (read_line(f, line, sizeof(line), csvargv != NULL, &toolong)) {
+		if (toolong) {
+			fprintf(stderr, "Line too long, skipping: %.40s...\n", line);
+			continue;
+		}
+		if (skip_line(line)) {
+			continue;
+		}
+		if (csvargv != NULL) {
+			if (!parse_csv_line(line, &number, &text)) {
+				fprintf(stderr, "Invalid CSV line, skipping: %s\n", line);
+				continue;
+			}
+			csvargv[startarg + 1] = number;
+			csvargv[argc + 1] = text;
+			error = CreateMessage(&type, &batch[count], argc + 2, startarg, csvargv, NULL);
+			if (error != ERR_NONE) {
+				printf("Failed to create message for %s: %s\n",
+				       number, GSM_ErrorString(error));
+				continue;
+			}
+			if (!set_recipient(&batch[count], number)) {
+				continue;
+			}
+		} else {
+			batch[count] = sms;
+			if (!set_recipient(&batch[count], line)) {
+				continue;
+			}
+		}
+		count++;
+		if (count == INJECT_BATCH_SIZE) {
+			error = flush_batch(config, batch, &count, &total);
+			if (error != ERR_NONE) {
+				break;
+			}
+		}
+	}
+	if (error == ERR_NONE) {
+		error = flush_batch(config, batch, &count, &total);
+	}
+
+	if (f != stdin) {
+		fclose(f);
+	}
+	free(csvargv);
+	free(batch);
+
+	printf("Written %ld messages\n", total);
+	if (error != ERR_NONE) {
+		printf("Failed to inject messages: %s\n",
+		       GSM_ErrorString(error));
+		return 3;
+	}
+	return 0;
+}
 
 int main(int argc, char **argv)
 {
 	GSM_Error error;
-	int startarg;
+	int startarg, ret;
 	GSM_MultiSMSMessage sms;
 	GSM_Message_Type type = SMS_SMSD;
 	GSM_SMSDConfig *config;
@@ -216,11 +508,18 @@ int main(int argc, char **argv)
 #endif
 	}
 
-	error = CreateMessage(&type, &sms, argc, startarg, argv, NULL);
-	if (error != ERR_NONE) {
-		printf("Failed to create message: %s\n",
-		       GSM_ErrorString(error));
-		return 1;
+	if (recipients_file != NULL && csv_file != NULL) {
+		fprintf(stderr, "Options --recipients and --csv can not be combined!\n");
+		exit(1);
+	}
+
+	if (recipients_file == NULL && csv_file == NULL) {
+		error = CreateMessage(&type, &sms, argc, startarg, argv, NULL);
+		if (error != ERR_NONE) {
+			printf("Failed to create message: %s\n",
+			       GSM_ErrorString(error));
+			return 1;
+		}
 	}
 
 	config = SMSD_NewConfig(program_name);
@@ -233,6 +532,12 @@ int main(int argc, char **argv)
 		return 2;
 	}
 
+	if (recipients_file != NULL || csv_file != NULL) {
+		ret = inject_bulk(config, argc, startarg, argv);
+		SMSD_FreeConfig(config);
+		return ret;
+	}
+
 	error = SMSD_InjectSMS(config, &sms, newid);
 	if (error != ERR_NONE) {
 		printf("Failed to inject message: %s\n",
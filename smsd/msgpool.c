@@ -0,0 +1,126 @@
+/**
+ * SMSD message pool.
+ *
+ * Stores truncated copies of multipart messages in large blocks.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "msgpool.h"
+
+/**
+ * Default size of pool block, fits about ten single part messages.
+ */
+#define SMSD_POOL_BLOCK_SIZE (10 * SMSD_MULTISMS_SIZE(1))
+
+/**
+ * Type with strictest alignment we need for stored messages.
+ */
+typedef union {
+	void *p;
+	long l;
+	double d;
+} SMSD_PoolAlign;
+
+#define SMSD_POOL_ROUND(size) \
+	(((size) + sizeof(SMSD_PoolAlign) - 1) / sizeof(SMSD_PoolAlign) * sizeof(SMSD_PoolAlign))
+
+struct _SMSD_PoolBlock {
+	/**
+	 * Previously allocated block.
+	 */
+	SMSD_PoolBlock *Next;
+	/**
+	 * Size of data area.
+	 */
+	size_t Size;
+	/**
+	 * Used size of data area.
+	 */
+	size_t Used;
+	/**
+	 * Data area, it continues after the structure.
+	 */
+	SMSD_PoolAlign Data[1];
+};
+
+void SMSD_PoolInit(SMSD_MessagePool *Pool)
+{
+	Pool->Blocks = NULL;
+}
+
+/**
+ * Allocates memory from the pool.
+ */
+static void *SMSD_PoolAlloc(SMSD_MessagePool *Pool, size_t size)
+{
+	SMSD_PoolBlock *block = Pool->Blocks;
+	size_t blocksize;
+	void *result;
+
+	size = SMSD_POOL_ROUND(size);
+
+	if (block == NULL || block->Size - block->Used < size) {
+		blocksize = SMSD_POOL_BLOCK_SIZE;
+		if (blocksize < size) {
+			blocksize = size;
+		}
+		block = (SMSD_PoolBlock *)malloc(offsetof(SMSD_PoolBlock, Data) + blocksize);
+		if (block == NULL) {
+			return NULL;
+		}
+		block->Size = blocksize;
+		block->Used = 0;
+		block->Next = Pool->Blocks;
+		Pool->Blocks = block;
+	}
+
+	result = (char *)block->Data + block->Used;
+	block->Used += size;
+	return result;
+}
+
+GSM_MultiSMSMessage *SMSD_PoolCopy(SMSD_MessagePool *Pool, const GSM_MultiSMSMessage *sms)
+{
+	GSM_MultiSMSMessage *result;
+	size_t size;
+
+	size = SMSD_MULTISMS_SIZE(sms->Number > 0 ? sms->Number : 1);
+	result = (GSM_MultiSMSMessage *)SMSD_PoolAlloc(Pool, size);
+	if (result == NULL) {
+		return NULL;
+	}
+	memcpy(result, sms, size);
+	return result;
+}
+
+GSM_MultiSMSMessage *SMSD_ExpandSMS(const GSM_MultiSMSMessage *sms)
+{
+	GSM_MultiSMSMessage *result;
+	size_t size;
+
+	result = (GSM_MultiSMSMessage *)malloc(sizeof(GSM_MultiSMSMessage));
+	if (result == NULL) {
+		return NULL;
+	}
+	size = SMSD_MULTISMS_SIZE(sms->Number > 0 ? sms->Number : 1);
+	memcpy(result, sms, size);
+	memset((char *)result + size, 0, sizeof(GSM_MultiSMSMessage) - size);
+	return result;
+}
+
+void SMSD_PoolFree(SMSD_MessagePool *Pool)
+{
+	SMSD_PoolBlock *block;
+
+	while (Pool->Blocks != NULL) {
+		block = Pool->Blocks;
+		Pool->Blocks = block->Next;
+		free(block);
+	}
+}
+
+/* How should editor hadle tabs in this file? Add editor commands here.
+ * vim: noexpandtab sw=8 ts=8 sts=8:
+ */
@@ -0,0 +1,71 @@
+/**
+ * SMSD message pool
+ *
+ * GSM_MultiSMSMessage always has space for GSM_MAX_MULTI_SMS parts,
+ * while most messages have only one. The pool stores copies of
+ * messages which hold only the used parts, all of them are freed at
+ * once.
+ */
+#ifndef __smsd_msgpool_h__
+#define __smsd_msgpool_h__
+
+#include <stddef.h>
+#include <gammu.h>
+
+/**
+ * Size of GSM_MultiSMSMessage holding given number of parts.
+ *
+ * Such truncated message can be passed to functions which access only
+ * first Number parts, but must not be copied by value or have more
+ * parts added.
+ */
+#define SMSD_MULTISMS_SIZE(parts) \
+	(offsetof(GSM_MultiSMSMessage, SMS) + (parts) * sizeof(GSM_SMSMessage))
+
+/**
+ * Block of memory in the pool.
+ */
+typedef struct _SMSD_PoolBlock SMSD_PoolBlock;
+
+/**
+ * Pool of truncated messages.
+ */
+typedef struct {
+	/**
+	 * Allocated blocks, the current one is first.
+	 */
+	SMSD_PoolBlock *Blocks;
+} SMSD_MessagePool;
+
+/**
+ * Initializes empty pool.
+ */
+void SMSD_PoolInit(SMSD_MessagePool *Pool);
+
+/**
+ * Stores copy of message in the pool, only used parts are copied.
+ *
+ * \return Copy of message or NULL if allocation failed.
+ */
+GSM_MultiSMSMessage *SMSD_PoolCopy(SMSD_MessagePool *Pool, const GSM_MultiSMSMessage *sms);
+
+/**
+ * Frees all messages stored in the pool.
+ */
+void SMSD_PoolFree(SMSD_MessagePool *Pool);
+
+/**
+ * Allocates full message holding copy of used parts of truncated one,
+ * use it before passing the message to backends. Unused parts are
+ * cleared.
+ *
+ * \return Full message which has to be freed by caller or NULL if
+ * allocation failed.
+ */
+GSM_MultiSMSMessage *SMSD_ExpandSMS(const GSM_MultiSMSMessage *sms);
+
+#endif
+
+/* How should editor hadle tabs in this file? Add editor commands here.
+ * vim: noexpandtab sw=8 ts=8 sts=8:
+ */
@@ -0,0 +1,281 @@
+/**
+ * SMSD send scheduler.
+ *
+ * Orders outbox messages by priority and applies token bucket rate
+ * limits per modem and per destination prefix.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include <gammu.h>
+
+#include "core.h"
+#include "scheduler.h"
+
+/**
+ * Initializes token bucket for given number of messages per minute.
+ */
+static void SMSD_RateLimitInit(SMSD_RateLimit *limit, int per_minute)
+{
+	limit->Rate = per_minute / 60.0;
+	limit->Capacity = per_minute;
+	limit->Tokens = per_minute;
+	limit->Updated = time(NULL);
+}
+
+/**
+ * Refills tokens in the bucket based on elapsed time.
+ */
+static void SMSD_RateLimitRefill(SMSD_RateLimit *limit, time_t now)
+{
+	if (now > limit->Updated) {
+		limit->Tokens += difftime(now, limit->Updated) * limit->Rate;
+		if (limit->Tokens > limit->Capacity) {
+			limit->Tokens = limit->Capacity;
+		}
+	}
+	limit->Updated = now;
+}
+
+/**
+ * Returns number of seconds until a message can pass the bucket, zero
+ * if it can pass right now.
+ */
+static int SMSD_RateLimitWait(SMSD_RateLimit *limit, time_t now)
+{
+	SMSD_RateLimitRefill(limit, now);
+	if (limit->Tokens >= 1.0) {
+		return 0;
+	}
+	return 1 + (int)((1.0 - limit->Tokens) / limit->Rate);
+}
+
+/**
+ * Finds rate limit applying to the number, the longest matching prefix
+ * wins.
+ */
+static SMSD_RateLimit *SMSD_FindRateLimit(GSM_SMSDConfig *Config, const char *number)
+{
+	SMSD_RateLimit *result = NULL;
+	size_t i, len, best = 0;
+
+	for (i = 0; i < Config->RateLimitsCount; i++) {
+		len = strlen(Config->RateLimits[i].Prefix);
+		if (len >= best && strncmp(number, Config->RateLimits[i].Prefix, len) == 0) {
+			result = &(Config->RateLimits[i]);
+			best = len;
+		}
+	}
+	return result;
+}
+
+GSM_Error SMSD_SchedulerConfigure(GSM_SMSDConfig *Config)
+{
+	INI_Entry *e;
+	int value;
+	size_t count = 0;
+
+	Config->SendQueue = NULL;
+	Config->SendQueueUsed = 0;
+	Config->RateLimits = NULL;
+	Config->RateLimitsCount = 0;
+	Config->ModemRateLimit.Prefix = NULL;
+	Config->ModemRateLimit.Rate = 0;
+
+	value = INI_GetInt(Config->smsdcfgfile, "smsd", "sendqueuesize", 1);
+	if (value < 1) {
+		SMSD_Log(DEBUG_NOTICE, Config, "SendQueueSize too low, forcing to 1");
+		value = 1;
+	}
+	Config->sendqueuesize = value;
+	Config->SendQueue = (SMSD_QueuedSMS **)calloc(Config->sendqueuesize, sizeof(SMSD_QueuedSMS *));
+	if (Config->SendQueue == NULL) {
+		return ERR_MOREMEMORY;
+	}
+
+	value = INI_GetInt(Config->smsdcfgfile, "smsd", "sendrate", 0);
+	if (value > 0) {
+		SMSD_RateLimitInit(&Config->ModemRateLimit, value);
+	}
+
+	for (e = INI_FindLastSectionEntry(Config->smsdcfgfile, "ratelimit", FALSE); e != NULL; e = e->Prev) {
+		count++;
+	}
+	if (count > 0) {
+		Config->RateLimits = (SMSD_RateLimit *)calloc(count, sizeof(SMSD_RateLimit));
+		if (Config->RateLimits == NULL) {
+			return ERR_MOREMEMORY;
+		}
+	}
+	for (e = INI_FindLastSectionEntry(Config->smsdcfgfile, "ratelimit", FALSE); e != NULL; e = e->Prev) {
+		value = atoi(e->EntryValue);
+		if (value <= 0) {
+			SMSD_Log(DEBUG_ERROR, Config, "Invalid rate limit for prefix %s: %s", e->EntryName, e->EntryValue);
+			return ERR_UNCONFIGURED;
+		}
+		Config->RateLimits[Config->RateLimitsCount].Prefix = strdup(e->EntryName);
+		if (Config->RateLimits[Config->RateLimitsCount].Prefix == NULL) {
+			return ERR_MOREMEMORY;
+		}
+		SMSD_RateLimitInit(&(Config->RateLimits[Config->RateLimitsCount]), value);
+		Config->RateLimitsCount++;
+	}
+
+	SMSD_Log(DEBUG_NOTICE, Config, "scheduler: SendQueueSize=%u, SendRate=%d, prefix limits=%ld",
+			Config->sendqueuesize,
+			(int)(Config->ModemRateLimit.Rate * 60 + 0.5),
+			(long)Config->RateLimitsCount);
+
+	return ERR_NONE;
+}
+
+void SMSD_SchedulerFree(GSM_SMSDConfig *Config)
+{
+	size_t i;
+
+	if (Config->SendQueue != NULL) {
+		for (i = 0; i < Config->SendQueueUsed; i++) {
+			free(Config->SendQueue[i]);
+		}
+		free(Config->SendQueue);
+		Config->SendQueue = NULL;
+	}
+	Config->SendQueueUsed = 0;
+
+	if (Config->RateLimits != NULL) {
+		for (i = 0; i < Config->RateLimitsCount; i++) {
+			free(Config->RateLimits[i].Prefix);
+		}
+		free(Config->RateLimits);
+		Config->RateLimits = NULL;
+	}
+	Config->RateLimitsCount = 0;
+}
+
+gboolean SMSD_SchedulerFull(GSM_SMSDConfig *Config)
+{
+	return Config->SendQueueUsed >= Config->sendqueuesize;
+}
+
+gboolean SMSD_SchedulerQueued(GSM_SMSDConfig *Config, const char *ID)
+{
+	size_t i;
+
+	for (i = 0; i < Config->SendQueueUsed; i++) {
+		if (strcmp(Config->SendQueue[i]->ID, ID) == 0) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+GSM_Error SMSD_SchedulerAdd(GSM_SMSDConfig *Config, SMSD_QueuedSMS *entry)
+{
+	if (SMSD_SchedulerQueued(Config, entry->ID)) {
+		return ERR_BUSY;
+	}
+	if (SMSD_SchedulerFull(Config)) {
+		return ERR_FULL;
+	}
+	entry->Queued = time(NULL);
+	Config->SendQueue[Config->SendQueueUsed++] = entry;
+	return ERR_NONE;
+}
+
+/**
+ * Removes entry from queue, keeping order of the remaining ones.
+ */
+static void SMSD_SchedulerRemove(GSM_SMSDConfig *Config, size_t pos)
+{
+	Config->SendQueueUsed--;
+	memmove(Config->SendQueue + pos, Config->SendQueue + pos + 1,
+		(Config->SendQueueUsed - pos) * sizeof(SMSD_QueuedSMS *));
+}
+
+void SMSD_SchedulerExpire(GSM_SMSDConfig *Config, time_t now)
+{
+	size_t i = 0;
+
+	while (i < Config->SendQueueUsed) {
+		if (difftime(now, Config->SendQueue[i]->Queued) > SMSD_QUEUE_MAX_AGE) {
+			SMSD_Log(DEBUG_NOTICE, Config, "Message %s waited too long in queue, dropping it", Config->SendQueue[i]->ID);
+			free(Config->SendQueue[i]);
+			SMSD_SchedulerRemove(Config, i);
+		} else {
+			i++;
+		}
+	}
+}
+
+SMSD_QueuedSMS *SMSD_SchedulerNext(GSM_SMSDConfig *Config, time_t now, int *wait)
+{
+	SMSD_QueuedSMS *entry, *result = NULL;
+	SMSD_RateLimit *limit;
+	char number[GSM_MAX_NUMBER_LENGTH + 1];
+	size_t i, best = 0;
+	int delay, mindelay = 0;
+
+	*wait = 0;
+
+	if (Config->SendQueueUsed == 0) {
+		return NULL;
+	}
+
+	/* Modem wide limit blocks everything */
+	if (Config->ModemRateLimit.Rate > 0) {
+		delay = SMSD_RateLimitWait(&Config->ModemRateLimit, now);
+		if (delay > 0) {
+			*wait = delay;
+			return NULL;
+		}
+	}
+
+	for (i = 0; i < Config->SendQueueUsed; i++) {
+		entry = Config->SendQueue[i];
+		/* We already have more urgent or older one */
+		if (result != NULL && entry->Priority >= result->Priority) {
+			continue;
+		}
+		if (Config->RateLimitsCount > 0) {
+			DecodeUnicode(entry->SMS.SMS[0].Number, number);
+			limit = SMSD_FindRateLimit(Config, number);
+			if (limit != NULL) {
+				delay = SMSD_RateLimitWait(limit, now);
+				if (delay > 0) {
+					if (mindelay == 0 || delay < mindelay) {
+						mindelay = delay;
+					}
+					continue;
+				}
+			}
+		}
+		result = entry;
+		best = i;
+	}
+
+	if (result == NULL) {
+		*wait = mindelay;
+		return NULL;
+	}
+
+	SMSD_SchedulerRemove(Config, best);
+
+	/* Charge all parts, this can get bucket below zero for long messages */
+	if (Config->ModemRateLimit.Rate > 0) {
+		Config->ModemRateLimit.Tokens -= result->SMS.Number;
+	}
+	if (Config->RateLimitsCount > 0) {
+		DecodeUnicode(result->SMS.SMS[0].Number, number);
+		limit = SMSD_FindRateLimit(Config, number);
+		if (limit != NULL) {
+			limit->Tokens -= result->SMS.Number;
+		}
+	}
+
+	return result;
+}
+
+/* How should editor hadle tabs in this file? Add editor commands here.
+ * vim: noexpandtab sw=8 ts=8 sts=8:
+ */
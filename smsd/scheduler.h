@@ -0,0 +1,144 @@
+/**
+ * SMSD send scheduler
+ *
+ * Keeps a bounded queue of messages fetched from the outbox and decides
+ * which one to send next based on priority and configured rate limits.
+ */
+#ifndef __smsd_scheduler_h__
+#define __smsd_scheduler_h__
+
+#include <time.h>
+#include <gammu.h>
+#include <gammu-smsd.h>
+
+#include "msgpool.h"
+
+/**
+ * Priority used for messages where backend does not provide any, it is
+ * in the middle of the A-Z range used by the FILES backend. Lower number
+ * means more urgent message.
+ */
+#define SMSD_DEFAULT_PRIORITY ('M' - 'A')
+
+/**
+ * How long (in seconds) can message wait in the queue. After this time
+ * it is dropped from the queue and fetched from the backend again (the
+ * lock in the backend might have expired meanwhile).
+ */
+#define SMSD_QUEUE_MAX_AGE (30)
+
+/**
+ * Message waiting in the send queue.
+ */
+typedef struct {
+	/**
+	 * Message ID in the backend.
+	 */
+	char ID[200];
+	/**
+	 * Priority class, lower is more urgent.
+	 */
+	int Priority;
+	/**
+	 * Delivery report request as set by backend.
+	 */
+	int DeliveryReport;
+	/**
+	 * Relative validity as set by backend.
+	 */
+	int RelativeValidity;
+	/**
+	 * When the message was added to the queue.
+	 */
+	time_t Queued;
+	/**
+	 * Message itself. It has to be last, queued entries are truncated
+	 * to hold only used parts, see \ref SMSD_QUEUEDSMS_SIZE.
+	 */
+	GSM_MultiSMSMessage SMS;
+} SMSD_QueuedSMS;
+
+/**
+ * Size of queue entry holding message with given number of parts.
+ */
+#define SMSD_QUEUEDSMS_SIZE(parts) \
+	(offsetof(SMSD_QueuedSMS, SMS) + SMSD_MULTISMS_SIZE(parts))
+
+/**
+ * Token bucket limiting sending rate.
+ */
+typedef struct {
+	/**
+	 * Destination number prefix, NULL for limit of whole modem.
+	 */
+	char *Prefix;
+	/**
+	 * Refill rate in messages per second.
+	 */
+	double Rate;
+	/**
+	 * Maximal number of tokens in the bucket.
+	 */
+	double Capacity;
+	/**
+	 * Currently available tokens.
+	 */
+	double Tokens;
+	/**
+	 * Last time when tokens were refilled.
+	 */
+	time_t Updated;
+} SMSD_RateLimit;
+
+/**
+ * Reads scheduler configuration (SendQueueSize, SendRate and
+ * [ratelimit] section) and allocates the queue.
+ */
+GSM_Error SMSD_SchedulerConfigure(GSM_SMSDConfig *Config);
+
+/**
+ * Frees queued messages and rate limits.
+ */
+void SMSD_SchedulerFree(GSM_SMSDConfig *Config);
+
+/**
+ * Checks whether the queue is full.
+ */
+gboolean SMSD_SchedulerFull(GSM_SMSDConfig *Config);
+
+/**
+ * Checks whether message with given ID is already queued, backends use
+ * this to skip messages they have already returned.
+ */
+gboolean SMSD_SchedulerQueued(GSM_SMSDConfig *Config, const char *ID);
+
+/**
+ * Adds message to the queue. On success the queue takes ownership of
+ * the entry.
+ *
+ * \return ERR_NONE on success, ERR_BUSY if message with same ID is
+ * already queued, ERR_FULL if there is no space left.
+ */
+GSM_Error SMSD_SchedulerAdd(GSM_SMSDConfig *Config, SMSD_QueuedSMS *entry);
+
+/**
+ * Drops messages which have been waiting in the queue for too long.
+ */
+void SMSD_SchedulerExpire(GSM_SMSDConfig *Config, time_t now);
+
+/**
+ * Picks next message to send: the most urgent one which is not blocked
+ * by rate limits, oldest first within same priority. The message is
+ * removed from the queue and its parts are charged to rate limits.
+ *
+ * \param wait Is set to number of seconds until some queued message
+ * can be sent when NULL is returned, zero otherwise.
+ * \return Message to send (caller frees it) or NULL.
+ */
+SMSD_QueuedSMS *SMSD_SchedulerNext(GSM_SMSDConfig *Config, time_t now, int *wait);
+
+#endif
+
+/* How should editor hadle tabs in this file? Add editor commands here.
+ * vim: noexpandtab sw=8 ts=8 sts=8:
+ */
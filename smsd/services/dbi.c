@@ -322,6 +322,8 @@ struct GSM_SMSDdbobj SMSDDBI = {
 	SMSDDBI_GetDate,
 	SMSDDBI_GetBool,
 	SMSDDBI_QuoteString,
+	NULL,
+	NULL,
 };
 
 /* How should editor hadle tabs in this file? Add editor commands here.
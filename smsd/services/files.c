@@ -8,6 +8,7 @@
 #include <time.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <ctype.h>
 
 #ifdef WIN32
 #include <io.h>
@@ -113,13 +114,13 @@ static GSM_Error SMSDFiles_SaveInboxSMS(GSM_MultiSMSMessage * sms, GSM_SMSDConfi
 				switch (sms->SMS[i].Coding) {
 					case SMS_Coding_Unicode_No_Compression:
 					case SMS_Coding_Default_No_Compression:
-						DecodeUnicode(sms->SMS[i].Text, buffer2);
 						if (strcasecmp(Config->inboxformat, "unicode") == 0) {
 							buffer[0] = 0xFE;
 							buffer[1] = 0xFF;
 							chk_fwrite(buffer, 1, 2, file);
-							chk_fwrite(sms->SMS[i].Text, 1, strlen(buffer2) * 2, file);
+							chk_fwrite(sms->SMS[i].Text, 1, UnicodeLength(sms->SMS[i].Text) * 2, file);
 						} else {
+							DecodeUnicode(sms->SMS[i].Text, buffer2);
 							chk_fwrite(buffer2, 1, strlen(buffer2), file);
 						}
 						break;
@@ -147,6 +148,25 @@ fail:
 	return ERR_WRITING_FILE;
 }
 
+#ifdef WIN32
+/**
+ * Finds first file matching pattern which is not already queued.
+ */
+static intptr_t SMSDFiles_FindFirst(GSM_SMSDConfig * Config, const char *pattern, struct _finddata_t *c_file)
+{
+	intptr_t hFile;
+
+	hFile = _findfirst(pattern, c_file);
+	while (hFile != -1 && SMSD_SchedulerQueued(Config, c_file->name)) {
+		if (_findnext(hFile, c_file) != 0) {
+			_findclose(hFile);
+			hFile = -1;
+		}
+	}
+	return hFile;
+}
+#endif
+
 /* Find one multi SMS to sending and return it (or return ERR_EMPTY)
  * There is also set ID for SMS
  * File extension convention:
@@ -179,11 +199,11 @@ static GSM_Error SMSDFiles_FindOutboxSMS(GSM_MultiSMSMessage * sms, GSM_SMSDConf
 
 	strcpy(FullName, Config->outboxpath);
 	strcat(FullName, "OUT*.txt*");
-	hFile = _findfirst(FullName, &c_file);
+	hFile = SMSDFiles_FindFirst(Config, FullName, &c_file);
 	if (hFile == -1) {
 		strcpy(FullName, Config->outboxpath);
 		strcat(FullName, "OUT*.smsbackup*");
-		hFile = _findfirst(FullName, &c_file);
+		hFile = SMSDFiles_FindFirst(Config, FullName, &c_file);
 		backup = TRUE;
 	}
 	if (hFile == -1) {
@@ -212,6 +232,10 @@ static GSM_Error SMSDFiles_FindOutboxSMS(GSM_MultiSMSMessage * sms, GSM_SMSDConf
 		if (strncasecmp(namelist[cur_file]->d_name, "out", 3) != 0) {
 			continue;
 		}
+		/* Already waiting in send queue */
+		if (SMSD_SchedulerQueued(Config, namelist[cur_file]->d_name)) {
+			continue;
+		}
 		/* Check extension */
 		pos = strrchr(namelist[cur_file]->d_name, '.');
 		if (pos == NULL) {
@@ -248,6 +272,11 @@ static GSM_Error SMSDFiles_FindOutboxSMS(GSM_MultiSMSMessage * sms, GSM_SMSDConf
 	strcpy(FullName, Config->outboxpath);
 	strcat(FullName, FileName);
 
+	/* OUT<priority>..., A is the most urgent one */
+	if (isalpha((unsigned char)FileName[3])) {
+		Config->currpriority = toupper((unsigned char)FileName[3]) - 'A';
+	}
+
 	if (backup) {
 #ifdef GSM_ENABLE_BACKUP
 		/* Remember ID */
@@ -658,7 +687,10 @@ GSM_SMSDService SMSDFiles = {
 	SMSDFiles_AddSentSMSInfo,
 	NOTIMPLEMENTED,		/* RefreshSendStatus    */
 	NOTIMPLEMENTED,		/* RefreshPhoneStatus   */
-	SMSDFiles_ReadConfiguration
+	SMSDFiles_ReadConfiguration,
+	NOTSUPPORTED,		/* GetNotifyDescriptor  */
+	EMPTYFUNCTION,		/* ReadNotify           */
+	NOTSUPPORTED		/* CreateOutboxSMSBatch */
 };
 
 /* How should editor handle tabs in this file? Add editor commands here.
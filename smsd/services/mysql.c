@@ -200,6 +200,8 @@ struct GSM_SMSDdbobj SMSDMySQL = {
 	SMSDMySQL_GetDate,
 	SMSDMySQL_GetBool,
 	SMSDMySQL_QuoteString,
+	NULL,
+	NULL,
 };
 
 #endif
@@ -18,7 +18,10 @@ GSM_SMSDService SMSDNull = {
 	NONEFUNCTION,		/* AddSentSMSInfo       */
 	NOTIMPLEMENTED,		/* RefreshSendStatus    */
 	NOTIMPLEMENTED,		/* RefreshPhoneStatus   */
-	NONEFUNCTION		/* ReadConfiguration    */
+	NONEFUNCTION,		/* ReadConfiguration    */
+	NOTSUPPORTED,		/* GetNotifyDescriptor  */
+	EMPTYFUNCTION,		/* ReadNotify           */
+	NOTSUPPORTED		/* CreateOutboxSMSBatch */
 };
 
 /* How should editor handle tabs in this file? Add editor commands here.
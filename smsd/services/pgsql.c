@@ -88,6 +88,7 @@ static SQL_Error SMSDPgSQL_Connect(GSM_SMSDConfig * Config)
 
 	Res = PQexec(Config->conn.pg, "SET NAMES UTF8");
 	PQclear(Res);
+	Config->listening = FALSE;
 	SMSD_Log(DEBUG_INFO, Config, "Connected to database: %s on %s. Server version: %d Protocol: %d",
 		 PQdb(Config->conn.pg), PQhost(Config->conn.pg), PQserverVersion(Config->conn.pg), PQprotocolVersion(Config->conn.pg));
 
@@ -184,6 +185,52 @@ unsigned long long SMSDPgSQL_SeqID(GSM_SMSDConfig * Config, const char *seq_id)
 	return id;
 }
 
+/* Starts listening for notifications on channel */
+static SQL_Error SMSDPgSQL_Listen(GSM_SMSDConfig * Config, const char *channel, int *fd)
+{
+	char buff[200];
+	PGresult *rc;
+
+	if (Config->conn.pg == NULL || PQstatus(Config->conn.pg) != CONNECTION_OK) {
+		return SQL_TIMEOUT;
+	}
+	if (!Config->listening) {
+		snprintf(buff, sizeof(buff), "LISTEN \"%s\"", channel);
+		SMSD_Log(DEBUG_SQL, Config, "Execute SQL: %s", buff);
+		rc = PQexec(Config->conn.pg, buff);
+		if (rc == NULL || PQresultStatus(rc) != PGRES_COMMAND_OK) {
+			SMSDPgSQL_LogError(Config, rc);
+			PQclear(rc);
+			return SQL_FAIL;
+		}
+		PQclear(rc);
+		Config->listening = TRUE;
+	}
+	*fd = PQsocket(Config->conn.pg);
+	return (*fd < 0) ? SQL_FAIL : SQL_OK;
+}
+
+/* Consumes pending notifications */
+static int SMSDPgSQL_CheckNotify(GSM_SMSDConfig * Config)
+{
+	PGnotify *notify;
+	int count = 0;
+
+	if (Config->conn.pg == NULL) {
+		return -1;
+	}
+	if (!PQconsumeInput(Config->conn.pg)) {
+		SMSDPgSQL_LogError(Config, NULL);
+		Config->listening = FALSE;
+		return -1;
+	}
+	while ((notify = PQnotifies(Config->conn.pg)) != NULL) {
+		count++;
+		PQfreemem(notify);
+	}
+	return count;
+}
+
 struct GSM_SMSDdbobj SMSDPgSQL = {
 	SMSDPgSQL_Connect,
 	SMSDPgSQL_Query,
@@ -197,6 +244,8 @@ struct GSM_SMSDdbobj SMSDPgSQL = {
 	SMSDPgSQL_GetDate,
 	SMSDPgSQL_GetBool,
 	SMSDPgSQL_QuoteString,
+	SMSDPgSQL_Listen,
+	SMSDPgSQL_CheckNotify,
 };
 
 #endif
@@ -150,6 +150,10 @@ struct GSM_SMSDdbobj {
 	time_t (* GetDate)(GSM_SMSDConfig *, SQL_result *, unsigned int);
 	gboolean (* GetBool)(GSM_SMSDConfig *, SQL_result *, unsigned int);
 	char * (* QuoteString)(GSM_SMSDConfig *, const char *);
+	/* optional, starts listening for notifications and returns descriptor to wait on */
+	SQL_Error (* Listen)(GSM_SMSDConfig *, const char *, int *);
+	/* optional, returns number of received notifications or -1 on failure */
+	int (* CheckNotify)(GSM_SMSDConfig *);
 };
 
 /* database backends */
@@ -222,6 +222,11 @@ static SQL_Error SMSDSQL_Query(GSM_SMSDConfig * Config, const char *query, SQL_r
 		}
 
 		SMSD_Log(DEBUG_INFO, Config, "SQL failed (timeout): %s", query);
+		if (Config->in_transaction) {
+			/* New connection would not continue the transaction, let caller abort it */
+			SMSD_Log(DEBUG_INFO, Config, "Not reconnecting inside transaction");
+			return error;
+		}
 		/* We will try to reconnect */
 		SMSD_Log(DEBUG_INFO, Config, "reconnecting to database!");
 		while (error != SQL_OK && attempts < Config->backend_retries) {
@@ -267,6 +272,7 @@ static SQL_Error SMSDSQL_NamedQuery(GSM_SMSDConfig * Config, const char *sql_que
 {
 	char buff[65536], *ptr, c, static_buff[8192];
 	char *buffer2, *end;
+	size_t len;
 	const char *to_print, *q = sql_query;
 	int int_to_print;
 	int numeric;
@@ -442,8 +448,9 @@ static SQL_Error SMSDSQL_NamedQuery(GSM_SMSDConfig * Config, const char *sql_que
 			ptr += sprintf(ptr, "%i", int_to_print);
 		} else if (to_print != NULL) {
 			buffer2 = db->QuoteString(Config, to_print);
-			memcpy(ptr, buffer2, strlen(buffer2));
-			ptr += strlen(buffer2);
+			len = strlen(buffer2);
+			memcpy(ptr, buffer2, len);
+			ptr += len;
 			free(buffer2);
 		} else {
 			memcpy(ptr, "NULL", 4);
@@ -507,6 +514,7 @@ static GSM_Error SMSDSQL_Init(GSM_SMSDConfig * Config)
 #endif
 
 	db = Config->db;
+	Config->in_transaction = FALSE;
 
 	if (db->Connect(Config) != SQL_OK)
 		return ERR_UNKNOWN;
@@ -753,9 +761,11 @@ static GSM_Error SMSDSQL_FindOutboxSMS(GSM_MultiSMSMessage * sms, GSM_SMSDConfig
 	const char *q;
 	size_t udh_len;
 	SQL_Var vars[3];
+	gboolean found;
 
+	/* Ask for enough rows to skip messages which are already queued */
 	vars[0].type = SQL_TYPE_INT;
-	vars[0].v.i = 1;
+	vars[0].v.i = Config->SendQueueUsed + 1;
 	vars[1].type = SQL_TYPE_NONE;
 
 	while (TRUE) {
@@ -764,12 +774,19 @@ static GSM_Error SMSDSQL_FindOutboxSMS(GSM_MultiSMSMessage * sms, GSM_SMSDConfig
 			return ERR_UNKNOWN;
 		}
 
-		if (db->NextRow(Config, &res) != 1) {
+		found = FALSE;
+		while (db->NextRow(Config, &res) == 1) {
+			sprintf(ID, "%ld", (long)db->GetNumber(Config, &res, 0));
+			if (!SMSD_SchedulerQueued(Config, ID)) {
+				found = TRUE;
+				break;
+			}
+		}
+		if (!found) {
 			db->FreeResult(Config, &res);
 			return ERR_EMPTY;
 		}
 
-		sprintf(ID, "%ld", (long)db->GetNumber(Config, &res, 0));
 		timestamp = db->GetDate(Config, &res, 1);
 
 		db->FreeResult(Config, &res);
@@ -786,11 +803,6 @@ static GSM_Error SMSDSQL_FindOutboxSMS(GSM_MultiSMSMessage * sms, GSM_SMSDConfig
 	}
 
 	sms->Number = 0;
-	for (i = 0; i < GSM_MAX_MULTI_SMS; i++) {
-		GSM_SetDefaultSMSData(&sms->SMS[i]);
-		sms->SMS[i].SMSC.Number[0] = 0;
-		sms->SMS[i].SMSC.Number[1] = 0;
-	}
 
 	for (i = 1; i < GSM_MAX_MULTI_SMS + 1; i++) {
 		vars[0].type = SQL_TYPE_STRING;
@@ -813,6 +825,11 @@ static GSM_Error SMSDSQL_FindOutboxSMS(GSM_MultiSMSMessage * sms, GSM_SMSDConfig
 			return ERR_NONE;
 		}
 
+		/* Clean only parts we really fill */
+		GSM_SetDefaultSMSData(&sms->SMS[sms->Number]);
+		sms->SMS[sms->Number].SMSC.Number[0] = 0;
+		sms->SMS[sms->Number].SMSC.Number[1] = 0;
+
 		coding = db->GetString(Config, &res, 1);
 		text = db->GetString(Config, &res, 0);
 		if (text == NULL) {
@@ -932,8 +949,8 @@ static GSM_Error SMSDSQL_MoveSMS(GSM_MultiSMSMessage * sms UNUSED, GSM_SMSDConfi
 	return ERR_NONE;
 }
 
-/* Adds SMS to Outbox */
-static GSM_Error SMSDSQL_CreateOutboxSMS(GSM_MultiSMSMessage * sms, GSM_SMSDConfig * Config, char *NewID)
+/* Stores SMS in Outbox */
+static GSM_Error SMSDSQL_StoreOutboxSMS(GSM_MultiSMSMessage * sms, GSM_SMSDConfig * Config, char *NewID)
 {
 	char creator[200];
 	int i;
@@ -985,6 +1002,148 @@ static GSM_Error SMSDSQL_CreateOutboxSMS(GSM_MultiSMSMessage * sms, GSM_SMSDConf
 	return ERR_NONE;
 }
 
+/* Lets listening daemon know about new messages */
+static void SMSDSQL_NotifyOutbox(GSM_SMSDConfig * Config)
+{
+	char buffer[100];
+	SQL_result res;
+	struct GSM_SMSDdbobj *db = Config->db;
+
+	if (db->Listen == NULL || Config->notifychannel[0] == 0) {
+		return;
+	}
+	sprintf(buffer, "NOTIFY \"%s\"", Config->notifychannel);
+	if (SMSDSQL_Query(Config, buffer, &res) == SQL_OK) {
+		db->FreeResult(Config, &res);
+	}
+}
+
+/* Adds SMS to Outbox */
+static GSM_Error SMSDSQL_CreateOutboxSMS(GSM_MultiSMSMessage * sms, GSM_SMSDConfig * Config, char *NewID)
+{
+	GSM_Error error;
+
+	error = SMSDSQL_StoreOutboxSMS(sms, Config, NewID);
+	if (error == ERR_NONE) {
+		SMSDSQL_NotifyOutbox(Config);
+	}
+	return error;
+}
+
+const char begin_mysql[] = "START TRANSACTION";
+const char begin_freetds[] = "BEGIN TRANSACTION";
+const char begin_fallback[] = "BEGIN";
+const char commit_freetds[] = "COMMIT TRANSACTION";
+const char commit_fallback[] = "COMMIT";
+const char rollback_freetds[] = "ROLLBACK TRANSACTION";
+const char rollback_fallback[] = "ROLLBACK";
+
+/* Returns statement for transaction handling, NULL if not supported */
+static const char *SMSDSQL_Transaction(GSM_SMSDConfig * Config, int stage)
+{
+	const char *driver_name;
+
+	driver_name = SMSDSQL_SQLName(Config);
+
+	if (strcasecmp(driver_name, "freetds") == 0 || strcasecmp(driver_name, "mssql") == 0 || strcasecmp(driver_name, "sybase") == 0) {
+		return stage == 0 ? begin_freetds : (stage == 1 ? commit_freetds : rollback_freetds);
+	} else if (strcasecmp(driver_name, "access") == 0 || strcasecmp(driver_name, "odbc") == 0) {
+		/* Unknown server, we can not know the syntax */
+		return NULL;
+	} else if (strcasecmp(driver_name, "mysql") == 0 || strcasecmp(driver_name, "native_mysql") == 0) {
+		return stage == 0 ? begin_mysql : (stage == 1 ? commit_fallback : rollback_fallback);
+	} else {
+		return stage == 0 ? begin_fallback : (stage == 1 ? commit_fallback : rollback_fallback);
+	}
+}
+
+/* Adds several SMS to Outbox in single transaction */
+static GSM_Error SMSDSQL_CreateOutboxSMSBatch(GSM_MultiSMSMessage * sms, size_t count, GSM_SMSDConfig * Config, size_t *done)
+{
+	GSM_Error error = ERR_NONE;
+	SQL_result res;
+	struct GSM_SMSDdbobj *db = Config->db;
+	const char *q;
+	size_t i;
+
+	*done = 0;
+
+	q = SMSDSQL_Transaction(Config, 0);
+	if (q != NULL) {
+		if (SMSDSQL_Query(Config, q, &res) != SQL_OK) {
+			SMSD_Log(DEBUG_INFO, Config, "Error starting transaction (%s)", __FUNCTION__);
+			return ERR_UNKNOWN;
+		}
+		db->FreeResult(Config, &res);
+		Config->in_transaction = TRUE;
+	}
+
+	for (i = 0; i < count; i++) {
+		error = SMSDSQL_StoreOutboxSMS(&sms[i], Config, NULL);
+		if (error != ERR_NONE) {
+			break;
+		}
+	}
+
+	if (q == NULL) {
+		/* Without transaction whatever was written stays there */
+		*done = i;
+	} else if (error != ERR_NONE) {
+		q = SMSDSQL_Transaction(Config, 2);
+		if (SMSDSQL_Query(Config, q, &res) == SQL_OK) {
+			db->FreeResult(Config, &res);
+		}
+		Config->in_transaction = FALSE;
+		return error;
+	} else {
+		q = SMSDSQL_Transaction(Config, 1);
+		if (SMSDSQL_Query(Config, q, &res) != SQL_OK) {
+			SMSD_Log(DEBUG_INFO, Config, "Error committing transaction (%s)", __FUNCTION__);
+			Config->in_transaction = FALSE;
+			return ERR_UNKNOWN;
+		}
+		Config->in_transaction = FALSE;
+		db->FreeResult(Config, &res);
+		*done = count;
+	}
+
+	SMSD_Log(DEBUG_INFO, Config, "Written %ld messages", (long)*done);
+	if (*done > 0) {
+		SMSDSQL_NotifyOutbox(Config);
+	}
+	return error;
+}
+
+
+static GSM_Error SMSDSQL_GetNotifyDescriptor(GSM_SMSDConfig * Config, int *fd)
+{
+	struct GSM_SMSDdbobj *db = Config->db;
+
+	if (db->Listen == NULL || Config->notifychannel[0] == 0) {
+		return ERR_NOTSUPPORTED;
+	}
+	if (db->Listen(Config, Config->notifychannel, fd) != SQL_OK) {
+		return ERR_UNKNOWN;
+	}
+	return ERR_NONE;
+}
+
+static GSM_Error SMSDSQL_ReadNotify(GSM_SMSDConfig * Config)
+{
+	struct GSM_SMSDdbobj *db = Config->db;
+	int count;
+
+	if (db->CheckNotify == NULL) {
+		return ERR_EMPTY;
+	}
+	count = db->CheckNotify(Config);
+	if (count < 0) {
+		/* Connection is probably broken, let outbox query reconnect */
+		return ERR_NONE;
+	}
+	return (count > 0) ? ERR_NONE : ERR_EMPTY;
+}
+
 static GSM_Error SMSDSQL_AddSentSMSInfo(GSM_MultiSMSMessage * sms, GSM_SMSDConfig * Config, char *ID, int Part, GSM_SMSDSendingError err, int TPMR)
 {
 	SQL_result res;
@@ -1158,6 +1317,16 @@ GSM_Error SMSDSQL_ReadConfiguration(GSM_SMSDConfig *Config)
 
 	Config->dbdir = INI_GetValue(Config->smsdcfgfile, "smsd", "dbdir", FALSE);
 
+	Config->notifychannel = INI_GetValue(Config->smsdcfgfile, "smsd", "notifychannel", FALSE);
+	if (Config->notifychannel == NULL) {
+		Config->notifychannel = "gammu_outbox";
+	}
+	if (strlen(Config->notifychannel) > 63 || strchr(Config->notifychannel, '"') != NULL) {
+		SMSD_Log(DEBUG_ERROR, Config, "Invalid NotifyChannel: %s", Config->notifychannel);
+		return ERR_UNKNOWN;
+	}
+	Config->listening = FALSE;
+
 	if (Config->driver == NULL) {
 		SMSD_Log(DEBUG_ERROR, Config, "No database driver selected. Must be native_mysql, native_pgsql, ODBC or DBI one.");
 		return ERR_UNKNOWN;
@@ -1465,7 +1634,10 @@ GSM_SMSDService SMSDSQL = {
 	SMSDSQL_AddSentSMSInfo,
 	SMSDSQL_RefreshSendStatus,
 	SMSDSQL_RefreshPhoneStatus,
-	SMSDSQL_ReadConfiguration
+	SMSDSQL_ReadConfiguration,
+	SMSDSQL_GetNotifyDescriptor,
+	SMSDSQL_ReadNotify,
+	SMSDSQL_CreateOutboxSMSBatch
 };
 
 /* How should editor hadle tabs in this file? Add editor commands here.
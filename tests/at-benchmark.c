@@ -0,0 +1,347 @@
+/*
+ * Benchmark of AT driver and SMSD against fake modem.
+ *
+ * Prints results as "BENCH name value unit" lines, so that they can be
+ * collected by continuous integration. The test fails when operation
+ * takes longer than its time budget.
+ */
+
+#include <gammu.h>
+#include <gammu-smsd.h>
+#include <gammu-config.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include "common.h"
+#include "fakemodem.h"
+
+/**
+ * Number of received messages preloaded in fake modem.
+ */
+#define BENCH_MESSAGES 50
+
+/**
+ * Time budget for single operation in seconds, it is generous to fail
+ * only on real regressions and not on slow build hosts.
+ */
+#define BENCH_BUDGET 5.0
+
+GSM_Error sms_send_status;
+
+static double bench_now(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static void send_sms_callback(GSM_StateMachine *sm UNUSED, int status, int MessageReference UNUSED, void *user_data UNUSED)
+{
+	sms_send_status = (status == 0) ? ERR_NONE : ERR_UNKNOWN;
+}
+
+/**
+ * Connects to fake modem.
+ */
+static GSM_StateMachine *bench_connect(const char *path)
+{
+	GSM_StateMachine *s;
+	GSM_Config *smcfg;
+
+	s = GSM_AllocStateMachine();
+	test_result(s != NULL);
+	GSM_SetDebugGlobal(TRUE, GSM_GetDebug(s));
+
+	smcfg = GSM_GetConfig(s, 0);
+	smcfg->Model[0] = 0;
+	free(smcfg->Device);
+	smcfg->Device = strdup(path);
+	free(smcfg->Connection);
+	smcfg->Connection = strdup("unixat");
+	GSM_SetConfigNum(s, 1);
+
+	gammu_test_result(GSM_InitConnection(s, 1), "GSM_InitConnection");
+	GSM_SetSendSMSStatusCallback(s, send_sms_callback, NULL);
+	return s;
+}
+
+static void bench_disconnect(GSM_StateMachine *s)
+{
+	gammu_test_result(GSM_TerminateConnection(s), "GSM_TerminateConnection");
+	GSM_FreeStateMachine(s);
+}
+
+/**
+ * Fills message to be sent by benchmark.
+ */
+static void bench_message(GSM_SMSMessage *sms, int i)
+{
+	char text[100];
+
+	GSM_SetDefaultSMSData(sms);
+	sprintf(text, "Benchmark message %d", i);
+	EncodeUnicode(sms->Text, text, strlen(text));
+	EncodeUnicode(sms->Number, "+48600123456", 12);
+	EncodeUnicode(sms->SMSC.Number, "+12345678901", 12);
+	sms->PDU = SMS_Submit;
+	sms->UDH.Type = UDH_NoUDH;
+	sms->Coding = SMS_Coding_Default_No_Compression;
+	sms->Class = -1;
+}
+
+/**
+ * Measures latency of simple status command.
+ */
+static void bench_latency(GSM_StateMachine *s, int iterations)
+{
+	GSM_SignalQuality sig;
+	double start, took, min = 1e9, max = 0, total;
+	int i;
+
+	total = bench_now();
+	for (i = 0; i < iterations; i++) {
+		start = bench_now();
+		gammu_test_result(GSM_GetSignalQuality(s, &sig), "GSM_GetSignalQuality");
+		took = bench_now() - start;
+		if (took < min) min = took;
+		if (took > max) max = took;
+	}
+	total = bench_now() - total;
+
+	printf("BENCH command_latency_avg %.3f ms\n", total * 1000 / iterations);
+	printf("BENCH command_latency_min %.3f ms\n", min * 1000);
+	printf("BENCH command_latency_max %.3f ms\n", max * 1000);
+	test_result(max < BENCH_BUDGET);
+}
+
+/**
+ * Measures reading of all messages from SIM.
+ */
+static void bench_read(GSM_StateMachine *s)
+{
+	GSM_MultiSMSMessage sms;
+	GSM_Error error;
+	gboolean start = TRUE;
+	double took;
+	int count = 0;
+
+	took = bench_now();
+	memset(&sms, 0, sizeof(sms));
+	while (TRUE) {
+		sms.SMS[0].Folder = 0;
+		error = GSM_GetNextSMS(s, &sms, start);
+		if (error == ERR_EMPTY) {
+			break;
+		}
+		gammu_test_result(error, "GSM_GetNextSMS");
+		test_result(sms.Number == 1);
+		test_result(strcmp(DecodeUnicodeString(sms.SMS[0].Text), "hellohello") == 0);
+		count++;
+		start = FALSE;
+	}
+	took = bench_now() - took;
+
+	test_result(count == BENCH_MESSAGES);
+	printf("BENCH sms_read %.1f msg/s\n", count / took);
+	test_result(took / count < BENCH_BUDGET);
+}
+
+/**
+ * Measures sending of messages.
+ */
+static void bench_send(GSM_StateMachine *s, int iterations)
+{
+	GSM_SMSMessage sms;
+	double took, timeout;
+	int i;
+
+	took = bench_now();
+	for (i = 0; i < iterations; i++) {
+		bench_message(&sms, i);
+		sms_send_status = ERR_TIMEOUT;
+		gammu_test_result(GSM_SendSMS(s, &sms), "GSM_SendSMS");
+		timeout = bench_now() + BENCH_BUDGET;
+		while (sms_send_status == ERR_TIMEOUT && bench_now() < timeout) {
+			GSM_ReadDevice(s, TRUE);
+		}
+		gammu_test_result(sms_send_status, "Sending status");
+	}
+	took = bench_now() - took;
+
+	printf("BENCH sms_send %.1f msg/s\n", iterations / took);
+	test_result(took / iterations < BENCH_BUDGET);
+}
+
+/**
+ * Checks that injected errors are reported and do not break
+ * connection.
+ */
+static void bench_errors(const char *path, int iterations)
+{
+	GSM_StateMachine *s;
+	GSM_SignalQuality sig;
+	FakeModem_Config config;
+	pid_t pid;
+	int i, failed = 0;
+
+	memset(&config, 0, sizeof(config));
+	config.ErrorEvery = 3;
+	pid = fakemodem_start(path, &config);
+	test_result(pid > 0);
+
+	s = bench_connect(path);
+	for (i = 0; i < iterations; i++) {
+		if (GSM_GetSignalQuality(s, &sig) != ERR_NONE) {
+			failed++;
+		}
+	}
+	bench_disconnect(s);
+	fakemodem_stop(pid);
+
+	printf("BENCH injected_errors %d commands\n", failed);
+	test_result(failed > 0 && failed < iterations);
+}
+
+#ifdef HAVE_PTHREAD
+static void *bench_smsd_loop(void *data)
+{
+	SMSD_MainLoop((GSM_SMSDConfig *)data, FALSE, 0);
+	return NULL;
+}
+
+/**
+ * Measures SMSD sending and receiving messages end to end.
+ */
+static void bench_smsd(const char *path, const char *dir, int iterations)
+{
+	GSM_SMSDConfig *config;
+	GSM_SMSDStatus status;
+	GSM_MultiSMSMessage sms;
+	FakeModem_Config modem;
+	char filename[1000], command[2000], id[200];
+	pthread_t thread;
+	FILE *f;
+	double took, timeout;
+	pid_t pid;
+	int i;
+
+	/* Prepare directories and configuration */
+	sprintf(command, "rm -rf %s && mkdir -p %s/inbox %s/outbox %s/sent %s/error", dir, dir, dir, dir, dir);
+	test_result(system(command) == 0);
+	sprintf(filename, "%s/smsdrc", dir);
+	f = fopen(filename, "w");
+	test_result(f != NULL);
+	fprintf(f, "[gammu]\nconnection = unixat\ndevice = %s\n\n", path);
+	fprintf(f, "[smsd]\nservice = files\nlogfile = %s/smsd.log\ndebuglevel = 0\n", dir);
+	fprintf(f, "checksecurity = 0\ncheckbattery = 0\nchecksignal = 0\nstatusfrequency = 0\n");
+	fprintf(f, "commtimeout = 1\nsendtimeout = 10\n");
+	fprintf(f, "inboxpath = %s/inbox/\noutboxpath = %s/outbox/\n", dir, dir);
+	fprintf(f, "sentsmspath = %s/sent/\nerrorsmspath = %s/error/\n", dir, dir);
+	fclose(f);
+
+	memset(&modem, 0, sizeof(modem));
+	modem.Messages = BENCH_MESSAGES;
+	pid = fakemodem_start(path, &modem);
+	test_result(pid > 0);
+
+	/* Queue messages to send */
+	config = SMSD_NewConfig("at-benchmark");
+	test_result(config != NULL);
+	gammu_test_result(SMSD_ReadConfig(filename, config, TRUE), "SMSD_ReadConfig");
+	for (i = 0; i < iterations; i++) {
+		sms.Number = 1;
+		bench_message(&sms.SMS[0], i);
+		gammu_test_result(SMSD_InjectSMS(config, &sms, id), "SMSD_InjectSMS");
+	}
+	SMSD_FreeConfig(config);
+
+	/* Run daemon until everything is processed */
+	config = SMSD_NewConfig("at-benchmark");
+	test_result(config != NULL);
+	gammu_test_result(SMSD_ReadConfig(filename, config, TRUE), "SMSD_ReadConfig");
+
+	took = bench_now();
+	timeout = took + 120;
+	test_result(pthread_create(&thread, NULL, bench_smsd_loop, config) == 0);
+	memset(&status, 0, sizeof(status));
+	while (bench_now() < timeout) {
+		usleep(10000);
+		if (SMSD_GetStatus(config, &status) != ERR_NONE) {
+			continue;
+		}
+		if (status.Sent + status.Failed >= iterations && status.Received >= BENCH_MESSAGES) {
+			break;
+		}
+	}
+	took = bench_now() - took;
+	SMSD_Shutdown(config);
+	pthread_join(thread, NULL);
+	SMSD_FreeConfig(config);
+	fakemodem_stop(pid);
+
+	test_result(status.Sent == iterations);
+	test_result(status.Received == BENCH_MESSAGES);
+	printf("BENCH smsd_throughput %.1f msg/s\n", (iterations + BENCH_MESSAGES) / took);
+	test_result(took / (iterations + BENCH_MESSAGES) < BENCH_BUDGET);
+}
+#endif
+
+int main(int argc, char **argv)
+{
+	GSM_Debug_Info *debug_info;
+	GSM_StateMachine *s;
+	FakeModem_Config config;
+	double took;
+	pid_t pid;
+	int iterations = 100;
+
+	if (argc < 3 || argc > 4) {
+		printf("Usage: at-benchmark SOCKET DIR [ITERATIONS]\n");
+		return 1;
+	}
+	if (argc == 4) {
+		iterations = atoi(argv[3]);
+	}
+
+	GSM_InitLocales(NULL);
+	debug_info = GSM_GetGlobalDebug();
+	GSM_SetDebugFileDescriptor(stderr, FALSE, debug_info);
+	GSM_SetDebugLevel("nothing", debug_info);
+
+	memset(&config, 0, sizeof(config));
+	config.Messages = BENCH_MESSAGES;
+	pid = fakemodem_start(argv[1], &config);
+	test_result(pid > 0);
+
+	took = bench_now();
+	s = bench_connect(argv[1]);
+	took = bench_now() - took;
+	printf("BENCH connect %.3f ms\n", took * 1000);
+	test_result(took < BENCH_BUDGET);
+
+	bench_latency(s, iterations);
+	bench_read(s);
+	bench_send(s, iterations);
+
+	bench_disconnect(s);
+	fakemodem_stop(pid);
+
+	bench_errors(argv[1], 30);
+
+#ifdef HAVE_PTHREAD
+	bench_smsd(argv[1], argv[2], iterations / 5);
+#endif
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
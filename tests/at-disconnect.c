@@ -0,0 +1,83 @@
+/* Test for detecting closed and silent connection on AT driver */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include "../libgammu/gsmstate.h"	/* Needed for state machine internals */
+
+#include "common.h"
+#include "fakemodem.h"
+
+int main(int argc, char **argv)
+{
+	GSM_Debug_Info *debug_info;
+	GSM_StateMachine *s;
+	GSM_Config *smcfg;
+	GSM_SignalQuality sig;
+	GSM_BatteryCharge bat;
+	FakeModem_Config config;
+	GSM_Error error;
+	pid_t pid;
+
+	if (argc != 2) {
+		printf("Usage: at-disconnect SOCKET\n");
+		return 1;
+	}
+
+	debug_info = GSM_GetGlobalDebug();
+	GSM_SetDebugFileDescriptor(stderr, FALSE, debug_info);
+	GSM_SetDebugLevel("textall", debug_info);
+
+	memset(&config, 0, sizeof(config));
+	pid = fakemodem_start(argv[1], &config);
+	test_result(pid > 0);
+
+	s = GSM_AllocStateMachine();
+	test_result(s != NULL);
+	GSM_SetDebugGlobal(TRUE, GSM_GetDebug(s));
+
+	smcfg = GSM_GetConfig(s, 0);
+	smcfg->Model[0] = 0;
+	free(smcfg->Device);
+	smcfg->Device = strdup(argv[1]);
+	free(smcfg->Connection);
+	smcfg->Connection = strdup("unixat");
+	GSM_SetConfigNum(s, 1);
+
+	gammu_test_result(GSM_InitConnection(s, 1), "GSM_InitConnection");
+
+	/* Socket can be watched by the application */
+	test_result(GSM_GetDeviceDescriptor(s) >= 0);
+
+	gammu_test_result(GSM_GetSignalQuality(s, &sig), "GSM_GetSignalQuality");
+
+	/* Modem which does not answer, but keeps connection, times out */
+	test_result(kill(pid, SIGSTOP) == 0);
+	test_result(GSM_GetBatteryCharge(s, &bat) == ERR_TIMEOUT);
+	test_result(kill(pid, SIGCONT) == 0);
+
+	/* Late reply is consumed and connection still works */
+	usleep(500000);
+	test_result(GSM_ReadDevice(s, FALSE) > 0);
+	gammu_test_result(GSM_GetSignalQuality(s, &sig), "GSM_GetSignalQuality");
+
+	/*
+	 * Modem going away is reported without waiting for timeout and
+	 * without killing us by SIGPIPE.
+	 */
+	fakemodem_stop(pid);
+	error = GSM_GetSignalQuality(s, &sig);
+	test_result(error == ERR_DEVICEWRITEERROR || error == ERR_DEVICENOTWORK);
+
+	GSM_TerminateConnection(s);
+	GSM_FreeStateMachine(s);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
@@ -0,0 +1,60 @@
+/*
+ * Fake AT modem listening on Unix socket, use it with unixat connection:
+ *
+ * at-fakemodem [-l latency_ms] [-t bytes_per_sec] [-e error_every]
+ *              [-m messages] [-n connections] SOCKET
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fakemodem.h"
+
+int main(int argc, char **argv)
+{
+	FakeModem_Config config;
+	int opt;
+
+	memset(&config, 0, sizeof(config));
+
+	while ((opt = getopt(argc, argv, "l:t:e:m:n:")) != -1) {
+		switch (opt) {
+			case 'l':
+				config.Latency = atoi(optarg);
+				break;
+			case 't':
+				config.Throughput = atoi(optarg);
+				break;
+			case 'e':
+				config.ErrorEvery = atoi(optarg);
+				break;
+			case 'm':
+				config.Messages = atoi(optarg);
+				break;
+			case 'n':
+				config.Connections = atoi(optarg);
+				break;
+			default:
+				optind = argc;
+				break;
+		}
+	}
+
+	if (optind != argc - 1) {
+		printf("Usage: at-fakemodem [-l latency_ms] [-t bytes_per_sec] [-e error_every] [-m messages] [-n connections] SOCKET\n");
+		return 1;
+	}
+
+	if (fakemodem_serve(argv[optind], &config) != 0) {
+		printf("Could not listen on %s\n", argv[optind]);
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
@@ -0,0 +1,284 @@
+/* Test for reading all messages at once on AT driver */
+
+#include <gammu.h>
+#include <gammu-smsd.h>
+#include <gammu-config.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/time.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#include "../libgammu/gsmstate.h"	/* Needed for state machine internals */
+
+#include "common.h"
+#include "fakemodem.h"
+
+/**
+ * Number of messages in fake modem.
+ */
+#define MESSAGES 6
+
+/**
+ * Location of message garbled only in listing, it can be read.
+ */
+#define BROKEN 2
+
+/**
+ * Location of message garbled everywhere, it is skipped.
+ */
+#define CORRUPTED 4
+
+/**
+ * Messages collected by callback.
+ */
+typedef struct {
+	int Locations[MESSAGES];
+	int Count;
+	/**
+	 * Abort reading after this number of messages, 0 to read all.
+	 */
+	int AbortAfter;
+} ReadState;
+
+static GSM_Error collect_sms(GSM_StateMachine *s UNUSED, GSM_MultiSMSMessage *sms, void *user_data)
+{
+	ReadState *state = (ReadState *)user_data;
+
+	test_result(sms->Number == 1);
+	test_result(strcmp(DecodeUnicodeString(sms->SMS[0].Text), "hellohello") == 0);
+	test_result(state->Count < MESSAGES);
+	state->Locations[state->Count++] = sms->SMS[0].Location;
+
+	if (state->AbortAfter > 0 && state->Count >= state->AbortAfter) {
+		return ERR_ABORTED;
+	}
+	return ERR_NONE;
+}
+
+/**
+ * Connects to fake modem, optionally with listing disabled.
+ */
+static GSM_StateMachine *connect_modem(const char *socket, gboolean nolist)
+{
+	GSM_StateMachine *s;
+	GSM_Config *smcfg;
+
+	s = GSM_AllocStateMachine();
+	test_result(s != NULL);
+	GSM_SetDebugGlobal(TRUE, GSM_GetDebug(s));
+
+	smcfg = GSM_GetConfig(s, 0);
+	smcfg->Model[0] = 0;
+	free(smcfg->Device);
+	smcfg->Device = strdup(socket);
+	free(smcfg->Connection);
+	smcfg->Connection = strdup("unixat");
+	if (nolist) {
+		smcfg->PhoneFeatures[0] = F_DISABLE_CMGL;
+		smcfg->PhoneFeatures[1] = 0;
+	}
+	GSM_SetConfigNum(s, 1);
+
+	gammu_test_result(GSM_InitConnection(s, 1), "GSM_InitConnection");
+	return s;
+}
+
+static void disconnect_modem(GSM_StateMachine *s)
+{
+	gammu_test_result(GSM_TerminateConnection(s), "GSM_TerminateConnection");
+	GSM_FreeStateMachine(s);
+}
+
+/**
+ * Reads all messages from fake modem with garbled entries.
+ */
+static void read_all(const char *socket, gboolean nolist)
+{
+	GSM_StateMachine *s;
+	GSM_Phone_ATGENData *Priv;
+	GSM_MultiSMSMessage sms;
+	FakeModem_Config config;
+	ReadState state;
+	pid_t pid;
+	int i;
+
+	memset(&config, 0, sizeof(config));
+	config.Messages = MESSAGES;
+	config.BrokenMessage = BROKEN;
+	config.CorruptedMessage = CORRUPTED;
+	pid = fakemodem_start(socket, &config);
+	test_result(pid > 0);
+
+	s = connect_modem(socket, nolist);
+	Priv = &s->Phone.Data.Priv.ATGEN;
+
+	/* Everything except corrupted message is read in order */
+	memset(&state, 0, sizeof(state));
+	gammu_test_result(GSM_GetAllSMS(s, collect_sms, &state), "GSM_GetAllSMS");
+	test_result(state.Count == MESSAGES - 1);
+	for (i = 0; i < state.Count; i++) {
+		test_result(state.Locations[i] == (i + 1 < CORRUPTED ? i + 1 : i + 2));
+	}
+
+	if (nolist) {
+		/* Messages were read one by one */
+		test_result(Priv->SMSCache == NULL);
+	} else {
+		/*
+		 * Messages come from listing, the one garbled there could
+		 * be read only by falling back to reading it separately.
+		 */
+		test_result(Priv->SMSCache != NULL);
+	}
+
+	/* Error from callback stops reading */
+	memset(&state, 0, sizeof(state));
+	state.AbortAfter = 2;
+	test_result(GSM_GetAllSMS(s, collect_sms, &state) == ERR_ABORTED);
+	test_result(state.Count == 2);
+
+	/* Reading single messages reports corruption */
+	memset(&sms, 0, sizeof(sms));
+	sms.Number = 1;
+	sms.SMS[0].Location = BROKEN;
+	gammu_test_result(GSM_GetSMS(s, &sms), "GSM_GetSMS");
+	test_result(strcmp(DecodeUnicodeString(sms.SMS[0].Text), "hellohello") == 0);
+	sms.SMS[0].Folder = 0;
+	sms.SMS[0].Location = CORRUPTED;
+	test_result(GSM_GetSMS(s, &sms) == ERR_CORRUPTED);
+
+	disconnect_modem(s);
+	fakemodem_stop(pid);
+}
+
+#ifdef HAVE_PTHREAD
+static void *smsd_loop(void *data)
+{
+	SMSD_MainLoop((GSM_SMSDConfig *)data, FALSE, 0);
+	return NULL;
+}
+
+static double time_now(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/**
+ * Counts messages stored in inbox.
+ */
+static int count_inbox(const char *dir)
+{
+	char path[1000];
+	struct dirent *entry;
+	DIR *d;
+	int count = 0;
+
+	sprintf(path, "%s/inbox", dir);
+	d = opendir(path);
+	test_result(d != NULL);
+	while ((entry = readdir(d)) != NULL) {
+		if (entry->d_name[0] != '.') {
+			count++;
+		}
+	}
+	closedir(d);
+	return count;
+}
+
+/**
+ * Checks that SMSD receives valid messages despite corrupted one.
+ */
+static void smsd_receive(const char *socket, const char *dir)
+{
+	GSM_SMSDConfig *config;
+	GSM_SMSDStatus status;
+	FakeModem_Config modem;
+	char filename[1000], command[2000];
+	pthread_t thread;
+	FILE *f;
+	double timeout;
+	pid_t pid;
+
+	sprintf(command, "rm -rf %s && mkdir -p %s/inbox %s/outbox %s/sent %s/error", dir, dir, dir, dir, dir);
+	test_result(system(command) == 0);
+	sprintf(filename, "%s/smsdrc", dir);
+	f = fopen(filename, "w");
+	test_result(f != NULL);
+	fprintf(f, "[gammu]\nconnection = unixat\ndevice = %s\n\n", socket);
+	fprintf(f, "[smsd]\nservice = files\nlogfile = %s/smsd.log\ndebuglevel = 1\n", dir);
+	fprintf(f, "checksecurity = 0\ncheckbattery = 0\nchecksignal = 0\nstatusfrequency = 0\n");
+	fprintf(f, "commtimeout = 1\n");
+	fprintf(f, "inboxpath = %s/inbox/\noutboxpath = %s/outbox/\n", dir, dir);
+	fprintf(f, "sentsmspath = %s/sent/\nerrorsmspath = %s/error/\n", dir, dir);
+	fclose(f);
+
+	memset(&modem, 0, sizeof(modem));
+	modem.Messages = MESSAGES;
+	modem.BrokenMessage = BROKEN;
+	modem.CorruptedMessage = CORRUPTED;
+	pid = fakemodem_start(socket, &modem);
+	test_result(pid > 0);
+
+	config = SMSD_NewConfig("at-getallsms");
+	test_result(config != NULL);
+	gammu_test_result(SMSD_ReadConfig(filename, config, TRUE), "SMSD_ReadConfig");
+
+	timeout = time_now() + 60;
+	test_result(pthread_create(&thread, NULL, smsd_loop, config) == 0);
+	memset(&status, 0, sizeof(status));
+	while (time_now() < timeout) {
+		usleep(10000);
+		if (SMSD_GetStatus(config, &status) != ERR_NONE) {
+			continue;
+		}
+		if (status.Received >= MESSAGES - 1) {
+			break;
+		}
+	}
+	SMSD_Shutdown(config);
+	pthread_join(thread, NULL);
+	SMSD_FreeConfig(config);
+	fakemodem_stop(pid);
+
+	/* Corrupted message does not block the others */
+	test_result(status.Received == MESSAGES - 1);
+	test_result(count_inbox(dir) == MESSAGES - 1);
+}
+#endif
+
+int main(int argc, char **argv)
+{
+	GSM_Debug_Info *debug_info;
+
+	if (argc != 3) {
+		printf("Usage: at-getallsms SOCKET DIR\n");
+		return 1;
+	}
+
+	debug_info = GSM_GetGlobalDebug();
+	GSM_SetDebugFileDescriptor(stderr, FALSE, debug_info);
+	GSM_SetDebugLevel("textall", debug_info);
+
+	/* Listing with fallback to reading garbled entries */
+	read_all(argv[1], FALSE);
+
+	/* Reading one by one without listing */
+	read_all(argv[1], TRUE);
+
+#ifdef HAVE_PTHREAD
+	smsd_receive(argv[1], argv[2]);
+#endif
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
@@ -0,0 +1,121 @@
+/* Test for parsing memory range replies on AT driver */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "../libgammu/protocol/protocol.h"	/* Needed for GSM_Protocol_Message */
+#include "../libgammu/gsmstate.h"	/* Needed for state machine internals */
+#include "../libgammu/gsmphones.h"	/* Phone data */
+
+#include "common.h"
+
+#define BUFFER_SIZE 16384
+
+extern GSM_Error ATGEN_ReplyGetMemoryRange(GSM_Protocol_Message *msg, GSM_StateMachine * s);
+
+int main(int argc, char **argv)
+{
+	GSM_Debug_Info *debug_info;
+	GSM_Phone_ATGENData *Priv;
+	GSM_Phone_Data *Data;
+	unsigned char buffer[BUFFER_SIZE];
+	FILE *f;
+	size_t len;
+	GSM_StateMachine *s;
+	GSM_Protocol_Message msg;
+	GSM_Error error;
+	GSM_AT_PBK_Cache *Cache;
+
+	/* Check parameters */
+	if (argc != 2) {
+		printf("Not enough parameters!\nUsage: at-getmemory-range comm.dump\n");
+		return 1;
+	}
+
+	/* Open file */
+	f = fopen(argv[1], "r");
+	if (f == NULL) {
+		printf("Could not open %s\n", argv[1]);
+		return 1;
+	}
+
+	/* Read data */
+	len = fread(buffer, 1, sizeof(buffer) - 1, f);
+	if (!feof(f)) {
+		printf("Could not read whole file %s\n", argv[1]);
+		fclose(f);
+		return 1;
+	}
+	/* Zero terminate data */
+	buffer[len] = 0;
+
+	/* Close file */
+	fclose(f);
+
+	/* Configure state machine */
+	debug_info = GSM_GetGlobalDebug();
+	GSM_SetDebugFileDescriptor(stderr, FALSE, debug_info);
+	GSM_SetDebugLevel("textall", debug_info);
+
+	/* Allocates state machine */
+	s = GSM_AllocStateMachine();
+	test_result(s != NULL);
+	debug_info = GSM_GetDebug(s);
+	GSM_SetDebugGlobal(TRUE, debug_info);
+
+	/* Initialize AT engine */
+	Data = &s->Phone.Data;
+	Data->ModelInfo = GetModelData(NULL, NULL, "unknown", NULL);
+	Priv = &s->Phone.Data.Priv.ATGEN;
+	Priv->ReplyState = AT_Reply_OK;
+	Priv->Manufacturer = AT_Nokia;
+	Priv->SMSMode = SMS_AT_PDU;
+	Priv->Charset = AT_CHARSET_UTF8;
+	Priv->FirstMemoryEntry = 1;
+
+	/* Prepare cache as ATGEN_GetNextMemory does */
+	Cache = &Priv->PBKCache;
+	Cache->Entries = (GSM_MemoryEntry *)malloc(AT_PBK_READAHEAD * sizeof(GSM_MemoryEntry));
+	test_result(Cache->Entries != NULL);
+	Cache->MemoryType = MEM_SM;
+	Cache->First = 1;
+	Cache->Last = 20;
+	Cache->Count = 0;
+
+	/* Init message */
+	msg.Type = 0;
+	msg.Length = len;
+	msg.Buffer = buffer;
+	SplitLines(msg.Buffer, msg.Length, &Priv->Lines, "\x0D\x0A", 2, "\"", 1, TRUE);
+
+	/* Parse it */
+	error = ATGEN_ReplyGetMemoryRange(&msg, s);
+
+	/* This is normally done by ATGEN_Terminate */
+	FreeLines(&Priv->Lines);
+	GetLineString(NULL, NULL, 0);
+
+	gammu_test_result(error, "ATGEN_ReplyGetMemoryRange");
+
+	/* Duplicate location is stored only once */
+	test_result(Cache->Count == 3);
+	test_result(Cache->Entries[0].Location == 1);
+	test_result(Cache->Entries[1].Location == 3);
+	test_result(Cache->Entries[2].Location == 7);
+	test_result(Cache->Entries[1].MemoryType == MEM_SM);
+	test_result(Cache->Entries[1].EntriesNum == 2);
+	test_result(strcmp(DecodeUnicodeString(Cache->Entries[1].Entries[1].Text), "Second") == 0);
+	test_result(strcmp(DecodeUnicodeString(Cache->Entries[2].Entries[0].Text), "+31234657899") == 0);
+
+	/* Free state machine */
+	free(Cache->Entries);
+	Cache->Entries = NULL;
+	GSM_FreeStateMachine(s);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
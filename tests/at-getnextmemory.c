@@ -0,0 +1,108 @@
+/* Test for reading phonebook in ranges on AT driver */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "../libgammu/gsmstate.h"	/* Needed for state machine internals */
+
+#include "common.h"
+#include "fakemodem.h"
+
+/**
+ * Number of contacts in fake modem, spans several read ahead ranges.
+ */
+#define CONTACTS 45
+
+/**
+ * Reads whole SIM phonebook from fake modem with given behaviour and
+ * returns read ahead state of the driver.
+ */
+static int read_phonebook(const char *socket, int broken, int noranges)
+{
+	GSM_StateMachine *s;
+	GSM_Config *smcfg;
+	GSM_MemoryEntry entry;
+	GSM_Error error;
+	FakeModem_Config config;
+	char name[20];
+	int count = 0, result;
+	pid_t pid;
+
+	memset(&config, 0, sizeof(config));
+	config.Contacts = CONTACTS;
+	config.BrokenContact = broken;
+	config.NoRanges = noranges;
+	pid = fakemodem_start(socket, &config);
+	test_result(pid > 0);
+
+	s = GSM_AllocStateMachine();
+	test_result(s != NULL);
+	GSM_SetDebugGlobal(TRUE, GSM_GetDebug(s));
+
+	smcfg = GSM_GetConfig(s, 0);
+	smcfg->Model[0] = 0;
+	free(smcfg->Device);
+	smcfg->Device = strdup(socket);
+	free(smcfg->Connection);
+	smcfg->Connection = strdup("unixat");
+	GSM_SetConfigNum(s, 1);
+
+	gammu_test_result(GSM_InitConnection(s, 1), "GSM_InitConnection");
+
+	memset(&entry, 0, sizeof(entry));
+	entry.MemoryType = MEM_SM;
+	error = GSM_GetNextMemory(s, &entry, TRUE);
+	while (error == ERR_NONE) {
+		count++;
+		/* Every location is returned once and in order */
+		test_result(entry.Location == count);
+		test_result(entry.EntriesNum == 2);
+		sprintf(name, "Contact %d", count);
+		test_result(strcmp(DecodeUnicodeString(entry.Entries[1].Text), name) == 0);
+		GSM_FreeMemoryEntry(&entry);
+		error = GSM_GetNextMemory(s, &entry, FALSE);
+	}
+	test_result(error == ERR_EMPTY);
+	test_result(count == CONTACTS);
+
+	result = s->Phone.Data.Priv.ATGEN.PBKReadAhead;
+
+	gammu_test_result(GSM_TerminateConnection(s), "GSM_TerminateConnection");
+	GSM_FreeStateMachine(s);
+	fakemodem_stop(pid);
+
+	return result;
+}
+
+int main(int argc, char **argv)
+{
+	GSM_Debug_Info *debug_info;
+
+	if (argc != 2) {
+		printf("Usage: at-getnextmemory SOCKET\n");
+		return 1;
+	}
+
+	debug_info = GSM_GetGlobalDebug();
+	GSM_SetDebugFileDescriptor(stderr, FALSE, debug_info);
+	GSM_SetDebugLevel("textall", debug_info);
+
+	/* Ranges work */
+	test_result(read_phonebook(argv[1], 0, FALSE) == AT_AVAILABLE);
+
+	/* Garbled entry falls back only for its range */
+	test_result(read_phonebook(argv[1], 25, FALSE) == AT_AVAILABLE);
+
+	/* Garbled entry in the first range does not disable ranges */
+	test_result(read_phonebook(argv[1], 3, FALSE) == AT_AVAILABLE);
+
+	/* Phone rejecting ranges is read one by one */
+	test_result(read_phonebook(argv[1], 0, TRUE) == AT_NOTAVAILABLE);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
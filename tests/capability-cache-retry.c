@@ -0,0 +1,103 @@
+/* Test for recovering from failed connection with capability cache */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "../libgammu/gsmstate.h"	/* Needed for state machine internals */
+
+#include "common.h"
+#include "fakemodem.h"
+
+/**
+ * Connects to fake modem using capability cache.
+ */
+static GSM_StateMachine *cache_connect(const char *socket, const char *cache)
+{
+	GSM_StateMachine *s;
+	GSM_Config *smcfg;
+
+	s = GSM_AllocStateMachine();
+	test_result(s != NULL);
+	GSM_SetDebugGlobal(TRUE, GSM_GetDebug(s));
+
+	smcfg = GSM_GetConfig(s, 0);
+	smcfg->Model[0] = 0;
+	free(smcfg->Device);
+	smcfg->Device = strdup(socket);
+	free(smcfg->Connection);
+	smcfg->Connection = strdup("unixat");
+	free(smcfg->CapabilityCache);
+	smcfg->CapabilityCache = strdup(cache);
+	GSM_SetConfigNum(s, 1);
+
+	gammu_test_result(GSM_InitConnection(s, 1), "GSM_InitConnection");
+	return s;
+}
+
+/**
+ * Disconnects from phone, this stores the cache.
+ */
+static void cache_disconnect(GSM_StateMachine *s)
+{
+	gammu_test_result(GSM_TerminateConnection(s), "GSM_TerminateConnection");
+	GSM_FreeStateMachine(s);
+}
+
+int main(int argc, char **argv)
+{
+	GSM_Debug_Info *debug_info;
+	GSM_StateMachine *s;
+	FakeModem_Config config;
+	INI_Section *file;
+	char tmpname[1000];
+	pid_t pid;
+
+	if (argc != 3) {
+		printf("Usage: capability-cache-retry SOCKET CACHE\n");
+		return 1;
+	}
+
+	debug_info = GSM_GetGlobalDebug();
+	GSM_SetDebugFileDescriptor(stderr, FALSE, debug_info);
+	GSM_SetDebugLevel("textall", debug_info);
+
+	sprintf(tmpname, "%s.tmp", argv[2]);
+	remove(argv[2]);
+
+	/* Cache is written on first connection */
+	memset(&config, 0, sizeof(config));
+	pid = fakemodem_start(argv[1], &config);
+	test_result(pid > 0);
+	s = cache_connect(argv[1], argv[2]);
+	test_result(s->Phone.Data.CapabilityCache == NULL);
+	cache_disconnect(s);
+	fakemodem_stop(pid);
+	test_result(access(argv[2], F_OK) == 0);
+	test_result(access(tmpname, F_OK) != 0);
+
+	/* Connection with cache fails, phone is probed again */
+	config.FailConnections = 1;
+	pid = fakemodem_start(argv[1], &config);
+	test_result(pid > 0);
+	s = cache_connect(argv[1], argv[2]);
+	test_result(s->Phone.Data.CapabilityCache == NULL);
+	test_result(strcmp(s->Phone.Data.Model, "FakeModem") == 0);
+	cache_disconnect(s);
+	fakemodem_stop(pid);
+
+	/* Cache was rewritten */
+	gammu_test_result(INI_ReadFile(argv[2], FALSE, &file), "INI_ReadFile");
+	test_result(strcmp(INI_GetValue(file, "device", "Model", FALSE), "FakeModem") == 0);
+	INI_Free(file);
+	test_result(access(tmpname, F_OK) != 0);
+
+	remove(argv[2]);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
@@ -0,0 +1,105 @@
+/* Test for capability cache using dummy phone */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "../libgammu/protocol/protocol.h"	/* Needed for GSM_Protocol_Message */
+#include "../libgammu/gsmstate.h"	/* Needed for state machine internals */
+
+#include "common.h"
+
+GSM_StateMachine *s;
+
+/**
+ * Connects to dummy phone using capability cache.
+ */
+static void cache_connect(const char *device, const char *cache)
+{
+	GSM_Config *smcfg;
+	GSM_Debug_Info *debug_info;
+
+	s = GSM_AllocStateMachine();
+	test_result(s != NULL);
+
+	debug_info = GSM_GetDebug(s);
+	GSM_SetDebugGlobal(TRUE, debug_info);
+
+	smcfg = GSM_GetConfig(s, 0);
+	smcfg->Model[0] = 0;
+	smcfg->Device = strdup(device);
+	smcfg->Connection = strdup("none");
+	smcfg->UseGlobalDebugFile = TRUE;
+	smcfg->CapabilityCache = strdup(cache);
+	GSM_SetConfigNum(s, 1);
+
+	gammu_test_result(GSM_InitConnection(s, 1), "GSM_InitConnection");
+}
+
+/**
+ * Disconnects from phone, this stores the cache.
+ */
+static void cache_disconnect(void)
+{
+	gammu_test_result(GSM_TerminateConnection(s), "GSM_TerminateConnection");
+	GSM_FreeStateMachine(s);
+}
+
+/**
+ * Checks IMEI stored in cache file.
+ */
+static void check_imei(const char *cache, const char *imei)
+{
+	INI_Section *file;
+
+	gammu_test_result(INI_ReadFile(cache, FALSE, &file), "INI_ReadFile");
+	test_result(strcmp(INI_GetValue(file, "device", "Model", FALSE), "Dummy") == 0);
+	test_result(strcmp(INI_GetValue(file, "device", "IMEI", FALSE), imei) == 0);
+	INI_Free(file);
+}
+
+int main(int argc, char **argv)
+{
+	GSM_Debug_Info *debug_info;
+	FILE *f;
+
+	if (argc != 3) {
+		printf("Usage: capability-cache DEVICE CACHE\n");
+		return 1;
+	}
+
+	debug_info = GSM_GetGlobalDebug();
+	GSM_SetDebugFileDescriptor(stderr, FALSE, debug_info);
+	GSM_SetDebugLevel("textall", debug_info);
+
+	/* No cache yet, it is written after connecting */
+	remove(argv[2]);
+	cache_connect(argv[1], argv[2]);
+	test_result(s->Phone.Data.CapabilityCache == NULL);
+	check_imei(argv[2], "999999999999999");
+	cache_disconnect();
+
+	/* Cache is used on next connection */
+	cache_connect(argv[1], argv[2]);
+	test_result(s->Phone.Data.CapabilityCache != NULL);
+	cache_disconnect();
+
+	/* Cache for different phone is detected and refreshed */
+	f = fopen(argv[2], "w");
+	test_result(f != NULL);
+	fprintf(f, "[device]\nGammu = %s\nDevice = %s\nConnection = none\n", GAMMU_VERSION, argv[1]);
+	fprintf(f, "Manufacturer = Gammu\nModel = Dummy\nFirmware = %s\nIMEI = 123456789012345\n", GAMMU_VERSION);
+	fclose(f);
+	cache_connect(argv[1], argv[2]);
+	test_result(s->Phone.Data.CapabilityCache == NULL);
+	check_imei(argv[2], "999999999999999");
+	cache_disconnect();
+
+	remove(argv[2]);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
@@ -0,0 +1,71 @@
+/**
+ * Test case for GSM default alphabet encoder/decoder in Gammu
+ */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common.h"
+
+#include "../libgammu/misc/coding/coding.h"
+
+/* @, Euro, a with acute, {, Greek Delta, unmapped Cyrillic char */
+static const unsigned char text[] =
+	"\x00\x40\x20\xac\x00\xe1\x00\x7b\x03\x94\x04\x10\x00\x00";
+
+static const unsigned char encoded_ext[] = "\x00\x1b\x65\x61\x1b\x28\x10\x3f";
+
+static const unsigned char encoded_noext[] = "\x00\x3f\x61\x3f\x10\x3f";
+
+int main(int argc UNUSED, char **argv UNUSED)
+{
+	unsigned char gsm[200];
+	unsigned char unicode[400];
+	unsigned char all[256];
+	size_t len, srclen, smslen;
+	int i;
+
+	/* Whole alphabet survives round trip */
+	for (i = 0; i < 128; i++) {
+		all[i] = i;
+	}
+	DecodeDefault(unicode, all, 128, TRUE, NULL);
+	test_result(UnicodeLength(unicode) == 128);
+	len = 128;
+	EncodeDefault(gsm, unicode, &len, TRUE, NULL);
+	test_result(len == 128);
+	test_result(memcmp(gsm, all, 128) == 0);
+
+	/* Extension chars, conversion and unknown chars */
+	len = UnicodeLength(text);
+	EncodeDefault(gsm, text, &len, TRUE, NULL);
+	test_result(len == sizeof(encoded_ext) - 1);
+	test_result(memcmp(gsm, encoded_ext, len) == 0);
+
+	len = UnicodeLength(text);
+	EncodeDefault(gsm, text, &len, FALSE, NULL);
+	test_result(len == sizeof(encoded_noext) - 1);
+	test_result(memcmp(gsm, encoded_noext, len) == 0);
+
+	/* Decoding of extension chars */
+	DecodeDefault(unicode, encoded_ext, sizeof(encoded_ext) - 1, TRUE, NULL);
+	test_result(UnicodeLength(unicode) == 6);
+	test_result(unicode[2] == 0x20 && unicode[3] == 0xac);
+	test_result(unicode[6] == 0x00 && unicode[7] == 0x7b);
+
+	/* Length calculation counts escape sequences */
+	FindDefaultAlphabetLen(text, &srclen, &smslen, 160);
+	test_result(srclen == 6);
+	test_result(smslen == 8);
+	FindDefaultAlphabetLen(text, &srclen, &smslen, 2);
+	test_result(srclen == 1);
+	test_result(smslen == 1);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
@@ -0,0 +1,162 @@
+/* Test for recording and replaying device traffic */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "common.h"
+#include "fakemodem.h"
+
+/**
+ * Returns current time in seconds.
+ */
+static double now(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/**
+ * Connects using given connection, device and trace.
+ */
+static GSM_StateMachine *connect_phone(const char *connection, const char *device, const char *trace, int timing)
+{
+	GSM_StateMachine *s;
+	GSM_Config *smcfg;
+
+	s = GSM_AllocStateMachine();
+	test_result(s != NULL);
+	GSM_SetDebugGlobal(TRUE, GSM_GetDebug(s));
+
+	smcfg = GSM_GetConfig(s, 0);
+	smcfg->Model[0] = 0;
+	free(smcfg->Device);
+	smcfg->Device = strdup(device);
+	free(smcfg->Connection);
+	smcfg->Connection = strdup(connection);
+	free(smcfg->DeviceTrace);
+	smcfg->DeviceTrace = (trace == NULL) ? NULL : strdup(trace);
+	smcfg->ReplayTiming = timing;
+	GSM_SetConfigNum(s, 1);
+
+	gammu_test_result(GSM_InitConnection(s, 1), "GSM_InitConnection");
+	return s;
+}
+
+/**
+ * Disconnects and connects again with the same configuration.
+ */
+static void reconnect_phone(GSM_StateMachine *s)
+{
+	gammu_test_result(GSM_TerminateConnection(s), "GSM_TerminateConnection");
+	gammu_test_result(GSM_InitConnection(s, 1), "GSM_InitConnection");
+}
+
+static void disconnect_phone(GSM_StateMachine *s)
+{
+	gammu_test_result(GSM_TerminateConnection(s), "GSM_TerminateConnection");
+	GSM_FreeStateMachine(s);
+}
+
+/**
+ * Reads messages and signal quality, returns time it took including
+ * connecting.
+ */
+static double session(GSM_StateMachine *s, double start, GSM_SignalQuality *sig)
+{
+	GSM_MultiSMSMessage sms;
+
+	memset(&sms, 0, sizeof(sms));
+	gammu_test_result(GSM_GetNextSMS(s, &sms, TRUE), "GSM_GetNextSMS");
+	test_result(strcmp(DecodeUnicodeString(sms.SMS[0].Text), "hellohello") == 0);
+	gammu_test_result(GSM_GetSignalQuality(s, sig), "GSM_GetSignalQuality");
+	return now() - start;
+}
+
+int main(int argc, char **argv)
+{
+	GSM_Debug_Info *debug_info;
+	GSM_StateMachine *s;
+	GSM_SignalQuality recorded, replayed;
+	GSM_BatteryCharge bat;
+	FakeModem_Config config;
+	double start, record_time, replay_time;
+	char line[100];
+	int sessions = 0;
+	FILE *f;
+	pid_t pid;
+
+	if (argc != 3) {
+		printf("Usage: device-replay SOCKET TRACE\n");
+		return 1;
+	}
+
+	debug_info = GSM_GetGlobalDebug();
+	GSM_SetDebugFileDescriptor(stderr, FALSE, debug_info);
+	GSM_SetDebugLevel("textall", debug_info);
+
+	/* Recording appends to existing trace */
+	remove(argv[2]);
+
+	/* Record session with slow modem */
+	memset(&config, 0, sizeof(config));
+	config.Messages = 2;
+	config.Latency = 100;
+	pid = fakemodem_start(argv[1], &config);
+	test_result(pid > 0);
+
+	start = now();
+	s = connect_phone("unixat", argv[1], argv[2], 100);
+	record_time = session(s, start, &recorded);
+
+	/* Reconnecting does not overwrite first session */
+	reconnect_phone(s);
+	session(s, now(), &recorded);
+	disconnect_phone(s);
+	fakemodem_stop(pid);
+
+	/* Trace knows connection and contains both sessions */
+	f = fopen(argv[2], "r");
+	test_result(f != NULL);
+	test_result(fgets(line, sizeof(line), f) != NULL);
+	test_result(line[0] == '#');
+	test_result(fgets(line, sizeof(line), f) != NULL);
+	test_result(strcmp(line, "connection unixat\n") == 0);
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (strncmp(line, "# Session started ", 18) == 0) {
+			sessions++;
+		}
+		test_result(strncmp(line, "connection ", 11) != 0);
+	}
+	fclose(f);
+	test_result(sessions == 2);
+
+	/* Replay it without delays, reconnect continues in trace */
+	start = now();
+	s = connect_phone("replay", argv[2], NULL, 0);
+	test_result(GSM_GetUsedConnection(s) == GCT_UNIXAT);
+	replay_time = session(s, start, &replayed);
+	reconnect_phone(s);
+	session(s, now(), &replayed);
+	disconnect_phone(s);
+
+	test_result(memcmp(&recorded, &replayed, sizeof(recorded)) == 0);
+	printf("Recorded %.3f s, replayed %.3f s\n", record_time, replay_time);
+	test_result(replay_time < record_time);
+
+	/* Different commands do not match the trace */
+	s = connect_phone("replay", argv[2], NULL, 0);
+	test_result(GSM_GetBatteryCharge(s, &bat) == ERR_DEVICEWRITEERROR);
+	disconnect_phone(s);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
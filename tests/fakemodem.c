@@ -0,0 +1,733 @@
+/**
+ * \file fakemodem.c
+ *
+ * Scriptable fake AT modem used for testing and benchmarking.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include <gammu-misc.h>
+
+#include "fakemodem.h"
+
+/**
+ * Maximal length of hex encoded PDU including SMSC.
+ */
+#define FAKEMODEM_PDU_SIZE 512
+
+/**
+ * Maximal length of command line.
+ */
+#define FAKEMODEM_LINE_SIZE 1024
+
+/**
+ * SMS-DELIVER with text "hellohello" used to fill SIM memory.
+ */
+#define FAKEMODEM_DELIVER_PDU "07919730071111F1000B919746121611F10000811170021222230AE8329BFD4697D9EC37"
+
+/**
+ * Garbled variant of FAKEMODEM_DELIVER_PDU, it is not valid hex string.
+ */
+#define FAKEMODEM_GARBLED_PDU "07919730071111F1000B919746121611F10000811170021222230AE8329BFD4697D9ECXX"
+
+typedef struct {
+	/**
+	 * Message status as in AT+CMGL, -1 for empty location.
+	 */
+	int Status;
+	char PDU[FAKEMODEM_PDU_SIZE];
+} FakeModem_Message;
+
+typedef struct {
+	const char *Name;
+	int Size;
+	FakeModem_Message *Messages;
+} FakeModem_Store;
+
+typedef struct {
+	const FakeModem_Config *Config;
+	/**
+	 * Index of connection, starting from 0.
+	 */
+	int Connection;
+	int fd;
+	int Echo;
+	int Commands;
+	int Reference;
+	/**
+	 * Length of PDU expected after AT+CMGS or AT+CMGW prompt, 0 when
+	 * not waiting for PDU.
+	 */
+	int PromptLength;
+	int PromptStore;
+	FakeModem_Store *Read;
+	FakeModem_Store *Write;
+	/**
+	 * Character set selected by AT+CSCS.
+	 */
+	char Charset[10];
+	char Line[FAKEMODEM_LINE_SIZE];
+	size_t LineLength;
+} FakeModem_State;
+
+static FakeModem_Message fakemodem_sm[FAKEMODEM_SM_SIZE];
+static FakeModem_Message fakemodem_me[FAKEMODEM_ME_SIZE];
+
+static FakeModem_Store fakemodem_stores[] = {
+	{"SM", FAKEMODEM_SM_SIZE, fakemodem_sm},
+	{"ME", FAKEMODEM_ME_SIZE, fakemodem_me},
+};
+
+static void fakemodem_init_stores(const FakeModem_Config *config)
+{
+	int i;
+
+	for (i = 0; i < FAKEMODEM_SM_SIZE; i++) {
+		fakemodem_sm[i].Status = -1;
+		if (i < config->Messages) {
+			fakemodem_sm[i].Status = 0;
+			strcpy(fakemodem_sm[i].PDU, FAKEMODEM_DELIVER_PDU);
+		}
+	}
+	for (i = 0; i < FAKEMODEM_ME_SIZE; i++) {
+		fakemodem_me[i].Status = -1;
+	}
+}
+
+static FakeModem_Store *fakemodem_find_store(const char *name)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(fakemodem_stores) / sizeof(fakemodem_stores[0]); i++) {
+		if (strncasecmp(name, fakemodem_stores[i].Name, 2) == 0) {
+			return &fakemodem_stores[i];
+		}
+	}
+	return NULL;
+}
+
+static int fakemodem_store_used(const FakeModem_Store *store)
+{
+	int i, used = 0;
+
+	for (i = 0; i < store->Size; i++) {
+		if (store->Messages[i].Status != -1) {
+			used++;
+		}
+	}
+	return used;
+}
+
+/**
+ * Returns length of TPDU, what is PDU without SMSC part.
+ */
+static int fakemodem_tpdu_length(const char *pdu)
+{
+	int smsc;
+
+	if (sscanf(pdu, "%2x", &smsc) != 1) {
+		return 0;
+	}
+	return strlen(pdu) / 2 - smsc - 1;
+}
+
+/**
+ * Writes data to client, throttled to configured throughput.
+ */
+static void fakemodem_write(FakeModem_State *state, const char *data, size_t length)
+{
+	size_t done = 0;
+	ssize_t ret;
+
+	while (done < length) {
+		ret = write(state->fd, data + done, length - done);
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return;
+		}
+		done += ret;
+	}
+	if (state->Config->Throughput > 0) {
+		usleep((useconds_t)((double)length * 1000000 / state->Config->Throughput));
+	}
+}
+
+static void fakemodem_printf(FakeModem_State *state, const char *format, ...) PRINTF_STYLE(2, 3);
+
+static void fakemodem_printf(FakeModem_State *state, const char *format, ...)
+{
+	char buffer[FAKEMODEM_PDU_SIZE + 100];
+	va_list ap;
+	int length;
+
+	va_start(ap, format);
+	length = vsnprintf(buffer, sizeof(buffer), format, ap);
+	va_end(ap);
+	if (length > (int)sizeof(buffer) - 1) {
+		length = sizeof(buffer) - 1;
+	}
+	fakemodem_write(state, buffer, length);
+}
+
+/**
+ * Checks whether command should fail because of error injection.
+ */
+static int fakemodem_inject_error(FakeModem_State *state)
+{
+	state->Commands++;
+	return state->Config->ErrorEvery > 0 &&
+		state->Commands % state->Config->ErrorEvery == 0;
+}
+
+static void fakemodem_cpms_reply(FakeModem_State *state)
+{
+	fakemodem_printf(state, "\r\n+CPMS: %d,%d,%d,%d,%d,%d\r\n",
+		fakemodem_store_used(state->Read), state->Read->Size,
+		fakemodem_store_used(state->Write), state->Write->Size,
+		fakemodem_store_used(state->Write), state->Write->Size);
+}
+
+/**
+ * Handles AT+CPMS, selects memories for reading and writing.
+ */
+static int fakemodem_cpms(FakeModem_State *state, const char *args)
+{
+	FakeModem_Store *store;
+	const char *pos;
+
+	if (strcmp(args, "=?") == 0) {
+		fakemodem_printf(state, "\r\n+CPMS: (\"SM\",\"ME\"),(\"SM\",\"ME\"),(\"SM\",\"ME\")\r\n");
+		return 1;
+	}
+	if (strcmp(args, "?") == 0) {
+		fakemodem_printf(state, "\r\n+CPMS: \"%s\",%d,%d,\"%s\",%d,%d,\"%s\",%d,%d\r\n",
+			state->Read->Name, fakemodem_store_used(state->Read), state->Read->Size,
+			state->Write->Name, fakemodem_store_used(state->Write), state->Write->Size,
+			state->Write->Name, fakemodem_store_used(state->Write), state->Write->Size);
+		return 1;
+	}
+	if (args[0] != '=' || args[1] != '"') {
+		return 0;
+	}
+	store = fakemodem_find_store(args + 2);
+	if (store == NULL) {
+		return 0;
+	}
+	state->Read = store;
+	pos = strchr(args + 2, ',');
+	if (pos != NULL && pos[1] == '"') {
+		store = fakemodem_find_store(pos + 2);
+		if (store == NULL) {
+			return 0;
+		}
+		state->Write = store;
+	}
+	fakemodem_cpms_reply(state);
+	return 1;
+}
+
+/**
+ * Prints phonebook entry at location, does nothing for empty one.
+ */
+static void fakemodem_cpbr_entry(FakeModem_State *state, int location, int range)
+{
+	char name[20], encoded[100];
+	size_t i;
+
+	if (location < 1 || location > state->Config->Contacts) {
+		return;
+	}
+	if (range && location == state->Config->BrokenContact) {
+		fakemodem_printf(state, "\r\n+CPBR: %d,\"", location);
+		return;
+	}
+	sprintf(name, "Contact %d", location);
+	if (strcmp(state->Charset, "UCS2") == 0) {
+		for (i = 0; name[i] != 0; i++) {
+			sprintf(encoded + 4 * i, "%04X", (unsigned char)name[i]);
+		}
+	} else {
+		strcpy(encoded, name);
+	}
+	fakemodem_printf(state, "\r\n+CPBR: %d,\"+42077%05d\",145,\"%s\"",
+		location, location, encoded);
+}
+
+/**
+ * Handles AT+CPBR reading of single location or range from SIM
+ * phonebook.
+ */
+static int fakemodem_cpbr(FakeModem_State *state, const char *args)
+{
+	int start, end, i;
+
+	if (strcmp(args, "=?") == 0) {
+		fakemodem_printf(state, "\r\n+CPBR: (1-%d),20,20\r\n", FAKEMODEM_PB_SIZE);
+		return 1;
+	}
+	if (args[0] != '=') {
+		return 0;
+	}
+	i = sscanf(args + 1, "%d,%d", &start, &end);
+	if (i < 1) {
+		return 0;
+	}
+	if (i == 1) {
+		end = start;
+	} else if (state->Config->NoRanges) {
+		return 0;
+	}
+	if (start < 1 || end > FAKEMODEM_PB_SIZE || start > end) {
+		fakemodem_printf(state, "\r\n+CME ERROR: 21\r\n");
+		return -1;
+	}
+	for (i = start; i <= end; i++) {
+		fakemodem_cpbr_entry(state, i, start != end);
+	}
+	fakemodem_printf(state, "\r\n");
+	return 1;
+}
+
+/**
+ * Returns PDU of message as it should be sent to client, garbled if
+ * configured so for its location in SIM memory.
+ */
+static const char *fakemodem_message_pdu(FakeModem_State *state, const FakeModem_Message *message, int listing)
+{
+	int location;
+
+	if (state->Read->Messages != fakemodem_sm) {
+		return message->PDU;
+	}
+	location = message - fakemodem_sm + 1;
+	if (location == state->Config->CorruptedMessage ||
+			(listing && location == state->Config->BrokenMessage)) {
+		return FAKEMODEM_GARBLED_PDU;
+	}
+	return message->PDU;
+}
+
+/**
+ * Handles AT+CMGL listing of messages in reading memory.
+ */
+static void fakemodem_cmgl(FakeModem_State *state, int status)
+{
+	FakeModem_Message *message;
+	int i;
+
+	for (i = 0; i < state->Read->Size; i++) {
+		message = &state->Read->Messages[i];
+		if (message->Status == -1 || (status != 4 && message->Status != status)) {
+			continue;
+		}
+		fakemodem_printf(state, "\r\n+CMGL: %d,%d,,%d\r\n%s",
+			i + 1, message->Status, fakemodem_tpdu_length(message->PDU),
+			fakemodem_message_pdu(state, message, 1));
+		if (message->Status == 0) {
+			message->Status = 1;
+		}
+	}
+	fakemodem_printf(state, "\r\n");
+}
+
+/**
+ * Returns message at location in reading memory, NULL if empty.
+ */
+static FakeModem_Message *fakemodem_location(FakeModem_State *state, const char *args)
+{
+	int location;
+
+	location = atoi(args);
+	if (location < 1 || location > state->Read->Size ||
+			state->Read->Messages[location - 1].Status == -1) {
+		return NULL;
+	}
+	return &state->Read->Messages[location - 1];
+}
+
+/**
+ * Stores PDU received after prompt.
+ */
+static void fakemodem_pdu(FakeModem_State *state, const char *pdu)
+{
+	FakeModem_Store *store = state->Write;
+	int i;
+
+	if (state->Config->Latency > 0) {
+		usleep(state->Config->Latency * 1000);
+	}
+
+	if (strlen(pdu) >= FAKEMODEM_PDU_SIZE ||
+			fakemodem_tpdu_length(pdu) != state->PromptLength) {
+		fakemodem_printf(state, "\r\n+CMS ERROR: 304\r\n");
+		return;
+	}
+
+	if (!state->PromptStore) {
+		state->Reference = (state->Reference + 1) % 256;
+		fakemodem_printf(state, "\r\n+CMGS: %d\r\n\r\nOK\r\n", state->Reference);
+		return;
+	}
+
+	for (i = 0; i < store->Size; i++) {
+		if (store->Messages[i].Status == -1) {
+			store->Messages[i].Status = 2;
+			strcpy(store->Messages[i].PDU, pdu);
+			fakemodem_printf(state, "\r\n+CMGW: %d\r\n\r\nOK\r\n", i + 1);
+			return;
+		}
+	}
+	fakemodem_printf(state, "\r\n+CMS ERROR: 322\r\n");
+}
+
+/**
+ * Processes single command line, returns 1 for success, 0 for ERROR
+ * and -1 if reply was already sent.
+ */
+static int fakemodem_command(FakeModem_State *state, const char *line)
+{
+	FakeModem_Message *message;
+	const char *cmd;
+
+	if (strncasecmp(line, "AT", 2) != 0) {
+		return 0;
+	}
+	cmd = line + 2;
+
+	/* Basic commands */
+	if (cmd[0] == 0 || strcasecmp(cmd, "Z") == 0 || strcasecmp(cmd, "&F") == 0 ||
+			strcasecmp(cmd, "V1") == 0 || strcasecmp(cmd, "Q0") == 0) {
+		return 1;
+	}
+	if (strcasecmp(cmd, "E0") == 0 || strcasecmp(cmd, "E1") == 0) {
+		state->Echo = (cmd[1] == '1');
+		return 1;
+	}
+
+	/* Identification */
+	if (strcasecmp(cmd, "+CGMI") == 0 || strcasecmp(cmd, "+GMI") == 0) {
+		fakemodem_printf(state, "\r\nGammu\r\n");
+		return 1;
+	}
+	if (strcasecmp(cmd, "+CGMM") == 0 || strcasecmp(cmd, "+GMM") == 0) {
+		if (state->Connection < state->Config->FailConnections) return 0;
+		fakemodem_printf(state, "\r\nFakeModem\r\n");
+		return 1;
+	}
+	if (strcasecmp(cmd, "+CGMR") == 0 || strcasecmp(cmd, "+GMR") == 0) {
+		fakemodem_printf(state, "\r\n1.0\r\n");
+		return 1;
+	}
+	if (strcasecmp(cmd, "+CGSN") == 0 || strcasecmp(cmd, "+GSN") == 0) {
+		fakemodem_printf(state, "\r\n999999999999999\r\n");
+		return 1;
+	}
+	if (strcasecmp(cmd, "+CIMI") == 0) {
+		fakemodem_printf(state, "\r\n999990000000000\r\n");
+		return 1;
+	}
+	if (strcasecmp(cmd, "+CPIN?") == 0) {
+		fakemodem_printf(state, "\r\n+CPIN: READY\r\n");
+		return 1;
+	}
+
+	/* Setup */
+	if (strncasecmp(cmd, "+CMEE=", 6) == 0 || strncasecmp(cmd, "+CNMI=", 6) == 0 ||
+			strncasecmp(cmd, "+CREG=", 6) == 0 || strncasecmp(cmd, "+COPS=", 6) == 0 ||
+			strcasecmp(cmd, "+CMGF=0") == 0) {
+		return 1;
+	}
+	if (strcasecmp(cmd, "+CMGF=?") == 0) {
+		fakemodem_printf(state, "\r\n+CMGF: (0)\r\n");
+		return 1;
+	}
+	if (strcasecmp(cmd, "+CSCS=?") == 0) {
+		fakemodem_printf(state, "\r\n+CSCS: (\"GSM\",\"IRA\",\"UCS2\")\r\n");
+		return 1;
+	}
+	if (strcasecmp(cmd, "+CSCS?") == 0) {
+		fakemodem_printf(state, "\r\n+CSCS: \"%s\"\r\n", state->Charset);
+		return 1;
+	}
+	if (strcasecmp(cmd, "+CSCS=\"GSM\"") == 0 || strcasecmp(cmd, "+CSCS=\"IRA\"") == 0 ||
+			strcasecmp(cmd, "+CSCS=\"UCS2\"") == 0) {
+		snprintf(state->Charset, sizeof(state->Charset), "%.*s",
+			(int)strlen(cmd + 7) - 1, cmd + 7);
+		return 1;
+	}
+	if (strcasecmp(cmd, "+CNMI=?") == 0) {
+		fakemodem_printf(state, "\r\n+CNMI: (0-2),(0-3),(0-3),(0-2),(0,1)\r\n");
+		return 1;
+	}
+	if (strcasecmp(cmd, "+CSCA?") == 0) {
+		fakemodem_printf(state, "\r\n+CSCA: \"+12345678901\",145\r\n");
+		return 1;
+	}
+	if (strncasecmp(cmd, "+CPMS", 5) == 0) {
+		return fakemodem_cpms(state, cmd + 5);
+	}
+
+	/* Phonebook, only SIM one is there */
+	if (strcasecmp(cmd, "+CPBS=?") == 0) {
+		fakemodem_printf(state, "\r\n+CPBS: (\"SM\")\r\n");
+		return 1;
+	}
+	if (strcasecmp(cmd, "+CPBS?") == 0) {
+		fakemodem_printf(state, "\r\n+CPBS: \"SM\",%d,%d\r\n",
+			state->Config->Contacts, FAKEMODEM_PB_SIZE);
+		return 1;
+	}
+	if (strcasecmp(cmd, "+CPBS=\"SM\"") == 0) {
+		return 1;
+	}
+	if (strncasecmp(cmd, "+CPBR", 5) == 0) {
+		return fakemodem_cpbr(state, cmd + 5);
+	}
+
+	/* Status and messages, these are subject of error injection */
+	if (strcasecmp(cmd, "+CSQ") == 0) {
+		if (fakemodem_inject_error(state)) return 0;
+		fakemodem_printf(state, "\r\n+CSQ: 20,99\r\n");
+		return 1;
+	}
+	if (strcasecmp(cmd, "+CBC") == 0) {
+		if (fakemodem_inject_error(state)) return 0;
+		fakemodem_printf(state, "\r\n+CBC: 0,80\r\n");
+		return 1;
+	}
+	if (strcasecmp(cmd, "+CREG?") == 0) {
+		if (fakemodem_inject_error(state)) return 0;
+		fakemodem_printf(state, "\r\n+CREG: 2,1,\"0001\",\"0002\"\r\n");
+		return 1;
+	}
+	if (strcasecmp(cmd, "+COPS?") == 0) {
+		if (fakemodem_inject_error(state)) return 0;
+		fakemodem_printf(state, "\r\n+COPS: 0,2,\"99999\"\r\n");
+		return 1;
+	}
+	if (strncasecmp(cmd, "+CMGL=", 6) == 0) {
+		if (fakemodem_inject_error(state)) return 0;
+		fakemodem_cmgl(state, atoi(cmd + 6));
+		return 1;
+	}
+	if (strncasecmp(cmd, "+CMGR=", 6) == 0) {
+		if (fakemodem_inject_error(state)) return 0;
+		message = fakemodem_location(state, cmd + 6);
+		if (message == NULL) {
+			fakemodem_printf(state, "\r\n+CMS ERROR: 321\r\n");
+			return -1;
+		}
+		fakemodem_printf(state, "\r\n+CMGR: %d,,%d\r\n%s\r\n",
+			message->Status, fakemodem_tpdu_length(message->PDU),
+			fakemodem_message_pdu(state, message, 0));
+		if (message->Status == 0) {
+			message->Status = 1;
+		}
+		return 1;
+	}
+	if (strncasecmp(cmd, "+CMGD=", 6) == 0) {
+		if (fakemodem_inject_error(state)) return 0;
+		message = fakemodem_location(state, cmd + 6);
+		if (message == NULL) {
+			fakemodem_printf(state, "\r\n+CMS ERROR: 321\r\n");
+			return -1;
+		}
+		message->Status = -1;
+		return 1;
+	}
+	if (strncasecmp(cmd, "+CMGS=", 6) == 0 || strncasecmp(cmd, "+CMGW=", 6) == 0) {
+		if (fakemodem_inject_error(state)) return 0;
+		state->PromptLength = atoi(cmd + 6);
+		state->PromptStore = (toupper((int)cmd[4]) == 'W');
+		if (state->PromptLength <= 0) {
+			state->PromptLength = 0;
+			return 0;
+		}
+		fakemodem_printf(state, "\r\n> ");
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Processes one complete line received from client.
+ */
+static void fakemodem_line(FakeModem_State *state, const char *line)
+{
+	int result;
+
+	if (state->Echo) {
+		fakemodem_write(state, line, strlen(line));
+		fakemodem_write(state, "\r", 1);
+	}
+	if (line[0] == 0) {
+		return;
+	}
+	if (state->Config->Latency > 0) {
+		usleep(state->Config->Latency * 1000);
+	}
+	result = fakemodem_command(state, line);
+	if (result == 1) {
+		fakemodem_printf(state, "\r\nOK\r\n");
+	} else if (result == 0) {
+		fakemodem_printf(state, "\r\nERROR\r\n");
+	}
+}
+
+/**
+ * Processes data received from client.
+ */
+static void fakemodem_receive(FakeModem_State *state, const char *data, size_t length)
+{
+	size_t i;
+	char c;
+
+	for (i = 0; i < length; i++) {
+		c = data[i];
+		if (state->PromptLength > 0) {
+			/* Waiting for PDU terminated by Ctrl+Z, Esc cancels */
+			if (c == 0x1A || c == 0x1B) {
+				state->Line[state->LineLength] = 0;
+				if (c == 0x1A) {
+					fakemodem_pdu(state, state->Line);
+				} else {
+					fakemodem_printf(state, "\r\nOK\r\n");
+				}
+				state->PromptLength = 0;
+				state->LineLength = 0;
+			} else if (c != '\r' && c != '\n' && state->LineLength < sizeof(state->Line) - 1) {
+				state->Line[state->LineLength++] = c;
+			}
+			continue;
+		}
+		if (c == '\r') {
+			state->Line[state->LineLength] = 0;
+			fakemodem_line(state, state->Line);
+			state->LineLength = 0;
+		} else if (c == 0x1B) {
+			/* Escape from message mode which was not entered */
+			state->LineLength = 0;
+		} else if (c != '\n' && state->LineLength < sizeof(state->Line) - 1) {
+			state->Line[state->LineLength++] = c;
+		}
+	}
+}
+
+static void fakemodem_connection(const FakeModem_Config *config, int connection, int fd)
+{
+	FakeModem_State state;
+	char buffer[256];
+	ssize_t length;
+
+	memset(&state, 0, sizeof(state));
+	state.Config = config;
+	state.Connection = connection;
+	state.fd = fd;
+	state.Echo = 1;
+	state.Read = &fakemodem_stores[0];
+	state.Write = &fakemodem_stores[0];
+	strcpy(state.Charset, "GSM");
+
+	while (1) {
+		length = read(fd, buffer, sizeof(buffer));
+		if (length < 0 && errno == EINTR) {
+			continue;
+		}
+		if (length <= 0) {
+			break;
+		}
+		fakemodem_receive(&state, buffer, length);
+	}
+	close(fd);
+}
+
+int fakemodem_serve(const char *path, const FakeModem_Config *config)
+{
+	struct sockaddr_un addr;
+	int server, client, served = 0;
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		return -1;
+	}
+
+	fakemodem_init_stores(config);
+
+	server = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (server < 0) {
+		return -1;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	remove(path);
+	if (bind(server, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(server, 1) != 0) {
+		close(server);
+		return -1;
+	}
+
+	while (config->Connections == 0 || served < config->Connections) {
+		client = accept(server, NULL, NULL);
+		if (client < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+		fakemodem_connection(config, served, client);
+		served++;
+	}
+
+	close(server);
+	remove(path);
+	return 0;
+}
+
+pid_t fakemodem_start(const char *path, const FakeModem_Config *config)
+{
+	pid_t pid;
+	int i;
+
+	remove(path);
+	pid = fork();
+	if (pid < 0) {
+		return -1;
+	}
+	if (pid == 0) {
+		_exit(fakemodem_serve(path, config) == 0 ? 0 : 1);
+	}
+
+	/* Wait for socket to appear */
+	for (i = 0; i < 500; i++) {
+		if (access(path, F_OK) == 0) {
+			return pid;
+		}
+		usleep(10000);
+	}
+	fakemodem_stop(pid);
+	return -1;
+}
+
+void fakemodem_stop(pid_t pid)
+{
+	kill(pid, SIGTERM);
+	waitpid(pid, NULL, 0);
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
@@ -0,0 +1,119 @@
+/**
+ * \file fakemodem.h
+ *
+ * Scriptable fake AT modem used for testing and benchmarking.
+ *
+ * The modem listens on Unix domain socket, so that it can be used with
+ * unixat connection. It understands commands needed for identification,
+ * network status, PDU mode messages stored in SIM (SM) and phone (ME)
+ * memories and SIM phonebook.
+ */
+#ifndef _fakemodem_h_
+#define _fakemodem_h_
+
+#include <sys/types.h>
+
+/**
+ * Number of messages which fit into SIM memory.
+ */
+#define FAKEMODEM_SM_SIZE 100
+
+/**
+ * Number of messages which fit into phone memory.
+ */
+#define FAKEMODEM_ME_SIZE 250
+
+/**
+ * Number of contacts which fit into SIM phonebook.
+ */
+#define FAKEMODEM_PB_SIZE 100
+
+/**
+ * Fake modem behaviour.
+ */
+typedef struct {
+	/**
+	 * Delay before each reply in milliseconds.
+	 */
+	int Latency;
+	/**
+	 * Throughput of the line in bytes per second, 0 for unlimited.
+	 */
+	int Throughput;
+	/**
+	 * Every Nth status or message command fails with ERROR, 0 to
+	 * disable. Identification and setup commands never fail, so that
+	 * connection can be always established.
+	 */
+	int ErrorEvery;
+	/**
+	 * Number of received messages preloaded in SIM memory.
+	 */
+	int Messages;
+	/**
+	 * Number of contacts preloaded in SIM phonebook, from location 1.
+	 */
+	int Contacts;
+	/**
+	 * Location of contact which is garbled when read as part of
+	 * range, 0 to disable.
+	 */
+	int BrokenContact;
+	/**
+	 * Reject reading range of phonebook locations with ERROR.
+	 */
+	int NoRanges;
+	/**
+	 * Location of message in SIM memory which is garbled when listed
+	 * by AT+CMGL, reading it by AT+CMGR works, 0 to disable.
+	 */
+	int BrokenMessage;
+	/**
+	 * Location of message in SIM memory which is garbled both when
+	 * listed and read, 0 to disable.
+	 */
+	int CorruptedMessage;
+	/**
+	 * Number of first connections on which model identification fails
+	 * with ERROR.
+	 */
+	int FailConnections;
+	/**
+	 * Number of connections to serve before exiting, 0 for unlimited.
+	 */
+	int Connections;
+} FakeModem_Config;
+
+/**
+ * Serves connections on Unix socket, returns after configured number
+ * of connections.
+ *
+ * \param path Path of the socket to create.
+ * \param config Modem behaviour.
+ *
+ * \return 0 on success, -1 on socket error.
+ */
+int fakemodem_serve(const char *path, const FakeModem_Config *config);
+
+/**
+ * Starts fake modem in child process and waits until it listens.
+ *
+ * \param path Path of the socket to create.
+ * \param config Modem behaviour.
+ *
+ * \return Process ID of modem, -1 on failure.
+ */
+pid_t fakemodem_start(const char *path, const FakeModem_Config *config);
+
+/**
+ * Terminates fake modem started by fakemodem_start.
+ *
+ * \param pid Process ID of modem.
+ */
+void fakemodem_stop(pid_t pid);
+
+#endif
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
@@ -0,0 +1,161 @@
+/* Test for streaming file API using dummy phone */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common.h"
+
+/**
+ * Size of test file, bigger than single part of most drivers.
+ */
+#define FILE_SIZE 10000
+
+/**
+ * State of streamed transfer.
+ */
+typedef struct {
+	size_t done;
+	size_t fail_at;
+	GSM_Error error;
+} StreamState;
+
+/**
+ * Returns byte expected at given position of test file.
+ */
+static unsigned char pattern(size_t pos)
+{
+	return (unsigned char)(pos % 251);
+}
+
+static GSM_Error source(GSM_StateMachine *s UNUSED, GSM_File *File UNUSED,
+			unsigned char *data, size_t length, void *user_data)
+{
+	StreamState *state = (StreamState *)user_data;
+	size_t i;
+
+	if (state->done + length > state->fail_at) {
+		return state->error;
+	}
+	for (i = 0; i < length; i++) {
+		data[i] = pattern(state->done + i);
+	}
+	state->done += length;
+	return ERR_NONE;
+}
+
+static GSM_Error sink(GSM_StateMachine *s UNUSED, GSM_File *File,
+		      const unsigned char *data, size_t length,
+		      size_t total UNUSED, void *user_data)
+{
+	StreamState *state = (StreamState *)user_data;
+	size_t i;
+
+	if (state->done + length > state->fail_at) {
+		return state->error;
+	}
+	for (i = 0; i < length; i++) {
+		test_result(data[i] == pattern(state->done + i));
+	}
+	state->done += length;
+	test_result(File->Used == state->done);
+	return ERR_NONE;
+}
+
+/**
+ * Initializes file structure for given name in root folder.
+ */
+static void init_file(GSM_File *File, const char *name, size_t size)
+{
+	memset(File, 0, sizeof(GSM_File));
+	EncodeUnicode(File->Name, name, strlen(name));
+	File->Used = size;
+	File->Buffer = NULL;
+}
+
+/**
+ * Initializes transfer state.
+ */
+static void init_state(StreamState *state, size_t fail_at, GSM_Error error)
+{
+	state->done = 0;
+	state->fail_at = fail_at;
+	state->error = error;
+}
+
+int main(int argc, char **argv)
+{
+	GSM_Debug_Info *debug_info;
+	GSM_StateMachine *s;
+	GSM_Config *smcfg;
+	GSM_File File;
+	StreamState state;
+	unsigned char fullname[2 * (GSM_MAX_FILENAME_ID_LENGTH + 1)];
+
+	if (argc != 2) {
+		printf("Usage: file-stream DEVICE\n");
+		return 1;
+	}
+
+	debug_info = GSM_GetGlobalDebug();
+	GSM_SetDebugFileDescriptor(stderr, FALSE, debug_info);
+	GSM_SetDebugLevel("textall", debug_info);
+
+	s = GSM_AllocStateMachine();
+	test_result(s != NULL);
+	GSM_SetDebugGlobal(TRUE, GSM_GetDebug(s));
+
+	smcfg = GSM_GetConfig(s, 0);
+	smcfg->Model[0] = 0;
+	free(smcfg->Device);
+	smcfg->Device = strdup(argv[1]);
+	free(smcfg->Connection);
+	smcfg->Connection = strdup("none");
+	GSM_SetConfigNum(s, 1);
+
+	gammu_test_result(GSM_InitConnection(s, 1), "GSM_InitConnection");
+
+	/* Data come from source */
+	init_file(&File, "stream.bin", FILE_SIZE);
+	init_state(&state, FILE_SIZE, ERR_NONE);
+	gammu_test_result(GSM_AddFileStream(s, &File, source, &state), "GSM_AddFileStream");
+	test_result(state.done == FILE_SIZE);
+	test_result(File.Buffer == NULL);
+	CopyUnicodeString(fullname, File.ID_FullName);
+
+	/* Sink gets all data in order */
+	init_file(&File, "", 0);
+	CopyUnicodeString(File.ID_FullName, fullname);
+	init_state(&state, FILE_SIZE, ERR_NONE);
+	gammu_test_result(GSM_GetFileStream(s, &File, sink, &state), "GSM_GetFileStream");
+	test_result(state.done == FILE_SIZE);
+	test_result(File.Buffer == NULL);
+
+	/* Error from sink aborts transfer */
+	init_file(&File, "", 0);
+	CopyUnicodeString(File.ID_FullName, fullname);
+	init_state(&state, 0, ERR_WRITING_FILE);
+	test_result(GSM_GetFileStream(s, &File, sink, &state) == ERR_WRITING_FILE);
+	test_result(File.Buffer == NULL);
+
+	/* Error from source aborts transfer */
+	init_file(&File, "failed.bin", FILE_SIZE);
+	init_state(&state, 0, ERR_CANTOPENFILE);
+	test_result(GSM_AddFileStream(s, &File, source, &state) == ERR_CANTOPENFILE);
+	test_result(File.Buffer == NULL);
+
+	/* Cleanup */
+	init_file(&File, "", 0);
+	CopyUnicodeString(File.ID_FullName, fullname);
+	gammu_test_result(GSM_DeleteFile(s, File.ID_FullName), "GSM_DeleteFile");
+
+	gammu_test_result(GSM_TerminateConnection(s), "GSM_TerminateConnection");
+	GSM_FreeStateMachine(s);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
@@ -0,0 +1,69 @@
+/**
+ * Test case for hex encoder/decoder in Gammu
+ */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "common.h"
+
+#include "../libgammu/misc/coding/coding.h"
+
+static const unsigned char binary[] = "\x00\x01\x7f\x80\xab\xcd\xef\xff";
+
+static const char hex[] = "00017F80ABCDEFFF";
+
+int main(int argc UNUSED, char **argv UNUSED)
+{
+	char encoded[100];
+	unsigned char decoded[100];
+	int i;
+
+	/* Encoding */
+	EncodeHexBin(encoded, binary, sizeof(binary) - 1);
+	test_result(strcmp(encoded, hex) == 0);
+
+	EncodeHexUnicode(encoded, binary, 2);
+	test_result(strcmp(encoded, "00017F80") == 0);
+
+	/* Decoding is case insensitive */
+	test_result(DecodeHexBin(decoded, (const unsigned char *)hex, strlen(hex)));
+	test_result(memcmp(decoded, binary, sizeof(binary) - 1) == 0);
+	test_result(DecodeHexBin(decoded, (const unsigned char *)"abCDef", 6));
+	test_result(memcmp(decoded, "\xab\xcd\xef", 4) == 0);
+
+	DecodeHexUnicode(decoded, "004100e4", 8);
+	test_result(memcmp(decoded, "\x00\x41\x00\xe4\x00\x00", 6) == 0);
+
+	/* Invalid input */
+	test_result(!DecodeHexBin(decoded, (const unsigned char *)"0G", 2));
+	test_result(!DecodeHexBin(decoded, (const unsigned char *)"12 4", 4));
+
+	/* Error position */
+	test_result(FindNonHexChar(hex, strlen(hex)) == strlen(hex));
+	test_result(FindNonHexChar("", 0) == 0);
+	test_result(FindNonHexChar("0123456789abcdefABCDEF", 22) == 22);
+	test_result(FindNonHexChar("0123456789,0", 12) == 10);
+	test_result(FindNonHexChar("01g", 3) == 2);
+	test_result(FindNonHexChar("\xff", 1) == 0);
+
+	/* Single digits */
+	for (i = 0; i < 256; i++) {
+		if ((i >= '0' && i <= '9') || (i >= 'a' && i <= 'f') || (i >= 'A' && i <= 'F')) {
+			test_result(DecodeWithHexBinAlphabet(i) >= 0);
+			test_result(EncodeWithHexBinAlphabet(DecodeWithHexBinAlphabet(i)) == toupper(i));
+		} else {
+			test_result(DecodeWithHexBinAlphabet(i) == -1);
+		}
+	}
+	test_result(EncodeWithHexBinAlphabet(16) == 0);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
@@ -0,0 +1,363 @@
+/* Test for streamed file parts on Nokia 6510 driver */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "../libgammu/protocol/protocol.h"	/* Needed for GSM_Protocol_Message */
+#include "../libgammu/gsmstate.h"	/* Needed for state machine internals */
+#include "../libgammu/phone/nokia/dct4s40/6510/6510file.h"	/* This is not part of API! */
+
+#include "common.h"
+
+/**
+ * Size of test file, one big part and one standard part.
+ */
+#define FILE_SIZE (N6510_FILE_PART_MAX + N6510_FILE_PART)
+
+/**
+ * Checksum of test file as calculated over whole buffer.
+ */
+#define FILE_CHECKSUM 0x3A22
+
+unsigned char frame[10 + N6510_FILE_PART_MAX];
+
+size_t received;
+
+/**
+ * Returns byte of test file at given position.
+ */
+static unsigned char pattern(size_t pos)
+{
+	return (unsigned char)(pos % 251);
+}
+
+static GSM_Error sink(GSM_StateMachine *s UNUSED, GSM_File *File,
+		      const unsigned char *data, size_t length,
+		      size_t total, void *user_data UNUSED)
+{
+	size_t i;
+
+	test_result(total == FILE_SIZE);
+	for (i = 0; i < length; i++) {
+		test_result(data[i] == pattern(received + i));
+	}
+	received += length;
+	test_result(File->Used == received);
+	return ERR_NONE;
+}
+
+/**
+ * Fills frame with file part starting at given position, the reply
+ * claims to contain length bytes, but carries only sent ones.
+ */
+static void fill_part(unsigned char type, size_t start, size_t length, size_t sent)
+{
+	size_t i;
+
+	memset(frame, 0, 10);
+	frame[3] = type;
+	frame[6] = (length >> 24) & 0xff;
+	frame[7] = (length >> 16) & 0xff;
+	frame[8] = (length >> 8) & 0xff;
+	frame[9] = length & 0xff;
+	for (i = 0; i < sent; i++) {
+		frame[10 + i] = pattern(start + i);
+	}
+}
+
+/**
+ * Passes file part starting at given position to the driver, the
+ * reply claims to contain length bytes, but carries only sent ones.
+ */
+static GSM_Error send_part(GSM_StateMachine *s, size_t start, size_t length, size_t sent)
+{
+	GSM_Protocol_Message msg;
+
+	fill_part(0x0F, start, length, sent);
+
+	msg.Type = 0x6D;
+	msg.Length = 10 + sent;
+	msg.Buffer = frame;
+
+	return N6510_ReplyGetFilePart12(&msg, s);
+}
+
+/**
+ * Reads whole test file in parts of given size, returns checksum.
+ */
+static int read_file(GSM_StateMachine *s, size_t part)
+{
+	GSM_Phone_N6510Data *Priv = &s->Phone.Data.Priv.N6510;
+	GSM_File File;
+	size_t length;
+
+	memset(&File, 0, sizeof(File));
+	s->Phone.Data.File = &File;
+	Priv->FileSink = sink;
+	Priv->FileStreamData = NULL;
+	Priv->FileSize = FILE_SIZE;
+	Priv->FileCheckAcc = 0xffff;
+	Priv->FileCheckAccx = 0;
+	received = 0;
+
+	while (File.Used < FILE_SIZE) {
+		length = FILE_SIZE - File.Used;
+		if (length > part) {
+			length = part;
+		}
+		gammu_test_result(send_part(s, File.Used, length, length), "N6510_ReplyGetFilePart12");
+	}
+	test_result(received == FILE_SIZE);
+	test_result(File.Buffer == NULL);
+
+	return Priv->FileCheckAcc & 0xffff;
+}
+
+/**
+ * How fake phone answers request for part bigger than it can send.
+ */
+typedef enum {
+	/**
+	 * Sends smaller part.
+	 */
+	PHONE_SMALLER = 1,
+	/**
+	 * Sends empty part.
+	 */
+	PHONE_EMPTY,
+	/**
+	 * Claims to send requested part, but sends smaller one.
+	 */
+	PHONE_SHORT
+} PhoneBehaviour;
+
+/**
+ * Biggest part fake phone sends.
+ */
+size_t phone_part;
+
+PhoneBehaviour phone_behaviour;
+
+/**
+ * Checksum of file reported by fake phone.
+ */
+int phone_checksum;
+
+/**
+ * Number of file part requests received by fake phone.
+ */
+int phone_requests;
+
+GSM_Protocol_Message phone_reply;
+
+gboolean phone_reply_pending;
+
+/**
+ * Prepares reply of fake phone with filesystem 2 to the request.
+ */
+static GSM_Error phone_write_message(GSM_StateMachine *s UNUSED, unsigned const char *buffer,
+				     int length UNUSED, int type)
+{
+	size_t start, part, sent;
+
+	test_result(type == 0x6D);
+
+	memset(frame, 0, 40);
+	phone_reply.Type = 0x6D;
+	phone_reply.Buffer = frame;
+	phone_reply_pending = TRUE;
+
+	switch (buffer[3]) {
+		case 0x6C:
+			/* File info, size of file at 10 */
+			frame[3] = 0x6D;
+			frame[10] = (FILE_SIZE >> 24) & 0xff;
+			frame[11] = (FILE_SIZE >> 16) & 0xff;
+			frame[12] = (FILE_SIZE >> 8) & 0xff;
+			frame[13] = FILE_SIZE & 0xff;
+			phone_reply.Length = 40;
+			break;
+		case 0x72:
+			/* Open file, handle at 6 */
+			frame[3] = 0x73;
+			frame[9] = 0x01;
+			phone_reply.Length = 10;
+			break;
+		case 0x5E:
+			/* File part, position at 10, length at 14 */
+			phone_requests++;
+			start = (buffer[10] << 24) + (buffer[11] << 16) + (buffer[12] << 8) + buffer[13];
+			part = (buffer[14] << 24) + (buffer[15] << 16) + (buffer[16] << 8) + buffer[17];
+			test_result(part <= N6510_FILE_PART_MAX);
+			if (part > FILE_SIZE - start) {
+				part = FILE_SIZE - start;
+			}
+			sent = part;
+			if (part > phone_part) {
+				switch (phone_behaviour) {
+					case PHONE_SMALLER:
+						part = sent = phone_part;
+						break;
+					case PHONE_EMPTY:
+						part = sent = 0;
+						break;
+					case PHONE_SHORT:
+						sent = phone_part;
+						break;
+				}
+			}
+			fill_part(0x5F, start, part, sent);
+			phone_reply.Length = 10 + sent;
+			break;
+		case 0x66:
+			/* Checksum at 6 */
+			frame[3] = 0x67;
+			frame[6] = (phone_checksum >> 8) & 0xff;
+			frame[7] = phone_checksum & 0xff;
+			phone_reply.Length = 8;
+			break;
+		case 0x74:
+			/* Close file */
+			frame[3] = 0x75;
+			phone_reply.Length = 6;
+			break;
+		default:
+			printf("Unexpected request 0x%02X\n", buffer[3]);
+			test_result(FALSE);
+	}
+	return ERR_NONE;
+}
+
+/**
+ * Dispatches prepared reply as soon as anything is read.
+ */
+static GSM_Error phone_state_machine(GSM_StateMachine *s, unsigned char rx_char UNUSED)
+{
+	phone_reply_pending = FALSE;
+	s->Phone.Data.RequestMsg = &phone_reply;
+	s->Phone.Data.DispatchError = s->Phone.Functions->DispatchMessage(s);
+	return ERR_NONE;
+}
+
+static int phone_read_device(GSM_StateMachine *s UNUSED, void *buf UNUSED, size_t nbytes UNUSED)
+{
+	return phone_reply_pending ? 1 : 0;
+}
+
+GSM_Protocol_Functions PhoneProtocol = {
+	phone_write_message,
+	phone_state_machine,
+	NULL,
+	NULL
+};
+
+GSM_Device_Functions PhoneDevice = {
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	phone_read_device,
+	NULL
+};
+
+GSM_PhoneModel phone_model = {"6510", "NHM-9", "", {F_FILES2, 0}};
+
+/**
+ * Reads test file from fake phone using the driver and returns used
+ * part size.
+ */
+static int stream_file(GSM_StateMachine *s, size_t part, PhoneBehaviour behaviour, int checksum, int requests)
+{
+	GSM_Phone_N6510Data *Priv = &s->Phone.Data.Priv.N6510;
+	GSM_File File;
+	GSM_Error error;
+
+	phone_part = part;
+	phone_behaviour = behaviour;
+	phone_checksum = checksum;
+	phone_requests = 0;
+	phone_reply_pending = FALSE;
+
+	Priv->FilePartSize = N6510_FILE_PART_MAX;
+
+	memset(&File, 0, sizeof(File));
+	EncodeUnicode(File.ID_FullName, "d:/test", 7);
+	received = 0;
+
+	error = N6510_GetFileStream(s, &File, sink, NULL);
+	if (checksum != FILE_CHECKSUM) {
+		test_result(error == ERR_WRONGCRC);
+	} else {
+		gammu_test_result(error, "N6510_GetFileStream");
+	}
+	test_result(received == FILE_SIZE);
+	test_result(File.Used == FILE_SIZE);
+	test_result(File.Buffer == NULL);
+	test_result((Priv->FileCheckAcc & 0xffff) == FILE_CHECKSUM);
+	test_result(phone_requests == requests);
+
+	return Priv->FilePartSize;
+}
+
+int main(int argc UNUSED, char **argv UNUSED)
+{
+	GSM_Debug_Info *debug_info;
+	GSM_StateMachine *s;
+	GSM_File File;
+
+	debug_info = GSM_GetGlobalDebug();
+	GSM_SetDebugFileDescriptor(stderr, FALSE, debug_info);
+	GSM_SetDebugLevel("textall", debug_info);
+
+	/* Allocates state machine */
+	s = GSM_AllocStateMachine();
+	test_result(s != NULL);
+
+	/* Checksum does not depend on size of parts */
+	test_result(read_file(s, N6510_FILE_PART_MAX) == FILE_CHECKSUM);
+	test_result(read_file(s, N6510_FILE_PART) == FILE_CHECKSUM);
+	test_result(read_file(s, 1) == FILE_CHECKSUM);
+
+	/* Part bigger than the frame is rejected */
+	memset(&File, 0, sizeof(File));
+	s->Phone.Data.File = &File;
+	test_result(send_part(s, 0, N6510_FILE_PART_MAX, N6510_FILE_PART) == ERR_UNKNOWNRESPONSE);
+	test_result(File.Used == 0);
+
+	/* Connect to fake phone */
+	s->Phone.Functions = &N6510Phone;
+	s->Protocol.Functions = &PhoneProtocol;
+	s->Device.Functions = &PhoneDevice;
+	s->Phone.Data.ModelInfo = &phone_model;
+	s->ReplyNum = 1;
+	s->opened = TRUE;
+
+	/* Phone sends big parts */
+	test_result(stream_file(s, N6510_FILE_PART_MAX, PHONE_SMALLER, FILE_CHECKSUM, 2) == N6510_FILE_PART_MAX);
+
+	/* Empty reply falls back to standard parts */
+	test_result(stream_file(s, N6510_FILE_PART, PHONE_EMPTY, FILE_CHECKSUM, 19) == N6510_FILE_PART);
+
+	/* Reply not matching its header falls back to standard parts */
+	test_result(stream_file(s, N6510_FILE_PART, PHONE_SHORT, FILE_CHECKSUM, 19) == N6510_FILE_PART);
+
+	/* Smaller parts are used as sent by phone */
+	test_result(stream_file(s, 4000, PHONE_SMALLER, FILE_CHECKSUM, 5) == 4000);
+
+	/* Checksum mismatch is reported */
+	test_result(stream_file(s, N6510_FILE_PART_MAX, PHONE_SMALLER, FILE_CHECKSUM ^ 1, 2) == N6510_FILE_PART_MAX);
+
+	s->opened = FALSE;
+	s->Phone.Functions = NULL;
+
+	/* Free state machine */
+	GSM_FreeStateMachine(s);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
@@ -0,0 +1,142 @@
+/* Test for IrMC change log parsing and synchronisation state of OBEX driver */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "../libgammu/protocol/protocol.h"	/* Needed for GSM_Protocol_Message */
+#include "../libgammu/gsmstate.h"	/* Needed for state machine internals */
+
+#include "common.h"
+
+/* Changes since change counter 10 */
+const char changelog[] =
+	"SN:1234567890\r\n"
+	"DID:ABC1\r\n"
+	"Total-Records:4\r\n"
+	"Maximum-Records:1000\r\n"
+	"M:11::00000C\r\n"
+	"D:12:20080102T102030Z:00000B\r\n"
+	"M:13::00000E\r\n"
+	"H:14::0000FF\r\n"
+	"M:15::00000A\r\n";
+
+/* Log which overflowed */
+const char changelog_full[] =
+	"SN:1234567890\r\n"
+	"DID:ABC1\r\n"
+	"*\r\n";
+
+/* Log after database was replaced */
+const char changelog_did[] =
+	"SN:1234567890\r\n"
+	"DID:ABC2\r\n";
+
+int main(int argc, char **argv)
+{
+	GSM_Debug_Info *debug_info;
+	GSM_StateMachine *s;
+	IRMC_SyncState State, Loaded;
+	IRMC_Change *Changes = NULL;
+	int Count = 0;
+	gboolean Full;
+	char *luid[4];
+	char tmpname[1000];
+
+	/* Check parameters */
+	if (argc != 2) {
+		printf("Not enough parameters!\nUsage: obex-changelog state.ini\n");
+		return 1;
+	}
+
+	/* Configure state machine */
+	debug_info = GSM_GetGlobalDebug();
+	GSM_SetDebugFileDescriptor(stderr, FALSE, debug_info);
+	GSM_SetDebugLevel("textall", debug_info);
+
+	/* Allocates state machine */
+	s = GSM_AllocStateMachine();
+	test_result(s != NULL);
+	debug_info = GSM_GetDebug(s);
+	GSM_SetDebugGlobal(TRUE, debug_info);
+
+	/* State after full read of three entries */
+	remove(argv[1]);
+	gammu_test_result(OBEXGEN_LoadSyncState(s, argv[1], "pb", &State), "OBEXGEN_LoadSyncState");
+	test_result(State.LUIDCount == 0);
+	test_result(State.CC == NULL);
+	luid[0] = NULL;
+	luid[1] = strdup("00000A");
+	luid[2] = strdup("00000B");
+	luid[3] = strdup("00000C");
+	State.LUID = (char **)malloc(sizeof(luid));
+	test_result(State.LUID != NULL);
+	memcpy(State.LUID, luid, sizeof(luid));
+	State.LUIDCount = 3;
+	State.DID = strdup("ABC1");
+	State.CC = strdup("10");
+
+	/* Apply changes */
+	gammu_test_result(OBEXGEN_ParseChangeLog(s, changelog, &State, &Changes, &Count, &Full), "OBEXGEN_ParseChangeLog");
+	test_result(!Full);
+	test_result(Count == 4);
+	test_result(Changes[0].Location == 3 && !Changes[0].Deleted);
+	test_result(Changes[1].Location == 2 && Changes[1].Deleted);
+	test_result(Changes[2].Location == 4 && !Changes[2].Deleted);
+	test_result(Changes[3].Location == 1 && !Changes[3].Deleted);
+	test_result(State.LUIDCount == 4);
+	test_result(strcmp(State.LUID[4], "00000E") == 0);
+	free(Changes);
+	Changes = NULL;
+	Count = 0;
+
+	/* Deleted entry is forgotten by caller */
+	free(State.LUID[2]);
+	State.LUID[2] = NULL;
+
+	/* Save and load state */
+	gammu_test_result(OBEXGEN_SaveSyncState(s, argv[1], "pb", &State), "OBEXGEN_SaveSyncState");
+	sprintf(tmpname, "%s.tmp", argv[1]);
+	/* Temporary file was renamed */
+	test_result(fopen(tmpname, "r") == NULL);
+	gammu_test_result(OBEXGEN_LoadSyncState(s, argv[1], "pb", &Loaded), "OBEXGEN_LoadSyncState");
+	test_result(Loaded.LUIDCount == 4);
+	test_result(strcmp(Loaded.DID, "ABC1") == 0);
+	test_result(strcmp(Loaded.CC, "10") == 0);
+	test_result(strcmp(Loaded.LUID[1], "00000A") == 0);
+	test_result(Loaded.LUID[2] == NULL);
+	test_result(strcmp(Loaded.LUID[3], "00000C") == 0);
+	test_result(strcmp(Loaded.LUID[4], "00000E") == 0);
+
+	/* Overflowed log requires full read */
+	gammu_test_result(OBEXGEN_ParseChangeLog(s, changelog_full, &Loaded, &Changes, &Count, &Full), "OBEXGEN_ParseChangeLog");
+	test_result(Full);
+	free(Changes);
+	Changes = NULL;
+	Count = 0;
+
+	/* So does changed database */
+	gammu_test_result(OBEXGEN_ParseChangeLog(s, changelog_did, &Loaded, &Changes, &Count, &Full), "OBEXGEN_ParseChangeLog");
+	test_result(Full);
+	test_result(strcmp(Loaded.DID, "ABC2") == 0);
+	free(Changes);
+	OBEXGEN_FreeSyncState(&Loaded);
+
+	/* State of different store is ignored */
+	gammu_test_result(OBEXGEN_LoadSyncState(s, argv[1], "cal", &Loaded), "OBEXGEN_LoadSyncState");
+	test_result(Loaded.LUIDCount == 0);
+	test_result(Loaded.DID == NULL);
+	OBEXGEN_FreeSyncState(&Loaded);
+
+	OBEXGEN_FreeSyncState(&State);
+	remove(argv[1]);
+
+	/* Free state machine */
+	GSM_FreeStateMachine(s);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
@@ -0,0 +1,116 @@
+/**
+ * Test case for batch PDU decoding in Gammu
+ */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common.h"
+
+static const char *pdus[] = {
+	"07917283010010F5040BC87238880900F10000993092516195800AE8329BFD4697D9EC37",
+	"0791361907001003B17A0C913619397750320000AD11CD701E340FB3C3F23CC81D0689C3BF",
+	"0791539111161616114F048123000000FF06D0B79BFE9E03",
+	/* Invalid hex */
+	"0791539111161616114F0481230000G0FF06D0B79BFE9E03",
+	/* Odd length */
+	"079",
+	/* Unicode text */
+	"07911326040000F0040B911346610089F6000820801191344240080048006500790021",
+	/* Empty */
+	"",
+};
+
+#define PDU_COUNT (sizeof(pdus) / sizeof(pdus[0]))
+
+/**
+ * Checks batch result against single message decoder.
+ */
+static void check_message(const GSM_SMSPDUInfo *info, const char *hex)
+{
+	GSM_SMSMessage sms;
+	unsigned char buffer[200];
+	char text[1000];
+	size_t length, parse_len;
+	GSM_Error error;
+
+	length = strlen(hex);
+	if (length == 0 || length % 2 != 0 || !DecodeHexBin(buffer, (const unsigned char *)hex, length)) {
+		test_result(info->Error == ERR_CORRUPTED);
+		return;
+	}
+
+	error = GSM_DecodePDUFrame(NULL, &sms, buffer, length / 2, &parse_len, TRUE);
+	test_result(info->Error == error);
+	if (error != ERR_NONE) {
+		return;
+	}
+
+	test_result(info->PDU == sms.PDU);
+	test_result(info->Coding == sms.Coding);
+	test_result(info->Class == sms.Class);
+	test_result(info->MessageReference == sms.MessageReference);
+	test_result(info->UDHType == sms.UDH.Type);
+	test_result(info->UDHLength == (size_t)sms.UDH.Length);
+	test_result(memcmp(info->UDH, sms.UDH.Text, sms.UDH.Length) == 0);
+	test_result(memcmp(&info->DateTime, &sms.DateTime, sizeof(GSM_DateTime)) == 0);
+
+	EncodeUTF8(text, sms.Number);
+	test_result(strcmp(info->Number, text) == 0);
+	EncodeUTF8(text, sms.SMSC.Number);
+	test_result(strcmp(info->SMSC, text) == 0);
+	EncodeUTF8(text, sms.Text);
+	test_result(strcmp(info->Text, text) == 0);
+	test_result(info->TextLength == strlen(text));
+}
+
+int main(int argc UNUSED, char **argv UNUSED)
+{
+	GSM_SMSPDUBatch batch;
+	const unsigned char *input[PDU_COUNT];
+	unsigned char raw[3][200];
+	size_t lengths[PDU_COUNT];
+	size_t i;
+
+	for (i = 0; i < PDU_COUNT; i++) {
+		input[i] = (const unsigned char *)pdus[i];
+		lengths[i] = strlen(pdus[i]);
+	}
+
+	/* Hex input */
+	test_result(GSM_DecodePDUBatch(NULL, &batch, input, lengths, PDU_COUNT, TRUE, TRUE) == ERR_NONE);
+	test_result(batch.Count == PDU_COUNT);
+	for (i = 0; i < PDU_COUNT; i++) {
+		check_message(&batch.Messages[i], pdus[i]);
+	}
+	test_result(strcmp(batch.Messages[0].Text, "hellohello") == 0);
+	test_result(strcmp(batch.Messages[5].Text, "Hey!") == 0);
+	GSM_FreePDUBatch(&batch);
+	test_result(batch.Messages == NULL);
+
+	/* Raw input */
+	for (i = 0; i < 3; i++) {
+		test_result(DecodeHexBin(raw[i], input[i], lengths[i]));
+		input[i] = raw[i];
+		lengths[i] /= 2;
+	}
+	test_result(GSM_DecodePDUBatch(NULL, &batch, input, lengths, 3, FALSE, TRUE) == ERR_NONE);
+	test_result(batch.Count == 3);
+	for (i = 0; i < 3; i++) {
+		check_message(&batch.Messages[i], pdus[i]);
+	}
+	GSM_FreePDUBatch(&batch);
+
+	/* Nothing to decode */
+	test_result(GSM_DecodePDUBatch(NULL, &batch, input, lengths, 0, FALSE, TRUE) == ERR_NONE);
+	test_result(batch.Count == 0);
+	GSM_FreePDUBatch(&batch);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
@@ -0,0 +1,168 @@
+/**
+ * Test case for national language shift tables in Gammu
+ */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common.h"
+
+/* Turkish text in UTF-8, none of the national chars is in default alphabet */
+#define TURKISH "\xc5\x9e\x61\x6b\x61\x20\xc4\xb1\xc4\x9f\xc4\xb1\x20\xc3\xa7\x6f\x6b\x20\xc4\xb0\x73\x74\x61\x6e\x62\x75\x6c\x20\xc5\x9f\x65\x68\x72\x69\x2e\x20"
+
+/* Portuguese text in UTF-8 */
+#define PORTUGUESE "\x4e\x61\x20\x61\x63\xc3\xa7\xc3\xa3\x6f\x20\x70\xc3\xba\x62\x6c\x69\x63\x61\x20\xc3\xa0\x73\x20\x74\x72\xc3\xaa\x73\x2c\x20\xc3\xb4\x6e\x69\x62\x75\x73\x21\x20"
+
+/**
+ * Encodes multipart message from UTF-8 text, encodes each part to frame,
+ * decodes it back and checks the text is same. Then joins the message
+ * and checks it is encoded same way again.
+ */
+static void check_roundtrip(const char *utf8, int repeat, GSM_NationalLanguage locking, GSM_NationalLanguage single)
+{
+	GSM_MultiPartSMSInfo info;
+	GSM_MultiSMSMessage *sms, *again;
+	GSM_SMSMessage decoded;
+	GSM_NationalLanguage found_locking, found_single;
+	unsigned char *text, *result;
+	unsigned char buffer[1000];
+	int i, length;
+	size_t pos = 0, text_length;
+
+	text = (unsigned char *)malloc((strlen(utf8) * repeat + 1) * 2);
+	result = (unsigned char *)malloc((strlen(utf8) * repeat + 1) * 2);
+	sms = (GSM_MultiSMSMessage *)malloc(sizeof(GSM_MultiSMSMessage));
+	again = (GSM_MultiSMSMessage *)malloc(sizeof(GSM_MultiSMSMessage));
+	test_result(text != NULL && result != NULL && sms != NULL && again != NULL);
+
+	DecodeUTF8(text, utf8, strlen(utf8));
+	text_length = UnicodeLength(text);
+	for (i = 1; i < repeat; i++) {
+		memcpy(text + i * text_length * 2, text, text_length * 2);
+	}
+	text[repeat * text_length * 2] = 0;
+	text[repeat * text_length * 2 + 1] = 0;
+
+	GSM_ClearMultiPartSMSInfo(&info);
+	info.EntriesNum = 1;
+	info.Entries[0].ID = SMS_ConcatenatedAutoTextLong;
+	info.Entries[0].Buffer = text;
+	test_result(GSM_EncodeMultiPartSMS(GSM_GetGlobalDebug(), &info, sms) == ERR_NONE);
+	test_result(sms->Number > 0);
+
+	for (i = 0; i < sms->Number; i++) {
+		test_result(sms->SMS[i].Coding == SMS_Coding_Default_No_Compression);
+		GSM_DecodeUDHNationalLanguage(&sms->SMS[i].UDH, &found_locking, &found_single);
+		test_result(found_locking == locking);
+		test_result(found_single == single);
+
+		EncodeUnicode(sms->SMS[i].Number, "+420123456789", 13);
+		test_result(GSM_EncodeSMSFrame(NULL, &sms->SMS[i], buffer, PHONE_SMSSubmit, &length, TRUE) == ERR_NONE);
+
+		GSM_SetDefaultReceivedSMSData(&decoded);
+		test_result(GSM_DecodeSMSFrame(NULL, &decoded, buffer, PHONE_SMSSubmit) == ERR_NONE);
+		test_result(decoded.Coding == SMS_Coding_Default_No_Compression);
+		if (sms->Number > 1) {
+			test_result(decoded.UDH.Type == UDH_ConcatenatedMessages);
+			test_result(decoded.UDH.PartNumber == i + 1);
+			test_result(decoded.UDH.AllParts == sms->Number);
+		}
+		memcpy(result + pos * 2, decoded.Text, UnicodeLength(decoded.Text) * 2);
+		pos += UnicodeLength(decoded.Text);
+	}
+	test_result(pos == repeat * text_length);
+	test_result(memcmp(result, text, pos * 2) == 0);
+
+	/* Joined message remembers the tables */
+	test_result(GSM_DecodeMultiPartSMS(GSM_GetGlobalDebug(), &info, sms, FALSE));
+	test_result(info.LockingShift == locking);
+	test_result(info.SingleShift == single);
+	test_result(mywstrncmp(info.Entries[0].Buffer, text, 0));
+
+	/* And encodes same way again */
+	test_result(GSM_EncodeMultiPartSMS(GSM_GetGlobalDebug(), &info, again) == ERR_NONE);
+	GSM_FreeMultiPartSMSInfo(&info);
+	test_result(again->Number == sms->Number);
+	for (i = 0; i < sms->Number; i++) {
+		test_result(again->SMS[i].Coding == SMS_Coding_Default_No_Compression);
+		GSM_DecodeUDHNationalLanguage(&again->SMS[i].UDH, &found_locking, &found_single);
+		test_result(found_locking == locking);
+		test_result(found_single == single);
+		test_result(mywstrncmp(again->SMS[i].Text, sms->SMS[i].Text, 0));
+	}
+
+	free(text);
+	free(result);
+	free(sms);
+	free(again);
+}
+
+int main(int argc UNUSED, char **argv UNUSED)
+{
+	unsigned char unicode[2000];
+	GSM_SMSSplitInfo info;
+	GSM_UDHHeader udh;
+	GSM_NationalLanguage locking, single;
+
+	/* Turkish text fits into less messages with Turkish tables */
+	DecodeUTF8(unicode, TURKISH TURKISH TURKISH TURKISH TURKISH TURKISH, strlen(TURKISH) * 6);
+	test_result(GSM_SplitSMSText(NULL, unicode, UnicodeLength(unicode), UDH_ConcatenatedMessages, 0, &info) == ERR_NONE);
+	test_result(info.Coding == SMS_Coding_Default_No_Compression);
+	test_result(info.LockingShift == SMS_Language_Turkish);
+	test_result(info.SingleShift == SMS_Language_Default);
+	test_result(info.UDHLength == 9);
+	test_result(info.Parts == 2);
+
+	/* Explicit coding does not use national tables */
+	test_result(GSM_SplitSMSText(NULL, unicode, UnicodeLength(unicode), UDH_ConcatenatedMessages, SMS_Coding_Default_No_Compression, &info) == ERR_NONE);
+	test_result(info.LockingShift == SMS_Language_Default);
+	test_result(info.SingleShift == SMS_Language_Default);
+	test_result(info.UDHLength == 6);
+
+	/* Short text stays in Unicode */
+	DecodeUTF8(unicode, TURKISH, strlen(TURKISH));
+	test_result(GSM_SplitSMSText(NULL, unicode, UnicodeLength(unicode), UDH_NoUDH, 0, &info) == ERR_NONE);
+	test_result(info.Coding == SMS_Coding_Unicode_No_Compression);
+	test_result(info.Parts == 1);
+
+	/* Concatenation is recognized together with national IEs */
+	udh.Type = UDH_ConcatenatedMessages;
+	udh.Text[0] = 0;
+	udh.ID8bit = 0x42;
+	udh.PartNumber = 2;
+	udh.AllParts = 3;
+	GSM_EncodeUDHHeader(NULL, &udh);
+	GSM_EncodeUDHNationalLanguage(&udh, SMS_Language_Portuguese, SMS_Language_Spanish);
+	test_result(udh.Length == 12);
+	GSM_DecodeUDHHeader(NULL, &udh);
+	test_result(udh.Type == UDH_ConcatenatedMessages);
+	test_result(udh.ID8bit == 0x42);
+	test_result(udh.PartNumber == 2);
+	test_result(udh.AllParts == 3);
+	GSM_DecodeUDHNationalLanguage(&udh, &locking, &single);
+	test_result(locking == SMS_Language_Portuguese);
+	test_result(single == SMS_Language_Spanish);
+
+	/* Full UDH is left untouched */
+	udh.Type = UDH_UserUDH;
+	memset(udh.Text, 0x42, sizeof(udh.Text));
+	udh.Text[0] = GSM_MAX_UDH_LENGTH - 5;
+	udh.Length = udh.Text[0] + 1;
+	test_result(GSM_EncodeUDHNationalLanguage(&udh, SMS_Language_Turkish, SMS_Language_Default) == ERR_NONE);
+	test_result(udh.Length == GSM_MAX_UDH_LENGTH - 1);
+	test_result(GSM_EncodeUDHNationalLanguage(&udh, SMS_Language_Turkish, SMS_Language_Default) == ERR_MOREMEMORY);
+	test_result(udh.Length == GSM_MAX_UDH_LENGTH - 1);
+
+	/* Whole messages survive encoding and decoding */
+	check_roundtrip(TURKISH, 10, SMS_Language_Turkish, SMS_Language_Default);
+	check_roundtrip(TURKISH, 3, SMS_Language_Turkish, SMS_Language_Default);
+	check_roundtrip(PORTUGUESE, 10, SMS_Language_Portuguese, SMS_Language_Default);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
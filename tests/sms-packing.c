@@ -0,0 +1,117 @@
+/**
+ * Test case for 7-bit packing and unpacking in Gammu, compares
+ * results with the original bit by bit implementation on random data.
+ */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common.h"
+
+#include "../libgammu/misc/coding/coding.h"
+
+#define ITERATIONS 100000
+#define MAX_LENGTH 200
+#define BUFFER_SIZE (MAX_LENGTH * 2)
+
+#define ByteMask ((1 << Bits) - 1)
+
+static int Reference_UnpackEightBitsToSeven(int offset, int in_length, int out_length,
+                           const unsigned char *input, unsigned char *output)
+{
+	unsigned char *output_pos = output;
+	const unsigned char *input_pos = input;
+	unsigned char Rest = 0x00;
+	int Bits;
+
+	Bits = offset ? offset : 7;
+
+	while ((input_pos - input) < in_length) {
+		*output_pos = ((*input_pos & ByteMask) << (7 - Bits)) | Rest;
+		Rest = *input_pos >> Bits;
+		if ((input_pos != input) || (Bits == 7)) output_pos++;
+		input_pos++;
+		if ((output_pos - output) >= out_length) break;
+		if (Bits == 1) {
+			*output_pos = Rest;
+			output_pos++;
+			Bits = 7;
+			Rest = 0x00;
+		} else {
+			Bits--;
+		}
+	}
+
+	return output_pos - output;
+}
+
+static int Reference_PackSevenBitsToEight(int offset, const unsigned char *input, unsigned char *output, int length)
+{
+	unsigned char *output_pos = output;
+	const unsigned char *input_pos = input;
+	int Bits;
+
+	Bits = (7 + offset) % 8;
+
+	if (offset) {
+		*output_pos = 0x00;
+		output_pos++;
+	}
+
+	while ((input_pos - input) < length) {
+		unsigned char Byte = *input_pos;
+
+		*output_pos = Byte >> (7 - Bits);
+		if (Bits != 7)
+			*(output_pos-1) |= (Byte & ((1 << (7-Bits)) - 1)) << (Bits+1);
+		Bits--;
+		if (Bits == -1) Bits = 7; else output_pos++;
+		input_pos++;
+	}
+	return (output_pos - output);
+}
+
+int main(int argc UNUSED, char **argv UNUSED)
+{
+	unsigned char input[BUFFER_SIZE];
+	unsigned char output[BUFFER_SIZE];
+	unsigned char reference[BUFFER_SIZE];
+	int i, j, offset, in_length, out_length, result, expected;
+
+	srand(42);
+
+	for (i = 0; i < ITERATIONS; i++) {
+		offset = rand() % 7;
+		in_length = rand() % MAX_LENGTH;
+		out_length = rand() % MAX_LENGTH + 1;
+		for (j = 0; j < BUFFER_SIZE; j++) {
+			input[j] = rand() & 0xff;
+			/* Mostly valid septets, sometimes any byte */
+			if (i % 2 == 0) {
+				input[j] &= 0x7f;
+			}
+		}
+
+		memset(output, 0xaa, sizeof(output));
+		memset(reference, 0xaa, sizeof(reference));
+		result = GSM_PackSevenBitsToEight(offset, input, output, in_length);
+		expected = Reference_PackSevenBitsToEight(offset, input, reference, in_length);
+		test_result(result == expected);
+		test_result(memcmp(output, reference, sizeof(output)) == 0);
+
+		memset(output, 0xaa, sizeof(output));
+		memset(reference, 0xaa, sizeof(reference));
+		result = GSM_UnpackEightBitsToSeven(offset, in_length, out_length, input, output);
+		expected = Reference_UnpackEightBitsToSeven(offset, in_length, out_length, input, reference);
+		test_result(result == expected);
+		test_result(memcmp(output, reference, sizeof(output)) == 0);
+	}
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
@@ -0,0 +1,106 @@
+/**
+ * Test case for splitting text into SMS messages in Gammu
+ */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common.h"
+
+/**
+ * Counts parts passed to callback and checks their lengths.
+ */
+static GSM_Error count_parts(GSM_SMSMessage *SMS, void *user_data)
+{
+	int *parts = (int *)user_data;
+
+	(*parts)++;
+	test_result(SMS->UDH.PartNumber == *parts);
+	test_result(UnicodeLength(SMS->Text) == (size_t)SMS->Length);
+	return ERR_NONE;
+}
+
+static GSM_Error stop_encoding(GSM_SMSMessage *SMS UNUSED, void *user_data UNUSED)
+{
+	return ERR_ABORTED;
+}
+
+int main(int argc UNUSED, char **argv UNUSED)
+{
+	char text[1000];
+	unsigned char unicode[2002];
+	GSM_SMSSplitInfo info;
+	int parts, num;
+	size_t left;
+
+	/* Single message in default alphabet */
+	memset(text, 'a', 160);
+	EncodeUnicode(unicode, text, 160);
+	test_result(GSM_SplitSMSText(NULL, unicode, 160, UDH_NoUDH, 0, &info) == ERR_NONE);
+	test_result(info.Coding == SMS_Coding_Default_No_Compression);
+	test_result(info.Parts == 1);
+	test_result(info.CharsLeft == 0);
+
+	/* Concatenated message */
+	memset(text, 'a', 307);
+	EncodeUnicode(unicode, text, 307);
+	test_result(GSM_SplitSMSText(NULL, unicode, 307, UDH_ConcatenatedMessages, SMS_Coding_Default_No_Compression, &info) == ERR_NONE);
+	test_result(info.UDHLength == 6);
+	test_result(info.Capacity == 153);
+	test_result(info.Parts == 3);
+	test_result(info.Start[1] == 153);
+	test_result(info.Start[2] == 306);
+	test_result(info.Start[3] == 307);
+	test_result(info.CharsLeft == 152);
+
+	/* Extension char is not split across messages */
+	memset(text, 'a', 152);
+	text[152] = '{';
+	EncodeUnicode(unicode, text, 153);
+	test_result(GSM_SplitSMSText(NULL, unicode, 153, UDH_ConcatenatedMessages, 0, &info) == ERR_NONE);
+	test_result(info.Coding == SMS_Coding_Default_No_Compression);
+	test_result(info.Parts == 2);
+	test_result(info.Start[1] == 152);
+	test_result(info.Used[0] == 152);
+	test_result(info.Used[1] == 2);
+
+	/* Char outside of default alphabet */
+	memset(text, 'a', 100);
+	EncodeUnicode(unicode, text, 100);
+	unicode[100] = 0x4e;
+	unicode[101] = 0x2d;
+	test_result(GSM_SplitSMSText(NULL, unicode, 100, UDH_ConcatenatedMessages, 0, &info) == ERR_NONE);
+	test_result(info.Coding == SMS_Coding_Unicode_No_Compression);
+	test_result(info.Capacity == 67);
+	test_result(info.Parts == 2);
+	test_result(info.CharsLeft == 34);
+
+	/* Same result as counter */
+	unicode[200] = 0;
+	unicode[201] = 0;
+	GSM_SMSCounter(NULL, unicode, UDH_ConcatenatedMessages, SMS_Coding_Unicode_No_Compression, &num, &left);
+	test_result(num == info.Parts);
+	test_result(left == info.CharsLeft);
+
+	/* Streaming encoder */
+	parts = 0;
+	test_result(GSM_EncodeSplitSMS(NULL, unicode, &info, UDH_ConcatenatedMessages, -1, count_parts, &parts) == ERR_NONE);
+	test_result(parts == 2);
+	test_result(GSM_EncodeSplitSMS(NULL, unicode, &info, UDH_ConcatenatedMessages, -1, stop_encoding, NULL) == ERR_ABORTED);
+
+	/* Empty text still needs one message */
+	test_result(GSM_SplitSMSText(NULL, unicode, 0, UDH_NoUDH, SMS_Coding_8bit, &info) == ERR_NONE);
+	test_result(info.Parts == 1);
+	test_result(info.CharsLeft == 140);
+
+	/* Compressed coding is not supported */
+	test_result(GSM_SplitSMSText(NULL, unicode, 10, UDH_NoUDH, SMS_Coding_Default_Compression, &info) == ERR_NOTSUPPORTED);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
@@ -0,0 +1,169 @@
+/**
+ * Test for SMSD message pool and truncated messages.
+ */
+
+#include <gammu.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "common.h"
+#include "../smsd/msgpool.h"
+
+/**
+ * Text long enough to need several message parts.
+ */
+#define LONG_TEXT \
+	"This is long text which does not fit into single message, so it " \
+	"is split to several parts and they have to be linked back together " \
+	"after reading them from the phone. Some more text to make it long."
+
+/**
+ * Prepares message with given number of parts, each part is marked by
+ * its index.
+ */
+static void make_message(GSM_MultiSMSMessage *sms, int parts)
+{
+	int i;
+
+	memset(sms, 0, sizeof(GSM_MultiSMSMessage));
+	sms->Number = parts;
+	for (i = 0; i < parts; i++) {
+		GSM_SetDefaultSMSData(&sms->SMS[i]);
+		sms->SMS[i].Location = i + 1;
+	}
+}
+
+/**
+ * Stores copy of truncated message just before inaccessible page, so
+ * that any access beyond used parts crashes the test.
+ */
+static GSM_MultiSMSMessage *guarded_copy(const GSM_MultiSMSMessage *sms, void **area, size_t *length)
+{
+	long pagesize = sysconf(_SC_PAGESIZE);
+	size_t size = SMSD_MULTISMS_SIZE(sms->Number);
+	char *data;
+
+	*length = (size + pagesize - 1) / pagesize * pagesize + pagesize;
+	data = mmap(NULL, *length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	test_result(data != MAP_FAILED);
+	test_result(mprotect(data + *length - pagesize, pagesize, PROT_NONE) == 0);
+	*area = data;
+
+	data += *length - pagesize - size;
+	memcpy(data, sms, size);
+	return (GSM_MultiSMSMessage *)data;
+}
+
+int main(int argc UNUSED, char **argv UNUSED)
+{
+	GSM_Debug_Info *debug_info;
+	SMSD_MessagePool pool;
+	SMSD_PoolBlock *block;
+	GSM_MultiSMSMessage sms, single, *first, *second, *big, *full;
+	GSM_MultiSMSMessage *input[GSM_MAX_MULTI_SMS + 1], *output[GSM_MAX_MULTI_SMS + 1];
+	GSM_MultiPartSMSInfo info;
+	void *areas[GSM_MAX_MULTI_SMS];
+	size_t lengths[GSM_MAX_MULTI_SMS];
+	unsigned char text[2 * (sizeof(LONG_TEXT) + 1)];
+	int i, parts;
+
+	debug_info = GSM_GetGlobalDebug();
+	GSM_SetDebugFileDescriptor(stderr, FALSE, debug_info);
+	GSM_SetDebugLevel("textall", debug_info);
+
+	/* Allocation copies used parts */
+	SMSD_PoolInit(&pool);
+	test_result(pool.Blocks == NULL);
+	make_message(&sms, 1);
+	first = SMSD_PoolCopy(&pool, &sms);
+	test_result(first != NULL);
+	test_result(first->Number == 1);
+	test_result(first->SMS[0].Location == 1);
+	block = pool.Blocks;
+	test_result(block != NULL);
+
+	/* Small messages reuse the same block */
+	make_message(&sms, 2);
+	second = SMSD_PoolCopy(&pool, &sms);
+	test_result(second != NULL);
+	test_result(pool.Blocks == block);
+	test_result(second->Number == 2);
+	test_result(second->SMS[1].Location == 2);
+	test_result((char *)second >= (char *)first + SMSD_MULTISMS_SIZE(1));
+	test_result(first->Number == 1);
+
+	/* Message bigger than block gets its own one */
+	make_message(&sms, GSM_MAX_MULTI_SMS);
+	big = SMSD_PoolCopy(&pool, &sms);
+	test_result(big != NULL);
+	test_result(pool.Blocks != block);
+	test_result(big->SMS[GSM_MAX_MULTI_SMS - 1].Location == GSM_MAX_MULTI_SMS);
+	test_result(second->SMS[1].Location == 2);
+
+	/* Expanding gives full message with cleared unused parts */
+	full = SMSD_ExpandSMS(second);
+	test_result(full != NULL);
+	test_result(full->Number == 2);
+	test_result(memcmp(full, second, SMSD_MULTISMS_SIZE(2)) == 0);
+	test_result(full->SMS[2].Location == 0);
+	test_result(full->SMS[GSM_MAX_MULTI_SMS - 1].Location == 0);
+	free(full);
+
+	/* Release frees everything and pool can be used again */
+	SMSD_PoolFree(&pool);
+	test_result(pool.Blocks == NULL);
+	make_message(&sms, 1);
+	first = SMSD_PoolCopy(&pool, &sms);
+	test_result(first != NULL);
+	test_result(first->Number == 1);
+	SMSD_PoolFree(&pool);
+	test_result(pool.Blocks == NULL);
+
+	/* Prepare long message */
+	GSM_ClearMultiPartSMSInfo(&info);
+	EncodeUnicode(text, LONG_TEXT, strlen(LONG_TEXT));
+	info.EntriesNum = 1;
+	info.Class = -1;
+	info.Entries[0].ID = SMS_ConcatenatedTextLong;
+	info.Entries[0].Buffer = text;
+	memset(&sms, 0, sizeof(sms));
+	gammu_test_result(GSM_EncodeMultiPartSMS(debug_info, &info, &sms), "GSM_EncodeMultiPartSMS");
+	info.Entries[0].Buffer = NULL;
+	GSM_FreeMultiPartSMSInfo(&info);
+	parts = sms.Number;
+	test_result(parts > 1);
+
+	/*
+	 * Parts come from phone in reverse order, one part each, linking
+	 * reads only used parts of truncated messages.
+	 */
+	for (i = 0; i < parts; i++) {
+		single.Number = 1;
+		single.SMS[0] = sms.SMS[parts - i - 1];
+		EncodeUnicode(single.SMS[0].Number, "+420800123456", 13);
+		input[i] = guarded_copy(&single, &areas[i], &lengths[i]);
+	}
+	input[parts] = NULL;
+
+	gammu_test_result(GSM_LinkSMS(debug_info, input, output, TRUE), "GSM_LinkSMS");
+	test_result(output[0] != NULL);
+	test_result(output[1] == NULL);
+	test_result(output[0]->Number == parts);
+	for (i = 0; i < parts; i++) {
+		test_result(output[0]->SMS[i].UDH.PartNumber == i + 1);
+	}
+	free(output[0]);
+
+	for (i = 0; i < parts; i++) {
+		munmap(areas[i], lengths[i]);
+	}
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
@@ -0,0 +1,97 @@
+/**
+ * Test for filling SMSD send queue from FILES backend.
+ */
+
+#include <gammu-smsd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "common.h"
+#include "../smsd/core.h"
+
+/**
+ * Creates file with given content.
+ */
+static void create_file(const char *dir, const char *name, const char *content)
+{
+	char path[1000];
+	FILE *f;
+
+	sprintf(path, "%s/%s", dir, name);
+	f = fopen(path, "w");
+	test_result(f != NULL);
+	fputs(content, f);
+	fclose(f);
+}
+
+int main(int argc, char **argv)
+{
+	GSM_SMSDConfig *config;
+	SMSD_QueuedSMS *entry;
+	char path[1000], outbox[1000];
+	int wait;
+	FILE *f;
+
+	if (argc != 2) {
+		printf("Usage: smsd-send-queue DIRECTORY\n");
+		return 1;
+	}
+
+	mkdir(argv[1], 0755);
+	sprintf(outbox, "%s/outbox/", argv[1]);
+	mkdir(outbox, 0755);
+
+	sprintf(path, "%s/smsdrc", argv[1]);
+	f = fopen(path, "w");
+	test_result(f != NULL);
+	fprintf(f, "[gammu]\nmodel = dummy\nconnection = none\nport = %s\n\n", argv[1]);
+	fprintf(f, "[smsd]\nservice = files\nlogfile = stderr\ndebuglevel = 255\n");
+	fprintf(f, "outboxpath = %s\nsendqueuesize = 10\n", outbox);
+	fclose(f);
+
+	/* Outbox with messages of different priority */
+	create_file(outbox, "OUTZ_+420800123456_00.txt", "Not urgent\n");
+	create_file(outbox, "OUT+420800123456.txt", "Default\n");
+	create_file(outbox, "OUTA_+420800123456_00.txt", "Urgent\n");
+
+	config = SMSD_NewConfig("test");
+	test_result(config != NULL);
+	gammu_test_result(SMSD_ReadConfig(path, config, TRUE), "SMSD_ReadConfig");
+
+	/* All messages are queued, not only the first one */
+	gammu_test_result(SMSD_FillSendQueue(config), "SMSD_FillSendQueue");
+	test_result(config->SendQueueUsed == 3);
+
+	/* Nothing more to fetch, queued ones are skipped */
+	gammu_test_result(SMSD_FillSendQueue(config), "SMSD_FillSendQueue");
+	test_result(config->SendQueueUsed == 3);
+
+	/* Most urgent goes first, file without letter is in the middle */
+	entry = SMSD_SchedulerNext(config, time(NULL), &wait);
+	test_result(entry != NULL);
+	test_result(strcmp(entry->ID, "OUTA_+420800123456_00.txt") == 0);
+	free(entry);
+
+	entry = SMSD_SchedulerNext(config, time(NULL), &wait);
+	test_result(entry != NULL);
+	test_result(strcmp(entry->ID, "OUT+420800123456.txt") == 0);
+	test_result(entry->Priority == SMSD_DEFAULT_PRIORITY);
+	free(entry);
+
+	entry = SMSD_SchedulerNext(config, time(NULL), &wait);
+	test_result(entry != NULL);
+	test_result(strcmp(entry->ID, "OUTZ_+420800123456_00.txt") == 0);
+	free(entry);
+
+	test_result(config->SendQueueUsed == 0);
+
+	SMSD_FreeConfig(config);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
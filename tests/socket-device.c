@@ -0,0 +1,146 @@
+/* Test for TCP and Unix socket device */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "../libgammu/gsmstate.h"	/* Needed for state machine internals */
+
+#include "common.h"
+
+GSM_StateMachine *s;
+
+/**
+ * Opens socket device for given connection type and device name.
+ */
+static GSM_Error device_open(GSM_ConnectionType type, const char *device)
+{
+	free(s->CurrentConfig->Device);
+	s->CurrentConfig->Device = strdup(device);
+	s->ConnectionType = type;
+	s->Device.Functions = &SocketDevice;
+	return s->Device.Functions->OpenDevice(s);
+}
+
+/**
+ * Sends data both ways over accepted connection.
+ */
+static void check_transfer(int server)
+{
+	char buffer[100];
+	int client, len, i;
+
+	client = accept(server, NULL, NULL);
+	test_result(client >= 0);
+
+	test_result(s->Device.Functions->WriteDevice(s, "AT\r", 3) == 3);
+	len = recv(client, buffer, sizeof(buffer), 0);
+	test_result(len == 3 && memcmp(buffer, "AT\r", 3) == 0);
+
+	test_result(send(client, "\r\nOK\r\n", 6, 0) == 6);
+	len = 0;
+	for (i = 0; i < 100 && len < 6; i++) {
+		len += s->Device.Functions->ReadDevice(s, buffer + len, sizeof(buffer) - len);
+		usleep(10000);
+	}
+	test_result(len == 6 && memcmp(buffer, "\r\nOK\r\n", 6) == 0);
+
+	/* Silent peer is not failure of device */
+	for (i = 0; i < 10; i++) {
+		test_result(s->Device.Functions->ReadDevice(s, buffer, sizeof(buffer)) == 0);
+		usleep(10000);
+	}
+
+	/* Closed connection is reported as failure */
+	close(client);
+	len = 0;
+	for (i = 0; i < 100 && len == 0; i++) {
+		len = s->Device.Functions->ReadDevice(s, buffer, sizeof(buffer));
+		usleep(10000);
+	}
+	test_result(len < 0);
+
+	/* Writing to closed connection does not raise SIGPIPE */
+	for (i = 0; i < 10; i++) {
+		s->Device.Functions->WriteDevice(s, "AT\r", 3);
+	}
+
+	gammu_test_result(s->Device.Functions->CloseDevice(s), "CloseDevice");
+}
+
+int main(int argc, char **argv)
+{
+	GSM_Debug_Info *debug_info;
+	struct sockaddr_in inaddr;
+	struct sockaddr_un unaddr;
+	socklen_t addrlen = sizeof(inaddr);
+	char device[100];
+	int server;
+
+	if (argc != 2) {
+		printf("Usage: socket-device SOCKET\n");
+		return 1;
+	}
+
+	debug_info = GSM_GetGlobalDebug();
+	GSM_SetDebugFileDescriptor(stderr, FALSE, debug_info);
+	GSM_SetDebugLevel("textall", debug_info);
+
+	s = GSM_AllocStateMachine();
+	test_result(s != NULL);
+	debug_info = GSM_GetDebug(s);
+	GSM_SetDebugGlobal(TRUE, debug_info);
+	s->CurrentConfig = GSM_GetConfig(s, 0);
+
+	/* TCP server on random local port */
+	server = socket(AF_INET, SOCK_STREAM, 0);
+	test_result(server >= 0);
+	memset(&inaddr, 0, sizeof(inaddr));
+	inaddr.sin_family = AF_INET;
+	inaddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	inaddr.sin_port = 0;
+	test_result(bind(server, (struct sockaddr *)&inaddr, sizeof(inaddr)) == 0);
+	test_result(listen(server, 1) == 0);
+	test_result(getsockname(server, (struct sockaddr *)&inaddr, &addrlen) == 0);
+
+	sprintf(device, "127.0.0.1:%d", ntohs(inaddr.sin_port));
+	gammu_test_result(device_open(GCT_TCPAT, device), "OpenDevice tcp");
+	check_transfer(server);
+	close(server);
+
+	/* Nobody listens there now */
+	test_result(device_open(GCT_TCPAT, device) == ERR_DEVICEOPENERROR);
+
+	/* Port is required */
+	test_result(device_open(GCT_TCPAT, "127.0.0.1") == ERR_DEVICENOTEXIST);
+
+	/* Unix socket */
+	remove(argv[1]);
+	server = socket(AF_UNIX, SOCK_STREAM, 0);
+	test_result(server >= 0);
+	memset(&unaddr, 0, sizeof(unaddr));
+	unaddr.sun_family = AF_UNIX;
+	strcpy(unaddr.sun_path, argv[1]);
+	test_result(bind(server, (struct sockaddr *)&unaddr, sizeof(unaddr)) == 0);
+	test_result(listen(server, 1) == 0);
+
+	gammu_test_result(device_open(GCT_UNIXAT, argv[1]), "OpenDevice unix");
+	check_transfer(server);
+	close(server);
+	remove(argv[1]);
+
+	test_result(device_open(GCT_UNIXAT, argv[1]) == ERR_DEVICENOTEXIST);
+
+	GSM_FreeStateMachine(s);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
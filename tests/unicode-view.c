@@ -0,0 +1,58 @@
+/**
+ * Test case for Unicode text views in Gammu
+ */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common.h"
+
+#include "../libgammu/misc/coding/coding.h"
+
+int main(int argc UNUSED, char **argv UNUSED)
+{
+	unsigned char a[100], b[100], c[100], dest[100];
+	GSM_UnicodeView va, vb, vc, empty;
+
+	EncodeUnicode(a, "+420123456", 10);
+	EncodeUnicode(b, "+420123456", 10);
+	EncodeUnicode(c, "+420123457", 10);
+	dest[0] = 0;
+	dest[1] = 0;
+
+	va = UnicodeView(a);
+	vb = UnicodeView(b);
+	vc = UnicodeView(c);
+	empty = UnicodeView(dest);
+
+	test_result(va.Text == a);
+	test_result(va.Length == 10);
+	test_result(empty.Length == 0);
+
+	/* Comparison */
+	test_result(UnicodeViewEqual(&va, &vb));
+	test_result(!UnicodeViewEqual(&va, &vc));
+	test_result(!UnicodeViewEqual(&va, &empty));
+	test_result(UnicodeViewEqual(&empty, &empty));
+
+	/* Copying */
+	memset(dest, 0xff, sizeof(dest));
+	test_result(UnicodeViewCopy(dest, &vc) == 10);
+	test_result(memcmp(dest, c, 22) == 0);
+
+	memset(dest, 0xff, sizeof(dest));
+	test_result(CopyUnicodeStringLen(dest, a) == 10);
+	test_result(memcmp(dest, a, 22) == 0);
+
+	/* Appending */
+	test_result(CopyUnicodeStringLen(dest + 20, c) == 10);
+	test_result(UnicodeLength(dest) == 20);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
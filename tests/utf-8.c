@@ -5,10 +5,12 @@
 #include "common.h"
 #include <gammu.h>
 #include <gammu-unicode.h>
+#include <string.h>
 
 int main(int argc UNUSED, char **argv UNUSED)
 {
     unsigned char out[20];
+    unsigned char unicode[40];
 
     test_result(EncodeWithUTF8Alphabet(0x24, out) == 1);
     test_result(out[0] == 0x24);
@@ -41,6 +43,19 @@ int main(int argc UNUSED, char **argv UNUSED)
     test_result(out[3] == 0x8d);
     test_result(out[4] == 0x00);
 
+    /* Length aware variants */
+    test_result(EncodeUTF8Len(out, "\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x20\xac\xD8\x3d\xDC\x4d", 8) == 12);
+    test_result(memcmp(out, "ABCDE\xe2\x82\xac\xf0\x9f\x91\x8d", 13) == 0);
+
+    test_result(DecodeUTF8Len(unicode, "ABCDEFGHI\xe2\x82\xac\xf0\x9f\x91\x8dXYZ", 19) == 15);
+    test_result(memcmp(unicode, "\x00\x41", 2) == 0);
+    test_result(memcmp(unicode + 16, "\x00\x49\x20\xac\xD8\x3d\xDC\x4d\x00\x58", 10) == 0);
+    test_result(unicode[30] == 0 && unicode[31] == 0);
+
+    /* Length limits input */
+    test_result(DecodeUTF8Len(unicode, "ABCDEFGHI", 3) == 3);
+    test_result(unicode[6] == 0 && unicode[7] == 0);
+
 	return 0;
 }
 
@@ -0,0 +1,85 @@
+/**
+ * Benchmark of parsing big vCard file.
+ *
+ * Generates file with many contacts and decodes them one by one same
+ * way as LoadVCard does. Optional parameter sets number of contacts.
+ */
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "common.h"
+
+#define DEFAULT_CONTACTS 10000
+
+/* Maximal length of one generated contact */
+#define CONTACT_SIZE 400
+
+int main(int argc, char **argv)
+{
+	size_t pos = 0, len = 0;
+	GSM_MemoryEntry pbk;
+	GSM_Error error;
+	char *buffer;
+	int contacts = DEFAULT_CONTACTS;
+	int i, found = 0;
+	clock_t start;
+
+	/* Check parameters */
+	if (argc > 2) {
+		printf("Usage: vcard-bulk [contacts]\n");
+		return 1;
+	}
+	if (argc == 2) {
+		contacts = atoi(argv[1]);
+	}
+
+	/* Generate vCard file */
+	buffer = (char *)malloc(contacts * CONTACT_SIZE + 1);
+	test_result(buffer != NULL);
+	for (i = 0; i < contacts; i++) {
+		len += sprintf(buffer + len,
+			"BEGIN:VCARD\r\n"
+			"VERSION:2.1\r\n"
+			"N:Surname%d;Name%d\r\n"
+			"TEL;CELL:+42077%07d\r\n"
+			"TEL;WORK;VOICE:+42022%07d\r\n"
+			"EMAIL;INTERNET:name%d@example.com\r\n"
+			"ORG:Company %d\r\n"
+			"NOTE;ENCODING=QUOTED-PRINTABLE:Long note about contact=\r\n"
+			" number %d\r\n"
+			"ADR;HOME:;;Street %d;City;;12345;Country\r\n"
+			"X-IRMC-LUID:%06X\r\n"
+			"END:VCARD\r\n",
+			i, i, i, i, i, i, i, i, i);
+	}
+
+	/* Decode all contacts */
+	start = clock();
+	while (1) {
+		error = GSM_DecodeVCARD(NULL, buffer, &pos, &pbk, Nokia_VCard21);
+		if (error == ERR_EMPTY) {
+			break;
+		}
+		gammu_test_result(error, "GSM_DecodeVCARD");
+		test_result(pbk.EntriesNum >= 8);
+		GSM_FreeMemoryEntry(&pbk);
+		found++;
+	}
+
+	printf("Decoded %d contacts (%ld bytes) in %.3f s\n",
+		found, (long)len,
+		(double)(clock() - start) / CLOCKS_PER_SEC);
+
+	test_result(found == contacts);
+
+	free(buffer);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */